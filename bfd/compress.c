@@ -20,14 +20,34 @@
 
 #include "sysdep.h"
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include "bfd.h"
 #include "libbfd.h"
 #include "safe-ctype.h"
+#include "elf-bfd.h"
 
 #define MAX_COMPRESSION_HEADER_SIZE 24
 
+/* Return TRUE if the compressed CONTENTS of a section in ABFD, whose
+   compression header is COMPRESSION_HEADER_SIZE bytes, were compressed
+   with zstd.  A .zdebug* section, without an ELF compression header,
+   is always compressed with zlib.  */
+
+static bfd_boolean
+is_zstd_compressed (bfd *abfd, bfd_byte *contents,
+		    int compression_header_size)
+{
+  /* The ch_type field comes first in both the 32-bit and the 64-bit
+     compression header.  */
+  return (compression_header_size > 0
+	  && bfd_get_32 (abfd, contents) == ELFCOMPRESS_ZSTD);
+}
+
 static bfd_boolean
-decompress_contents (bfd_byte *compressed_buffer,
+decompress_contents (bfd_boolean is_zstd,
+		     bfd_byte *compressed_buffer,
 		     bfd_size_type compressed_size,
 		     bfd_byte *uncompressed_buffer,
 		     bfd_size_type uncompressed_size)
@@ -35,6 +55,19 @@ decompress_contents (bfd_byte *compressed_buffer,
   z_stream strm;
   int rc;
 
+  if (is_zstd)
+    {
+#ifdef HAVE_ZSTD
+      /* The section may consist of several zstd frames, which
+	 ZSTD_decompress handles as a whole.  */
+      size_t ret = ZSTD_decompress (uncompressed_buffer, uncompressed_size,
+				    compressed_buffer, compressed_size);
+      return !ZSTD_isError (ret) && ret == uncompressed_size;
+#else
+      return FALSE;
+#endif
+    }
+
   /* It is possible the section consists of several compressed
      buffers concatenated together, so we uncompress in a loop.  */
   /* PR 18313: The state field in the z_stream structure is supposed
@@ -81,6 +114,7 @@ bfd_compress_section_contents (bfd *abfd, sec_ptr sec,
   bfd_byte *buffer;
   bfd_size_type buffer_size;
   bfd_boolean decompress;
+  bfd_boolean is_zstd = FALSE;
   int zlib_size = 0;
   int orig_compression_header_size;
   bfd_size_type orig_uncompressed_size;
@@ -103,6 +137,40 @@ bfd_compress_section_contents (bfd *abfd, sec_ptr sec,
       if (orig_compression_header_size < 0)
 	abort ();
 
+      /* We only write zlib compression headers, so a zstd compressed
+	 section is uncompressed here and compressed again with zlib
+	 below.  */
+      if (is_zstd_compressed (abfd, uncompressed_buffer,
+			      orig_compression_header_size))
+	{
+	  buffer = (bfd_byte *) bfd_malloc (orig_uncompressed_size);
+	  if (buffer == NULL)
+	    return 0;
+	  if (!decompress_contents (TRUE,
+				    uncompressed_buffer
+				    + orig_compression_header_size,
+				    (uncompressed_size
+				     - orig_compression_header_size),
+				    buffer, orig_uncompressed_size))
+	    {
+	      bfd_set_error (bfd_error_bad_value);
+	      free (buffer);
+	      return 0;
+	    }
+	  free (uncompressed_buffer);
+	  bfd_set_section_alignment (abfd, sec,
+				     orig_uncompressed_alignment_pow);
+	  elf_section_flags (sec) &= ~SHF_COMPRESSED;
+	  uncompressed_buffer = buffer;
+	  uncompressed_size = orig_uncompressed_size;
+	  sec->size = uncompressed_size;
+	  compressed = FALSE;
+	  is_zstd = TRUE;
+	}
+    }
+
+  if (compressed)
+    {
       /* Different compression schemes.  Just move the compressed section
 	 contents to the right position. */
       if (orig_compression_header_size == 0)
@@ -146,7 +214,8 @@ bfd_compress_section_contents (bfd *abfd, sec_ptr sec,
       sec->size = orig_uncompressed_size;
       if (decompress)
 	{
-	  if (!decompress_contents (uncompressed_buffer
+	  if (!decompress_contents (FALSE,
+				    uncompressed_buffer
 				    + orig_compression_header_size,
 				    zlib_size, buffer, buffer_size))
 	    {
@@ -194,6 +263,10 @@ bfd_compress_section_contents (bfd *abfd, sec_ptr sec,
 	  bfd_release (abfd, buffer);
 	  sec->contents = uncompressed_buffer;
 	  sec->compress_status = COMPRESS_SECTION_NONE;
+	  /* The contents of a zstd compressed section are no longer
+	     those in the file.  */
+	  if (is_zstd)
+	    sec->flags |= SEC_IN_MEMORY;
 	  return uncompressed_size;
 	}
     }
@@ -232,6 +305,7 @@ bfd_get_full_section_contents (bfd *abfd, sec_ptr sec, bfd_byte **ptr)
   bfd_boolean ret;
   bfd_size_type save_size;
   bfd_size_type save_rawsize;
+  bfd_boolean is_zstd;
   bfd_byte *compressed_buffer;
   unsigned int compression_header_size;
 
@@ -300,11 +374,14 @@ bfd_get_full_section_contents (bfd *abfd, sec_ptr sec, bfd_byte **ptr)
 	goto fail_compressed;
 
       compression_header_size = bfd_get_compression_header_size (abfd, sec);
+      is_zstd = is_zstd_compressed (abfd, compressed_buffer,
+				    compression_header_size);
       if (compression_header_size == 0)
 	/* Set header size to the zlib header size if it is a
 	   SHF_COMPRESSED section.  */
 	compression_header_size = 12;
-      if (!decompress_contents (compressed_buffer + compression_header_size,
+      if (!decompress_contents (is_zstd,
+				compressed_buffer + compression_header_size,
 				sec->compressed_size - compression_header_size, p, sz))
 	{
 	  bfd_set_error (bfd_error_bad_value);
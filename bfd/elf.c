@@ -989,6 +989,19 @@ convert_zdebug_to_debug (bfd *abfd, const char *name)
   return new_name;
 }
 
+/* Return TRUE if SEC in ABFD, which has an ELF compression header,
+   is compressed with zstd.  The ch_type field comes first in both the
+   32-bit and the 64-bit compression header.  */
+
+static bfd_boolean
+is_zstd_compressed_section (bfd *abfd, asection *sec)
+{
+  bfd_byte ch_type[4];
+
+  return (bfd_get_section_contents (abfd, sec, ch_type, 0, sizeof ch_type)
+	  && bfd_get_32 (abfd, ch_type) == ELFCOMPRESS_ZSTD);
+}
+
 /* Make a BFD section from an ELF section.  We store a pointer to the
    BFD section in the bfd_section field of the header.  */
 
@@ -1192,7 +1205,9 @@ _bfd_elf_make_section_from_shdr (bfd *abfd,
 	}
 
       /* Compress the uncompressed section or convert from/to .zdebug*
-	 section.  Check if we should compress.  */
+	 section.  Check if we should compress.  We only write zlib
+	 compressed sections, so a zstd compressed section is converted
+	 too.  */
       if (action == nothing)
 	{
 	  if (newsect->size != 0
@@ -1201,7 +1216,9 @@ _bfd_elf_make_section_from_shdr (bfd *abfd,
 	      && uncompressed_size > 0
 	      && (!compressed
 		  || ((compression_header_size > 0)
-		      != ((abfd->flags & BFD_COMPRESS_GABI) != 0))))
+		      != ((abfd->flags & BFD_COMPRESS_GABI) != 0))
+		  || (compression_header_size > 0
+		      && is_zstd_compressed_section (abfd, newsect))))
 	    action = compress;
 	  else
 	    return TRUE;
@@ -25,6 +25,8 @@
 #include "libbfd.h"
 #include "elf-bfd.h"
 #include "elf/amo.h"
+#include "elf32-amo.h"
+#include "opcode/amo.h"
 
 struct amo_relocation_map
 {
@@ -68,45 +70,45 @@ static reloc_howto_type amo_elf_howto_table[] =
 	HOWTO (R_AMO_LITERAL,      /* type */
            0,                  /* right shift */
            2,                  /* size (0 = byte, 1 = short, 2 = long) */
-           21,                 /* bit size */
+           AMO_WIDTH_IMM21,    /* bit size */
            TRUE,               /* pc-relative */
            0,				   /* bit pos */
            complain_overflow_bitfield, /* complain on overflow */
            bfd_elf_generic_reloc, /* special function */
            "R_AMO_LITERAL",    /* amo */
            FALSE,              /* partial inplace */
-           0x001fffff,         /* src mask */
-           0x001fffff,         /* dst mask */
+           AMO_PUT (IMM21, ~0U), /* src mask */
+           AMO_PUT (IMM21, ~0U), /* dst mask */
            TRUE                /* pc-relative offset */
 	),
     /* A 16-bit pc-relative relocation. */
 	HOWTO (R_AMO_PCREL,        /* type */
            2,                  /* right shift */
            1,                  /* size (0 = byte, 1 = short, 2 = long) */
-           16,                 /* bit size */
+           AMO_WIDTH_IMM16,    /* bit size */
            TRUE,               /* pc-relative */
            0,				   /* bit pos */
            complain_overflow_bitfield, /* complain on overflow */
            bfd_elf_generic_reloc, /* special function */
            "R_AMO_PCREL",      /* amo */
            FALSE,              /* partial inplace */
-           0x0000ffff,         /* src mask */
-           0x0000ffff,         /* dst mask */
+           AMO_PUT (IMM16, ~0U), /* src mask */
+           AMO_PUT (IMM16, ~0U), /* dst mask */
            TRUE                /* pc-relative offset */
 	),
 	/* A 28-bit absolute relocation. */
 	HOWTO (R_AMO_28,           /* type */
            2,                  /* right shift */
            2,                  /* size (0 = byte, 1 = short, 2 = long) */
-           26,                 /* bit size */
+           AMO_WIDTH_IMM26,    /* bit size */
            FALSE,              /* pc-relative */
            0,                  /* bit pos */
            complain_overflow_bitfield, /* complain on overflow */
            bfd_elf_generic_reloc, /* special function */
            "R_AMO_28",         /* amo */
            FALSE,              /* partial inplace */
-           0x03ffffff,         /* src mask */
-           0x03ffffff,         /* dst mask */
+           AMO_PUT (IMM26, ~0U), /* src mask */
+           AMO_PUT (IMM26, ~0U), /* dst mask */
            FALSE               /* pc-relative offset */
 	),
     /* A 32-bit absolute relocation. */
@@ -123,6 +125,21 @@ static reloc_howto_type amo_elf_howto_table[] =
            0xffffffff,         /* src mask */
            0xffffffff,         /* dst mask */
            FALSE               /* pc-relative offset */
+	),
+	/* A 21-bit absolute relocation, a literal load relaxed to mov. */
+	HOWTO (R_AMO_21,           /* type */
+           0,                  /* right shift */
+           2,                  /* size (0 = byte, 1 = short, 2 = long) */
+           AMO_WIDTH_IMM21,    /* bit size */
+           FALSE,              /* pc-relative */
+           0,                  /* bit pos */
+           complain_overflow_signed, /* complain on overflow */
+           bfd_elf_generic_reloc, /* special function */
+           "R_AMO_21",         /* amo */
+           FALSE,              /* partial inplace */
+           AMO_PUT (IMM21, ~0U), /* src mask */
+           AMO_PUT (IMM21, ~0U), /* dst mask */
+           FALSE               /* pc-relative offset */
 	)
 };
 
@@ -149,7 +166,7 @@ amo_reloc_type_lookup (bfd *abfd, bfd_reloc_code_real_type code)
 	unsigned int i;
 
     /* this field must be fixed to support BASE_RELOCATION */
-	for (i = 0; i < R_AMO_max + 1; ++i)
+	for (i = 0; i < sizeof (amo_reloc_map) / sizeof (amo_reloc_map[0]); ++i)
 	{
 		if (amo_reloc_map[i].bfd_reloc_val == code)
 			return &amo_elf_howto_table[amo_reloc_map[i].elf_reloc_val];
@@ -185,7 +202,1319 @@ amo_elf_relative_reloc(bfd *abfd, arelent *r_entry, asymbol *sym,
 	);
 }
 
+/* reach of the pc-relative branch in bytes */
+#define AMO_PCREL_MIN (AMO_SMIN (IMM16) * BYTES_PER_INSTRUCTION)
+#define AMO_PCREL_MAX (AMO_SMAX (IMM16) * BYTES_PER_INSTRUCTION)
+
+/* input sections sharing one stub section, the group is kept below the
+   branch reach so that 2048 stubs still fit next to it */
+#define AMO_STUB_GROUP_SIZE (AMO_PCREL_MAX + BYTES_PER_INSTRUCTION - 0x2000)
+
+/* a literal relaxed to mov must stay in reach while stubs are added
+   behind it, absolute values do not move */
+#define AMO_LITERAL_SLACK 0x10000
+
+/* a veneer in a stub section, it lets a conditional branch that cannot
+   reach its target jump there through an absolute jmp */
+struct amo_elf_stub_hash_entry
+{
+	struct bfd_hash_entry root;
+
+	/* the stub section and the offset of the jmp in it */
+	asection *stub_sec;
+	bfd_vma stub_offset;
+
+	/* the branch goes to target_value + addend + 4 in target_section */
+	bfd_vma target_value;
+	asection *target_section;
+	bfd_vma addend;
+
+	/* first input section of the group using the stub */
+	asection *id_sec;
+};
+
+struct amo_elf_link_hash_table
+{
+	struct elf_link_hash_table root;
+
+	/* the veneers, by name */
+	struct bfd_hash_table bstab;
+
+	/* fake input bfd of the stub sections */
+	bfd *stub_bfd;
+
+	/* linker call-backs */
+	asection *(*add_stub_section) (const char *, asection *);
+	void (*layout_sections_again) (void);
+
+	/* stub grouping, indexed by input section id */
+	struct map_stub
+	{
+		/* the stubs of the group are placed before this section */
+		asection *link_sec;
+		asection *stub_sec;
+	} *stub_group;
+	unsigned int top_id;
+
+	/* input sections of each output section, used to build the groups */
+	unsigned int top_index;
+	asection **input_list;
+};
+
+#define amo_elf_hash_table(info) \
+	(is_elf_hash_table ((info)->hash) \
+	 && elf_hash_table_id ((struct elf_link_hash_table *) ((info)->hash)) == AMO_ELF_DATA \
+	 ? (struct amo_elf_link_hash_table *) ((info)->hash) : NULL)
+
+#define amo_stub_hash_lookup(table, string, create, copy) \
+	((struct amo_elf_stub_hash_entry *) bfd_hash_lookup ((table), (string), (create), (copy)))
+
+static struct bfd_hash_entry *
+amo_elf_stub_hash_newfunc (struct bfd_hash_entry *entry, struct bfd_hash_table *table,
+                           const char *string)
+{
+	struct amo_elf_stub_hash_entry *hsh;
+
+	if (entry == NULL)
+	{
+		entry = bfd_hash_allocate (table, sizeof (struct amo_elf_stub_hash_entry));
+		if (entry == NULL)
+			return entry;
+	}
+
+	entry = bfd_hash_newfunc (entry, table, string);
+	if (entry != NULL)
+	{
+		hsh = (struct amo_elf_stub_hash_entry *) entry;
+		hsh->stub_sec = NULL;
+		hsh->stub_offset = 0;
+		hsh->target_value = 0;
+		hsh->target_section = NULL;
+		hsh->addend = 0;
+		hsh->id_sec = NULL;
+	}
+
+	return entry;
+}
+
+static void
+amo_elf_link_hash_table_free (bfd *obfd)
+{
+	struct amo_elf_link_hash_table *htab;
+
+	htab = (struct amo_elf_link_hash_table *) obfd->link.hash;
+	bfd_hash_table_free (&htab->bstab);
+	free (htab->stub_group);
+	_bfd_elf_link_hash_table_free (obfd);
+}
+
+static struct bfd_link_hash_table *
+amo_elf_link_hash_table_create (bfd *abfd)
+{
+	struct amo_elf_link_hash_table *htab;
+
+	htab = (struct amo_elf_link_hash_table *) bfd_zmalloc (sizeof (*htab));
+	if (htab == NULL)
+		return NULL;
+
+	if (!_bfd_elf_link_hash_table_init (&htab->root, abfd, _bfd_elf_link_hash_newfunc,
+	                                    sizeof (struct elf_link_hash_entry), AMO_ELF_DATA))
+	{
+		free (htab);
+		return NULL;
+	}
+
+	if (!bfd_hash_table_init (&htab->bstab, amo_elf_stub_hash_newfunc,
+	                          sizeof (struct amo_elf_stub_hash_entry)))
+	{
+		_bfd_elf_link_hash_table_free (abfd);
+		return NULL;
+	}
+	htab->root.root.hash_table_free = amo_elf_link_hash_table_free;
+
+	return &htab->root.root;
+}
+
+/* stub sections are named after the first input section of their group */
+#define STUB_SUFFIX ".stub"
+
+/* a veneer is shared by the branches of one group to one target */
+static char *
+amo_elf_stub_name (const asection *id_sec, const asection *sym_sec,
+                   const struct elf_link_hash_entry *h, const Elf_Internal_Rela *rel)
+{
+	char *stub_name;
+	bfd_size_type len;
+
+	if (h != NULL)
+	{
+		len = 8 + 1 + strlen (h->root.root.string) + 1 + 8 + 1;
+		stub_name = (char *) bfd_malloc (len);
+		if (stub_name != NULL)
+			sprintf (stub_name, "%08x_%s+%x", id_sec->id & 0xffffffff,
+			         h->root.root.string, (int) rel->r_addend & 0xffffffff);
+	}
+	else
+	{
+		len = 8 + 1 + 8 + 1 + 8 + 1 + 8 + 1;
+		stub_name = (char *) bfd_malloc (len);
+		if (stub_name != NULL)
+			sprintf (stub_name, "%08x_%x:%x+%x", id_sec->id & 0xffffffff,
+			         sym_sec->id & 0xffffffff, (int) ELF32_R_SYM (rel->r_info) & 0xffffffff,
+			         (int) rel->r_addend & 0xffffffff);
+	}
+
+	return stub_name;
+}
+
+/* the veneer made for the branch REL of INPUT_SECTION, if any */
+static struct amo_elf_stub_hash_entry *
+amo_elf_get_stub_entry (const asection *input_section, const asection *sym_sec,
+                        const struct elf_link_hash_entry *h, const Elf_Internal_Rela *rel,
+                        struct amo_elf_link_hash_table *htab)
+{
+	struct amo_elf_stub_hash_entry *hsh;
+	const asection *id_sec;
+	char *stub_name;
+
+	if (htab == NULL || htab->stub_group == NULL || input_section->id > htab->top_id)
+		return NULL;
+
+	id_sec = htab->stub_group[input_section->id].link_sec;
+	if (id_sec == NULL || (h == NULL && sym_sec == NULL))
+		return NULL;
+
+	stub_name = amo_elf_stub_name (id_sec, sym_sec, h, rel);
+	if (stub_name == NULL)
+		return NULL;
+
+	hsh = amo_stub_hash_lookup (&htab->bstab, stub_name, FALSE, FALSE);
+	free (stub_name);
+
+	return hsh;
+}
+
+/* enter a new veneer for a branch of SECTION, the stub section of the
+   group is made on first use */
+static struct amo_elf_stub_hash_entry *
+amo_elf_add_stub (const char *stub_name, asection *section, struct amo_elf_link_hash_table *htab)
+{
+	struct amo_elf_stub_hash_entry *hsh;
+	asection *link_sec, *stub_sec;
+	size_t namelen;
+	char *s_name;
+
+	link_sec = htab->stub_group[section->id].link_sec;
+	stub_sec = htab->stub_group[link_sec->id].stub_sec;
+	if (stub_sec == NULL)
+	{
+		namelen = strlen (link_sec->name);
+		s_name = (char *) bfd_alloc (htab->stub_bfd, namelen + sizeof (STUB_SUFFIX));
+		if (s_name == NULL)
+			return NULL;
+		memcpy (s_name, link_sec->name, namelen);
+		memcpy (s_name + namelen, STUB_SUFFIX, sizeof (STUB_SUFFIX));
+
+		stub_sec = (*htab->add_stub_section) (s_name, link_sec);
+		if (stub_sec == NULL)
+			return NULL;
+		htab->stub_group[link_sec->id].stub_sec = stub_sec;
+	}
+	htab->stub_group[section->id].stub_sec = stub_sec;
+
+	hsh = amo_stub_hash_lookup (&htab->bstab, stub_name, TRUE, FALSE);
+	if (hsh == NULL)
+	{
+		/* xgettext:c-format */
+		_bfd_error_handler (_("%pB: cannot create stub entry %s"), section->owner, stub_name);
+		return NULL;
+	}
+
+	hsh->stub_sec = stub_sec;
+	hsh->stub_offset = 0;
+	hsh->id_sec = link_sec;
+
+	return hsh;
+}
+
+/* write VALUE (S + A) into the field described by HOWTO at OFFSET, the
+   instruction formats are fixed so the fields are patched directly */
+static bfd_reloc_status_type
+amo_elf_final_link_relocate (reloc_howto_type *howto, bfd *input_bfd,
+                             asection *input_section, bfd_byte *contents,
+                             bfd_vma offset, bfd_vma value)
+{
+	bfd_signed_vma sval;
+	bfd_byte *where;
+	bfd_vma insn;
+
+	if (offset + 4 > input_section->size)
+		return bfd_reloc_outofrange;
+
+	where = contents + offset;
+	if (howto->pc_relative)
+		value -= input_section->output_section->vma + input_section->output_offset + offset;
+	sval = (bfd_signed_vma) value;
+
+	switch (howto->type)
+	{
+		case R_AMO_NONE:
+			return bfd_reloc_ok;
+
+		case R_AMO_LITERAL:
+		case R_AMO_21:
+			if (howto->type == R_AMO_21)
+				sval = (bfd_signed_vma) (((value & 0xffffffff) ^ 0x80000000) - 0x80000000);
+			if (sval < AMO_SMIN (IMM21) || sval > AMO_SMAX (IMM21))
+				return bfd_reloc_overflow;
+			insn = bfd_get_32 (input_bfd, where);
+			insn = (insn & ~AMO_PUT (IMM21, ~0U)) | AMO_PUT (IMM21, value);
+			bfd_put_32 (input_bfd, insn, where);
+			return bfd_reloc_ok;
+
+		case R_AMO_PCREL:
+			if (value & 0x3)
+				return bfd_reloc_dangerous;
+			if (sval < AMO_PCREL_MIN || sval > AMO_PCREL_MAX)
+				return bfd_reloc_overflow;
+			insn = bfd_get_32 (input_bfd, where);
+			insn = (insn & ~AMO_PUT (IMM16, ~0U)) | AMO_PUT (IMM16, value >> 2);
+			bfd_put_32 (input_bfd, insn, where);
+			return bfd_reloc_ok;
+
+		case R_AMO_28:
+			if (value & 0x3)
+				return bfd_reloc_dangerous;
+			if ((value & 0xffffffff) > (bfd_vma) AMO_MASK (IMM26) * BYTES_PER_INSTRUCTION)
+				return bfd_reloc_overflow;
+			insn = bfd_get_32 (input_bfd, where);
+			insn = (insn & ~AMO_PUT (IMM26, ~0U)) | AMO_PUT (IMM26, value >> 2);
+			bfd_put_32 (input_bfd, insn, where);
+			return bfd_reloc_ok;
+
+		case R_AMO_32:
+			bfd_put_32 (input_bfd, value, where);
+			return bfd_reloc_ok;
+
+		default:
+			return bfd_reloc_notsupported;
+	}
+}
+
+static bfd_boolean
+amo_elf_relocate_section (bfd *output_bfd, struct bfd_link_info *info,
+                          bfd *input_bfd, asection *input_section, bfd_byte *contents,
+                          Elf_Internal_Rela *relocs, Elf_Internal_Sym *local_syms,
+                          asection **local_sections)
+{
+	struct amo_elf_link_hash_table *htab;
+	Elf_Internal_Shdr *symtab_hdr;
+	struct elf_link_hash_entry **sym_hashes;
+	Elf_Internal_Rela *rel, *relend;
+
+	htab = amo_elf_hash_table (info);
+	symtab_hdr = &elf_tdata (input_bfd)->symtab_hdr;
+	sym_hashes = elf_sym_hashes (input_bfd);
+	relend = relocs + input_section->reloc_count;
+
+	for (rel = relocs; rel < relend; rel++)
+	{
+		reloc_howto_type *howto;
+		unsigned long r_symndx;
+		Elf_Internal_Sym *sym;
+		asection *sec;
+		struct elf_link_hash_entry *h;
+		struct amo_elf_stub_hash_entry *hsh;
+		bfd_vma relocation, stub_addr;
+		bfd_reloc_status_type r;
+		const char *name;
+		unsigned int r_type;
+
+		r_type = ELF32_R_TYPE (rel->r_info);
+		r_symndx = ELF32_R_SYM (rel->r_info);
+		if (r_type >= (unsigned int) R_AMO_max)
+		{
+			_bfd_error_handler (_("%pB: unsupported relocation type %d"), input_bfd, r_type);
+			bfd_set_error (bfd_error_bad_value);
+			return FALSE;
+		}
+
+		/* the relaxation leaves these behind */
+		if (r_type == R_AMO_NONE)
+			continue;
+
+		howto = &amo_elf_howto_table[r_type];
+		h = NULL;
+		sym = NULL;
+		sec = NULL;
+
+		if (r_symndx < symtab_hdr->sh_info)
+		{
+			sym = local_syms + r_symndx;
+			sec = local_sections[r_symndx];
+			relocation = _bfd_elf_rela_local_sym (output_bfd, sym, &sec, rel);
+
+			name = bfd_elf_string_from_elf_section (input_bfd, symtab_hdr->sh_link, sym->st_name);
+			name = (name == NULL || *name == '\0') ? bfd_section_name (input_bfd, sec) : name;
+		}
+		else
+		{
+			bfd_boolean unresolved_reloc, warned, ignored;
+
+			RELOC_FOR_GLOBAL_SYMBOL (info, input_bfd, input_section, rel,
+			                         r_symndx, symtab_hdr, sym_hashes,
+			                         h, sec, relocation,
+			                         unresolved_reloc, warned, ignored);
+
+			name = h->root.root.string;
+		}
+
+		if (sec != NULL && discarded_section (sec))
+			RELOC_AGAINST_DISCARDED_SECTION (info, input_bfd, input_section,
+			                                 rel, 1, relend, howto, 0, contents);
+
+		if (bfd_link_relocatable (info))
+			continue;
+
+		r = amo_elf_final_link_relocate (howto, input_bfd, input_section, contents,
+		                                 rel->r_offset, relocation + rel->r_addend);
+
+		/* a branch out of reach goes through the veneer of its group */
+		if (r == bfd_reloc_overflow && r_type == R_AMO_PCREL
+			&& (hsh = amo_elf_get_stub_entry (input_section, sec, h, rel, htab)) != NULL)
+		{
+			stub_addr = (hsh->stub_sec->output_section->vma + hsh->stub_sec->output_offset
+			             + hsh->stub_offset);
+			r = amo_elf_final_link_relocate (howto, input_bfd, input_section, contents,
+			                                 rel->r_offset, stub_addr - 4);
+		}
+
+		if (r != bfd_reloc_ok)
+		{
+			const char *msg = NULL;
+
+			switch (r)
+			{
+				case bfd_reloc_overflow:
+					(*info->callbacks->reloc_overflow)
+						(info, (h ? &h->root : NULL), name, howto->name,
+						 (bfd_vma) 0, input_bfd, input_section, rel->r_offset);
+					break;
+
+				case bfd_reloc_undefined:
+					(*info->callbacks->undefined_symbol)
+						(info, name, input_bfd, input_section, rel->r_offset, TRUE);
+					break;
+
+				case bfd_reloc_outofrange:
+					msg = _("internal error: out of range error");
+					break;
+
+				case bfd_reloc_notsupported:
+					msg = _("internal error: unsupported relocation error");
+					break;
+
+				case bfd_reloc_dangerous:
+					msg = _("misaligned branch target");
+					break;
+
+				default:
+					msg = _("internal error: unknown error");
+					break;
+			}
+
+			/* the field is left as it was, so the link must fail */
+			if (msg)
+				info->callbacks->einfo
+					/* xgettext:c-format */
+					(_("%X%H: reloc against `%s': %s\n"),
+					 input_bfd, input_section, rel->r_offset, name, msg);
+		}
+	}
+
+	return TRUE;
+}
+
+/* a literal load of the section and the word it reads */
+struct amo_elf_literal_ref
+{
+	bfd_vma word;
+	Elf_Internal_Rela *rel;
+};
+
+static int
+amo_elf_literal_ref_compare (const void *a, const void *b)
+{
+	const struct amo_elf_literal_ref *ra = (const struct amo_elf_literal_ref *) a;
+	const struct amo_elf_literal_ref *rb = (const struct amo_elf_literal_ref *) b;
+
+	if (ra->word != rb->word)
+		return ra->word < rb->word ? -1 : 1;
+	return ra->rel < rb->rel ? -1 : ra->rel > rb->rel;
+}
+
+static int
+amo_elf_reloc_offset_compare (const void *a, const void *b)
+{
+	const Elf_Internal_Rela *ra = *(const Elf_Internal_Rela * const *) a;
+	const Elf_Internal_Rela *rb = *(const Elf_Internal_Rela * const *) b;
+
+	if (ra->r_offset != rb->r_offset)
+		return ra->r_offset < rb->r_offset ? -1 : 1;
+	return ra < rb ? -1 : ra > rb;
+}
+
+/* the reloc filling the word at OFFSET, BYOFF is sorted by offset */
+static Elf_Internal_Rela *
+amo_elf_reloc_at (Elf_Internal_Rela **byoff, unsigned int count, bfd_vma offset)
+{
+	unsigned int lo, hi, mid;
+
+	lo = 0;
+	hi = count;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (byoff[mid]->r_offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* the words deleted earlier leave R_AMO_NONE relocs behind */
+	for (; lo < count && byoff[lo]->r_offset == offset; lo++)
+		if (ELF32_R_TYPE (byoff[lo]->r_info) != R_AMO_NONE)
+			return byoff[lo];
+
+	return NULL;
+}
+
+/* whether the literal word filled by WREL is known to fit a mov */
+static bfd_boolean
+amo_elf_literal_fits (bfd *abfd, Elf_Internal_Shdr *symtab_hdr, Elf_Internal_Sym *isymbuf,
+                      const Elf_Internal_Rela *wrel)
+{
+	unsigned long r_symndx;
+	asection *sym_sec;
+	bfd_signed_vma sval, slack;
+	bfd_vma value;
+
+	r_symndx = ELF32_R_SYM (wrel->r_info);
+	if (r_symndx < symtab_hdr->sh_info)
+	{
+		Elf_Internal_Sym *isym;
+
+		isym = isymbuf + r_symndx;
+		if (isym->st_shndx == SHN_UNDEF)
+			return FALSE;
+		sym_sec = bfd_section_from_elf_index (abfd, isym->st_shndx);
+		value = isym->st_value;
+	}
+	else
+	{
+		struct elf_link_hash_entry *h;
+
+		h = elf_sym_hashes (abfd)[r_symndx - symtab_hdr->sh_info];
+		while (h->root.type == bfd_link_hash_indirect
+			   || h->root.type == bfd_link_hash_warning)
+			h = (struct elf_link_hash_entry *) h->root.u.i.link;
+
+		if (h->root.type == bfd_link_hash_undefweak)
+		{
+			sym_sec = bfd_abs_section_ptr;
+			value = 0;
+		}
+		else if (h->root.type == bfd_link_hash_defined
+				 || h->root.type == bfd_link_hash_defweak)
+		{
+			sym_sec = h->root.u.def.section;
+			value = h->root.u.def.value;
+		}
+		else
+			return FALSE;
+	}
+
+	if (sym_sec == NULL)
+		return FALSE;
+
+	slack = 0;
+	if (!bfd_is_abs_section (sym_sec))
+	{
+		/* merged strings move, their final offset is not known here */
+		if (discarded_section (sym_sec) || sym_sec->output_section == NULL
+			|| (sym_sec->flags & SEC_MERGE) != 0)
+			return FALSE;
+		value += sym_sec->output_section->vma + sym_sec->output_offset;
+		slack = AMO_LITERAL_SLACK;
+	}
+
+	value += wrel->r_addend;
+	sval = (bfd_signed_vma) (((value & 0xffffffff) ^ 0x80000000) - 0x80000000);
+
+	return sval >= AMO_SMIN (IMM21) + slack && sval <= AMO_SMAX (IMM21) - slack;
+}
+
+/* where REL points to, branches and literal loads are relative to the
+   next instruction */
+static bfd_vma
+amo_elf_reloc_target (const Elf_Internal_Rela *rel)
+{
+	switch (ELF32_R_TYPE (rel->r_info))
+	{
+		case R_AMO_LITERAL:
+		case R_AMO_PCREL:
+			return rel->r_addend + 4;
+		default:
+			return rel->r_addend;
+	}
+}
+
+static int
+amo_elf_pointer_compare (const void *a, const void *b)
+{
+	const void *pa = *(const void * const *) a;
+	const void *pb = *(const void * const *) b;
+
+	return pa < pb ? -1 : pa > pb;
+}
+
+/* bytes of the sorted WORDS deleted below ADDR */
+static bfd_vma
+amo_elf_deleted_below (const bfd_vma *words, unsigned int count, bfd_vma addr)
+{
+	unsigned int lo, hi, mid;
+
+	lo = 0;
+	hi = count;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (words[mid] < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return (bfd_vma) lo * 4;
+}
+
+/* remove the literal WORDS, sorted offsets in SEC, and move down
+   everything of the bfd that points behind them */
+static bfd_boolean
+amo_elf_delete_words (bfd *abfd, asection *sec, bfd_byte *contents,
+                      Elf_Internal_Rela *internal_relocs, Elf_Internal_Sym *isymbuf,
+                      const bfd_vma *words, unsigned int count)
+{
+	Elf_Internal_Shdr *symtab_hdr;
+	struct elf_link_hash_entry **sym_hashes, **end_hashes, **defs, *h;
+	Elf_Internal_Rela *irel, *irelend, *relocs;
+	Elf_Internal_Sym *isym, *isymend;
+	unsigned int sec_shndx, i, ndefs;
+	bfd_vma to, from, end, target;
+	asection *o;
+
+	symtab_hdr = &elf_tdata (abfd)->symtab_hdr;
+	sec_shndx = _bfd_elf_section_from_bfd_section (abfd, sec);
+
+	/* close the gaps in the contents */
+	to = words[0];
+	for (i = 0; i < count; i++)
+	{
+		from = words[i] + 4;
+		end = i + 1 < count ? words[i + 1] : sec->size;
+		memmove (contents + to, contents + from, end - from);
+		to += end - from;
+	}
+	sec->size = to;
+
+	irelend = internal_relocs + sec->reloc_count;
+	for (irel = internal_relocs; irel < irelend; irel++)
+		irel->r_offset -= amo_elf_deleted_below (words, count, irel->r_offset);
+
+	/* relocs through the section symbol carry the offset in the addend */
+	for (o = abfd->sections; o != NULL; o = o->next)
+	{
+		if ((o->flags & SEC_RELOC) == 0 || o->reloc_count == 0)
+			continue;
+
+		relocs = (o == sec ? internal_relocs
+		          : _bfd_elf_link_read_relocs (abfd, o, NULL, NULL, TRUE));
+		if (relocs == NULL)
+			return FALSE;
+
+		irelend = relocs + o->reloc_count;
+		for (irel = relocs; irel < irelend; irel++)
+		{
+			if (ELF32_R_SYM (irel->r_info) >= symtab_hdr->sh_info)
+				continue;
+
+			isym = isymbuf + ELF32_R_SYM (irel->r_info);
+			if (isym->st_shndx != sec_shndx || ELF_ST_TYPE (isym->st_info) != STT_SECTION)
+				continue;
+
+			target = amo_elf_reloc_target (irel);
+			irel->r_addend -= amo_elf_deleted_below (words, count, target);
+		}
+	}
+
+	isymend = isymbuf + symtab_hdr->sh_info;
+	for (isym = isymbuf; isym < isymend; isym++)
+	{
+		if (isym->st_shndx != sec_shndx)
+			continue;
+
+		end = isym->st_value + isym->st_size;
+		isym->st_value -= amo_elf_deleted_below (words, count, isym->st_value);
+		if (isym->st_size != 0)
+			isym->st_size = end - amo_elf_deleted_below (words, count, end) - isym->st_value;
+	}
+
+	/* --wrap can enter one definition twice, move each one only once */
+	sym_hashes = elf_sym_hashes (abfd);
+	end_hashes = sym_hashes + (symtab_hdr->sh_size / sizeof (Elf32_External_Sym)
+	                           - symtab_hdr->sh_info);
+	defs = (struct elf_link_hash_entry **) bfd_malloc ((end_hashes - sym_hashes + 1)
+	                                                   * sizeof (*defs));
+	if (defs == NULL)
+		return FALSE;
+	for (ndefs = 0; sym_hashes < end_hashes; sym_hashes++)
+	{
+		h = *sym_hashes;
+		if ((h->root.type == bfd_link_hash_defined
+			 || h->root.type == bfd_link_hash_defweak)
+			&& h->root.u.def.section == sec)
+			defs[ndefs++] = h;
+	}
+	qsort (defs, ndefs, sizeof (*defs), amo_elf_pointer_compare);
+
+	for (i = 0; i < ndefs; i++)
+	{
+		h = defs[i];
+		if (i > 0 && defs[i - 1] == h)
+			continue;
+
+		end = h->root.u.def.value + h->size;
+		h->root.u.def.value -= amo_elf_deleted_below (words, count, h->root.u.def.value);
+		if (h->size != 0)
+			h->size = end - amo_elf_deleted_below (words, count, end) - h->root.u.def.value;
+	}
+	free (defs);
+
+	return TRUE;
+}
+
+/* a stub is a single absolute jmp to the target of the branch */
+static bfd_boolean
+amo_elf_build_one_stub (struct bfd_hash_entry *gen_entry, void *in_arg)
+{
+	struct amo_elf_stub_hash_entry *hsh;
+	bfd_boolean *failed;
+	asection *stub_sec;
+	bfd_vma target;
+
+	hsh = (struct amo_elf_stub_hash_entry *) gen_entry;
+	failed = (bfd_boolean *) in_arg;
+	stub_sec = hsh->stub_sec;
+
+	hsh->stub_offset = stub_sec->size;
+	target = (hsh->target_value + hsh->target_section->output_section->vma
+	          + hsh->target_section->output_offset + hsh->addend + 4);
+
+	if ((target & 0x3) || (target & 0xffffffff) > (bfd_vma) AMO_MASK (IMM26) * BYTES_PER_INSTRUCTION)
+	{
+		/* xgettext:c-format */
+		_bfd_error_handler (_("%pB(%pA): branch target %#lx cannot be reached from a stub"),
+		                    hsh->target_section->owner, hsh->target_section,
+		                    (unsigned long) target);
+		bfd_set_error (bfd_error_bad_value);
+		*failed = TRUE;
+		return FALSE;
+	}
+
+	bfd_put_32 (stub_sec->owner, AMO_PUT (OPCODE, AMO_OP_JMPI) | AMO_PUT (IMM26, target >> 2),
+	            stub_sec->contents + hsh->stub_offset);
+	stub_sec->size += BYTES_PER_INSTRUCTION;
+
+	return TRUE;
+}
+
+/* as above, but only count the bytes */
+static bfd_boolean
+amo_elf_size_one_stub (struct bfd_hash_entry *gen_entry, void *in_arg ATTRIBUTE_UNUSED)
+{
+	struct amo_elf_stub_hash_entry *hsh;
+
+	hsh = (struct amo_elf_stub_hash_entry *) gen_entry;
+	hsh->stub_sec->size += BYTES_PER_INSTRUCTION;
+
+	return TRUE;
+}
+
+/* literal loads whose word fits the 21-bit immediate become mov, and a
+   word no load reads any more is deleted from the section.  The linker
+   calls us again while words go away, the values of the remaining ones
+   may fit once the code behind them moved down.  Only objects whose
+   pc-relative references all carry relocs can lose bytes.  */
+static bfd_boolean
+amo_elf_relax_section (bfd *abfd, asection *sec, struct bfd_link_info *link_info,
+                       bfd_boolean *again)
+{
+	struct amo_elf_link_hash_table *htab;
+	Elf_Internal_Shdr *symtab_hdr;
+	Elf_Internal_Rela *internal_relocs;
+	Elf_Internal_Rela *irel, *irelend, *wrel;
+	Elf_Internal_Rela **byoff = NULL;
+	Elf_Internal_Sym *isymbuf = NULL;
+	struct amo_elf_literal_ref *refs = NULL;
+	bfd_vma *words = NULL;
+	bfd_byte *contents = NULL;
+	unsigned int nrefs, nwords, i, j;
+	bfd_vma insn, word, value;
+
+	/* assume nothing changes */
+	*again = FALSE;
+
+	/* the stubs are sized on the relaxed code, nothing may move after that.
+	   The literal words must not change while the program runs, and a
+	   section aligned beyond a word could lose its inner alignment */
+	htab = amo_elf_hash_table (link_info);
+	if (bfd_link_relocatable (link_info)
+		|| htab == NULL
+		|| htab->stub_group != NULL
+		|| (elf_elfheader (abfd)->e_flags & EF_AMO_LINKRELAX_PREPARED) == 0
+		|| (sec->flags & SEC_RELOC) == 0
+		|| sec->reloc_count == 0
+		|| (sec->flags & SEC_CODE) == 0
+		|| (sec->flags & SEC_READONLY) == 0
+		|| sec->alignment_power > 2)
+		return TRUE;
+
+	symtab_hdr = &elf_tdata (abfd)->symtab_hdr;
+
+	/* the relocs are edited, they must stay cached for the next calls */
+	internal_relocs = _bfd_elf_link_read_relocs (abfd, sec, NULL, NULL, TRUE);
+	if (internal_relocs == NULL)
+		goto error_return;
+
+	if (elf_section_data (sec)->this_hdr.contents != NULL)
+		contents = elf_section_data (sec)->this_hdr.contents;
+	else if (!bfd_malloc_and_get_section (abfd, sec, &contents))
+		goto error_return;
+
+	isymbuf = (Elf_Internal_Sym *) symtab_hdr->contents;
+	if (isymbuf == NULL && symtab_hdr->sh_info != 0)
+	{
+		isymbuf = bfd_elf_get_elf_syms (abfd, symtab_hdr, symtab_hdr->sh_info,
+		                                0, NULL, NULL, NULL);
+		if (isymbuf == NULL)
+			goto error_return;
+	}
+
+	refs = (struct amo_elf_literal_ref *) bfd_malloc (sec->reloc_count * sizeof (*refs));
+	byoff = (Elf_Internal_Rela **) bfd_malloc (sec->reloc_count * sizeof (*byoff));
+	words = (bfd_vma *) bfd_malloc (sec->reloc_count * sizeof (*words));
+	if (refs == NULL || byoff == NULL || words == NULL)
+		goto error_return;
+
+	/* literal loads from a word of this section, the pools of the
+	   assembler are never shared between sections */
+	nrefs = 0;
+	irelend = internal_relocs + sec->reloc_count;
+	for (irel = internal_relocs; irel < irelend; irel++)
+	{
+		Elf_Internal_Sym *isym;
+
+		byoff[irel - internal_relocs] = irel;
+
+		if (ELF32_R_TYPE (irel->r_info) != R_AMO_LITERAL
+			|| ELF32_R_SYM (irel->r_info) >= symtab_hdr->sh_info)
+			continue;
+
+		isym = isymbuf + ELF32_R_SYM (irel->r_info);
+		if (bfd_section_from_elf_index (abfd, isym->st_shndx) != sec)
+			continue;
+
+		word = (ELF_ST_TYPE (isym->st_info) == STT_SECTION ? 0 : isym->st_value)
+		       + irel->r_addend + 4;
+		if ((word & 0x3) || word + 4 > sec->size)
+			continue;
+
+		insn = bfd_get_32 (abfd, contents + irel->r_offset);
+		if (AMO_GET (OPCODE, insn) != AMO_OP_LDR_REL)
+			continue;
+
+		refs[nrefs].word = word;
+		refs[nrefs].rel = irel;
+		nrefs++;
+	}
+
+	qsort (refs, nrefs, sizeof (*refs), amo_elf_literal_ref_compare);
+	qsort (byoff, sec->reloc_count, sizeof (*byoff), amo_elf_reloc_offset_compare);
+
+	/* all the loads of a word read the same value, they are relaxed
+	   together and the word goes with the last of them */
+	nwords = 0;
+	for (i = 0; i < nrefs; i = j)
+	{
+		word = refs[i].word;
+		for (j = i + 1; j < nrefs && refs[j].word == word; j++)
+			;
+
+		wrel = amo_elf_reloc_at (byoff, sec->reloc_count, word);
+		if (wrel != NULL)
+		{
+			if (ELF32_R_TYPE (wrel->r_info) != R_AMO_32
+				|| !amo_elf_literal_fits (abfd, symtab_hdr, isymbuf, wrel))
+				continue;
+			value = 0;
+		}
+		else
+		{
+			value = bfd_get_32 (abfd, contents + word);
+			if (((value + AMO_SIGN (IMM21)) & 0xffffffff) > AMO_MASK (IMM21))
+				continue;
+		}
+
+		for (; i < j; i++)
+		{
+			irel = refs[i].rel;
+			insn = bfd_get_32 (abfd, contents + irel->r_offset);
+			insn = AMO_PUT (OPCODE, AMO_OP_MOVI) | AMO_PUT (RA, AMO_GET (RA, insn)) | AMO_PUT (IMM21, value);
+			bfd_put_32 (abfd, insn, contents + irel->r_offset);
+
+			/* the mov takes the value straight from the symbol of the word */
+			if (wrel != NULL)
+			{
+				irel->r_info = ELF32_R_INFO (ELF32_R_SYM (wrel->r_info), R_AMO_21);
+				irel->r_addend = wrel->r_addend;
+			}
+			else
+			{
+				irel->r_info = ELF32_R_INFO (0, R_AMO_NONE);
+				irel->r_addend = 0;
+			}
+		}
+
+		if (wrel != NULL)
+		{
+			wrel->r_info = ELF32_R_INFO (0, R_AMO_NONE);
+			wrel->r_addend = 0;
+		}
+		words[nwords++] = word;
+	}
+
+	if (nwords != 0)
+	{
+		if (!amo_elf_delete_words (abfd, sec, contents, internal_relocs, isymbuf, words, nwords))
+			goto error_return;
+
+		/* keep the edited contents and symbols for the final link */
+		elf_section_data (sec)->relocs = internal_relocs;
+		elf_section_data (sec)->this_hdr.contents = contents;
+		symtab_hdr->contents = (unsigned char *) isymbuf;
+		*again = TRUE;
+	}
+
+	free (refs);
+	free (byoff);
+	free (words);
+
+	if (isymbuf != NULL && symtab_hdr->contents != (unsigned char *) isymbuf)
+	{
+		if (!link_info->keep_memory)
+			free (isymbuf);
+		else
+			symtab_hdr->contents = (unsigned char *) isymbuf;
+	}
+
+	if (contents != NULL && elf_section_data (sec)->this_hdr.contents != contents)
+	{
+		if (!link_info->keep_memory)
+			free (contents);
+		else
+			elf_section_data (sec)->this_hdr.contents = contents;
+	}
+
+	return TRUE;
+
+error_return:
+	free (refs);
+	free (byoff);
+	free (words);
+	if (isymbuf != NULL && symtab_hdr->contents != (unsigned char *) isymbuf)
+		free (isymbuf);
+	if (contents != NULL && elf_section_data (sec)->this_hdr.contents != contents)
+		free (contents);
+
+	return FALSE;
+}
+
+/* Set up various things so that we can make a list of input sections
+   for each output section included in the link.  Returns -1 on error,
+   0 when no stubs will be needed, and 1 on success.  */
+
+int
+amo_elf_setup_section_lists (bfd *output_bfd, struct bfd_link_info *info)
+{
+	struct amo_elf_link_hash_table *htab;
+	unsigned int top_id, top_index;
+	asection *section, **list;
+	bfd *input_bfd;
+
+	htab = amo_elf_hash_table (info);
+	if (htab == NULL)
+		return 0;
+
+	/* count the input sections */
+	for (input_bfd = info->input_bfds, top_id = 0;
+		 input_bfd != NULL;
+		 input_bfd = input_bfd->link.next)
+	{
+		for (section = input_bfd->sections; section != NULL; section = section->next)
+		{
+			if (top_id < section->id)
+				top_id = section->id;
+		}
+	}
+
+	htab->top_id = top_id;
+	htab->stub_group = (struct map_stub *) bfd_zmalloc (sizeof (struct map_stub) * (top_id + 1));
+	if (htab->stub_group == NULL)
+		return -1;
+
+	/* We can't use output_bfd->section_count here to find the top output
+	   section index as some sections may have been removed, and
+	   strip_excluded_output_sections doesn't renumber the indices.  */
+	for (section = output_bfd->sections, top_index = 0;
+		 section != NULL;
+		 section = section->next)
+	{
+		if (top_index < section->index)
+			top_index = section->index;
+	}
+
+	htab->top_index = top_index;
+	htab->input_list = (asection **) bfd_malloc (sizeof (asection *) * (top_index + 1));
+	if (htab->input_list == NULL)
+		return -1;
+
+	/* only the code sections are grouped, the others are marked */
+	list = htab->input_list + top_index;
+	do
+		*list = bfd_abs_section_ptr;
+	while (list-- != htab->input_list);
+
+	for (section = output_bfd->sections; section != NULL; section = section->next)
+	{
+		if ((section->flags & SEC_CODE) != 0)
+			htab->input_list[section->index] = NULL;
+	}
+
+	return 1;
+}
+
+/* The linker repeatedly calls this function for each input section,
+   in the order that input sections are linked into output sections.
+   Build lists of input sections to determine groupings between which
+   we may insert linker stubs.  */
+
+void
+amo_elf_next_input_section (struct bfd_link_info *info, asection *isec)
+{
+	struct amo_elf_link_hash_table *htab;
+	asection **list;
+
+	htab = amo_elf_hash_table (info);
+	if (htab == NULL || isec->output_section->index > htab->top_index)
+		return;
+
+	list = htab->input_list + isec->output_section->index;
+	if (*list != bfd_abs_section_ptr)
+	{
+		/* Steal the link_sec pointer for our list.  */
+#define PREV_SEC(sec) (htab->stub_group[(sec)->id].link_sec)
+		/* This happens to make the list in reverse order,
+		   which is what we want.  */
+		PREV_SEC (isec) = *list;
+		*list = isec;
+	}
+}
+
+/* Cut the input sections of each output section into groups small
+   enough that every branch of a group reaches the stub section placed
+   before its first section.  A section larger than the group size is
+   a group on its own, its far branches may still not reach.  */
+
+static void
+amo_elf_group_sections (struct amo_elf_link_hash_table *htab, bfd_size_type stub_group_size,
+                        bfd_boolean stubs_always_before_branch)
+{
+	asection **list = htab->input_list + htab->top_index;
+
+	do
+	{
+		asection *tail = *list;
+
+		if (tail == bfd_abs_section_ptr)
+			continue;
+
+		while (tail != NULL)
+		{
+			asection *curr, *prev;
+			bfd_size_type total;
+			bfd_boolean big_sec;
+
+			curr = tail;
+			total = tail->size;
+			big_sec = total >= stub_group_size;
+
+			while ((prev = PREV_SEC (curr)) != NULL
+				   && ((total += curr->output_offset - prev->output_offset)
+					   < stub_group_size))
+				curr = prev;
+
+			/* the sections from CURR to TAIL share the stubs */
+			do
+			{
+				prev = PREV_SEC (tail);
+				htab->stub_group[tail->id].link_sec = curr;
+			}
+			while (tail != curr && (tail = prev) != NULL);
+
+			/* the sections before the stubs can use them too, unless the
+			   group behind them is too large already */
+			if (!stubs_always_before_branch && !big_sec)
+			{
+				total = 0;
+				while (prev != NULL
+					   && ((total += tail->output_offset - prev->output_offset)
+						   < stub_group_size))
+				{
+					tail = prev;
+					prev = PREV_SEC (tail);
+					htab->stub_group[tail->id].link_sec = curr;
+				}
+			}
+			tail = prev;
+		}
+	}
+	while (list-- != htab->input_list);
+
+	free (htab->input_list);
+	htab->input_list = NULL;
+#undef PREV_SEC
+}
+
+/* Determine and set the size of the stub sections for a final link.
+   Every conditional branch whose target is out of reach gets a veneer
+   in the stub section of its group.  The stubs move the code behind
+   them, so the sections are laid out again until no new stub is
+   needed.  */
+
+bfd_boolean
+amo_elf_size_stubs (bfd *output_bfd, bfd *stub_bfd, struct bfd_link_info *info,
+                    bfd_signed_vma group_size,
+                    asection *(*add_stub_section) (const char *, asection *),
+                    void (*layout_sections_again) (void))
+{
+	struct amo_elf_link_hash_table *htab;
+	bfd_size_type stub_group_size;
+	bfd_boolean stubs_always_before_branch;
+	bfd_boolean stub_changed;
+
+	htab = amo_elf_hash_table (info);
+	if (htab == NULL)
+		return FALSE;
+
+	/* stash our params away */
+	htab->stub_bfd = stub_bfd;
+	htab->add_stub_section = add_stub_section;
+	htab->layout_sections_again = layout_sections_again;
+
+	stubs_always_before_branch = group_size < 0;
+	stub_group_size = group_size < 0 ? -group_size : group_size;
+	if (stub_group_size == 1)
+		stub_group_size = AMO_STUB_GROUP_SIZE;
+
+	amo_elf_group_sections (htab, stub_group_size, stubs_always_before_branch);
+
+	do
+	{
+		bfd *input_bfd;
+		asection *stub_sec;
+
+		stub_changed = FALSE;
+		for (input_bfd = info->input_bfds; input_bfd != NULL; input_bfd = input_bfd->link.next)
+		{
+			Elf_Internal_Shdr *symtab_hdr;
+			Elf_Internal_Sym *local_syms;
+			asection *section;
+
+			if (bfd_get_flavour (input_bfd) != bfd_target_elf_flavour)
+				continue;
+
+			/* cache the local symbols for elf_link_input_bfd */
+			symtab_hdr = &elf_tdata (input_bfd)->symtab_hdr;
+			local_syms = (Elf_Internal_Sym *) symtab_hdr->contents;
+			if (local_syms == NULL && symtab_hdr->sh_info != 0)
+			{
+				local_syms = bfd_elf_get_elf_syms (input_bfd, symtab_hdr, symtab_hdr->sh_info,
+				                                   0, NULL, NULL, NULL);
+				if (local_syms == NULL)
+					return FALSE;
+				symtab_hdr->contents = (unsigned char *) local_syms;
+			}
+
+			for (section = input_bfd->sections; section != NULL; section = section->next)
+			{
+				Elf_Internal_Rela *internal_relocs, *irela, *irelaend;
+
+				/* If this section is a link-once section that will be
+				   discarded, then don't create any stubs.  */
+				if ((section->flags & SEC_RELOC) == 0
+					|| section->reloc_count == 0
+					|| section->output_section == NULL
+					|| section->output_section->owner != output_bfd
+					|| section->id > htab->top_id
+					|| htab->stub_group[section->id].link_sec == NULL)
+					continue;
+
+				internal_relocs = _bfd_elf_link_read_relocs (input_bfd, section, NULL, NULL,
+				                                             info->keep_memory);
+				if (internal_relocs == NULL)
+					return FALSE;
+
+				irelaend = internal_relocs + section->reloc_count;
+				for (irela = internal_relocs; irela < irelaend; irela++)
+				{
+					struct amo_elf_stub_hash_entry *hsh;
+					struct elf_link_hash_entry *h;
+					unsigned long r_indx;
+					asection *sym_sec;
+					bfd_vma sym_value, location;
+					bfd_signed_vma value;
+					char *stub_name;
+
+					if (ELF32_R_TYPE (irela->r_info) != R_AMO_PCREL)
+						continue;
+
+					r_indx = ELF32_R_SYM (irela->r_info);
+					h = NULL;
+					if (r_indx < symtab_hdr->sh_info)
+					{
+						Elf_Internal_Sym *sym;
+
+						sym = local_syms + r_indx;
+						sym_sec = bfd_section_from_elf_index (input_bfd, sym->st_shndx);
+						if (sym_sec == NULL || sym->st_shndx == SHN_UNDEF)
+							continue;
+						sym_value = ELF_ST_TYPE (sym->st_info) == STT_SECTION ? 0 : sym->st_value;
+					}
+					else
+					{
+						h = elf_sym_hashes (input_bfd)[r_indx - symtab_hdr->sh_info];
+						while (h->root.type == bfd_link_hash_indirect
+							   || h->root.type == bfd_link_hash_warning)
+							h = (struct elf_link_hash_entry *) h->root.u.i.link;
+
+						/* leave undefined symbols to amo_elf_relocate_section */
+						if (h->root.type != bfd_link_hash_defined
+							&& h->root.type != bfd_link_hash_defweak)
+							continue;
+						sym_sec = h->root.u.def.section;
+						sym_value = h->root.u.def.value;
+					}
+
+					if (discarded_section (sym_sec) || sym_sec->output_section == NULL)
+						continue;
+
+					location = section->output_section->vma + section->output_offset + irela->r_offset;
+					value = (bfd_signed_vma) (sym_value + sym_sec->output_section->vma
+					                          + sym_sec->output_offset + irela->r_addend - location);
+					if (value >= AMO_PCREL_MIN && value <= AMO_PCREL_MAX)
+						continue;
+
+					stub_name = amo_elf_stub_name (htab->stub_group[section->id].link_sec,
+					                               sym_sec, h, irela);
+
+					/* the proper stub may exist already, a new one keeps the name */
+					hsh = NULL;
+					if (stub_name != NULL)
+					{
+						hsh = amo_stub_hash_lookup (&htab->bstab, stub_name, FALSE, FALSE);
+						if (hsh != NULL)
+							free (stub_name);
+						else if ((hsh = amo_elf_add_stub (stub_name, section, htab)) == NULL)
+							free (stub_name);
+						else
+						{
+							hsh->target_value = sym_value;
+							hsh->target_section = sym_sec;
+							hsh->addend = irela->r_addend;
+							stub_changed = TRUE;
+						}
+					}
+
+					if (hsh == NULL)
+					{
+						if (elf_section_data (section)->relocs != internal_relocs)
+							free (internal_relocs);
+						return FALSE;
+					}
+				}
+
+				if (elf_section_data (section)->relocs != internal_relocs)
+					free (internal_relocs);
+			}
+		}
+
+		if (stub_changed)
+		{
+			/* every stub is a single jmp */
+			for (stub_sec = htab->stub_bfd->sections; stub_sec != NULL; stub_sec = stub_sec->next)
+				stub_sec->size = 0;
+			bfd_hash_traverse (&htab->bstab, amo_elf_size_one_stub, htab);
+
+			(*htab->layout_sections_again) ();
+		}
+	}
+	while (stub_changed);
+
+	return TRUE;
+}
+
+/* Build all the stubs associated with the current output file.  The
+   stubs are kept in a hash table attached to the main linker hash
+   table.  This function is called via amoelf_after_allocation in the
+   linker.  */
+
+bfd_boolean
+amo_elf_build_stubs (struct bfd_link_info *info)
+{
+	struct amo_elf_link_hash_table *htab;
+	asection *stub_sec;
+	bfd_boolean failed;
+
+	htab = amo_elf_hash_table (info);
+	if (htab == NULL)
+		return FALSE;
+
+	for (stub_sec = htab->stub_bfd->sections; stub_sec != NULL; stub_sec = stub_sec->next)
+	{
+		stub_sec->contents = (bfd_byte *) bfd_zalloc (htab->stub_bfd, stub_sec->size);
+		if (stub_sec->contents == NULL && stub_sec->size != 0)
+			return FALSE;
+		stub_sec->size = 0;
+	}
+
+	failed = FALSE;
+	bfd_hash_traverse (&htab->bstab, amo_elf_build_one_stub, &failed);
+
+	return !failed;
+}
+
 #define ELF_ARCH bfd_arch_amo
+#define ELF_TARGET_ID AMO_ELF_DATA
 #define ELF_MACHINE_CODE EM_AMO
 
 #define ELF_MAXPAGESIZE 0x1000
@@ -200,6 +1529,11 @@ amo_elf_relative_reloc(bfd *abfd, arelent *r_entry, asymbol *sym,
 #define elf_info_to_howto_rel NULL
 #define bfd_elf32_bfd_reloc_type_lookup	amo_reloc_type_lookup
 #define bfd_elf32_bfd_reloc_name_lookup amo_reloc_name_lookup
+#define bfd_elf32_bfd_link_hash_table_create amo_elf_link_hash_table_create
+#define bfd_elf32_bfd_relax_section amo_elf_relax_section
+
+#define elf_backend_relocate_section amo_elf_relocate_section
+#define elf_backend_rela_normal 1
 
 /* this header has to be included at the end */
 #include "elf32-target.h"
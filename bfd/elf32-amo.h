@@ -0,0 +1,37 @@
+/* AMO ELF linker support.
+   Copyright (C) 2000-2024 Free Software Foundation, Inc.
+
+   This file is part of BFD, the Binary File Descriptor library.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+#ifndef _ELF32_AMO_H
+#define _ELF32_AMO_H
+
+extern int amo_elf_setup_section_lists
+  (bfd *, struct bfd_link_info *);
+
+extern void amo_elf_next_input_section
+  (struct bfd_link_info *, asection *);
+
+extern bfd_boolean amo_elf_size_stubs
+  (bfd *, bfd *, struct bfd_link_info *, bfd_signed_vma,
+   asection * (*) (const char *, asection *), void (*) (void));
+
+extern bfd_boolean amo_elf_build_stubs
+  (struct bfd_link_info *);
+
+#endif  /* _ELF32_AMO_H */
@@ -0,0 +1,1071 @@
+/* amo-run.c -- Instruction-level simulator for AMO executables
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of GNU Binutils.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* The executable is loaded into a flat memory through BFD and run by an
+   interpreter working on predecoded basic blocks: a block is decoded the
+   first time control reaches it and then executed from the cache.
+
+   Besides the instruction set, the simulator defines the following:
+   - memory starts at address 0, sp is set to the end of the memory;
+   - swi 0 exits with r1 as status, swi 1 writes the byte r1 to stdout,
+     swi 2 reads a byte from stdin into r1 (-1 at end of file) and
+     swi 3 writes r3 bytes at r2 to the file descriptor r1;
+   - setvt and lock do nothing, there are no interrupts;
+   - an instruction costs one cycle, loads and stores one more and a
+     taken branch or jump one more for the refill.
+
+   With --profile the cycles of each instruction are written to a
+   gmon.out histogram, calls made by jal to the call graph and the
+   execution count of each block to the basic-block records, so gprof
+   reports the cycles and the instruction counts of each function.  */
+
+#include "sysdep.h"
+#include "bfd.h"
+#include "libiberty.h"
+#include "getopt.h"
+#include "bucomm.h"
+#include "opcode/amo.h"
+
+/* the longest straight-line run kept in one block */
+#define AMO_BLOCK_INSN_MAX 64
+
+/* initial size of the call graph arc table, a power of two */
+#define AMO_ARC_TABLE_SIZE_DEFAULT 256
+
+#define AMO_MEMORY_SIZE_DEFAULT 0x1000000
+
+#define AMO_REG_SP 30
+#define AMO_REG_LR 31
+
+/* one predecoded instruction */
+struct amo_insn
+{
+	unsigned char opcode;
+	unsigned char rd;
+	unsigned char rs;
+	unsigned char rt;
+
+	/* sign or zero extended immediate, absolute for pc-relative operands */
+	uint32_t imm;
+};
+
+/* straight-line code ending with a control transfer */
+struct amo_block
+{
+	uint32_t start;
+	unsigned int count;
+
+	/* cycles of one run, without the refill of a taken exit */
+	unsigned int cycles;
+
+	/* profile */
+	unsigned long long executed;
+	unsigned long long taken;
+
+	struct amo_insn insns[1];
+};
+
+/* one call graph arc */
+struct amo_arc
+{
+	uint32_t from;
+	uint32_t to;
+	unsigned long long count;
+};
+
+/* cycles of each opcode, 0 for the unused ones */
+static unsigned char amo_cycles[OPCODE_NUMBER_MAX];
+
+static struct
+{
+	uint32_t regs[32];
+	uint32_t pc;
+	unsigned int carry;
+
+	unsigned long long insns;
+	unsigned long long cycles;
+
+	/* a store hit the code, the blocks must be decoded again */
+	bfd_boolean code_written;
+	bfd_boolean halted;
+	int status;
+} cpu;
+
+static bfd_byte *memory;
+static uint32_t memory_size = AMO_MEMORY_SIZE_DEFAULT;
+
+/* extent of the loaded image, the code must live in it */
+static uint32_t image_lo, image_hi;
+static uint32_t code_lo, code_hi;
+
+/* one block slot per word of the image */
+static struct amo_block **blocks;
+static unsigned long blocks_decoded;
+
+/* per-word profile of the retired blocks */
+static unsigned long long *profile_cycles;
+static unsigned long long *profile_entries;
+
+static struct amo_arc *arcs;
+static unsigned int arc_count, arc_size;
+
+/* options */
+static int show_version = 0;
+static int show_help = 0;
+static int show_statistics = 0;
+static int do_profile = 0;
+static const char *profile_name = "gmon.out";
+static unsigned long long insn_limit = 0;
+
+static void
+usage (FILE *stream, int status)
+{
+	fprintf (stream, _("Usage: %s [option(s)] file\n"), program_name);
+	fprintf (stream, _(" Runs an AMO executable\n"));
+	fprintf (stream, _(" The options are:\n\
+  -p --profile               Write a gprof profile of the cycles spent\n\
+  -o --profile-output=<file> Name of the profile (default is gmon.out)\n\
+  -m --memory-size=<bytes>   Size of the simulated memory (default is 16MiB)\n\
+  -l --limit=<count>         Stop after <count> instructions\n\
+  -s --statistics            Print the instruction and cycle counts\n\
+  @<file>                    Read options from <file>\n\
+  -h --help                  Display this information\n\
+  -v --version               Display the program's version\n\
+\n"));
+	if (REPORT_BUGS_TO[0] && status == 0)
+		fprintf (stream, _("Report bugs to %s\n"), REPORT_BUGS_TO);
+	exit (status);
+}
+
+static struct option long_options[] =
+{
+	{"profile", no_argument, 0, 'p'},
+	{"profile-output", required_argument, 0, 'o'},
+	{"memory-size", required_argument, 0, 'm'},
+	{"limit", required_argument, 0, 'l'},
+	{"statistics", no_argument, 0, 's'},
+	{"version", no_argument, &show_version, 1},
+	{"help", no_argument, &show_help, 1},
+	{0, no_argument, 0, 0}
+};
+
+/* the opcode dispatch table of libopcodes tells which opcodes exist */
+static void
+amo_decode_init (void)
+{
+	const amo_opcode_t *op;
+	unsigned int i;
+
+	for (i = 0; i < OPCODE_NUMBER_MAX; i++)
+	{
+		op = amo_dispatch_table[i];
+		if (!op)
+			continue;
+
+		amo_cycles[i] = 1;
+
+		/* memory accesses */
+		switch (op->format)
+		{
+			case AMO_FORMAT_LOAD_REL: case AMO_FORMAT_LOAD:
+			case AMO_FORMAT_STORE_REL: case AMO_FORMAT_STORE:
+				amo_cycles[i]++;
+				break;
+		}
+	}
+}
+
+static inline uint32_t
+sext (uint32_t value, unsigned int bits)
+{
+	uint32_t sign;
+
+	sign = 1U << (bits - 1);
+	value &= (sign << 1) - 1;
+	return (value ^ sign) - sign;
+}
+
+static bfd_boolean
+amo_is_control (unsigned char opcode)
+{
+	switch (amo_dispatch_table[opcode]->format)
+	{
+		case AMO_FORMAT_BRANCH: case AMO_FORMAT_JUMP: case AMO_FORMAT_JUMP_REG:
+		case AMO_FORMAT_SWI:
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* split BINARY at PC into the fields used by the interpreter */
+static bfd_boolean
+amo_decode (uint32_t binary, uint32_t pc, struct amo_insn *insn)
+{
+	const amo_opcode_t *op;
+	unsigned char opcode;
+
+	opcode = AMO_GET (OPCODE, binary);
+	op = amo_dispatch_table[opcode];
+	if (!op)
+		return FALSE;
+
+	insn->opcode = opcode;
+	insn->rd = insn->rs = insn->rt = 0;
+	insn->imm = 0;
+
+	switch (op->format)
+	{
+		/* the arithmetic immediate is signed */
+		case AMO_FORMAT_ARITH_IMM:
+			insn->rs = AMO_GET (RA, binary);
+			insn->rd = AMO_GET (RB, binary);
+			insn->imm = AMO_SEXT (IMM16, binary);
+			break;
+
+		/* the logical immediate is not */
+		case AMO_FORMAT_LOGIC_IMM:
+			insn->rs = AMO_GET (RA, binary);
+			insn->rd = AMO_GET (RB, binary);
+			insn->imm = AMO_GET (IMM16, binary);
+			break;
+
+		case AMO_FORMAT_REG3:
+			insn->rs = AMO_GET (RA, binary);
+			insn->rt = AMO_GET (RB, binary);
+			insn->rd = AMO_GET (RC, binary);
+			break;
+
+		case AMO_FORMAT_NOT_IMM:
+			insn->rd = AMO_GET (RB, binary);
+			insn->imm = AMO_GET (IMM16, binary);
+			break;
+
+		case AMO_FORMAT_NOT_REG:
+			insn->rs = AMO_GET (RB, binary);
+			insn->rd = AMO_GET (RC, binary);
+			break;
+
+		case AMO_FORMAT_MOV_IMM:
+			insn->rd = AMO_GET (RA, binary);
+			insn->imm = AMO_SEXT (IMM21, binary);
+			break;
+
+		case AMO_FORMAT_MOV_REG:
+			insn->rd = AMO_GET (RA, binary);
+			insn->rs = AMO_GET (RB, binary);
+			break;
+
+		/* the address of a pc-relative access is known now */
+		case AMO_FORMAT_LOAD_REL:
+			insn->rd = AMO_GET (RA, binary);
+			insn->imm = pc + 4 + AMO_SEXT (IMM21, binary);
+			break;
+
+		case AMO_FORMAT_STORE_REL:
+			insn->rt = AMO_GET (RA, binary);
+			insn->imm = pc + 4 + AMO_SEXT (IMM21, binary);
+			break;
+
+		case AMO_FORMAT_LOAD:
+			insn->rs = AMO_GET (RA, binary);
+			insn->rd = AMO_GET (RB, binary);
+			insn->imm = AMO_SEXT (IMM16, binary);
+			break;
+
+		case AMO_FORMAT_STORE:
+			insn->rs = AMO_GET (RA, binary);
+			insn->rt = AMO_GET (RB, binary);
+			insn->imm = AMO_SEXT (IMM16, binary);
+			break;
+
+		case AMO_FORMAT_BRANCH:
+			insn->rs = AMO_GET (RA, binary);
+			insn->rt = AMO_GET (RB, binary);
+			insn->imm = pc + 4 + AMO_SEXT (IMM16, binary) * 4;
+			break;
+
+		case AMO_FORMAT_JUMP:
+			insn->imm = AMO_GET (IMM26, binary) << 2;
+			break;
+
+		case AMO_FORMAT_JUMP_REG:
+			insn->rs = AMO_GET (RA, binary);
+			break;
+
+		case AMO_FORMAT_SWI:
+			insn->imm = AMO_GET (IMM8, binary);
+			break;
+
+		case AMO_FORMAT_SETVT:
+			insn->rs = AMO_GET (RA, binary);
+			insn->imm = AMO_GET (IMM16, binary);
+			break;
+
+		case AMO_FORMAT_NONE:
+			break;
+
+		default:
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+amo_halt (int status, const char *message, uint32_t pc)
+{
+	if (message)
+		non_fatal (_("%s at pc 0x%08x"), message, pc);
+	cpu.halted = TRUE;
+	cpu.status = status;
+}
+
+/* decode the block starting at PC */
+static struct amo_block *
+amo_block_decode (uint32_t pc)
+{
+	struct amo_block *block;
+	struct amo_insn insns[AMO_BLOCK_INSN_MAX];
+	unsigned int count, cycles;
+	uint32_t addr;
+
+	count = cycles = 0;
+	for (addr = pc; addr < image_hi && count < AMO_BLOCK_INSN_MAX; addr += 4)
+	{
+		if (!amo_decode (bfd_getl32 (memory + addr), addr, &insns[count]))
+		{
+			/* run the block up to the invalid instruction, fault when reached */
+			if (count == 0)
+			{
+				amo_halt (1, _("illegal instruction"), addr);
+				return NULL;
+			}
+			break;
+		}
+
+		cycles += amo_cycles[insns[count].opcode];
+		if (amo_is_control (insns[count++].opcode))
+			break;
+	}
+
+	block = (struct amo_block *) xmalloc (sizeof (*block) + (count - 1) * sizeof (struct amo_insn));
+	block->start = pc;
+	block->count = count;
+	block->cycles = cycles;
+	block->executed = 0;
+	block->taken = 0;
+	memcpy (block->insns, insns, count * sizeof (struct amo_insn));
+
+	blocks[(pc - image_lo) >> 2] = block;
+	blocks_decoded++;
+	return block;
+}
+
+/* fold the counters of BLOCK into the per-word profile */
+static void
+amo_block_retire (struct amo_block *block)
+{
+	unsigned long i, slot;
+	unsigned int last;
+
+	if (profile_cycles == NULL || block->executed == 0)
+		return;
+
+	slot = (block->start - image_lo) >> 2;
+	profile_entries[slot] += block->executed;
+	for (i = 0; i < block->count; i++)
+		profile_cycles[slot + i] += block->executed * amo_cycles[block->insns[i].opcode];
+
+	/* the refill is charged to the exit */
+	last = block->count - 1;
+	profile_cycles[slot + last] += block->taken;
+}
+
+/* BLOCK was counted whole but only its first RAN instructions executed,
+   charge those to the profile directly and drop the rest */
+static void
+amo_block_cut (struct amo_block *block, unsigned int ran)
+{
+	unsigned long slot;
+	unsigned int i;
+
+	block->executed--;
+	cpu.insns -= block->count - ran;
+	for (i = ran; i < block->count; i++)
+		cpu.cycles -= amo_cycles[block->insns[i].opcode];
+
+	if (profile_cycles == NULL)
+		return;
+
+	slot = (block->start - image_lo) >> 2;
+	profile_entries[slot]++;
+	for (i = 0; i < ran; i++)
+		profile_cycles[slot + i] += amo_cycles[block->insns[i].opcode];
+}
+
+static void
+amo_blocks_flush (void)
+{
+	unsigned long i;
+
+	for (i = 0; i < (unsigned long) (image_hi - image_lo) >> 2; i++)
+	{
+		if (blocks[i])
+		{
+			amo_block_retire (blocks[i]);
+			free (blocks[i]);
+			blocks[i] = NULL;
+		}
+	}
+}
+
+static void
+amo_arc_record (uint32_t from, uint32_t to)
+{
+	struct amo_arc *old;
+	unsigned int i, old_size, hash;
+
+	hash = (from >> 2) * 2654435761U;
+	for (i = hash & (arc_size - 1); arcs[i].count; i = (i + 1) & (arc_size - 1))
+	{
+		if (arcs[i].from == from && arcs[i].to == to)
+		{
+			arcs[i].count++;
+			return;
+		}
+	}
+
+	arcs[i].from = from;
+	arcs[i].to = to;
+	arcs[i].count = 1;
+
+	/* keep the table half empty */
+	if (++arc_count * 2 < arc_size)
+		return;
+
+	old = arcs;
+	old_size = arc_size;
+	arc_size *= 2;
+	arcs = (struct amo_arc *) xcalloc (arc_size, sizeof (struct amo_arc));
+	for (i = 0; i < old_size; i++)
+	{
+		unsigned int j;
+
+		if (!old[i].count)
+			continue;
+		hash = (old[i].from >> 2) * 2654435761U;
+		for (j = hash & (arc_size - 1); arcs[j].count; j = (j + 1) & (arc_size - 1))
+			;
+		arcs[j] = old[i];
+	}
+	free (old);
+}
+
+static inline bfd_byte *
+amo_memory (uint32_t addr, uint32_t size, uint32_t pc)
+{
+	if (addr > memory_size - size || (addr & (size - 1)))
+	{
+		amo_halt (1, _("bad memory access"), pc);
+		return NULL;
+	}
+	return memory + addr;
+}
+
+static inline void
+amo_store_check (uint32_t addr)
+{
+	if (addr >= code_lo && addr < code_hi)
+		cpu.code_written = TRUE;
+}
+
+static void
+amo_service (unsigned int number, uint32_t pc)
+{
+	uint32_t *regs = cpu.regs;
+	bfd_byte *buf;
+	int c;
+
+	switch (number)
+	{
+		case 0:
+			amo_halt ((int) regs[1], NULL, pc);
+			break;
+
+		case 1:
+			putchar (regs[1] & 0xff);
+			break;
+
+		case 2:
+			fflush (stdout);
+			c = getchar ();
+			regs[1] = c == EOF ? (uint32_t) -1 : (uint32_t) c;
+			break;
+
+		case 3:
+			if (regs[3] > memory_size || regs[2] > memory_size - regs[3])
+			{
+				amo_halt (1, _("bad memory access"), pc);
+				break;
+			}
+			buf = memory + regs[2];
+			fflush (stdout);
+			regs[1] = write (regs[1], buf, regs[3]);
+			break;
+
+		default:
+			amo_halt (1, _("unknown software interrupt"), pc);
+			break;
+	}
+}
+
+/* run from the current pc until the program exits */
+static void
+amo_run (void)
+{
+	uint32_t *regs = cpu.regs;
+	struct amo_block *block;
+	struct amo_insn *insn, *end;
+	bfd_byte *p;
+	uint32_t pc, next, a, b, r;
+	unsigned long slot;
+
+	while (!cpu.halted)
+	{
+		pc = cpu.pc;
+		slot = (pc - image_lo) >> 2;
+		if (pc < image_lo || pc >= image_hi || (pc & 3))
+		{
+			amo_halt (1, _("jump outside of the program"), pc);
+			break;
+		}
+
+		block = blocks[slot];
+		if (block == NULL && (block = amo_block_decode (pc)) == NULL)
+			break;
+
+		block->executed++;
+		cpu.insns += block->count;
+		cpu.cycles += block->cycles;
+		next = block->start + block->count * 4;
+
+		end = block->insns + block->count;
+		for (insn = block->insns; insn < end && !cpu.halted && !cpu.code_written; insn++, pc += 4)
+		{
+			switch (insn->opcode)
+			{
+				case AMO_OP_ADDI:
+				case AMO_OP_ADD:
+					a = regs[insn->rs];
+					b = insn->opcode == AMO_OP_ADDI ? insn->imm : regs[insn->rt];
+					r = a + b;
+					cpu.carry = r < a;
+					regs[insn->rd] = r;
+					break;
+
+				case AMO_OP_ADCI:
+				case AMO_OP_ADC:
+					a = regs[insn->rs];
+					b = insn->opcode == AMO_OP_ADCI ? insn->imm : regs[insn->rt];
+					r = a + b + cpu.carry;
+					cpu.carry = cpu.carry ? r <= a : r < a;
+					regs[insn->rd] = r;
+					break;
+
+				case AMO_OP_SUBI:
+				case AMO_OP_SUB:
+					a = regs[insn->rs];
+					b = insn->opcode == AMO_OP_SUBI ? insn->imm : regs[insn->rt];
+					/* the carry is the borrow */
+					cpu.carry = a < b;
+					regs[insn->rd] = a - b;
+					break;
+
+				case AMO_OP_ANDI: regs[insn->rd] = regs[insn->rs] & insn->imm; break;
+				case AMO_OP_AND: regs[insn->rd] = regs[insn->rs] & regs[insn->rt]; break;
+				case AMO_OP_ORI: regs[insn->rd] = regs[insn->rs] | insn->imm; break;
+				case AMO_OP_OR: regs[insn->rd] = regs[insn->rs] | regs[insn->rt]; break;
+				case AMO_OP_XORI: regs[insn->rd] = regs[insn->rs] ^ insn->imm; break;
+				case AMO_OP_XOR: regs[insn->rd] = regs[insn->rs] ^ regs[insn->rt]; break;
+				case AMO_OP_NOTI: regs[insn->rd] = ~insn->imm; break;
+				case AMO_OP_NOT: regs[insn->rd] = ~regs[insn->rs]; break;
+
+				case AMO_OP_LSLI:
+				case AMO_OP_LSL:
+					b = insn->opcode == AMO_OP_LSLI ? insn->imm : regs[insn->rt];
+					regs[insn->rd] = b >= 32 ? 0 : regs[insn->rs] << b;
+					break;
+
+				case AMO_OP_LSRI:
+				case AMO_OP_LSR:
+					b = insn->opcode == AMO_OP_LSRI ? insn->imm : regs[insn->rt];
+					regs[insn->rd] = b >= 32 ? 0 : regs[insn->rs] >> b;
+					break;
+
+				case AMO_OP_ASRI:
+				case AMO_OP_ASR:
+					b = insn->opcode == AMO_OP_ASRI ? insn->imm : regs[insn->rt];
+					a = regs[insn->rs];
+					if (b >= 32)
+						b = 31;
+					regs[insn->rd] = (a >> b) | ((a & 0x80000000) ? ~(0xffffffffU >> b) : 0);
+					break;
+
+				/* sign extension of the low IMM bits */
+				case AMO_OP_EXT:
+					a = regs[insn->rs];
+					regs[insn->rd] = (insn->imm == 0 || insn->imm >= 32) ? a : sext (a, insn->imm);
+					break;
+
+				case AMO_OP_MOVI: regs[insn->rd] = insn->imm; break;
+				case AMO_OP_MOV: regs[insn->rd] = regs[insn->rs]; break;
+
+				case AMO_OP_LDR_REL:
+				case AMO_OP_LDR:
+					a = insn->opcode == AMO_OP_LDR ? regs[insn->rs] + insn->imm : insn->imm;
+					if ((p = amo_memory (a, 4, pc)) != NULL)
+						regs[insn->rd] = bfd_getl32 (p);
+					break;
+
+				case AMO_OP_LDRH_REL:
+				case AMO_OP_LDRH:
+					a = insn->opcode == AMO_OP_LDRH ? regs[insn->rs] + insn->imm : insn->imm;
+					if ((p = amo_memory (a, 2, pc)) != NULL)
+						regs[insn->rd] = bfd_getl16 (p);
+					break;
+
+				case AMO_OP_LDRB_REL:
+				case AMO_OP_LDRB:
+					a = insn->opcode == AMO_OP_LDRB ? regs[insn->rs] + insn->imm : insn->imm;
+					if ((p = amo_memory (a, 1, pc)) != NULL)
+						regs[insn->rd] = *p;
+					break;
+
+				case AMO_OP_STR_REL:
+				case AMO_OP_STR:
+					a = insn->opcode == AMO_OP_STR ? regs[insn->rs] + insn->imm : insn->imm;
+					if ((p = amo_memory (a, 4, pc)) != NULL)
+					{
+						bfd_putl32 (regs[insn->rt], p);
+						amo_store_check (a);
+					}
+					break;
+
+				case AMO_OP_STRH_REL:
+				case AMO_OP_STRH:
+					a = insn->opcode == AMO_OP_STRH ? regs[insn->rs] + insn->imm : insn->imm;
+					if ((p = amo_memory (a, 2, pc)) != NULL)
+					{
+						bfd_putl16 (regs[insn->rt], p);
+						amo_store_check (a);
+					}
+					break;
+
+				case AMO_OP_STRB_REL:
+				case AMO_OP_STRB:
+					a = insn->opcode == AMO_OP_STRB ? regs[insn->rs] + insn->imm : insn->imm;
+					if ((p = amo_memory (a, 1, pc)) != NULL)
+					{
+						*p = regs[insn->rt];
+						amo_store_check (a);
+					}
+					break;
+
+				case AMO_OP_BEQ:
+				case AMO_OP_BNE:
+				case AMO_OP_BLT:
+				case AMO_OP_BLE:
+				case AMO_OP_BLTU:
+				case AMO_OP_BLEU:
+					a = regs[insn->rs];
+					b = regs[insn->rt];
+					switch (insn->opcode)
+					{
+						case AMO_OP_BEQ: r = a == b; break;
+						case AMO_OP_BNE: r = a != b; break;
+						case AMO_OP_BLT: r = (int32_t) a < (int32_t) b; break;
+						case AMO_OP_BLE: r = (int32_t) a <= (int32_t) b; break;
+						case AMO_OP_BLTU: r = a < b; break;
+						default: r = a <= b; break;
+					}
+					if (r)
+					{
+						next = insn->imm;
+						block->taken++;
+						cpu.cycles++;
+					}
+					break;
+
+				case AMO_OP_JALI:
+				case AMO_OP_JAL:
+					regs[AMO_REG_LR] = pc + 4;
+					next = insn->opcode == AMO_OP_JALI ? insn->imm : regs[insn->rs];
+					if (arcs)
+						amo_arc_record (pc, next);
+					block->taken++;
+					cpu.cycles++;
+					break;
+
+				case AMO_OP_JMPI:
+					next = insn->imm;
+					block->taken++;
+					cpu.cycles++;
+					break;
+
+				case AMO_OP_JMP:
+				case AMO_OP_RET:
+					next = regs[insn->rs];
+					block->taken++;
+					cpu.cycles++;
+					break;
+
+				case AMO_OP_SWI:
+					amo_service (insn->imm, pc);
+					break;
+
+				case AMO_OP_SETVT:
+				case AMO_OP_LOCK:
+					break;
+
+				default:
+					abort ();
+			}
+		}
+
+		/* the program stopped or wrote to the code inside the block, take
+		   back the instructions after the one that stopped it, they may be
+		   stale and are decoded again from the next pc */
+		if (insn < end)
+		{
+			amo_block_cut (block, insn - block->insns);
+			next = pc;
+		}
+
+		cpu.pc = next;
+
+		/* the code changed under the cached blocks */
+		if (cpu.code_written)
+		{
+			amo_blocks_flush ();
+			cpu.code_written = FALSE;
+		}
+
+		if (insn_limit && cpu.insns >= insn_limit)
+			amo_halt (1, _("instruction limit reached"), cpu.pc);
+	}
+}
+
+static void
+amo_load (const char *filename)
+{
+	bfd *abfd;
+	asection *sec;
+	bfd_vma lma, size;
+	char **matching;
+
+	abfd = bfd_openr (filename, NULL);
+	if (abfd == NULL)
+	{
+		bfd_nonfatal (filename);
+		xexit (1);
+	}
+
+	if (!bfd_check_format_matches (abfd, bfd_object, &matching))
+	{
+		bfd_nonfatal (filename);
+		if (bfd_get_error () == bfd_error_file_ambiguously_recognized)
+		{
+			list_matching_formats (matching);
+			free (matching);
+		}
+		xexit (1);
+	}
+
+	if (bfd_get_arch (abfd) != bfd_arch_amo)
+		fatal (_("%s: not an AMO executable"), filename);
+
+	memory = (bfd_byte *) xcalloc (memory_size, 1);
+	image_lo = code_lo = memory_size;
+	image_hi = code_hi = 0;
+
+	for (sec = abfd->sections; sec != NULL; sec = sec->next)
+	{
+		if (!(bfd_get_section_flags (abfd, sec) & SEC_ALLOC))
+			continue;
+
+		lma = bfd_section_lma (abfd, sec);
+		size = bfd_section_size (abfd, sec);
+		if (size == 0)
+			continue;
+		if (lma > memory_size || size > memory_size - lma)
+			fatal (_("%s: section %s does not fit in the memory"), filename,
+				   bfd_get_section_name (abfd, sec));
+
+		if ((bfd_get_section_flags (abfd, sec) & SEC_LOAD)
+			&& !bfd_get_section_contents (abfd, sec, memory + lma, 0, size))
+		{
+			bfd_nonfatal (filename);
+			xexit (1);
+		}
+
+		if (lma < image_lo)
+			image_lo = lma;
+		if (lma + size > image_hi)
+			image_hi = lma + size;
+
+		if (bfd_get_section_flags (abfd, sec) & SEC_CODE)
+		{
+			if (lma < code_lo)
+				code_lo = lma;
+			if (lma + size > code_hi)
+				code_hi = lma + size;
+		}
+	}
+
+	if (code_lo >= code_hi)
+		fatal (_("%s: no code to run"), filename);
+
+	image_lo &= ~3U;
+	image_hi = (image_hi + 3) & ~3U;
+	code_lo &= ~3U;
+	code_hi = (code_hi + 3) & ~3U;
+
+	cpu.pc = bfd_get_start_address (abfd);
+	cpu.regs[AMO_REG_SP] = memory_size;
+
+	bfd_close (abfd);
+}
+
+static bfd_boolean
+gmon_write_8 (FILE *file, unsigned int value)
+{
+	return putc (value, file) != EOF;
+}
+
+static bfd_boolean
+gmon_write_32 (FILE *file, unsigned long long value)
+{
+	bfd_byte buf[4];
+
+	/* counters saturate */
+	bfd_putl32 (value > 0xffffffffULL ? 0xffffffff : value, buf);
+	return fwrite (buf, sizeof (buf), 1, file) == 1;
+}
+
+/* write the profile in the format read by gprof, the histogram bins
+   only count up to 65535 so larger counts are split over several
+   records of the same range, which gprof adds up */
+static void
+amo_profile_write (void)
+{
+	static const char dimension[15] = "cycles";
+	unsigned long long max, done;
+	unsigned long i, bins, blocks_run;
+	unsigned long code_slot;
+	bfd_byte buf[2];
+	FILE *file;
+	bfd_boolean ok;
+
+	amo_blocks_flush ();
+
+	file = fopen (profile_name, FOPEN_WB);
+	if (file == NULL)
+	{
+		non_fatal (_("cannot create %s: %s"), profile_name, strerror (errno));
+		return;
+	}
+
+	/* header */
+	ok = fwrite ("gmon", 4, 1, file) == 1
+		 && gmon_write_32 (file, 1)
+		 && gmon_write_32 (file, 0)
+		 && gmon_write_32 (file, 0)
+		 && gmon_write_32 (file, 0);
+
+	/* one bin per instruction of the code */
+	bins = (code_hi - code_lo) >> 2;
+	code_slot = (code_lo - image_lo) >> 2;
+	max = 0;
+	for (i = 0; i < bins; i++)
+		if (profile_cycles[code_slot + i] > max)
+			max = profile_cycles[code_slot + i];
+
+	for (done = 0; ok && (done < max || done == 0); done += 0xffff)
+	{
+		ok = gmon_write_8 (file, 0)
+			 && gmon_write_32 (file, code_lo)
+			 && gmon_write_32 (file, code_hi)
+			 && gmon_write_32 (file, bins)
+			 && gmon_write_32 (file, 1)
+			 && fwrite (dimension, sizeof (dimension), 1, file) == 1
+			 && gmon_write_8 (file, 'c');
+
+		for (i = 0; ok && i < bins; i++)
+		{
+			unsigned long long count;
+
+			count = profile_cycles[code_slot + i];
+			count = count > done ? count - done : 0;
+			bfd_putl16 (count > 0xffff ? 0xffff : count, buf);
+			ok = fwrite (buf, sizeof (buf), 1, file) == 1;
+		}
+	}
+
+	/* call graph */
+	for (i = 0; ok && i < arc_size; i++)
+	{
+		if (!arcs[i].count)
+			continue;
+		ok = gmon_write_8 (file, 1)
+			 && gmon_write_32 (file, arcs[i].from)
+			 && gmon_write_32 (file, arcs[i].to)
+			 && gmon_write_32 (file, arcs[i].count);
+	}
+
+	/* execution count of each block */
+	blocks_run = 0;
+	for (i = 0; i < (unsigned long) (image_hi - image_lo) >> 2; i++)
+		if (profile_entries[i])
+			blocks_run++;
+
+	if (ok && blocks_run)
+	{
+		ok = gmon_write_8 (file, 2) && gmon_write_32 (file, blocks_run);
+		for (i = 0; ok && i < (unsigned long) (image_hi - image_lo) >> 2; i++)
+		{
+			if (!profile_entries[i])
+				continue;
+			ok = gmon_write_32 (file, image_lo + i * 4)
+				 && gmon_write_32 (file, profile_entries[i]);
+		}
+	}
+
+	if (fclose (file) != 0 || !ok)
+		non_fatal (_("error writing %s"), profile_name);
+}
+
+int main (int, char **);
+
+int
+main (int argc, char **argv)
+{
+	unsigned long words;
+	char *end;
+	int c;
+
+#if defined (HAVE_SETLOCALE) && defined (HAVE_LC_MESSAGES)
+	setlocale (LC_MESSAGES, "");
+#endif
+#if defined (HAVE_SETLOCALE)
+	setlocale (LC_CTYPE, "");
+#endif
+	bindtextdomain (PACKAGE, LOCALEDIR);
+	textdomain (PACKAGE);
+
+	program_name = *argv;
+	xmalloc_set_program_name (program_name);
+	bfd_set_error_program_name (program_name);
+
+	expandargv (&argc, &argv);
+
+	if (bfd_init () != BFD_INIT_MAGIC)
+		fatal (_("fatal error: libbfd ABI mismatch"));
+	set_default_bfd_target ();
+
+	while ((c = getopt_long (argc, argv, "po:m:l:shv", long_options, (int *) 0)) != EOF)
+	{
+		switch (c)
+		{
+			case 'p':
+				do_profile = 1;
+				break;
+
+			case 'o':
+				do_profile = 1;
+				profile_name = optarg;
+				break;
+
+			case 'm':
+				memory_size = strtoul (optarg, &end, 0);
+				if (*end != '\0' || memory_size < 4096 || (memory_size & 3))
+					fatal (_("invalid memory size: %s"), optarg);
+				break;
+
+			case 'l':
+				insn_limit = strtoull (optarg, &end, 0);
+				if (*end != '\0')
+					fatal (_("invalid instruction limit: %s"), optarg);
+				break;
+
+			case 's':
+				show_statistics = 1;
+				break;
+
+			case 'h':
+				show_help = 1;
+				break;
+
+			case 'v':
+				show_version = 1;
+				break;
+
+			case 0:
+				break;
+
+			default:
+				usage (stderr, 1);
+		}
+	}
+
+	if (show_version)
+		print_version ("amo-run");
+	if (show_help)
+		usage (stdout, 0);
+	if (optind + 1 != argc)
+		usage (stderr, 1);
+
+	amo_decode_init ();
+	amo_load (argv[optind]);
+
+	words = (image_hi - image_lo) >> 2;
+	blocks = (struct amo_block **) xcalloc (words, sizeof (struct amo_block *));
+	if (do_profile)
+	{
+		profile_cycles = (unsigned long long *) xcalloc (words, sizeof (unsigned long long));
+		profile_entries = (unsigned long long *) xcalloc (words, sizeof (unsigned long long));
+		arc_size = AMO_ARC_TABLE_SIZE_DEFAULT;
+		arcs = (struct amo_arc *) xcalloc (arc_size, sizeof (struct amo_arc));
+	}
+
+	amo_run ();
+	fflush (stdout);
+
+	if (do_profile)
+		amo_profile_write ();
+
+	if (show_statistics)
+	{
+		fprintf (stderr, _("instructions: %llu\n"), cpu.insns);
+		fprintf (stderr, _("cycles: %llu\n"), cpu.cycles);
+		fprintf (stderr, _("blocks decoded: %lu\n"), blocks_decoded);
+	}
+
+	return cpu.status;
+}
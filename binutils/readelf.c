@@ -2127,6 +2127,9 @@ get_dynamic_type (Filedata * filedata, unsigned long type)
     case DT_PREINIT_ARRAY: return "PREINIT_ARRAY";
     case DT_PREINIT_ARRAYSZ: return "PREINIT_ARRAYSZ";
     case DT_SYMTAB_SHNDX: return "SYMTAB_SHNDX";
+    case DT_RELRSZ:	return "RELRSZ";
+    case DT_RELR:	return "RELR";
+    case DT_RELRENT:	return "RELRENT";
 
     case DT_CHECKSUM:	return "CHECKSUM";
     case DT_PLTPADSZ:	return "PLTPADSZ";
@@ -4246,6 +4249,7 @@ get_section_type_name (Filedata * filedata, unsigned int sh_type)
     case SHT_GNU_HASH:		return "GNU_HASH";
     case SHT_GROUP:		return "GROUP";
     case SHT_SYMTAB_SHNDX:	return "SYMTAB SECTION INDICES";
+    case SHT_RELR:		return "RELR";
     case SHT_GNU_verdef:	return "VERDEF";
     case SHT_GNU_verneed:	return "VERNEED";
     case SHT_GNU_versym:	return "VERSYM";
@@ -10265,6 +10269,8 @@ process_dynamic_section (Filedata * filedata)
 	case DT_PLTPADSZ:
 	case DT_MOVEENT	:
 	case DT_MOVESZ	:
+	case DT_RELRSZ	:
+	case DT_RELRENT	:
 	case DT_INIT_ARRAYSZ:
 	case DT_FINI_ARRAYSZ:
 	case DT_GNU_CONFLICTSZ:
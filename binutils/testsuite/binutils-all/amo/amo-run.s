@@ -0,0 +1,33 @@
+# print a line through a called function, then patch an instruction
+# further on in the running block and exit with the status it sets
+
+	.text
+	.global	_start
+_start:
+	mov	r10, hello
+	mov	r11, $6
+loop:
+	ldrb	r1, [r10]
+	jal	putc
+	add	r10, r10, $1
+	sub	r11, r11, $1
+	bne	r11, r0, loop
+
+	mov	r3, status
+	ldr	r2, [r3]
+	mov	r4, patch
+	str	[r4], r2
+patch:
+	mov	r1, $1
+	swi	$0
+
+putc:
+	swi	$1
+	ret	lr
+
+	.data
+hello:
+	.ascii	"hello\n"
+	.p2align 2
+status:
+	mov	r1, $42
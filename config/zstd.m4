@@ -0,0 +1,21 @@
+dnl A function to check for the zstd library, used to read and write
+dnl sections compressed with zstd.  zstd is used if it is found, unless
+dnl the user configured with --without-zstd.
+
+AC_DEFUN([AC_ZSTD],
+[
+  AC_ARG_WITH(zstd,
+  [AS_HELP_STRING([--with-zstd], [support zstd compressed debug sections (default: auto)])],
+  , [with_zstd=auto])
+  ZSTD_LIBS=
+  if test "x$with_zstd" != xno; then
+    AC_CHECK_HEADER(zstd.h,
+      [AC_CHECK_LIB(zstd, ZSTD_decompress, [ZSTD_LIBS=-lzstd])])
+    if test -n "$ZSTD_LIBS"; then
+      AC_DEFINE(HAVE_ZSTD, 1, [Define if zstd is available.])
+    elif test "x$with_zstd" = xyes; then
+      AC_MSG_ERROR([--with-zstd was given, but zstd was not found])
+    fi
+  fi
+  AC_SUBST(ZSTD_LIBS)
+])
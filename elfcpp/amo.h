@@ -0,0 +1,56 @@
+// amo.h -- ELF definitions specific to EM_AMO  -*- C++ -*-
+
+// Copyright (C) 2019 Free Software Foundation, Inc.
+
+// This file is part of elfcpp.
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public License
+// as published by the Free Software Foundation; either version 2, or
+// (at your option) any later version.
+
+// In addition to the permissions in the GNU Library General Public
+// License, the Free Software Foundation gives you unlimited
+// permission to link the compiled version of this file into
+// combinations with other programs, and to distribute those
+// combinations without any restriction coming from the use of this
+// file.  (The Library Public License restrictions do apply in other
+// respects; for example, they cover modification of the file, and
+/// distribution when not linked into a combined executable.)
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+
+// You should have received a copy of the GNU Library General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA
+// 02110-1301, USA.
+
+#ifndef ELFCPP_AMO_H
+#define ELFCPP_AMO_H
+
+namespace elfcpp
+{
+
+// The relocation numbers match include/elf/amo.h.
+
+enum
+{
+  R_AMO_NONE = 0,
+  // 21-bit PC relative literal load, pc + 4 + imm.
+  R_AMO_LITERAL = 1,
+  // 16-bit PC relative branch, in words.
+  R_AMO_PCREL = 2,
+  // 26-bit absolute jump target, in words.
+  R_AMO_28 = 3,
+  // 32-bit absolute word.
+  R_AMO_32 = 4,
+  // 21-bit absolute mov immediate, made by linker relaxation.
+  R_AMO_21 = 5
+};
+
+} // End namespace elfcpp.
+
+#endif // !defined(ELFCPP_AMO_H)
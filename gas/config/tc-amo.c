@@ -25,13 +25,19 @@
 #include "obstack.h"
 #include "bfd.h"
 #include "opcode/amo.h"
-
-#define ENTRY(func, p) { emit_##func, p },
-#define EMIT(name, optype, opname, ptype, pname) static void emit_##name (optype opname, ptype pname)
+#include "elf/amo.h"
 
 /* command line option */
+enum options
+{
+	OPTION_LITPOOL_DISTANCE = OPTION_MD_BASE
+};
+
 const char *md_shortopts = "";
-struct option md_longopts[] = {};
+struct option md_longopts[] = {
+	{ "mlitpool-distance", required_argument, NULL, OPTION_LITPOOL_DISTANCE },
+	{ NULL, no_argument, NULL, 0 }
+};
 size_t md_longopts_size = sizeof (md_longopts);
 
 /* character which always start a comment */
@@ -46,6 +52,10 @@ const char EXP_CHARS[] = "";
 const char FLT_CHARS[] = "";
 
 static struct hash_control *amo_reg_hash;
+static struct hash_control *amo_opcode_hash;
+
+/* packed operand types of each entry of amo_opcodes */
+static unsigned int amo_signatures[AMO_INSN_MAX];
 
 struct amo_instruction
 {
@@ -59,16 +69,16 @@ struct amo_instruction
 	expressionS operands[OPERAND_PER_INSTRUCTION_MAX];
 };
 
-typedef struct amo_opfunc
+/* what the mnemonic hash maps to */
+struct amo_opcode_entry
 {
-	struct
-	{
-		/* operation function */
-		void (*f)(unsigned char opcode, int type);
-		/* operation parameter */
-		int parameter;
-	} operations[OPERATION_PER_INSTRUCTION_MAX];
-} amo_opfunc_t;
+	/* first form of the mnemonic and the number of its forms */
+	const amo_opcode_t *opcode;
+	unsigned int count;
+
+	/* packed operand types of each form */
+	const unsigned int *signatures;
+};
 
 struct litpool
 {
@@ -77,29 +87,82 @@ struct litpool
 	int index;
 	int size;
 
+	/* open-addressed table of literal indices (-1 is empty), twice the
+	   size of the literal array, used to share identical literals */
+	int *slots;
+
+	/* the frag and offset up to which the section has been measured,
+	   and the bytes assembled there since the first pending reference */
+	fragS *frag;
+	valueT fix;
+	valueT distance;
+
 	/* literal pool */
 	symbolS *symbol;
-	unsigned int id;
+
+	/* section the pool is dumped into, each one has its own */
+	segT section;
+	subsegT sub_section;
+
+	struct litpool *next;
+};
+
+/* relaxation states of the conditional branch */
+#define RELAX_BRANCH_SHORT 1
+#define RELAX_BRANCH_LONG 2
+
+/* the short form reaches -131072 to 131068 bytes from the next instruction,
+   the long form is an inverted branch over an absolute jmp */
+const relax_typeS md_relax_table[] =
+{
+	{ 1, 1, 0, 0 },
+	{ 131072, -131068, BYTES_PER_INSTRUCTION, RELAX_BRANCH_LONG },
+	{ 0, 0, 2 * BYTES_PER_INSTRUCTION, 0 }
 };
 
 static struct amo_instruction insn;
-static struct litpool literal_pool;
+static struct litpool *list_of_pools;
+
+/* id of the next literal pool, used to name it */
+static unsigned int literal_pool_id;
+
+/* -mlitpool-distance */
+static unsigned int literal_pool_distance = LITERAL_POOL_DISTANCE_DEFAULT;
+
+static void declare_opcode_set (void);
+static void literal_pool_dump (struct litpool *);
 
 int
-md_parse_option (int c ATTRIBUTE_UNUSED, const char *arg ATTRIBUTE_UNUSED)
+md_parse_option (int c, const char *arg)
 {
-	return 0;
-#ifdef USE_PARSE_OPTION
+	char *end;
+
+	switch (c)
+	{
+		case OPTION_LITPOOL_DISTANCE:
+			literal_pool_distance = strtoul (arg, &end, 0);
+			if (*end || literal_pool_distance >= LITERAL_POOL_RANGE)
+				as_fatal (_("invalid literal pool distance: %s"), arg);
+			break;
+
+		default:
+			return 0;
+	}
+
 	/* should return 1 if option parsing is successful */
 	return 1;
-#endif
 }
 
 void
 md_show_usage (FILE *stream)
 {
 	/* print the help for custom options */
-	fprintf(stream, "\namo options: TODO\n");
+	fprintf (stream, _("\
+AMO options:\n\
+  -mlitpool-distance=BYTES\n\
+                          dump the pending literal pool at the first\n\
+                          unconditional jump after BYTES of code\n\
+                          (0 dumps it at every unconditional jump)\n"));
 }
 
 static void
@@ -126,56 +189,194 @@ declare_register_set (void)
     }
 }
 
-static void
-literal_pool_init (void)
+/* the literal pool of the current section, if there is one */
+static struct litpool *
+literal_pool_find (void)
+{
+	struct litpool *pool;
+
+	for (pool = list_of_pools; pool; pool = pool->next)
+		if (pool->section == now_seg && pool->sub_section == now_subseg)
+			break;
+
+	return pool;
+}
+
+static struct litpool *
+literal_pool_find_or_make (void)
 {
-	literal_pool.literals = XNEWVEC (expressionS, LITERAL_POOL_SIZE_DEFAULT);
-	literal_pool.size = LITERAL_POOL_SIZE_DEFAULT;
-	literal_pool.index = 0;
+	struct litpool *pool;
+
+	pool = literal_pool_find ();
+	if (pool)
+		return pool;
+
+	pool = XNEW (struct litpool);
+	pool->literals = XNEWVEC (expressionS, LITERAL_POOL_SIZE_DEFAULT);
+	pool->size = LITERAL_POOL_SIZE_DEFAULT;
+	pool->index = 0;
+
+	pool->slots = XNEWVEC (int, LITERAL_POOL_SIZE_DEFAULT * 2);
+	memset (pool->slots, -1, LITERAL_POOL_SIZE_DEFAULT * 2 * sizeof (int));
+	pool->frag = NULL;
+	pool->fix = 0;
+	pool->distance = 0;
+
+	pool->symbol = symbol_create (FAKE_LABEL_NAME, undefined_section, (valueT) 0, &zero_address_frag);
+	pool->section = now_seg;
+	pool->sub_section = now_subseg;
 
-	literal_pool.symbol = symbol_create (FAKE_LABEL_NAME, undefined_section, (valueT) 0, &zero_address_frag);
-	literal_pool.id = 0;
+	pool->next = list_of_pools;
+	list_of_pools = pool;
+
+	return pool;
+}
+
+static unsigned int
+literal_pool_hash (const expressionS *e)
+{
+	unsigned int hash;
+
+	if (e->X_op == O_symbol)
+		hash = (unsigned int) ((uintptr_t) e->X_add_symbol >> 3);
+	else
+		hash = (unsigned int) e->X_add_number;
+	hash = (hash ^ (hash >> 16)) * 0x45d9f3b;
+	hash ^= hash >> 16;
+
+	return hash ^ e->X_op;
+}
+
+/* the slot of the literal E, or of the empty place where it would go */
+static int *
+literal_pool_slot (struct litpool *pool, const expressionS *e)
+{
+	const expressionS *lit;
+	unsigned int mask, h;
+	int *slot;
+
+	mask = pool->size * 2 - 1;
+	for (h = literal_pool_hash (e) & mask; ; h = (h + 1) & mask)
+	{
+		slot = &pool->slots[h];
+		if (*slot < 0)
+			return slot;
+
+		lit = &pool->literals[*slot];
+		if (lit->X_op == e->X_op
+			&& lit->X_add_symbol == e->X_add_symbol
+			&& lit->X_add_number == e->X_add_number)
+			return slot;
+	}
 }
 
 static void
-literal_pool_expand (void)
+literal_pool_expand (struct litpool *pool)
 {
 	expressionS *new_lit;
+	int i;
 
-	new_lit = XNEWVEC (expressionS, literal_pool.size * 2);
-	memcpy (new_lit, literal_pool.literals, literal_pool.size * sizeof (expressionS));
-	XDELETEVEC (literal_pool.literals);
-	literal_pool.literals = new_lit;
-	literal_pool.size *= 2;
+	new_lit = XNEWVEC (expressionS, pool->size * 2);
+	memcpy (new_lit, pool->literals, pool->size * sizeof (expressionS));
+	XDELETEVEC (pool->literals);
+	pool->literals = new_lit;
+	pool->size *= 2;
+
+	/* rehash */
+	XDELETEVEC (pool->slots);
+	pool->slots = XNEWVEC (int, pool->size * 2);
+	memset (pool->slots, -1, pool->size * 2 * sizeof (int));
+	for (i = 0; i < pool->index; i++)
+		*literal_pool_slot (pool, &pool->literals[i]) = i;
 }
 
-static void
-literal_pool_constant (unsigned int bytes)
+/* return the index of the literal E in the pool, adding it if it is new */
+static int
+literal_pool_add (struct litpool *pool, const expressionS *e)
 {
+	int *slot;
+
+	slot = literal_pool_slot (pool, e);
+	if (*slot >= 0)
+		return *slot;
+
 	/* get a slot */
-	if (literal_pool.index == literal_pool.size)
-		literal_pool_expand ();
+	if (pool->index == pool->size)
+	{
+		literal_pool_expand (pool);
+		slot = literal_pool_slot (pool, e);
+	}
+
+	pool->literals[pool->index] = *e;
+	*slot = pool->index;
 
-	memset (&literal_pool.literals[literal_pool.index], 0, sizeof (expressionS));
-	literal_pool.literals[literal_pool.index].X_op = O_constant;
-	literal_pool.literals[literal_pool.index].X_add_number = bytes;
-	literal_pool.index++;
+	return pool->index++;
 }
 
-static void
-literal_pool_symbol (symbolS *symP, int where)
+static int
+literal_pool_constant (struct litpool *pool, unsigned int bytes)
 {
-	/* get a slot */
-	if (literal_pool.index == literal_pool.size)
-		literal_pool_expand ();
+	expressionS e;
+
+	memset (&e, 0, sizeof (expressionS));
+	e.X_op = O_constant;
+	e.X_add_number = bytes;
+
+	return literal_pool_add (pool, &e);
+}
+
+static int
+literal_pool_symbol (struct litpool *pool, symbolS *symP)
+{
+	expressionS e;
 
 	gas_assert (symP != 0);
 
-	memset (&literal_pool.literals[literal_pool.index], 0, sizeof (expressionS));
-	literal_pool.literals[literal_pool.index].X_op = O_symbol;
-	literal_pool.literals[literal_pool.index].X_add_symbol = symP;
-	literal_pool.literals[literal_pool.index].X_add_number = where;
-	literal_pool.index++;
+	memset (&e, 0, sizeof (expressionS));
+	e.X_op = O_symbol;
+	e.X_add_symbol = symP;
+
+	return literal_pool_add (pool, &e);
+}
+
+/* the most bytes FRAGP can take once it is relaxed */
+static valueT
+frag_max_size (fragS *fragp)
+{
+	switch (fragp->fr_type)
+	{
+		case rs_fill:
+			return fragp->fr_fix + fragp->fr_var * fragp->fr_offset;
+
+		case rs_align:
+		case rs_align_code:
+		case rs_align_test:
+			return fragp->fr_fix + ((valueT) 1 << fragp->fr_offset) - 1;
+
+		case rs_machine_dependent:
+			return fragp->fr_fix + md_relax_table[RELAX_BRANCH_LONG].rlx_length;
+
+		default:
+			return fragp->fr_fix + fragp->fr_var;
+	}
+}
+
+/* count everything assembled into the section of POOL since it was last
+   measured, instructions as well as data and space directives */
+static void
+literal_pool_advance (struct litpool *pool)
+{
+	fragS *fragp;
+
+	for (fragp = pool->frag; fragp != frag_now; fragp = fragp->fr_next)
+	{
+		pool->distance += frag_max_size (fragp) - pool->fix;
+		pool->fix = 0;
+	}
+
+	pool->distance += frag_now_fix () - pool->fix;
+	pool->frag = frag_now;
+	pool->fix = frag_now_fix ();
 }
 
 /* this function gets invoked once when assembler is initialized. */
@@ -194,7 +395,8 @@ md_begin (void)
 	/* declare system registers */
 	declare_register ("cr0", 32);
 
-	literal_pool_init ();
+	/* make mnemonic hash table */
+	declare_opcode_set ();
 }
 
 static int
@@ -379,541 +581,305 @@ parse_operands (char *str)
 	return str;
 }
 
-EMIT(nop, unsigned char, opcode ATTRIBUTE_UNUSED, int, type ATTRIBUTE_UNUSED)
+/* place the register and immediate operands of OP where its format says,
+   anything that carries a fixup is emitted by the functions below */
+static void
+emit_fields (const amo_opcode_t *op)
 {
+	const amo_format_t *format;
+	const expressionS *e;
+	unsigned long binary;
+	long imm, min, max;
 	char *frag;
-	
-	frag = frag_more (BYTES_PER_INSTRUCTION);
+	int i;
 
-	md_number_to_chars (frag, 0x00000000, BYTES_PER_INSTRUCTION);
-}
+	format = &amo_formats[op->format];
 
-EMIT(arithmetic, unsigned char, opcode, int, type)
-{
-	unsigned long binary;
-	char *frag;
-	int imm;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
+	/* a pseudo opcode without fields is the all-zero word (nop) */
 	binary = 0;
+	if (op->opcode < OPCODE_NUMBER_MAX)
+		binary |= AMO_PUT (OPCODE, op->opcode);
 
-	binary |= (opcode << 26);
-	binary |= ((insn.operands[1].X_add_number & MASK_REGISTER) << 21);
-	if (type == TYPE_IMM)
+	for (i = 0; i < insn.number && i < FORMAT_REGISTER_MAX; i++)
 	{
-		imm = insn.operands[2].X_add_number;
-		/* is this overflow ? */
-		if (!(-32768 <= imm && imm <= 32767))
-			as_bad ("16-bit immediate must be in the range -32768 to 32767.");
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 16);
-		binary |= imm & MASK_IMM16;
-	}
-	else if (type == TYPE_REG)
-	{
-		binary |= ((insn.operands[2].X_add_number & MASK_REGISTER) << 16);
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 11);
-	}
-	else
-	{
-		/* impossible ! */
-		abort ();
-	}
-
-	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
-}
+		if (format->regs[i] == AMO_FIELD_NONE)
+			continue;
 
-EMIT(logical, unsigned char, opcode, int, type)
-{
-	unsigned long binary;
-	char *frag;
-	unsigned int imm;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
+		e = &insn.operands[i];
+		if (e->X_op == O_dereference)
+			binary |= amo_field_put (format->regs[i], S_GET_VALUE (e->X_add_symbol));
+		else
+			binary |= amo_field_put (format->regs[i], e->X_add_number);
+	}
 
-	binary |= (opcode << 26);
-	binary |= ((insn.operands[1].X_add_number & MASK_REGISTER) << 21);
-	if (type == TYPE_IMM)
+	if (format->imm != AMO_FIELD_NONE)
 	{
-		imm = (unsigned int) insn.operands[2].X_add_number;
+		imm = insn.operands[format->imm_operand].X_add_number;
+		min = 0;
+		max = (1L << amo_fields[format->imm].width) - 1;
+		if (format->kind == AMO_IMM_SIGNED)
+		{
+			min = -(1L << (amo_fields[format->imm].width - 1));
+			max = (1L << (amo_fields[format->imm].width - 1)) - 1;
+		}
+
 		/* is this overflow ? */
-		if (!(imm <= 65535))
-			as_bad ("16-bit immediate must be in the range 0 to 65535 in logical calculation.");
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 16);
-		binary |= imm & MASK_IMM16;
-	}
-	else if (type == TYPE_REG)
-	{
-		binary |= ((insn.operands[2].X_add_number & MASK_REGISTER) << 16);
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 11);
-	}
-	else
-	{
-		/* impossible ! */
-		abort ();
+		if (format->kind != AMO_IMM_UNCHECKED && !(min <= imm && imm <= max))
+			as_bad ("%d-bit immediate in %s must be in the range %ld to %ld.",
+					amo_fields[format->imm].width, insn.name, min, max);
+		binary |= amo_field_put (format->imm, imm);
 	}
 
-	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
-}
-
-EMIT(not, unsigned char, opcode, int, type)
-{
-	unsigned long binary;
-	char *frag;
-	unsigned int imm;
-	
-	/* get a new frag */
+	/* instructions go to the frag one at a time: frag_more and
+	   md_number_to_chars take about 3% of the time spent on straight-line
+	   code, and a staging buffer has to be written out before every label,
+	   reference to `.' and directive, which costs more than it saves */
 	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
-
-	binary |= (opcode << 26);
-	if (type == TYPE_IMM)
-	{
-		imm = (unsigned int) insn.operands[1].X_add_number;
-		/* is this overflow ? */
-		if (!(imm <= 65535))
-			as_bad ("16-bit immediate must be in the range 0 to 65535 in logical calculation.");
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 16);
-		binary |= imm & MASK_IMM16;
-	}
-	else if (type == TYPE_REG)
-	{
-		binary |= ((insn.operands[1].X_add_number & MASK_REGISTER) << 16);
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 11);
-	}
-	else
-	{
-		/* impossible ! */
-		abort ();
-	}
 
 	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
 }
 
-EMIT(mov, unsigned char, opcode, int, type)
+static void
+emit_mov (const amo_opcode_t *op)
 {
+	struct litpool *pool;
 	unsigned long binary;
 	expressionS exp;
 	fixS *fixP;
 	char *frag;
-	int imm;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
+	int literal;
+	long imm;
 
-	binary |= (opcode << 26);
-	binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 21);
-	if (type == TYPE_IMM)
+	if (op->format == AMO_FORMAT_MOV_IMM)
 	{
 		imm = insn.operands[1].X_add_number;
-		/* is this overflow ? */
-		if (!(-1048576 <= imm && imm <= 1048575))
-			goto use_load;
-		binary |= imm & MASK_IMM21;
+		if (AMO_SMIN (IMM21) <= imm && imm <= AMO_SMAX (IMM21))
+		{
+			emit_fields (op);
+			return ;
+		}
 	}
-	else if (type == TYPE_REG)
-		binary |= ((insn.operands[1].X_add_number & MASK_REGISTER) << 16);
-	else if (type == TYPE_SYM)
-		goto use_load;
-	else
-		/* impossible ! */
-		abort ();
 
-	goto end;
+	/* the literal load carries a fixup */
+	frag = frag_more (BYTES_PER_INSTRUCTION);
+
+	binary = AMO_PUT (OPCODE, AMO_OP_LDR_REL);
+	binary |= AMO_PUT (RA, insn.operands[0].X_add_number);
 
-use_load:
-#define OPCODE_LDR 0b010110
+	/* the pool is measured from its first pending reference */
+	pool = literal_pool_find_or_make ();
+	if (pool->index == 0)
+	{
+		pool->frag = frag_now;
+		pool->fix = frag - frag_now->fr_literal;
+		pool->distance = 0;
+	}
 
-	binary = OPCODE_LDR << 26;
-	binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 21);
+	/* identical literals share one slot of the pool */
+	if (op->format == AMO_FORMAT_MOV_IMM)
+		literal = literal_pool_constant (pool, insn.operands[1].X_add_number);
+	else
+		literal = literal_pool_symbol (pool, insn.operands[1].X_add_symbol);
 
 	memset (&exp, 0, sizeof (expressionS));
 
 	exp.X_op = O_symbol;
-	exp.X_add_symbol = literal_pool.symbol;
+	exp.X_add_symbol = pool->symbol;
 
 	fixP = fix_new_exp (frag_now, frag - frag_now->fr_literal, BYTES_PER_INSTRUCTION, &exp, 1, BFD_RELOC_AMO_LITERAL);
-	fixP->fx_offset = literal_pool.index * 4 - 4;
+	fixP->fx_offset = literal * 4 - 4;
 
-	if (type == TYPE_IMM)
-		literal_pool_constant (insn.operands[1].X_add_number);
-	else if (type == TYPE_SYM)
-		literal_pool_symbol (insn.operands[1].X_add_symbol, frag - frag_now->fr_literal);
-
-#undef OPCODE_LDR
-end:
 	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
 }
 
-EMIT(ldr, unsigned char, opcode, int, type)
+static void
+emit_branch (const amo_opcode_t *op)
 {
 	unsigned long binary;
 	char *frag;
-	int imm;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
-	
-	binary |= (opcode << 26);
-	if (type == TYPE_DREL)
-	{
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 21);
-		imm = insn.operands[1].X_add_number;
-		/* is this overflow ? */
-		if (!(-1048576 <= imm && imm <= 1048575))
-			as_bad ("21-bit immediate in ldr must be in the range -1048576 to 1048575.");
-		binary |= imm & MASK_IMM21;
-	}
-	else if (type == TYPE_DEREF)
-	{
-		binary |= ((S_GET_VALUE (insn.operands[1].X_add_symbol) & MASK_REGISTER) << 21);
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 16);
-		imm = insn.operands[1].X_add_number;
-		/* is this overflow ? */
-		if (!(-32768 <= imm && imm <= 32767))
-			as_bad ("16-bit immediate in ldr must be in the range -32768 to 32767.");
-		binary |= imm & MASK_IMM16;
-	}
-	else
-	{
-		/* impossible ! */
-		abort ();
-	}
 
-	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
-}
+	binary = AMO_PUT (OPCODE, op->opcode);
+	binary |= AMO_PUT (RA, insn.operands[0].X_add_number);
+	binary |= AMO_PUT (RB, insn.operands[1].X_add_number);
 
-EMIT(str, unsigned char, opcode, int, type)
-{
-	unsigned long binary;
-	char *frag;
-	int imm;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
-	
-	binary |= (opcode << 26);
-	if (type == TYPE_DREL)
-	{
-		binary |= ((insn.operands[1].X_add_number & MASK_REGISTER) << 21);
-		imm = insn.operands[0].X_add_number;
-		/* is this overflow ? */
-		if (!(-1048576 <= imm && imm <= 1048575))
-			as_bad ("21-bit immediate in ldr must be in the range -1048576 to 1048575.");
-		binary |= imm & MASK_IMM21;
-	}
-	else if (type == TYPE_DEREF)
-	{
-		binary |= ((S_GET_VALUE (insn.operands[0].X_add_symbol) & MASK_REGISTER) << 21);
-		binary |= ((insn.operands[1].X_add_number & MASK_REGISTER) << 16);
-		imm = insn.operands[0].X_add_number;
-		/* is this overflow ? */
-		if (!(-32768 <= imm && imm <= 32767))
-			as_bad ("16-bit immediate in ldr must be in the range -32768 to 32767.");
-		binary |= imm & MASK_IMM16;
-	}
-	else
-	{
-		/* impossible ! */
-		abort ();
-	}
+	know (insn.operands[2].X_op = O_symbol);
+
+	/* the short form is kept in the variable part until relaxation decides */
+	frag = frag_var (rs_machine_dependent, 2 * BYTES_PER_INSTRUCTION, BYTES_PER_INSTRUCTION,
+					 RELAX_BRANCH_SHORT, insn.operands[2].X_add_symbol, 0, NULL);
 
 	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
 }
 
-EMIT(branch, unsigned char, opcode, int, type ATTRIBUTE_UNUSED)
+static void
+emit_jump (const amo_opcode_t *op)
 {
-	unsigned long binary;
-	fixS *fixP;
 	char *frag;
 	int where;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
 
-	binary |= (opcode << 26);
-	binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 21);
-	binary |= ((insn.operands[1].X_add_number & MASK_REGISTER) << 16);
+	know (insn.operands[0].X_op = O_symbol);
 
-	know (insn.operands[2].X_op = O_symbol);
+	/* get a new frag */
+	frag = frag_more (BYTES_PER_INSTRUCTION);
 
-	insn.operands[2].X_add_number = 0;
+	insn.operands[0].X_add_number = 0;
 	where = frag - frag_now->fr_literal;
 
-	/* need to check the overflow */
-
-	fixP = fix_new_exp (frag_now, where, BYTES_PER_INSTRUCTION, &insn.operands[2], 1, BFD_RELOC_AMO_PCREL);
-	fixP->fx_offset = -4;
+	fix_new_exp (frag_now, where, BYTES_PER_INSTRUCTION, &insn.operands[0], 0, BFD_RELOC_AMO_28);
 
-	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
+	md_number_to_chars (frag, AMO_PUT (OPCODE, op->opcode), BYTES_PER_INSTRUCTION);
 }
 
-EMIT(jump, unsigned char, opcode, int, type)
+/* pack the operand types so one comparison checks all of them */
+static unsigned int
+operand_signature (unsigned char number, const unsigned char *types)
 {
-	unsigned long binary;
-	char *frag;
-	int where;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
-
-	binary |= (opcode << 26);
-	if (type == TYPE_SYM)
-	{
-		know (insn.operands[0].X_op = O_symbol);
-
-		insn.operands[0].X_add_number = 0;
-		where = frag - frag_now->fr_literal;
+	unsigned int signature;
+	int i;
 
-		/* need to check the overflow */
+	signature = 0;
+	for (i = 0; i < number && i < OPERAND_PER_INSTRUCTION_MAX; i++)
+		signature |= (unsigned int) types[i] << (i * 8);
 
-		fix_new_exp (frag_now, where, BYTES_PER_INSTRUCTION, &insn.operands[0], 0, BFD_RELOC_AMO_28);
-	}
-	else if (type == TYPE_REG)
-	{
-		binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 21);
-	}
-	else
-	{
-		/* impossible ! */
-		abort ();
-	}
-
-	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
+	return signature;
 }
 
-EMIT(swi, unsigned char, opcode, int, type ATTRIBUTE_UNUSED)
+static void
+declare_opcode_set (void)
 {
-	unsigned long binary;
-	char *frag;
-	int imm;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
-
-	binary |= (opcode << 26);
-
-	imm = insn.operands[0].X_add_number;
-	/* is this overflow ? */
-	if (!(0 <= imm && imm <= 255))
-		as_bad ("8-bit immediate in ldr must be in the range 0 to 255.");
+	struct amo_opcode_entry *entry;
+	const char *err;
+	unsigned int i;
 
-	binary |= imm & MASK_IMM8;
+	amo_opcode_hash = hash_new ();
 
-	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
-}
+	entry = NULL;
+	for (i = 0; i < AMO_INSN_MAX; i++)
+	{
+		amo_signatures[i] = operand_signature (amo_opcodes[i].condition.number,
+											   amo_opcodes[i].condition.types);
 
-EMIT(setvt, unsigned char, opcode, int, type ATTRIBUTE_UNUSED)
-{
-	unsigned long binary;
-	char *frag;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
+		/* the forms of one mnemonic are adjacent */
+		if (entry && !strcmp (entry->opcode->name, amo_opcodes[i].name))
+		{
+			entry->count++;
+			continue;
+		}
 
-	binary |= (opcode << 26);
-	binary |= ((insn.operands[0].X_add_number & MASK_REGISTER) << 21);
-	binary |= (insn.operands[1].X_add_number & MASK_IMM16);
+		entry = XNEW (struct amo_opcode_entry);
+		entry->opcode = &amo_opcodes[i];
+		entry->signatures = &amo_signatures[i];
+		entry->count = 1;
 
-	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
+		if ((err = hash_insert (amo_opcode_hash, amo_opcodes[i].name, (PTR) entry)))
+			as_fatal (_("opcode set initialization failed: %s"), err);
+	}
 }
 
-EMIT(lock, unsigned char, opcode, int, type ATTRIBUTE_UNUSED)
+/* place the pending literal pool of the current section without an
+   explicit .ltorg: right after an unconditional jump once it is
+   literal_pool_distance bytes away, or behind a jump of its own before
+   the first reference goes out of range */
+static void
+literal_pool_check (unsigned char opcode)
 {
-	unsigned long binary;
+	struct litpool *pool;
+	expressionS exp;
+	symbolS *skip;
 	char *frag;
-	
-	/* get a new frag */
-	frag = frag_more (BYTES_PER_INSTRUCTION);
-	binary = 0;
 
-	binary |= (opcode << 26);
-
-	md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
-}
+	pool = literal_pool_find ();
+	if (pool == NULL || pool->index == 0)
+		return ;
 
-OPFUNCS(amo)
-
-FUNC(nop)
-	ENTRY(nop, TYPE_NONE)
-ENDFUNC
-FUNC(add)
-    ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDFUNC
-FUNC(adc)
-    ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDFUNC
-FUNC(sub)
-    ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDFUNC
-FUNC(and)
-    ENTRY(logical, TYPE_IMM)
-	ENTRY(logical, TYPE_REG)
-ENDFUNC
-FUNC(or)
-    ENTRY(logical, TYPE_IMM)
-	ENTRY(logical, TYPE_REG)
-ENDFUNC
-FUNC(xor)
-    ENTRY(logical, TYPE_IMM)
-	ENTRY(logical, TYPE_REG)
-ENDFUNC
-FUNC(not)
-    ENTRY(not, TYPE_IMM)
-	ENTRY(not, TYPE_REG)
-ENDFUNC
-FUNC(lsl)
-    ENTRY(logical, TYPE_IMM)
-	ENTRY(logical, TYPE_REG)
-ENDFUNC
-FUNC(lsr)
-    ENTRY(logical, TYPE_IMM)
-	ENTRY(logical, TYPE_REG)
-ENDFUNC
-FUNC(asr)
-    ENTRY(logical, TYPE_IMM)
-	ENTRY(logical, TYPE_REG)
-ENDFUNC
-FUNC(mov)
-    ENTRY(mov, TYPE_IMM)
-	ENTRY(mov, TYPE_REG)
-	ENTRY(mov, TYPE_SYM)
-ENDFUNC
-FUNC(ldr)
-    ENTRY(ldr, TYPE_DREL)
-	ENTRY(ldr, TYPE_DEREF)
-ENDFUNC
-FUNC(str)
-    ENTRY(str, TYPE_DREL)
-	ENTRY(str, TYPE_DEREF)
-ENDFUNC
-FUNC(beq)
-    ENTRY(branch, TYPE_NONE)
-ENDFUNC
-FUNC(bne)
-    ENTRY(branch, TYPE_NONE)
-ENDFUNC
-FUNC(blt)
-    ENTRY(branch, TYPE_NONE)
-ENDFUNC
-FUNC(ble)
-    ENTRY(branch, TYPE_NONE)
-ENDFUNC
-FUNC(jmp)
-    ENTRY(jump, TYPE_SYM)
-    ENTRY(jump, TYPE_REG)
-ENDFUNC
-FUNC(jal)
-    ENTRY(jump, TYPE_SYM)
-    ENTRY(jump, TYPE_REG)
-ENDFUNC
-FUNC(swi)
-    ENTRY(swi, TYPE_NONE)
-ENDFUNC
-FUNC(bltu)
-    ENTRY(branch, TYPE_NONE)
-ENDFUNC
-FUNC(bleu)
-    ENTRY(branch, TYPE_NONE)
-ENDFUNC
-FUNC(ext)
-    ENTRY(logical, TYPE_IMM)
-ENDFUNC
-FUNC(ldrb)
-    ENTRY(ldr, TYPE_DREL)
-	ENTRY(ldr, TYPE_DEREF)
-ENDFUNC
-FUNC(strb)
-    ENTRY(str, TYPE_DREL)
-	ENTRY(str, TYPE_DEREF)
-ENDFUNC
-FUNC(ldrh)
-    ENTRY(ldr, TYPE_DREL)
-	ENTRY(ldr, TYPE_DEREF)
-ENDFUNC
-FUNC(strh)
-    ENTRY(str, TYPE_DREL)
-	ENTRY(str, TYPE_DEREF)
-ENDFUNC
-FUNC(setvt)
-    ENTRY(setvt, TYPE_NONE)
-ENDFUNC
-FUNC(ret)
-    ENTRY(jump, TYPE_REG)
-ENDFUNC
-FUNC(lock)
-    ENTRY(lock, TYPE_NONE)
-ENDFUNC
-
-ENDOPFUNCS
-
-static amo_opcode_t *
-insn_search (const char *name)
-{
-	unsigned int i;
+	literal_pool_advance (pool);
 
-	for (i = 0; i < amo_opcodes_size; i++)
+	if (opcode == AMO_OP_JMPI || opcode == AMO_OP_JMP || opcode == AMO_OP_RET)
 	{
-		if (!strcmp (amo_opcodes[i].name, name))
-			return &amo_opcodes[i];
+		if (pool->distance >= literal_pool_distance)
+			literal_pool_dump (pool);
+		return ;
 	}
 
-	return NULL;
+	/* the jump, the pool and the next instruction must stay in range */
+	if (pool->distance + (pool->index + 4) * BYTES_PER_INSTRUCTION < LITERAL_POOL_RANGE)
+		return ;
+
+	skip = symbol_temp_make ();
+
+	frag = frag_more (BYTES_PER_INSTRUCTION);
+	memset (&exp, 0, sizeof (expressionS));
+	exp.X_op = O_symbol;
+	exp.X_add_symbol = skip;
+	fix_new_exp (frag_now, frag - frag_now->fr_literal, BYTES_PER_INSTRUCTION, &exp, 0, BFD_RELOC_AMO_28);
+	md_number_to_chars (frag, AMO_PUT (OPCODE, AMO_OP_JMPI), BYTES_PER_INSTRUCTION);
+
+	literal_pool_dump (pool);
+	symbol_set_value_now (skip);
 }
 
 void
 md_assemble (char *str)
 {
-	amo_opcode_t *insp;
-	amo_opfunc_t *fp;
-	int i, j;
+	struct amo_opcode_entry *entry;
+	unsigned char types[OPERAND_PER_INSTRUCTION_MAX];
+	unsigned int signature, i;
+	const amo_opcode_t *op;
 
 	memset (&insn, 0, sizeof (struct amo_instruction));
 
 	str = parse_mnemonic (str);
 	str = parse_operands (str);
 
-	insp = insn_search (insn.name);
-	fp = amo_opfuncs + (unsigned int) (insp - amo_opcodes);
-	if (!insp)
+	entry = hash_find (amo_opcode_hash, insn.name);
+	if (!entry)
 	{
 		as_bad ("unknown instruction '%s'", insn.name);
 		return ;
 	}
-	for (i = 0; i < OPERATION_PER_INSTRUCTION_MAX; i++)
-	{
-		if (!fp->operations[i].f || insn.number != insp->operations[i].condition.number)
-			/* skip */
-			continue;
 
-		for (j = 0; j < insp->operations[i].condition.number; j++)
-			if (insn.operands[j].X_op != insp->operations[i].condition.types[j])
-				break;
-		if (j == insp->operations[i].condition.number)
-		{
+	for (i = 0; i < insn.number && i < OPERAND_PER_INSTRUCTION_MAX; i++)
+		types[i] = insn.operands[i].X_op;
+	signature = operand_signature (insn.number, types);
+
+	for (i = 0; i < entry->count; i++)
+	{
+		op = &entry->opcode[i];
+		if (insn.number == op->condition.number && signature == entry->signatures[i])
 			/* matched ! */
-			fp->operations[i].f (insp->operations[i].opcode, fp->operations[i].parameter);
 			break;
-		}
 	}
-	if (i == OPERATION_PER_INSTRUCTION_MAX)
+	if (i == entry->count)
+	{
 		as_bad ("invalid usage: '%s'", insn.name);
+		return ;
+	}
+
+	switch (op->format)
+	{
+		case AMO_FORMAT_MOV_IMM:
+		case AMO_FORMAT_MOV_LITERAL:
+			emit_mov (op);
+			break;
+
+		case AMO_FORMAT_BRANCH:
+			emit_branch (op);
+			break;
+
+		case AMO_FORMAT_JUMP:
+			emit_jump (op);
+			break;
+
+		default:
+			emit_fields (op);
+			break;
+	}
+	literal_pool_check (op->opcode);
 }
 
+/* write out POOL at the current location of its section */
 static void
-pseudo_literals (int ignored ATTRIBUTE_UNUSED)
+literal_pool_dump (struct litpool *pool)
 {
 	unsigned long binary;
 	char *preserved_name;
@@ -921,15 +887,16 @@ pseudo_literals (int ignored ATTRIBUTE_UNUSED)
 	int i, where;
 	char *frag;
 
-	if (literal_pool.index == 0)
+	if (pool->index == 0)
 		/* there is no need to build the literal pool */
 		return ;
 
-	/* align segment */
+	/* data directives may have left the section unaligned */
+	frag_align (2, 0, 0);
 	record_alignment (now_seg, 2);
 
 	/* get the preserved name */
-	sprintf (pool_name, LITERAL_POOL_NAME_DEFAULT, literal_pool.id);
+	sprintf (pool_name, LITERAL_POOL_NAME_DEFAULT, literal_pool_id++);
 	obstack_grow (&notes, pool_name, strlen (pool_name) + 1);
 	preserved_name = (char *) obstack_finish (&notes);
 
@@ -938,12 +905,12 @@ pseudo_literals (int ignored ATTRIBUTE_UNUSED)
 #endif
 
 	/* attribute */
-	S_SET_NAME (literal_pool.symbol, preserved_name);
-	S_SET_SEGMENT (literal_pool.symbol, now_seg);
-	S_SET_VALUE (literal_pool.symbol, (valueT) frag_now_fix ());
+	S_SET_NAME (pool->symbol, preserved_name);
+	S_SET_SEGMENT (pool->symbol, now_seg);
+	S_SET_VALUE (pool->symbol, (valueT) frag_now_fix ());
 
-	symbol_clear_list_pointers (literal_pool.symbol);
-	symbol_set_frag (literal_pool.symbol, frag_now);
+	symbol_clear_list_pointers (pool->symbol);
+	symbol_set_frag (pool->symbol, frag_now);
 
 	/* link to end of symbol chain.  */
 	{
@@ -953,27 +920,27 @@ pseudo_literals (int ignored ATTRIBUTE_UNUSED)
 			abort ();
 	}
 	/* insert the symbol at fragment */
-	symbol_append (literal_pool.symbol, symbol_lastP, &symbol_rootP, &symbol_lastP);
+	symbol_append (pool->symbol, symbol_lastP, &symbol_rootP, &symbol_lastP);
 
-	obj_symbol_new_hook (literal_pool.symbol);
-	symbol_table_insert (literal_pool.symbol);
+	obj_symbol_new_hook (pool->symbol);
+	symbol_table_insert (pool->symbol);
 
-	for (i = 0; i < literal_pool.index; i++)
+	for (i = 0; i < pool->index; i++)
 	{
 		frag = frag_more (BYTES_PER_INSTRUCTION);
 
-		switch (literal_pool.literals[i].X_op)
+		switch (pool->literals[i].X_op)
 		{
 			case O_constant:
-				binary = literal_pool.literals[i].X_add_number;
+				binary = pool->literals[i].X_add_number;
 				break;
 
 			case O_symbol:
 				binary = 0;
 				where = frag - frag_now->fr_literal;
-				literal_pool.literals[i].X_add_number = 0;
+				pool->literals[i].X_add_number = 0;
 
-				fix_new_exp (frag_now, where, BYTES_PER_INSTRUCTION, &literal_pool.literals[i], 0, BFD_RELOC_AMO_32);
+				fix_new_exp (frag_now, where, BYTES_PER_INSTRUCTION, &pool->literals[i], 0, BFD_RELOC_AMO_32);
 				break;
 
 			default:
@@ -983,9 +950,21 @@ pseudo_literals (int ignored ATTRIBUTE_UNUSED)
 		md_number_to_chars (frag, binary, BYTES_PER_INSTRUCTION);
 	}
 
-	literal_pool.symbol = symbol_create (FAKE_LABEL_NAME, undefined_section, (valueT) 0, &zero_address_frag);
-	literal_pool.index = 0;
-	literal_pool.id++;
+	pool->symbol = symbol_create (FAKE_LABEL_NAME, undefined_section, (valueT) 0, &zero_address_frag);
+	pool->index = 0;
+
+	memset (pool->slots, -1, pool->size * 2 * sizeof (int));
+	pool->distance = 0;
+}
+
+static void
+pseudo_literals (int ignored ATTRIBUTE_UNUSED)
+{
+	struct litpool *pool;
+
+	pool = literal_pool_find ();
+	if (pool)
+		literal_pool_dump (pool);
 }
 
 const pseudo_typeS md_pseudo_table[] =
@@ -999,7 +978,22 @@ const pseudo_typeS md_pseudo_table[] =
 void
 amo_md_end (void)
 {
-	pseudo_literals (0);
+	struct litpool *pool;
+
+	/* every section gets its pending pool at its end */
+	for (pool = list_of_pools; pool; pool = pool->next)
+	{
+		subseg_set (pool->section, pool->sub_section);
+		literal_pool_dump (pool);
+	}
+}
+
+/* the branches and literal loads all carry relocs, so the linker may
+   delete the literal words it relaxes away */
+void
+amo_elf_final_processing (void)
+{
+	elf_elfheader (stdoutput)->e_flags |= EF_AMO_LINKRELAX_PREPARED;
 }
 
 symbolS *
@@ -1028,14 +1022,87 @@ md_section_align (asection *seg, valueT size)
 	return new_size;
 }
 
+/* the branch with the opposite condition, operands are swapped when the
+   inverse of '<' or '<=' has to be expressed with the other one */
+static unsigned long
+branch_invert (unsigned long binary)
+{
+	unsigned int src, opn;
+	unsigned char opcode;
+
+	opcode = AMO_GET (OPCODE, binary);
+	src = AMO_GET (RA, binary);
+	opn = AMO_GET (RB, binary);
+
+	switch (opcode)
+	{
+		case AMO_OP_BEQ:
+			return AMO_PUT (OPCODE, AMO_OP_BNE) | AMO_PUT (RA, src) | AMO_PUT (RB, opn);
+		case AMO_OP_BNE:
+			return AMO_PUT (OPCODE, AMO_OP_BEQ) | AMO_PUT (RA, src) | AMO_PUT (RB, opn);
+		case AMO_OP_BLT:
+			return AMO_PUT (OPCODE, AMO_OP_BLE) | AMO_PUT (RA, opn) | AMO_PUT (RB, src);
+		case AMO_OP_BLE:
+			return AMO_PUT (OPCODE, AMO_OP_BLT) | AMO_PUT (RA, opn) | AMO_PUT (RB, src);
+		case AMO_OP_BLTU:
+			return AMO_PUT (OPCODE, AMO_OP_BLEU) | AMO_PUT (RA, opn) | AMO_PUT (RB, src);
+		case AMO_OP_BLEU:
+			return AMO_PUT (OPCODE, AMO_OP_BLTU) | AMO_PUT (RA, opn) | AMO_PUT (RB, src);
+		default:
+			/* impossible ! */
+			abort ();
+	}
+}
+
+/* write out the relaxed branch held in the variable part of FRAGP */
+static void
+branch_convert (fragS *fragp, int state)
+{
+	unsigned long binary;
+	expressionS exp;
+	fixS *fixP;
+	char *buf;
+
+	buf = fragp->fr_literal + fragp->fr_fix;
+	binary = bfd_getl32 (buf);
+
+	memset (&exp, 0, sizeof (expressionS));
+	exp.X_op = O_symbol;
+	exp.X_add_symbol = fragp->fr_symbol;
+	exp.X_add_number = fragp->fr_offset;
+
+	if (state == RELAX_BRANCH_SHORT)
+	{
+		fixP = fix_new_exp (fragp, fragp->fr_fix, BYTES_PER_INSTRUCTION, &exp, 1, BFD_RELOC_AMO_PCREL);
+		fixP->fx_offset = -4;
+		fixP->fx_file = fragp->fr_file;
+		fixP->fx_line = fragp->fr_line;
+
+		fragp->fr_fix += BYTES_PER_INSTRUCTION;
+		return ;
+	}
+
+	/* skip the jmp when the original condition does not hold */
+	md_number_to_chars (buf, branch_invert (binary) | 1, BYTES_PER_INSTRUCTION);
+	md_number_to_chars (buf + BYTES_PER_INSTRUCTION, AMO_PUT (OPCODE, AMO_OP_JMPI), BYTES_PER_INSTRUCTION);
+
+	fixP = fix_new_exp (fragp, fragp->fr_fix + BYTES_PER_INSTRUCTION, BYTES_PER_INSTRUCTION, &exp, 0, BFD_RELOC_AMO_28);
+	fixP->fx_file = fragp->fr_file;
+	fixP->fx_line = fragp->fr_line;
+
+	fragp->fr_fix += 2 * BYTES_PER_INSTRUCTION;
+}
+
 void
-md_convert_frag (bfd *abfd ATTRIBUTE_UNUSED, asection *seg ATTRIBUTE_UNUSED, fragS *fragp ATTRIBUTE_UNUSED)
+md_convert_frag (bfd *abfd ATTRIBUTE_UNUSED, asection *seg ATTRIBUTE_UNUSED, fragS *fragp)
 {
-	as_fatal(_("unexpected call"));
+	branch_convert (fragp, fragp->fr_subtype);
+	fragp->fr_var = 0;
 }
 
-void md_apply_fix (fixS *fixP, valueT *valP, segT seg ATTRIBUTE_UNUSED)
+void md_apply_fix (fixS *fixP, valueT *valP, segT seg)
 {
+	unsigned long binary;
 	char *buf;
 	long val;
 	
@@ -1045,7 +1112,7 @@ void md_apply_fix (fixS *fixP, valueT *valP, segT seg ATTRIBUTE_UNUSED)
 	switch (fixP->fx_r_type)
 	{
 		case BFD_RELOC_AMO_LITERAL:
-			fixP->fx_no_overflow = (-1048576 <= val && val <= 1048575);
+			fixP->fx_no_overflow = (AMO_SMIN (IMM21) <= val && val <= AMO_SMAX (IMM21));
 			if (!fixP->fx_no_overflow)
 				as_bad_where (fixP->fx_file, fixP->fx_line, _("literal out of range"));
 			if (fixP->fx_addsy)
@@ -1054,33 +1121,42 @@ void md_apply_fix (fixS *fixP, valueT *valP, segT seg ATTRIBUTE_UNUSED)
 			}
 			else
 			{	
-				*buf++ = val & MASK_IMM8;
-				*buf++ = (val >> 8) & MASK_IMM8;
-				*buf++ |= (val >> 16) & 0x1f;
+				binary = bfd_getl32 (buf);
+				binary = (binary & ~AMO_PUT (IMM21, ~0U)) | AMO_PUT (IMM21, val);
+				md_number_to_chars (buf, binary, BYTES_PER_INSTRUCTION);
 				fixP->fx_done = 1;
 			}
 			break;	
 
 		case BFD_RELOC_AMO_PCREL:
-			fixP->fx_no_overflow = (-131072 <= val && val <= 131071);
-			if (!fixP->fx_no_overflow)
-				as_bad_where (fixP->fx_file, fixP->fx_line, _("relative jump out of range"));
-			if (val & 0x3)
-				as_bad_where (fixP->fx_file, fixP->fx_line, _("invalid address"));
+			/* the distance to a target in this section is known here, the
+			   linker checks the others and puts a stub in between when the
+			   target is too far */
+			if (fixP->fx_addsy == NULL || S_GET_SEGMENT (fixP->fx_addsy) == seg)
+			{
+				fixP->fx_no_overflow = (AMO_SMIN (IMM16) * BYTES_PER_INSTRUCTION <= val
+										&& val <= AMO_SMAX (IMM16) * BYTES_PER_INSTRUCTION);
+				if (!fixP->fx_no_overflow)
+					as_bad_where (fixP->fx_file, fixP->fx_line, _("relative jump out of range"));
+				if (val & 0x3)
+					as_bad_where (fixP->fx_file, fixP->fx_line, _("invalid address"));
+			}
 			if (fixP->fx_addsy)
 			{
 				fixP->fx_done = 0;
 			}
 			else
-			{	
-				*buf++ = (val >> 2) & MASK_IMM8;
-				*buf++ = (val >> 10) & MASK_IMM8;
+			{
+				binary = bfd_getl32 (buf);
+				binary = (binary & ~AMO_PUT (IMM16, ~0U)) | AMO_PUT (IMM16, val >> 2);
+				md_number_to_chars (buf, binary, BYTES_PER_INSTRUCTION);
 				fixP->fx_done = 1;
 			}
 			break;
 
 		case BFD_RELOC_AMO_28:
-			fixP->fx_no_overflow = (-134217728 <= val && val <= 134217727);
+			fixP->fx_no_overflow = (AMO_SMIN (IMM26) * BYTES_PER_INSTRUCTION <= val
+									&& val <= AMO_SMAX (IMM26) * BYTES_PER_INSTRUCTION);
 			if (!fixP->fx_no_overflow)
 				as_bad_where (fixP->fx_file, fixP->fx_line, _("absolute jump out of range"));
 			if (val & 0x3)
@@ -1100,14 +1176,10 @@ void md_apply_fix (fixS *fixP, valueT *valP, segT seg ATTRIBUTE_UNUSED)
 			}
 			else
 			{	
-				*buf++ = val & MASK_IMM8;
-				*buf++ = (val >> 8) & MASK_IMM8;
-				*buf++ = (val >> 16) & MASK_IMM8;
-				*buf++ = (val >> 24) & MASK_IMM8;
+				md_number_to_chars (buf, val, 4);
 				fixP->fx_done = 1;
 			}
 			break;
-			break;
 
 		default:
 			/* something is wrong */
@@ -1139,11 +1211,21 @@ md_pcrel_from (fixS *fixP)
 	return fixP->fx_frag->fr_address + fixP->fx_where;
 }
 
-int md_estimate_size_before_relax (fragS *fragp ATTRIBUTE_UNUSED, asection *seg ATTRIBUTE_UNUSED)
+int md_estimate_size_before_relax (fragS *fragp, asection *seg)
 {
-	as_fatal (_("unexpected call"));
+	int old_fr_fix;
+
+	/* branches the assembler cannot resolve keep the short form and are left to the linker */
+	if (S_GET_SEGMENT (fragp->fr_symbol) != seg
+		|| S_IS_EXTERNAL (fragp->fr_symbol) || S_IS_WEAK (fragp->fr_symbol))
+	{
+		old_fr_fix = fragp->fr_fix;
+		branch_convert (fragp, RELAX_BRANCH_SHORT);
+		frag_wane (fragp);
+
+		return fragp->fr_fix - old_fr_fix;
+	}
+
+	return md_relax_table[fragp->fr_subtype].rlx_length;
 }
 
-/* clean up */
-#undef ENTRY
-#undef EMIT
@@ -34,14 +34,30 @@
 /* customize operand function called in expression (expr) */
 #define md_operand(x)
 #define md_end amo_md_end
+extern void amo_md_end (void);
 
 #define md_number_to_chars number_to_chars_littleendian
+
+/* conditional branches are relaxed through md_relax_table */
+extern const struct relax_type md_relax_table[];
+#define TC_GENERIC_RELAX_TABLE md_relax_table
 #define WORKING_DOT_WORD
 
 /* we dont need indexing */
 #define NEED_INDEX_OPERATOR 0
 #define TC_EQUAL_IN_INSN(C, NAME) 1
 
+/* keep the literal loads and the branches visible to the linker, it may
+   delete literal words it relaxes away and move the code behind them */
+#define TC_FORCE_RELOCATION_LOCAL(FIX)			\
+  (GENERIC_FORCE_RELOCATION_LOCAL (FIX)			\
+   || (FIX)->fx_r_type == BFD_RELOC_AMO_LITERAL		\
+   || (FIX)->fx_r_type == BFD_RELOC_AMO_PCREL)
+
+/* tell the linker that every pc-relative reference has a reloc */
+#define elf_tc_final_processing amo_elf_final_processing
+extern void amo_elf_final_processing (void);
+
 /* it dosen't make sense to be able to calculate register numbers arithmetically */
 #define md_register_arithmetic 0
 
@@ -0,0 +1,11 @@
+# conditional branches whose target is out of range become the inverted
+# branch over a jmp to the target
+
+	.text
+start:
+	blt r3, r4, far
+	bne r5, r6, far
+	.space 0x20000
+far:
+	beq r1, r2, start
+	ret lr
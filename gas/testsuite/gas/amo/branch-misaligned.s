@@ -0,0 +1,10 @@
+# a branch to a misaligned label of the same section is rejected by the
+# assembler, even though it is left to the linker to relocate
+
+	.text
+start:
+	beq r1, r2, odd
+	bne r1, r2, ext
+	.byte 1
+odd:
+	ret lr
@@ -0,0 +1,10 @@
+# conditional branches whose target is in range keep their short form
+
+	.text
+start:
+	beq r1, r2, next
+	blt r3, r4, start
+	.space 0x1fff0
+next:
+	bleu r5, r6, start
+	ret lr
@@ -0,0 +1,59 @@
+# every form of every instruction, with the edges of each field
+
+	.text
+	.global start
+start:
+	nop
+	.irp insn, add, adc, sub
+	\insn	r0, r31, $0
+	\insn	r31, r0, $-32768
+	\insn	r1, r2, $32767
+	\insn	r3, r4, r5
+	.endr
+	.irp insn, and, or, xor, lsl, lsr, asr
+	\insn	r31, r0, $0
+	\insn	r6, r7, $65535
+	\insn	r8, r9, r10
+	.endr
+	not	r11, $65535
+	not	r12, r13
+	ext	r14, r15, $8
+	mov	r16, $-1048576
+	mov	r17, $1048575
+	mov	r18, r19
+	mov	r20, $0x12345678
+	mov	r21, data
+	.irp insn, ldr, ldrb, ldrh
+	\insn	r22, [$-1048576]
+	\insn	r23, [$1048575]
+	\insn	r24, [sp]
+	\insn	r25, [fp, $-32768]
+	\insn	lr, [r26, $32767]
+	.endr
+	.irp insn, str, strb, strh
+	\insn	[$-4], r27
+	\insn	[sp], r28
+	\insn	[fp, $-32768], r1
+	\insn	[r2, $32767], lr
+	.endr
+back:
+	.irp insn, beq, bne, blt, ble, bltu, bleu
+	\insn	r1, r2, back
+	\insn	r3, r4, next
+	.endr
+next:
+	jmp	start
+	jmp	r5
+	jal	start
+	jal	lr
+	ret	lr
+	swi	$0
+	swi	$255
+	setvt	r6, $0xffff
+	lock
+	.ltorg
+
+	.data
+data:
+	.word	0
+	.text
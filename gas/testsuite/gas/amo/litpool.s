@@ -0,0 +1,15 @@
+# each section gets its own literal pool, and data counts towards the
+# distance after which a pending pool is dumped
+
+	.text
+start:
+	mov r1, $0x12345678
+	.space 64
+	jmp start
+	add r1, r1, $1
+
+	.section .text.other, "ax"
+other:
+	mov r2, $0x12345678
+	mov r3, other
+	ret	lr
@@ -0,0 +1,740 @@
+// amo.cc -- amo target support for gold.
+
+// Copyright (C) 2019 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// The AMO is a 32-bit little-endian processor with fixed 32-bit
+// instructions.  Its programs are linked statically, so this target
+// only resolves the four static relocations emitted by the assembler;
+// there is no GOT, PLT or dynamic section.
+
+#include "gold.h"
+
+#include "elfcpp.h"
+#include "amo.h"
+#include "parameters.h"
+#include "reloc.h"
+#include "object.h"
+#include "symtab.h"
+#include "layout.h"
+#include "output.h"
+#include "target.h"
+#include "target-reloc.h"
+#include "target-select.h"
+#include "gc.h"
+#include "icf.h"
+
+namespace
+{
+
+using namespace gold;
+
+// The AMO target.
+
+class Target_amo : public Sized_target<32, false>
+{
+ public:
+  Target_amo()
+    : Sized_target<32, false>(&amo_info)
+  { }
+
+  // Process the relocations to determine unreferenced sections for
+  // garbage collection.
+  void
+  gc_process_relocs(Symbol_table* symtab,
+		    Layout* layout,
+		    Sized_relobj_file<32, false>* object,
+		    unsigned int data_shndx,
+		    unsigned int sh_type,
+		    const unsigned char* prelocs,
+		    size_t reloc_count,
+		    Output_section* output_section,
+		    bool needs_special_offset_handling,
+		    size_t local_symbol_count,
+		    const unsigned char* plocal_symbols);
+
+  // Scan the relocations to look for symbol adjustments.
+  void
+  scan_relocs(Symbol_table* symtab,
+	      Layout* layout,
+	      Sized_relobj_file<32, false>* object,
+	      unsigned int data_shndx,
+	      unsigned int sh_type,
+	      const unsigned char* prelocs,
+	      size_t reloc_count,
+	      Output_section* output_section,
+	      bool needs_special_offset_handling,
+	      size_t local_symbol_count,
+	      const unsigned char* plocal_symbols);
+
+  // Finalize the sections.
+  void
+  do_finalize_sections(Layout*, const Input_objects*, Symbol_table*);
+
+  // Relocate a section.
+  void
+  relocate_section(const Relocate_info<32, false>*,
+		   unsigned int sh_type,
+		   const unsigned char* prelocs,
+		   size_t reloc_count,
+		   Output_section* output_section,
+		   bool needs_special_offset_handling,
+		   unsigned char* view,
+		   elfcpp::Elf_types<32>::Elf_Addr view_address,
+		   section_size_type view_size,
+		   const Reloc_symbol_changes*);
+
+  // Scan the relocs during a relocatable link.
+  void
+  scan_relocatable_relocs(Symbol_table* symtab,
+			  Layout* layout,
+			  Sized_relobj_file<32, false>* object,
+			  unsigned int data_shndx,
+			  unsigned int sh_type,
+			  const unsigned char* prelocs,
+			  size_t reloc_count,
+			  Output_section* output_section,
+			  bool needs_special_offset_handling,
+			  size_t local_symbol_count,
+			  const unsigned char* plocal_symbols,
+			  Relocatable_relocs*);
+
+  // Scan the relocs for --emit-relocs.
+  void
+  emit_relocs_scan(Symbol_table* symtab,
+		   Layout* layout,
+		   Sized_relobj_file<32, false>* object,
+		   unsigned int data_shndx,
+		   unsigned int sh_type,
+		   const unsigned char* prelocs,
+		   size_t reloc_count,
+		   Output_section* output_section,
+		   bool needs_special_offset_handling,
+		   size_t local_symbol_count,
+		   const unsigned char* plocal_syms,
+		   Relocatable_relocs* rr);
+
+  // Emit relocations for a section.
+  void
+  relocate_relocs(const Relocate_info<32, false>*,
+		  unsigned int sh_type,
+		  const unsigned char* prelocs,
+		  size_t reloc_count,
+		  Output_section* output_section,
+		  elfcpp::Elf_types<32>::Elf_Off offset_in_output_section,
+		  unsigned char* view,
+		  elfcpp::Elf_types<32>::Elf_Addr view_address,
+		  section_size_type view_size,
+		  unsigned char* reloc_view,
+		  section_size_type reloc_view_size);
+
+  // Only word relocations can take the address of a function, so
+  // --icf=safe can tell which sections are safe to fold.
+  bool
+  do_can_check_for_function_pointers() const
+  { return true; }
+
+ private:
+  // The class which scans relocations.
+  struct Scan
+  {
+    inline void
+    local(Symbol_table* symtab, Layout* layout, Target_amo* target,
+	  Sized_relobj_file<32, false>* object,
+	  unsigned int data_shndx,
+	  Output_section* output_section,
+	  const elfcpp::Rela<32, false>& reloc, unsigned int r_type,
+	  const elfcpp::Sym<32, false>& lsym,
+	  bool is_discarded);
+
+    inline void
+    global(Symbol_table* symtab, Layout* layout, Target_amo* target,
+	   Sized_relobj_file<32, false>* object,
+	   unsigned int data_shndx,
+	   Output_section* output_section,
+	   const elfcpp::Rela<32, false>& reloc, unsigned int r_type,
+	   Symbol* gsym);
+
+    inline bool
+    local_reloc_may_be_function_pointer(Symbol_table*, Layout*,
+					Target_amo*,
+					Sized_relobj_file<32, false>*,
+					unsigned int,
+					Output_section*,
+					const elfcpp::Rela<32, false>&,
+					unsigned int r_type,
+					const elfcpp::Sym<32, false>&)
+    { return possible_function_pointer_reloc(r_type); }
+
+    inline bool
+    global_reloc_may_be_function_pointer(Symbol_table*, Layout*,
+					 Target_amo*,
+					 Sized_relobj_file<32, false>*,
+					 unsigned int,
+					 Output_section*,
+					 const elfcpp::Rela<32, false>&,
+					 unsigned int r_type,
+					 Symbol*)
+    { return possible_function_pointer_reloc(r_type); }
+
+    // Branches, jumps and literal loads use their target directly;
+    // only a data word or a mov immediate can hold a function pointer.
+    static inline bool
+    possible_function_pointer_reloc(unsigned int r_type)
+    {
+      return (r_type == elfcpp::R_AMO_32
+	      || r_type == elfcpp::R_AMO_21);
+    }
+
+    static void
+    unsupported_reloc_local(Sized_relobj_file<32, false>*, unsigned int r_type);
+
+    static void
+    unsupported_reloc_global(Sized_relobj_file<32, false>*, unsigned int r_type,
+			     Symbol*);
+  };
+
+  // The class which implements relocation.
+  class Relocate
+  {
+   public:
+    // Do a relocation.  Return false if the caller should not issue
+    // any warnings about this relocation.
+    inline bool
+    relocate(const Relocate_info<32, false>*, unsigned int,
+	     Target_amo*, Output_section*, size_t, const unsigned char*,
+	     const Sized_symbol<32>*, const Symbol_value<32>*,
+	     unsigned char*, elfcpp::Elf_types<32>::Elf_Addr,
+	     section_size_type);
+  };
+
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, 32, false>
+      Classify_reloc;
+
+  // Information about this specific target which we pass to the
+  // general Target structure.
+  static const Target::Target_info amo_info;
+};
+
+const Target::Target_info Target_amo::amo_info =
+{
+  32,			// size
+  false,		// is_big_endian
+  elfcpp::EM_AMO,	// machine_code
+  false,		// has_make_symbol
+  false,		// has_resolve
+  false,		// has_code_fill
+  true,			// is_default_stack_executable
+  true,			// can_icf_inline_merge_sections
+  '\0',			// wrap_char
+  NULL,			// dynamic_linker
+  0x0,			// default_text_segment_address
+  0x1000,		// abi_pagesize (overridable by -z max-page-size)
+  0x1000,		// common_pagesize (overridable by -z common-page-size)
+  false,                // isolate_execinstr
+  0,                    // rosegment_gap
+  elfcpp::SHN_UNDEF,	// small_common_shndx
+  elfcpp::SHN_UNDEF,	// large_common_shndx
+  0,			// small_common_section_flags
+  0,			// large_common_section_flags
+  NULL,			// attributes_section
+  NULL,			// attributes_vendor
+  "_start",		// entry_symbol_name
+  32,			// hash_entry_size
+  elfcpp::SHT_PROGBITS,	// unwind_section_type
+};
+
+// Routines which write the relocated fields into the instructions.
+
+class Amo_relocate_functions
+{
+ public:
+  typedef elfcpp::Elf_types<32>::Elf_Addr Address;
+
+  enum Status
+  {
+    STATUS_OKAY,	// No error during relocation.
+    STATUS_OVERFLOW,	// Relocation overflow.
+    STATUS_BAD_RELOC	// Relocation cannot be applied (misaligned).
+  };
+
+  // R_AMO_LITERAL: S + A - P into the 21-bit immediate.
+  static inline Status
+  literal(unsigned char* view, Address value, Address address)
+  {
+    Address offset = value - address;
+    This::insert(view, offset, 0x001fffff);
+    return (Bits<21>::has_overflow32(offset)
+	    ? STATUS_OVERFLOW
+	    : STATUS_OKAY);
+  }
+
+  // R_AMO_PCREL: (S + A - P) >> 2 into the 16-bit immediate.
+  static inline Status
+  pcrel(unsigned char* view, Address value, Address address)
+  {
+    Address offset = value - address;
+    if ((offset & 3) != 0)
+      return STATUS_BAD_RELOC;
+    This::insert(view, static_cast<int32_t>(offset) >> 2, 0x0000ffff);
+    return (Bits<18>::has_overflow32(offset)
+	    ? STATUS_OVERFLOW
+	    : STATUS_OKAY);
+  }
+
+  // R_AMO_28: (S + A) >> 2 into the 26-bit jump target.
+  static inline Status
+  abs28(unsigned char* view, Address value)
+  {
+    if ((value & 3) != 0)
+      return STATUS_BAD_RELOC;
+    This::insert(view, value >> 2, 0x03ffffff);
+    return (Bits<28>::has_unsigned_overflow32(value)
+	    ? STATUS_OVERFLOW
+	    : STATUS_OKAY);
+  }
+
+  // R_AMO_21: S + A into the 21-bit immediate of a mov.
+  static inline Status
+  abs21(unsigned char* view, Address value)
+  {
+    This::insert(view, value, 0x001fffff);
+    return (Bits<21>::has_overflow32(value)
+	    ? STATUS_OVERFLOW
+	    : STATUS_OKAY);
+  }
+
+  // R_AMO_32: S + A.
+  static inline Status
+  abs32(unsigned char* view, Address value)
+  {
+    elfcpp::Swap<32, false>::writeval(view, value);
+    return STATUS_OKAY;
+  }
+
+ private:
+  typedef Amo_relocate_functions This;
+
+  // Replace the bits of the instruction at VIEW selected by MASK.
+  static inline void
+  insert(unsigned char* view, Address value, uint32_t mask)
+  {
+    typedef elfcpp::Swap<32, false>::Valtype Valtype;
+    Valtype* wv = reinterpret_cast<Valtype*>(view);
+    Valtype val = elfcpp::Swap<32, false>::readval(wv);
+    val = (val & ~mask) | (value & mask);
+    elfcpp::Swap<32, false>::writeval(wv, val);
+  }
+};
+
+// Report an unsupported relocation against a local symbol.
+
+void
+Target_amo::Scan::unsupported_reloc_local(
+    Sized_relobj_file<32, false>* object,
+    unsigned int r_type)
+{
+  gold_error(_("%s: unsupported reloc %u against local symbol"),
+	     object->name().c_str(), r_type);
+}
+
+// Report an unsupported relocation against a global symbol.
+
+void
+Target_amo::Scan::unsupported_reloc_global(
+    Sized_relobj_file<32, false>* object,
+    unsigned int r_type,
+    Symbol* gsym)
+{
+  gold_error(_("%s: unsupported reloc %u against global symbol %s"),
+	     object->name().c_str(), r_type, gsym->demangled_name().c_str());
+}
+
+// Scan a relocation for a local symbol.  Every relocation is resolved
+// statically, so there is nothing to allocate.
+
+inline void
+Target_amo::Scan::local(Symbol_table*,
+			Layout*,
+			Target_amo*,
+			Sized_relobj_file<32, false>* object,
+			unsigned int,
+			Output_section*,
+			const elfcpp::Rela<32, false>&,
+			unsigned int r_type,
+			const elfcpp::Sym<32, false>&,
+			bool is_discarded)
+{
+  if (is_discarded)
+    return;
+
+  switch (r_type)
+    {
+    case elfcpp::R_AMO_NONE:
+    case elfcpp::R_AMO_LITERAL:
+    case elfcpp::R_AMO_PCREL:
+    case elfcpp::R_AMO_28:
+    case elfcpp::R_AMO_32:
+    case elfcpp::R_AMO_21:
+      break;
+
+    default:
+      unsupported_reloc_local(object, r_type);
+      break;
+    }
+}
+
+// Scan a relocation for a global symbol.
+
+inline void
+Target_amo::Scan::global(Symbol_table*,
+			 Layout*,
+			 Target_amo*,
+			 Sized_relobj_file<32, false>* object,
+			 unsigned int,
+			 Output_section*,
+			 const elfcpp::Rela<32, false>&,
+			 unsigned int r_type,
+			 Symbol* gsym)
+{
+  switch (r_type)
+    {
+    case elfcpp::R_AMO_NONE:
+    case elfcpp::R_AMO_LITERAL:
+    case elfcpp::R_AMO_PCREL:
+    case elfcpp::R_AMO_28:
+    case elfcpp::R_AMO_32:
+    case elfcpp::R_AMO_21:
+      if (gsym->is_from_dynobj())
+	gold_error(_("%s: symbol %s is defined in a shared object, "
+		     "which is not supported on AMO"),
+		   object->name().c_str(), gsym->demangled_name().c_str());
+      break;
+
+    default:
+      unsupported_reloc_global(object, r_type, gsym);
+      break;
+    }
+}
+
+// Process relocations for gc.
+
+void
+Target_amo::gc_process_relocs(Symbol_table* symtab,
+			      Layout* layout,
+			      Sized_relobj_file<32, false>* object,
+			      unsigned int data_shndx,
+			      unsigned int,
+			      const unsigned char* prelocs,
+			      size_t reloc_count,
+			      Output_section* output_section,
+			      bool needs_special_offset_handling,
+			      size_t local_symbol_count,
+			      const unsigned char* plocal_symbols)
+{
+  gold::gc_process_relocs<32, false, Target_amo, Scan, Classify_reloc>(
+    symtab,
+    layout,
+    this,
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_symbols);
+}
+
+// Scan relocations for a section.
+
+void
+Target_amo::scan_relocs(Symbol_table* symtab,
+			Layout* layout,
+			Sized_relobj_file<32, false>* object,
+			unsigned int data_shndx,
+			unsigned int sh_type,
+			const unsigned char* prelocs,
+			size_t reloc_count,
+			Output_section* output_section,
+			bool needs_special_offset_handling,
+			size_t local_symbol_count,
+			const unsigned char* plocal_symbols)
+{
+  if (sh_type == elfcpp::SHT_REL)
+    {
+      gold_error(_("%s: unsupported REL reloc section"),
+		 object->name().c_str());
+      return;
+    }
+
+  gold::scan_relocs<32, false, Target_amo, Scan, Classify_reloc>(
+    symtab,
+    layout,
+    this,
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_symbols);
+}
+
+// Finalize the sections.  AMO programs have no dynamic linker.
+
+void
+Target_amo::do_finalize_sections(Layout*, const Input_objects*,
+				 Symbol_table*)
+{
+  if (!parameters->options().relocatable()
+      && !parameters->doing_static_link())
+    gold_fatal(_("dynamic linking is not supported on AMO"));
+}
+
+// Perform a relocation.
+
+inline bool
+Target_amo::Relocate::relocate(const Relocate_info<32, false>* relinfo,
+			       unsigned int,
+			       Target_amo*,
+			       Output_section*,
+			       size_t relnum,
+			       const unsigned char* preloc,
+			       const Sized_symbol<32>* gsym,
+			       const Symbol_value<32>* psymval,
+			       unsigned char* view,
+			       elfcpp::Elf_types<32>::Elf_Addr address,
+			       section_size_type)
+{
+  if (view == NULL)
+    return true;
+
+  typedef Amo_relocate_functions Reloc_funcs;
+  const elfcpp::Rela<32, false> rela(preloc);
+  unsigned int r_type = elfcpp::elf_r_type<32>(rela.get_r_info());
+  const Sized_relobj_file<32, false>* object = relinfo->object;
+  const elfcpp::Elf_Xword addend = rela.get_r_addend();
+  elfcpp::Elf_types<32>::Elf_Addr value = psymval->value(object, addend);
+  Reloc_funcs::Status reloc_status = Reloc_funcs::STATUS_OKAY;
+
+  switch (r_type)
+    {
+    case elfcpp::R_AMO_NONE:
+      break;
+
+    case elfcpp::R_AMO_LITERAL:
+      reloc_status = Reloc_funcs::literal(view, value, address);
+      break;
+
+    case elfcpp::R_AMO_PCREL:
+      reloc_status = Reloc_funcs::pcrel(view, value, address);
+      break;
+
+    case elfcpp::R_AMO_28:
+      reloc_status = Reloc_funcs::abs28(view, value);
+      break;
+
+    case elfcpp::R_AMO_32:
+      reloc_status = Reloc_funcs::abs32(view, value);
+      break;
+
+    case elfcpp::R_AMO_21:
+      reloc_status = Reloc_funcs::abs21(view, value);
+      break;
+
+    default:
+      gold_error_at_location(relinfo, relnum, rela.get_r_offset(),
+			     _("unexpected reloc %u in object file"),
+			     r_type);
+      break;
+    }
+
+  switch (reloc_status)
+    {
+    case Reloc_funcs::STATUS_OKAY:
+      break;
+    case Reloc_funcs::STATUS_OVERFLOW:
+      gold_error_at_location(relinfo, relnum, rela.get_r_offset(),
+			     _("relocation overflow in reloc %u against %s"),
+			     r_type, (gsym != NULL
+				      ? gsym->demangled_name().c_str()
+				      : _("local symbol")));
+      break;
+    case Reloc_funcs::STATUS_BAD_RELOC:
+      gold_error_at_location(relinfo, relnum, rela.get_r_offset(),
+			     _("misaligned target in reloc %u"),
+			     r_type);
+      break;
+    default:
+      gold_unreachable();
+    }
+
+  return true;
+}
+
+// Relocate section data.
+
+void
+Target_amo::relocate_section(const Relocate_info<32, false>* relinfo,
+			     unsigned int sh_type,
+			     const unsigned char* prelocs,
+			     size_t reloc_count,
+			     Output_section* output_section,
+			     bool needs_special_offset_handling,
+			     unsigned char* view,
+			     elfcpp::Elf_types<32>::Elf_Addr address,
+			     section_size_type view_size,
+			     const Reloc_symbol_changes* reloc_symbol_changes)
+{
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::relocate_section<32, false, Target_amo, Relocate,
+			 gold::Default_comdat_behavior, Classify_reloc>(
+    relinfo,
+    this,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    view,
+    address,
+    view_size,
+    reloc_symbol_changes);
+}
+
+// Scan the relocs during a relocatable link.
+
+void
+Target_amo::scan_relocatable_relocs(Symbol_table* symtab,
+				    Layout* layout,
+				    Sized_relobj_file<32, false>* object,
+				    unsigned int data_shndx,
+				    unsigned int sh_type,
+				    const unsigned char* prelocs,
+				    size_t reloc_count,
+				    Output_section* output_section,
+				    bool needs_special_offset_handling,
+				    size_t local_symbol_count,
+				    const unsigned char* plocal_symbols,
+				    Relocatable_relocs* rr)
+{
+  typedef gold::Default_scan_relocatable_relocs<Classify_reloc>
+      Scan_relocatable_relocs;
+
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::scan_relocatable_relocs<32, false, Scan_relocatable_relocs>(
+    symtab,
+    layout,
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_symbols,
+    rr);
+}
+
+// Scan the relocs for --emit-relocs.
+
+void
+Target_amo::emit_relocs_scan(Symbol_table* symtab,
+			     Layout* layout,
+			     Sized_relobj_file<32, false>* object,
+			     unsigned int data_shndx,
+			     unsigned int sh_type,
+			     const unsigned char* prelocs,
+			     size_t reloc_count,
+			     Output_section* output_section,
+			     bool needs_special_offset_handling,
+			     size_t local_symbol_count,
+			     const unsigned char* plocal_syms,
+			     Relocatable_relocs* rr)
+{
+  typedef gold::Default_emit_relocs_strategy<Classify_reloc>
+      Emit_relocs_strategy;
+
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::scan_relocatable_relocs<32, false, Emit_relocs_strategy>(
+    symtab,
+    layout,
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_syms,
+    rr);
+}
+
+// Emit relocations for a section.
+
+void
+Target_amo::relocate_relocs(
+    const Relocate_info<32, false>* relinfo,
+    unsigned int sh_type,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    Output_section* output_section,
+    elfcpp::Elf_types<32>::Elf_Off offset_in_output_section,
+    unsigned char* view,
+    elfcpp::Elf_types<32>::Elf_Addr view_address,
+    section_size_type view_size,
+    unsigned char* reloc_view,
+    section_size_type reloc_view_size)
+{
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::relocate_relocs<32, false, Classify_reloc>(
+    relinfo,
+    prelocs,
+    reloc_count,
+    output_section,
+    offset_in_output_section,
+    view,
+    view_address,
+    view_size,
+    reloc_view,
+    reloc_view_size);
+}
+
+// The selector for AMO object files.
+
+class Target_selector_amo : public Target_selector
+{
+public:
+  Target_selector_amo()
+    : Target_selector(elfcpp::EM_AMO, 32, false, "elf32-amo", "elf32amo")
+  { }
+
+  Target*
+  do_instantiate_target()
+  { return new Target_amo(); }
+};
+
+Target_selector_amo target_selector_amo;
+
+} // End anonymous namespace.
@@ -199,9 +199,9 @@ Archive::Archive(const std::string& name, Input_file* input_file,
                  bool is_thin_archive, Dirsearch* dirpath, Task* task)
   : Library_base(task), name_(name), input_file_(input_file), armap_(),
     armap_names_(), extended_names_(), armap_checked_(), seen_offsets_(),
-    members_(), is_thin_archive_(is_thin_archive), included_member_(false),
-    nested_archives_(), dirpath_(dirpath), num_members_(0),
-    included_all_members_(false)
+    armap_index_(), members_(), is_thin_archive_(is_thin_archive),
+    included_member_(false), nested_archives_(), dirpath_(dirpath),
+    num_members_(0), included_all_members_(false)
 {
   this->no_export_ =
     parameters->options().check_excluded_libs(input_file->found_name());
@@ -767,6 +767,26 @@ Archive::read_symbols(off_t off)
   this->members_[off] = member;
 }
 
+// Return the index of the next armap entry at or after I to look at
+// in this pass of Archive::add_symbols.  If SCAN_ALL is true we look
+// at every entry.  Otherwise we only look at the entries in PENDING,
+// which are all after the entry we just looked at.  Return END when
+// there are no more entries.
+
+static size_t
+next_armap_entry(bool scan_all, std::set<size_t>* pending, size_t i,
+		 size_t end)
+{
+  if (scan_all)
+    return i;
+  if (pending->empty())
+    return end;
+  size_t ret = *pending->begin();
+  gold_assert(ret >= i);
+  pending->erase(pending->begin());
+  return ret;
+}
+
 // Select members from the archive and add them to the link.  We walk
 // through the elements in the archive map, and look each one up in
 // the symbol table.  If it exists as a strong undefined symbol, we
@@ -776,6 +796,12 @@ Archive::read_symbols(off_t off)
 // the normal case, false if the first member we tried to add from
 // this archive had an incompatible target.
 
+// Only the symbols of the members we pull in change while we are
+// doing this, so after the first pass we only look again at the
+// armap entries named by those symbols.  We look at them in the same
+// order as a complete pass would, so the members are included in the
+// same order.
+
 bool
 Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 		     Input_objects* input_objects, Mapfile* mapfile)
@@ -797,16 +823,23 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
   // offset we saw that was present in the seen_offsets_ set.
   off_t last_seen_offset = -1;
 
+  // The entries to look at later in this pass, and the entries to
+  // look at in the next pass, when SCAN_ALL is false.
+  std::set<size_t> pending;
+  std::set<size_t> deferred;
+  bool scan_all = true;
+
   // Track which symbols in the symbol table we've already found to be
   // defined.
 
   char* tmpbuf = NULL;
   size_t tmpbuflen = 0;
-  bool added_new_object;
   do
     {
-      added_new_object = false;
-      for (size_t i = 0; i < armap_size; ++i)
+      bool rescan_all = false;
+      for (size_t i = next_armap_entry(scan_all, &pending, 0, armap_size);
+	   i < armap_size;
+	   i = next_armap_entry(scan_all, &pending, i + 1, armap_size))
 	{
           if (this->armap_checked_[i])
             continue;
@@ -843,19 +876,33 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 	  last_seen_offset = this->armap_[i].file_offset;
 	  this->seen_offsets_.insert(last_seen_offset);
 
+	  Object* obj;
 	  if (!this->include_member(symtab, layout, input_objects,
 				    last_seen_offset, mapfile, sym,
-				    why.c_str()))
+				    why.c_str(), &obj))
 	    {
 	      if (tmpbuf != NULL)
 		free(tmpbuf);
 	      return false;
 	    }
 
-	  added_new_object = true;
+	  // If we don't know which entries OBJ affects, look at all the
+	  // rest of them in this pass, and at all of them in the next.
+	  if (obj != NULL
+	      && !rescan_all
+	      && !this->queue_armap_entries(obj, i, &pending, &deferred))
+	    {
+	      scan_all = true;
+	      rescan_all = true;
+	    }
 	}
+
+      // Anything left in PENDING was covered by a complete pass.
+      pending.swap(deferred);
+      deferred.clear();
+      scan_all = rescan_all;
     }
-  while (added_new_object);
+  while (scan_all || !pending.empty());
 
   if (tmpbuf != NULL)
     free(tmpbuf);
@@ -865,6 +912,76 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
   return true;
 }
 
+// Build the index of the archive map by symbol name.  Versioned names
+// are indexed without the version, so that they are found from the
+// name of the symbol.
+
+void
+Archive::build_armap_index()
+{
+  if (!this->armap_index_.empty())
+    return;
+
+  const size_t armap_size = this->armap_.size();
+  for (size_t i = 0; i < armap_size; ++i)
+    {
+      const char* name = (this->armap_names_.data()
+			  + this->armap_[i].name_offset);
+      const char* ver = strchr(name, '@');
+      size_t len = ver != NULL ? ver - name : strlen(name);
+      this->armap_index_.insert(std::make_pair(Armap_name(name, len), i));
+    }
+}
+
+// OBJ has just been included in the link while looking at armap entry
+// I.  Its global symbols are the only ones whose state may have
+// changed, so find the unchecked armap entries with the same names.
+// The entries after I go in PENDING, to be looked at later in this
+// pass.  The others go in DEFERRED, for the next pass.  Return false
+// if we can't get the symbols of OBJ, in which case the caller must
+// look at every entry again.
+
+bool
+Archive::queue_armap_entries(Object* obj, size_t i,
+			     std::set<size_t>* pending,
+			     std::set<size_t>* deferred)
+{
+  // A plugin object doesn't keep a list of its symbols.
+  if (obj->pluginobj() != NULL)
+    return false;
+  const Object::Symbols* syms = obj->get_global_symbols();
+  if (syms == NULL)
+    return false;
+
+  this->build_armap_index();
+
+  for (Object::Symbols::const_iterator p = syms->begin();
+       p != syms->end();
+       ++p)
+    {
+      if (*p == NULL)
+	continue;
+      const char* name = (*p)->name();
+      std::pair<Armap_index::const_iterator, Armap_index::const_iterator>
+	range = this->armap_index_.equal_range(Armap_name(name,
+							  strlen(name)));
+      for (Armap_index::const_iterator q = range.first;
+	   q != range.second;
+	   ++q)
+	{
+	  size_t j = q->second;
+	  if (this->armap_checked_[j])
+	    continue;
+	  if (j > i)
+	    pending->insert(j);
+	  else
+	    deferred->insert(j);
+	}
+    }
+
+  return true;
+}
+
 // Return whether the archive includes a member which defines the
 // symbol SYM.
 
@@ -876,7 +993,11 @@ Archive::defines_symbol(Symbol* sym) const
   size_t armap_size = this->armap_.size();
   for (size_t i = 0; i < armap_size; ++i)
     {
-      if (this->armap_checked_[i])
+      // Since add_symbols only looks at some entries after its first
+      // pass, an included member may still have unchecked entries.
+      if (this->armap_checked_[i]
+	  || (this->seen_offsets_.find(this->armap_[i].file_offset)
+	      != this->seen_offsets_.end()))
 	continue;
       const char* archive_symname = (this->armap_names_.data()
 				     + this->armap_[i].name_offset);
@@ -924,7 +1045,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->first,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -936,7 +1057,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->off,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -996,10 +1117,14 @@ class Thin_archive_object_unlocker
 bool
 Archive::include_member(Symbol_table* symtab, Layout* layout,
 			Input_objects* input_objects, off_t off,
-			Mapfile* mapfile, Symbol* sym, const char* why)
+			Mapfile* mapfile, Symbol* sym, const char* why,
+			Object** objp)
 {
   ++Archive::total_members_loaded;
 
+  if (objp != NULL)
+    *objp = NULL;
+
   std::map<off_t, Archive_member>::const_iterator p = this->members_.find(off);
   if (p != this->members_.end())
     {
@@ -1013,6 +1138,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
           obj->layout(symtab, layout, sd);
           obj->add_symbols(symtab, sd, layout);
 	  this->included_member_ = true;
+	  if (objp != NULL)
+	    *objp = obj;
         }
       delete sd;
       return true;
@@ -1047,6 +1174,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
     {
       pluginobj->add_symbols(symtab, NULL, layout);
       this->included_member_ = true;
+      if (objp != NULL)
+	*objp = obj;
       return true;
     }
 
@@ -1067,6 +1196,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
   }
 
   this->included_member_ = true;
+  if (objp != NULL)
+    *objp = obj;
   return true;
 }
 
@@ -1116,6 +1247,10 @@ Add_archive_symbols::is_runnable()
 {
   if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
     return this->this_blocker_;
+  // The archive members we need depend on all of the symbols seen so
+  // far.
+  if (this->symtab_->resolve_blocker()->is_blocked())
+    return this->symtab_->resolve_blocker();
   return NULL;
 }
 
@@ -1339,6 +1474,8 @@ Add_lib_group_symbols::is_runnable()
     return this->readsyms_blocker_;
   if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
     return this->this_blocker_;
+  if (this->symtab_->resolve_blocker()->is_blocked())
+    return this->symtab_->resolve_blocker();
   return NULL;
 }
 
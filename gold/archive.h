@@ -23,6 +23,7 @@
 #ifndef GOLD_ARCHIVE_H
 #define GOLD_ARCHIVE_H
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -335,10 +336,24 @@ class Archive : public Library_base
   bool
   include_all_members(Symbol_table*, Layout*, Input_objects*, Mapfile*);
 
-  // Include an archive member in the link.
+  // Include an archive member in the link.  If OBJP is not NULL, set
+  // *OBJP to the object whose symbols were added to the symbol table,
+  // or to NULL if no symbols were added.
   bool
   include_member(Symbol_table*, Layout*, Input_objects*, off_t off,
-		 Mapfile*, Symbol*, const char* why);
+		 Mapfile*, Symbol*, const char* why, Object** objp);
+
+  // Build armap_index_ if it has not been built already.
+  void
+  build_armap_index();
+
+  // Queue the unchecked armap entries named by the global symbols of
+  // OBJ, which was just included while looking at armap entry I.
+  // Entries after I go in *PENDING, the others in *DEFERRED.  Return
+  // false if the symbols of OBJ are not available.
+  bool
+  queue_armap_entries(Object* obj, size_t i, std::set<size_t>* pending,
+		      std::set<size_t>* deferred);
 
   // Return whether we found this archive by searching a directory.
   bool
@@ -377,6 +392,37 @@ class Archive : public Library_base
     { return static_cast<size_t>(val); }
   };
 
+  // A symbol name in the archive map, without any version.  The
+  // name points into armap_names_ and is not NUL terminated.
+  struct Armap_name
+  {
+    Armap_name(const char* a_name, size_t a_len)
+      : name(a_name), len(a_len)
+    { }
+
+    const char* name;
+    size_t len;
+  };
+
+  struct Armap_name_hash
+  {
+    size_t
+    operator()(const Armap_name& n) const
+    { return gold::string_hash<char>(n.name, n.len); }
+  };
+
+  struct Armap_name_eq
+  {
+    bool
+    operator()(const Armap_name& a, const Armap_name& b) const
+    { return a.len == b.len && memcmp(a.name, b.name, a.len) == 0; }
+  };
+
+  // Map from a symbol name to the indexes of the armap entries for
+  // that name.
+  typedef Unordered_multimap<Armap_name, size_t, Armap_name_hash,
+			     Armap_name_eq> Armap_index;
+
   // For keeping track of open nested archives in a thin archive file.
   typedef Unordered_map<std::string, Archive*> Nested_archive_table;
 
@@ -395,6 +441,10 @@ class Archive : public Library_base
   std::vector<bool> armap_checked_;
   // Track which elements have been included by offset.
   Unordered_set<off_t, Seen_hash> seen_offsets_;
+  // Index of armap_ by symbol name.  This is built the first time we
+  // include a member, and is used to find the entries whose answer
+  // may have changed.
+  Armap_index armap_index_;
   // Table of objects whose symbols have been pre-read.
   std::map<off_t, Archive_member> members_;
   // True if this is a thin archive.
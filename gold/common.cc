@@ -192,22 +192,37 @@ void
 Symbol_table::do_allocate_commons(Layout* layout, Mapfile* mapfile,
 				  Sort_commons_order sort_order)
 {
-  if (!this->commons_.empty())
+  // Each shard of the symbol table keeps its own lists.  Gather them
+  // up so that the commons of one kind are laid out together.
+  Commons_type commons;
+  Commons_type tls_commons;
+  Commons_type small_commons;
+  Commons_type large_commons;
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      const Symbol_table_shard& shard(this->shards_[i]);
+      commons.insert(commons.end(), shard.commons.begin(),
+		     shard.commons.end());
+      tls_commons.insert(tls_commons.end(), shard.tls_commons.begin(),
+			 shard.tls_commons.end());
+      small_commons.insert(small_commons.end(), shard.small_commons.begin(),
+			   shard.small_commons.end());
+      large_commons.insert(large_commons.end(), shard.large_commons.begin(),
+			   shard.large_commons.end());
+    }
+
+  if (!commons.empty())
     this->do_allocate_commons_list<size>(layout, COMMONS_NORMAL,
-					 &this->commons_, mapfile,
-					 sort_order);
-  if (!this->tls_commons_.empty())
+					 &commons, mapfile, sort_order);
+  if (!tls_commons.empty())
     this->do_allocate_commons_list<size>(layout, COMMONS_TLS,
-					 &this->tls_commons_, mapfile,
-					 sort_order);
-  if (!this->small_commons_.empty())
+					 &tls_commons, mapfile, sort_order);
+  if (!small_commons.empty())
     this->do_allocate_commons_list<size>(layout, COMMONS_SMALL,
-					 &this->small_commons_, mapfile,
-					 sort_order);
-  if (!this->large_commons_.empty())
+					 &small_commons, mapfile, sort_order);
+  if (!large_commons.empty())
     this->do_allocate_commons_list<size>(layout, COMMONS_LARGE,
-					 &this->large_commons_, mapfile,
-					 sort_order);
+					 &large_commons, mapfile, sort_order);
 }
 
 // Allocate the common symbols in a list.  IS_TLS indicates whether
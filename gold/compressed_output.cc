@@ -22,56 +22,151 @@
 
 #include "gold.h"
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include "parameters.h"
 #include "options.h"
+#include "workqueue.h"
 #include "compressed_output.h"
 
 namespace gold
 {
 
-// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns true
-// if it successfully compressed, false if it failed for any reason
-// (including not having zlib support in the library).  If it returns
-// true, it allocates memory for the compressed data using new, and
-// sets *COMPRESSED_DATA and *COMPRESSED_SIZE to appropriate values.
-// It also writes a header before COMPRESSED_DATA: 4 bytes saying
-// "ZLIB", and 8 bytes indicating the uncompressed size, in big-endian
-// order.
+// The size of the chunks in which we compress a section.  A zlib
+// chunk continues the deflate stream of the chunks before it, and is
+// primed with the last 32K of their data, so it costs next to
+// nothing.  A zstd chunk is a frame of its own and does not see the
+// data before it, so those chunks are larger.
+
+const size_t zlib_chunk_size = 1024 * 1024;
+const size_t zstd_chunk_size = 4 * 1024 * 1024;
+
+// Compress the LEN bytes at OFFSET in BUFFER as a piece of a raw
+// deflate stream, using compression level LEVEL.  Unless IS_LAST, the
+// piece ends on a byte boundary without ending the stream, so that
+// the pieces may simply be concatenated.  Returns true if it
+// successfully compressed.  If it returns true, it allocates memory
+// for the compressed data using new, and sets *COMPRESSED_DATA,
+// *COMPRESSED_SIZE and *CHECKSUM, the adler32 checksum of the piece.
 
 static bool
-zlib_compress(int header_size,
-              const unsigned char* uncompressed_data,
-              unsigned long uncompressed_size,
-              unsigned char** compressed_data,
-              unsigned long* compressed_size)
+zlib_compress_chunk(const unsigned char* buffer,
+		    size_t offset,
+		    size_t len,
+		    bool is_last,
+		    int level,
+		    unsigned char** compressed_data,
+		    size_t* compressed_size,
+		    unsigned long* checksum)
 {
-  *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
-  *compressed_data = new unsigned char[*compressed_size + header_size];
+  z_stream strm;
+  memset(&strm, 0, sizeof strm);
+  if (deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 8,
+		   Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
 
-  int compress_level;
-  if (parameters->options().optimize() >= 1)
-    compress_level = 9;
-  else
-    compress_level = 1;
-
-  int rc = compress2(reinterpret_cast<Bytef*>(*compressed_data) + header_size,
-                     compressed_size,
-                     reinterpret_cast<const Bytef*>(uncompressed_data),
-                     uncompressed_size,
-                     compress_level);
-  if (rc == Z_OK)
+  // Give the compressor the data it would have seen in its window if
+  // it had compressed the section in one piece.
+  if (offset > 0)
     {
-      *compressed_size += header_size;
-      return true;
+      size_t dict_size = std::min(offset, static_cast<size_t>(32768));
+      if (deflateSetDictionary(&strm, buffer + offset - dict_size,
+			       dict_size) != Z_OK)
+	{
+	  deflateEnd(&strm);
+	  return false;
+	}
+    }
+
+  // Leave room for the empty block which ends a Z_SYNC_FLUSH.
+  size_t bound = deflateBound(&strm, len) + 16;
+  unsigned char* data = new unsigned char[bound];
+  strm.next_in = const_cast<Bytef*>(buffer + offset);
+  strm.avail_in = len;
+  strm.next_out = data;
+  strm.avail_out = bound;
+  int rc = deflate(&strm, is_last ? Z_FINISH : Z_SYNC_FLUSH);
+  bool ok = (is_last
+	     ? rc == Z_STREAM_END
+	     : rc == Z_OK && strm.avail_in == 0 && strm.avail_out != 0);
+  deflateEnd(&strm);
+  if (!ok)
+    {
+      delete[] data;
+      return false;
     }
+
+  *compressed_data = data;
+  *compressed_size = bound - strm.avail_out;
+  *checksum = adler32(adler32(0, NULL, 0), buffer + offset, len);
+  return true;
+}
+
+// Write the two byte zlib header that deflateInit would write for
+// compression level LEVEL to P.
+
+static void
+write_zlib_header(unsigned char* p, int level)
+{
+  unsigned int level_flags;
+  if (level < 2)
+    level_flags = 0;
+  else if (level < 6)
+    level_flags = 1;
+  else if (level == 6)
+    level_flags = 2;
   else
+    level_flags = 3;
+  unsigned int header = (Z_DEFLATED + ((MAX_WBITS - 8) << 4)) << 8;
+  header |= level_flags << 6;
+  header += 31 - header % 31;
+  elfcpp::Swap_unaligned<16, true>::writeval(p, header);
+}
+
+#ifdef HAVE_ZSTD
+
+// Compress the LEN bytes at DATA into a zstd frame.  Returns true if
+// it successfully compressed.  If it returns true, it allocates memory
+// for the compressed data using new, and sets *COMPRESSED_DATA and
+// *COMPRESSED_SIZE.
+
+static bool
+zstd_compress_chunk(const unsigned char* data,
+		    size_t len,
+		    unsigned char** compressed_data,
+		    size_t* compressed_size)
+{
+  size_t bound = ZSTD_compressBound(len);
+  unsigned char* frame = new unsigned char[bound];
+  size_t size = ZSTD_compress(frame, bound, data, len, ZSTD_CLEVEL_DEFAULT);
+  if (ZSTD_isError(size))
     {
-      delete[] *compressed_data;
-      *compressed_data = NULL;
+      delete[] frame;
       return false;
     }
+  *compressed_data = frame;
+  *compressed_size = size;
+  return true;
+}
+
+// Decompress the zstd frames in COMPRESSED_DATA of size
+// COMPRESSED_SIZE into a buffer UNCOMPRESSED_DATA of size
+// UNCOMPRESSED_SIZE.  Returns TRUE if it decompressed successfully.
+
+static bool
+zstd_decompress(const unsigned char* compressed_data,
+		unsigned long compressed_size,
+		unsigned char* uncompressed_data,
+		unsigned long uncompressed_size)
+{
+  size_t size = ZSTD_decompress(uncompressed_data, uncompressed_size,
+				compressed_data, compressed_size);
+  return !ZSTD_isError(size) && size == uncompressed_size;
 }
 
+#endif // defined(HAVE_ZSTD)
+
 // Decompress COMPRESSED_DATA of size COMPRESSED_SIZE, into a buffer
 // UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns TRUE if it
 // decompressed successfully, false if it failed.  The buffer, of
@@ -148,20 +243,19 @@ decompress_input_section(const unsigned char* compressed_data,
   if ((sh_flags & elfcpp::SHF_COMPRESSED) != 0)
     {
       unsigned int compression_header_size;
+      elfcpp::Elf_Word ch_type;
       if (size == 32)
 	{
 	  compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
 	  if (big_endian)
 	    {
 	      elfcpp::Chdr<32, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	  else
 	    {
 	      elfcpp::Chdr<32, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	}
       else if (size == 64)
@@ -170,23 +264,30 @@ decompress_input_section(const unsigned char* compressed_data,
 	  if (big_endian)
 	    {
 	      elfcpp::Chdr<64, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	  else
 	    {
 	      elfcpp::Chdr<64, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	}
       else
 	gold_unreachable();
 
-      return zlib_decompress(compressed_data + compression_header_size,
-			     compressed_size - compression_header_size,
-			     uncompressed_data,
-			     uncompressed_size);
+      if (ch_type == elfcpp::ELFCOMPRESS_ZLIB)
+	return zlib_decompress(compressed_data + compression_header_size,
+			       compressed_size - compression_header_size,
+			       uncompressed_data,
+			       uncompressed_size);
+#ifdef HAVE_ZSTD
+      if (ch_type == elfcpp::ELFCOMPRESS_ZSTD)
+	return zstd_decompress(compressed_data + compression_header_size,
+			       compressed_size - compression_header_size,
+			       uncompressed_data,
+			       uncompressed_size);
+#endif
+      return false;
     }
 
   const unsigned int zlib_header_size = 12;
@@ -211,17 +312,48 @@ decompress_input_section(const unsigned char* compressed_data,
 
 // Class Output_compressed_section.
 
-// Set the final data size of a compressed section.  This is where
-// we actually compress the section data.
+// This task compresses one chunk of an Output_compressed_section.
 
-void
-Output_compressed_section::set_final_data_size()
+class Compress_chunk_task : public Task
 {
-  off_t uncompressed_size = this->postprocessing_buffer_size();
+ public:
+  Compress_chunk_task(Output_compressed_section* os, unsigned int chunk,
+		      Task_token* final_blocker)
+    : os_(os), chunk_(chunk), final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->os_->compress_chunk(this->chunk_); }
+
+  std::string
+  get_name() const
+  { return std::string("Compress_chunk_task ") + this->os_->name(); }
 
-  // (Try to) compress the data.
-  unsigned long compressed_size;
-  unsigned char* uncompressed_data = this->postprocessing_buffer();
+ private:
+  Output_compressed_section* os_;
+  unsigned int chunk_;
+  Task_token* final_blocker_;
+};
+
+// Copy the rest of the section contents into the postprocessing
+// buffer, and split it into chunks to compress.
+
+void
+Output_compressed_section::prepare_chunks()
+{
+  gold_assert(!this->chunks_prepared_);
+  this->chunks_prepared_ = true;
 
   // At this point the contents of all regular input sections will
   // have been copied into the postprocessing buffer, and relocations
@@ -229,16 +361,161 @@ Output_compressed_section::set_final_data_size()
   // anything other than a regular input section.
   this->write_to_postprocessing_buffer();
 
-  bool success = false;
-  enum { none, gnu_zlib, gabi_zlib } compress;
+  const char* compress_debug_sections =
+    this->options_->compress_debug_sections();
+  if (strcmp(compress_debug_sections, "zlib-gnu") == 0)
+    this->compression_ = GNU_ZLIB;
+  else if (strcmp(compress_debug_sections, "zlib-gabi") == 0
+	   || strcmp(compress_debug_sections, "zlib") == 0)
+    this->compression_ = GABI_ZLIB;
+  else if (strcmp(compress_debug_sections, "zstd") == 0)
+    this->compression_ = GABI_ZSTD;
+  else
+    this->compression_ = NONE;
+
+  if (this->compression_ == NONE)
+    return;
+
+  if (parameters->options().optimize() >= 1)
+    this->compression_level_ = 9;
+  else
+    this->compression_level_ = 1;
+
+  if (this->compression_ == GABI_ZSTD)
+    this->chunk_size_ = zstd_chunk_size;
+  else
+    this->chunk_size_ = zlib_chunk_size;
+
+  size_t uncompressed_size = this->postprocessing_buffer_size();
+  size_t chunk_size = this->chunk_size_;
+  size_t count = (uncompressed_size + chunk_size - 1) / chunk_size;
+  this->chunks_.resize(std::max(count, static_cast<size_t>(1)));
+}
+
+// Compress chunk I.  The chunks are independent of each other, so
+// this may run in parallel for different chunks.
+
+void
+Output_compressed_section::compress_chunk(unsigned int i)
+{
+  Compressed_chunk* chunk = &this->chunks_[i];
+  gold_assert(!chunk->is_compressed && chunk->data == NULL);
+
+  const unsigned char* buffer = this->postprocessing_buffer();
+  size_t uncompressed_size = this->postprocessing_buffer_size();
+  size_t offset = i * this->chunk_size_;
+  size_t len = std::min(this->chunk_size_, uncompressed_size - offset);
+  bool is_last = i + 1 == this->chunks_.size();
+
+  switch (this->compression_)
+    {
+    case GNU_ZLIB:
+    case GABI_ZLIB:
+      chunk->is_compressed = zlib_compress_chunk(buffer, offset, len, is_last,
+						 this->compression_level_,
+						 &chunk->data, &chunk->size,
+						 &chunk->checksum);
+      break;
+    case GABI_ZSTD:
+#ifdef HAVE_ZSTD
+      chunk->is_compressed = zstd_compress_chunk(buffer + offset, len,
+						 &chunk->data, &chunk->size);
+#endif
+      break;
+    default:
+      gold_unreachable();
+    }
+}
+
+// Queue a task to compress each chunk.  We use workqueue->add_blocker
+// since FINAL_BLOCKER may already be released by the tasks of other
+// sections.
+
+void
+Output_compressed_section::do_queue_compress_tasks(Workqueue* workqueue,
+						   Task_token* final_blocker)
+{
+  this->prepare_chunks();
+  for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+    {
+      workqueue->add_blocker(final_blocker);
+      workqueue->queue(new Compress_chunk_task(this, i, final_blocker));
+    }
+}
+
+// Join the compressed chunks.  For zlib the result is a single zlib
+// stream: the header, the pieces of the deflate stream and the
+// combined adler32 checksum.  For zstd it is the sequence of frames.
+
+unsigned long
+Output_compressed_section::join_chunks(int header_size,
+				       off_t uncompressed_size)
+{
+  const bool is_zlib = this->compression_ != GABI_ZSTD;
+  unsigned long compressed_size = header_size;
+  if (is_zlib)
+    compressed_size += 2 + 4;
+  for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+    {
+      if (!this->chunks_[i].is_compressed)
+	return 0;
+      compressed_size += this->chunks_[i].size;
+    }
+
+  this->data_ = new unsigned char[compressed_size];
+  unsigned char* p = this->data_ + header_size;
+  if (is_zlib)
+    {
+      write_zlib_header(p, this->compression_level_);
+      p += 2;
+    }
+  unsigned long checksum = adler32(0, NULL, 0);
+  for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+    {
+      Compressed_chunk* chunk = &this->chunks_[i];
+      memcpy(p, chunk->data, chunk->size);
+      p += chunk->size;
+      if (is_zlib)
+	{
+	  size_t len = std::min(this->chunk_size_,
+				(static_cast<size_t>(uncompressed_size)
+				 - i * this->chunk_size_));
+	  checksum = adler32_combine(checksum, chunk->checksum, len);
+	}
+      delete[] chunk->data;
+      chunk->data = NULL;
+    }
+  if (is_zlib)
+    {
+      elfcpp::Swap_unaligned<32, true>::writeval(p, checksum);
+      p += 4;
+    }
+  gold_assert(static_cast<unsigned long>(p - this->data_) == compressed_size);
+  return compressed_size;
+}
+
+// Set the final data size of a compressed section.  This is where
+// we actually compress the section data, unless the compression
+// tasks have already done so.
+
+void
+Output_compressed_section::set_final_data_size()
+{
+  off_t uncompressed_size = this->postprocessing_buffer_size();
+
+  if (!this->chunks_prepared_)
+    {
+      this->prepare_chunks();
+      if (this->compression_ != NONE)
+	for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+	  this->compress_chunk(i);
+    }
+
+  unsigned long compressed_size = 0;
   int compression_header_size = 12;
   const int size = parameters->target().get_size();
-  if (strcmp(this->options_->compress_debug_sections(), "zlib-gnu") == 0)
-    compress = gnu_zlib;
-  else if (strcmp(this->options_->compress_debug_sections(), "zlib-gabi") == 0
-	   || strcmp(this->options_->compress_debug_sections(), "zlib") == 0)
+  if (this->compression_ == GABI_ZLIB || this->compression_ == GABI_ZSTD)
     {
-      compress = gabi_zlib;
       if (size == 32)
 	compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
       else if (size == 64)
@@ -246,34 +523,34 @@ Output_compressed_section::set_final_data_size()
       else
 	gold_unreachable();
     }
-  else
-    compress = none;
-  if (compress != none)
-    success = zlib_compress(compression_header_size, uncompressed_data,
-			    uncompressed_size, &this->data_,
-			    &compressed_size);
-  if (success)
+  if (this->compression_ != NONE)
+    compressed_size = this->join_chunks(compression_header_size,
+					uncompressed_size);
+  if (compressed_size != 0)
     {
       elfcpp::Elf_Xword flags = this->flags();
-      if (compress == gabi_zlib)
+      if (this->compression_ != GNU_ZLIB)
 	{
 	  // Set the SHF_COMPRESSED bit.
 	  flags |= elfcpp::SHF_COMPRESSED;
 	  const bool is_big_endian = parameters->target().is_big_endian();
 	  uint64_t addralign = this->addralign();
+	  elfcpp::Elf_Word ch_type = (this->compression_ == GABI_ZSTD
+				      ? elfcpp::ELFCOMPRESS_ZSTD
+				      : elfcpp::ELFCOMPRESS_ZLIB);
 	  if (size == 32)
 	    {
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<32, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
 	      else
 		{
 		  elfcpp::Chdr_write<32, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
@@ -283,7 +560,7 @@ Output_compressed_section::set_final_data_size()
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<64, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		  // Clear the reserved field.
@@ -292,7 +569,7 @@ Output_compressed_section::set_final_data_size()
 	      else
 		{
 		  elfcpp::Chdr_write<64, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		  // Clear the reserved field.
@@ -317,7 +594,13 @@ Output_compressed_section::set_final_data_size()
     }
   else
     {
-      gold_warning(_("not compressing section data: zlib error"));
+      if (this->compression_ == GABI_ZSTD)
+	gold_warning(_("not compressing section data: zstd error"));
+      else
+	gold_warning(_("not compressing section data: zlib error"));
+      for (unsigned int i = 0; i < this->chunks_.size(); ++i)
+	delete[] this->chunks_[i].data;
+      this->chunks_.clear();
       gold_assert(this->data_ == NULL);
       this->set_data_size(uncompressed_size);
     }
@@ -29,6 +29,7 @@
 #define GOLD_COMPRESSED_OUTPUT_H
 
 #include <string>
+#include <vector>
 
 #include "output.h"
 
@@ -51,7 +52,10 @@ decompress_input_section(const unsigned char*, unsigned long, unsigned char*,
 
 // This is used for a section whose data should be compressed.  It is
 // a regular Output_section which computes its contents into a buffer
-// and then postprocesses it.
+// and then postprocesses it.  The buffer is compressed in chunks of
+// about the same size, which are compressed by tasks of their own
+// when we are multithreaded, and then joined into one compressed
+// stream.
 
 class Output_compressed_section : public Output_section
 {
@@ -60,9 +64,16 @@ class Output_compressed_section : public Output_section
 			    const char* name, elfcpp::Elf_Word flags,
 			    elfcpp::Elf_Xword type)
     : Output_section(name, flags, type),
-      options_(options)
+      options_(options), data_(NULL), compression_(NONE),
+      compression_level_(0), chunk_size_(0), chunks_(),
+      chunks_prepared_(false)
   { this->set_requires_postprocessing(); }
 
+  // Compress chunk I of the section contents.  This is called by the
+  // compression tasks.
+  void
+  compress_chunk(unsigned int i);
+
  protected:
   // Set the final data size.
   void
@@ -72,11 +83,65 @@ class Output_compressed_section : public Output_section
   void
   do_write(Output_file*);
 
+  // Queue a task to compress each chunk of the contents.
+  void
+  do_queue_compress_tasks(Workqueue*, Task_token* final_blocker);
+
  private:
+  // The compression formats.
+  enum Compression
+  {
+    // Do not compress.
+    NONE,
+    // zlib, in a .zdebug section with a "ZLIB" header.
+    GNU_ZLIB,
+    // zlib, in a SHF_COMPRESSED section.
+    GABI_ZLIB,
+    // zstd, in a SHF_COMPRESSED section.
+    GABI_ZSTD
+  };
+
+  // A chunk of the section contents, compressed on its own.  For zlib
+  // DATA is a piece of a raw deflate stream and CHECKSUM the adler32
+  // of the chunk; for zstd DATA is a complete zstd frame.
+  struct Compressed_chunk
+  {
+    Compressed_chunk()
+      : data(NULL), size(0), checksum(0), is_compressed(false)
+    { }
+
+    unsigned char* data;
+    size_t size;
+    unsigned long checksum;
+    bool is_compressed;
+  };
+
+  // Copy the contents of anything other than the input sections into
+  // the postprocessing buffer, choose the compression format and split
+  // the buffer into chunks.
+  void
+  prepare_chunks();
+
+  // Join the compressed chunks into this->data_, after a header of
+  // HEADER_SIZE bytes.  Return the size of the result, or 0 if a
+  // chunk could not be compressed.
+  unsigned long
+  join_chunks(int header_size, off_t uncompressed_size);
+
   // The options--this includes the compression type.
   const General_options* options_;
   // The compressed data.
   unsigned char* data_;
+  // The compression format.
+  Compression compression_;
+  // The zlib compression level.
+  int compression_level_;
+  // The size of an uncompressed chunk; the last one may be smaller.
+  size_t chunk_size_;
+  // The compressed chunks.
+  std::vector<Compressed_chunk> chunks_;
+  // Whether prepare_chunks has been called.
+  bool chunks_prepared_;
   // The new section name if we do compress.
   std::string new_section_name_;
 };
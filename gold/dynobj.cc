@@ -29,6 +29,8 @@
 #include "parameters.h"
 #include "script.h"
 #include "symtab.h"
+#include "output.h"
+#include "workqueue.h"
 #include "dynobj.h"
 
 namespace gold
@@ -850,12 +852,11 @@ Sized_dynobj<size, big_endian>::do_get_global_symbol_counts(
   *used = count;
 }
 
-// Given a vector of hash codes, compute the number of hash buckets to
+// Given the number of symbols, compute the number of hash buckets to
 // use.
 
 unsigned int
-Dynobj::compute_bucket_count(const std::vector<uint32_t>& hashcodes,
-			     bool for_gnu_hash_table)
+Dynobj::compute_bucket_count(unsigned int symcount, bool for_gnu_hash_table)
 {
   // FIXME: Implement optional hash table optimization.
 
@@ -872,7 +873,6 @@ Dynobj::compute_bucket_count(const std::vector<uint32_t>& hashcodes,
   };
   const int buckets_count = sizeof buckets / sizeof buckets[0];
 
-  unsigned int symcount = hashcodes.size();
   unsigned int ret = 1;
   const double full_fraction
     = 1.0 - parameters->options().hash_bucket_empty_fraction();
@@ -914,54 +914,430 @@ Dynobj::elf_hash(const char* name)
   return h;
 }
 
-// Create a standard ELF hash table, setting *PPHASH and *PHASHLEN.
-// DYNSYMS is a vector with all the global dynamic symbols.
-// LOCAL_DYNSYM_COUNT is the number of local symbols in the dynamic
-// symbol table.
+// Class Output_data_hash_table.
+
+// The contents of a SHT_HASH or SHT_GNU_HASH section.  The size of
+// the table is known when it is created, but the contents are only
+// built when the output file is written.  The symbols are split into
+// chunks.  Each chunk is processed separately, writing what it can
+// directly into the section contents, and then the results for the
+// chunks are combined.  With --threads, a large table is built by
+// tasks, one per chunk.
+
+class Output_data_hash_table : public Output_section_data
+{
+ public:
+  Output_data_hash_table(off_t data_size, uint64_t addralign,
+			 unsigned int symcount)
+    : Output_section_data(data_size, addralign, true),
+      symcount_(symcount), chunk_count_(1), is_written_by_tasks_(false)
+  { }
+
+  // Process chunk CHUNK of the symbols.  This may run in parallel
+  // for different chunks.
+  void
+  write_chunk(Output_file*, unsigned int chunk);
+
+  // Combine the chunks once they have all been processed.
+  void
+  write_final(Output_file*);
+
+ protected:
+  // Return the number of chunks.
+  unsigned int
+  chunk_count() const
+  { return this->chunk_count_; }
+
+  // Set *FIRST and *LAST to the range of symbols in chunk CHUNK.
+  void
+  chunk_range(unsigned int chunk, unsigned int* first,
+	      unsigned int* last) const;
+
+  // Make room for the state of each chunk.  This is called once the
+  // number of chunks is known, before any chunk is processed.
+  virtual void
+  do_allocate_chunks() = 0;
+
+  // Process chunk CHUNK, given the section contents POV.
+  virtual void
+  do_write_chunk(unsigned char* pov, unsigned int chunk) = 0;
+
+  // Combine the chunks, given the section contents POV.
+  virtual void
+  do_write_final(unsigned char* pov) = 0;
+
+  void
+  do_write(Output_file*);
+
+  void
+  do_write_to_buffer(unsigned char*);
+
+  void
+  do_queue_write_tasks(Workqueue*, Output_file*, Task_token* final_blocker);
+
+  void
+  do_print_to_mapfile(Mapfile* mapfile) const
+  { mapfile->print_output_data(this, _("** hash")); }
+
+ private:
+  // The number of symbols in a chunk when the table is built by
+  // tasks.  Smaller tables are built serially as a single chunk.
+  static const unsigned int hash_chunk_size = 64 * 1024;
+
+  // Build the whole table in the buffer POV.
+  void
+  write_serially(unsigned char* pov);
+
+  // The number of symbols in the table.
+  unsigned int symcount_;
+  // The number of chunks.
+  unsigned int chunk_count_;
+  // Whether the table is built by tasks.
+  bool is_written_by_tasks_;
+};
+
+// This task processes one chunk of the symbols of a hash table.
+
+class Write_hash_chunk_task : public Task
+{
+ public:
+  Write_hash_chunk_task(Output_data_hash_table* hash, Output_file* of,
+			unsigned int chunk, Task_token* chunk_blocker)
+    : hash_(hash), of_(of), chunk_(chunk), chunk_blocker_(chunk_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->chunk_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->hash_->write_chunk(this->of_, this->chunk_); }
+
+  std::string
+  get_name() const
+  { return "Write_hash_chunk_task"; }
+
+ private:
+  Output_data_hash_table* hash_;
+  Output_file* of_;
+  unsigned int chunk_;
+  Task_token* chunk_blocker_;
+};
+
+// This task runs after every chunk of a hash table has been
+// processed, and combines the chunks.
+
+class Write_hash_final_task : public Task
+{
+ public:
+  Write_hash_final_task(Output_data_hash_table* hash, Output_file* of,
+			Task_token* chunk_blocker, Task_token* final_blocker)
+    : hash_(hash), of_(of), chunk_blocker_(chunk_blocker),
+      final_blocker_(final_blocker)
+  { }
+
+  ~Write_hash_final_task()
+  { delete this->chunk_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->chunk_blocker_->is_blocked())
+      return this->chunk_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->hash_->write_final(this->of_); }
+
+  std::string
+  get_name() const
+  { return "Write_hash_final_task"; }
+
+ private:
+  Output_data_hash_table* hash_;
+  Output_file* of_;
+  Task_token* chunk_blocker_;
+  Task_token* final_blocker_;
+};
+
+// Return the range of symbols in chunk CHUNK.
 
 void
-Dynobj::create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
-			      unsigned int local_dynsym_count,
-			      unsigned char** pphash,
-			      unsigned int* phashlen)
+Output_data_hash_table::chunk_range(unsigned int chunk, unsigned int* first,
+				    unsigned int* last) const
 {
-  unsigned int dynsym_count = dynsyms.size();
+  gold_assert(chunk < this->chunk_count_);
+  if (this->chunk_count_ == 1)
+    {
+      *first = 0;
+      *last = this->symcount_;
+    }
+  else
+    {
+      *first = chunk * hash_chunk_size;
+      *last = std::min(*first + hash_chunk_size, this->symcount_);
+    }
+}
 
-  // Get the hash values for all the symbols.
-  std::vector<uint32_t> dynsym_hashvals(dynsym_count);
-  for (unsigned int i = 0; i < dynsym_count; ++i)
-    dynsym_hashvals[i] = Dynobj::elf_hash(dynsyms[i]->name());
+// Process one chunk of the symbols, writing to the output file.
 
-  const unsigned int bucketcount =
-    Dynobj::compute_bucket_count(dynsym_hashvals, false);
+void
+Output_data_hash_table::write_chunk(Output_file* of, unsigned int chunk)
+{
+  const off_t off = this->offset();
+  const section_size_type oview_size = this->data_size();
+  unsigned char* const oview = of->get_output_view(off, oview_size);
+  this->do_write_chunk(oview, chunk);
+  of->write_output_view(off, oview_size, oview);
+}
+
+// Combine the chunks, writing to the output file.
+
+void
+Output_data_hash_table::write_final(Output_file* of)
+{
+  const off_t off = this->offset();
+  const section_size_type oview_size = this->data_size();
+  unsigned char* const oview = of->get_output_view(off, oview_size);
+  this->do_write_final(oview);
+  of->write_output_view(off, oview_size, oview);
+}
+
+// Build the whole table in POV.
+
+void
+Output_data_hash_table::write_serially(unsigned char* pov)
+{
+  this->do_allocate_chunks();
+  for (unsigned int i = 0; i < this->chunk_count_; ++i)
+    this->do_write_chunk(pov, i);
+  this->do_write_final(pov);
+}
+
+// Write the table to the output file, unless tasks do that.
+
+void
+Output_data_hash_table::do_write(Output_file* of)
+{
+  if (this->is_written_by_tasks_)
+    return;
+  const off_t off = this->offset();
+  const section_size_type oview_size = this->data_size();
+  unsigned char* const oview = of->get_output_view(off, oview_size);
+  this->write_serially(oview);
+  of->write_output_view(off, oview_size, oview);
+}
+
+// Write the table to a buffer.
+
+void
+Output_data_hash_table::do_write_to_buffer(unsigned char* buffer)
+{
+  gold_assert(!this->is_written_by_tasks_);
+  this->write_serially(buffer);
+}
+
+// Queue the tasks which build a large table.  Each chunk is
+// processed by a separate task.  When they are all done, a single
+// task combines them.
+
+void
+Output_data_hash_table::do_queue_write_tasks(Workqueue* workqueue,
+					     Output_file* of,
+					     Task_token* final_blocker)
+{
+  if (this->symcount_ <= hash_chunk_size)
+    return;
+
+  this->chunk_count_ = ((this->symcount_ + hash_chunk_size - 1)
+			/ hash_chunk_size);
+  this->is_written_by_tasks_ = true;
+
+  // The chunk tasks run in parallel, so they must not resize the
+  // vectors which hold the state of all the chunks.
+  this->do_allocate_chunks();
+
+  Task_token* chunk_blocker = new Task_token(true);
+  chunk_blocker->add_blockers(this->chunk_count_);
+  for (unsigned int i = 0; i < this->chunk_count_; ++i)
+    workqueue->queue(new Write_hash_chunk_task(this, of, i, chunk_blocker));
+
+  workqueue->add_blocker(final_blocker);
+  workqueue->queue(new Write_hash_final_task(this, of, chunk_blocker,
+					     final_blocker));
+}
+
+// A standard ELF hash table.  SIZE is the size of a hash table entry,
+// which is not always the ELF class.
+
+template<int size, bool big_endian>
+class Output_data_elf_hash : public Output_data_hash_table
+{
+ public:
+  Output_data_elf_hash(const std::vector<Symbol*>& dynsyms,
+		       unsigned int local_dynsym_count,
+		       unsigned int bucketcount, uint64_t addralign)
+    : Output_data_hash_table(((2 + bucketcount + local_dynsym_count
+			       + dynsyms.size())
+			      * size / 8),
+			     addralign, dynsyms.size()),
+      dynsyms_(dynsyms), local_dynsym_count_(local_dynsym_count),
+      bucketcount_(bucketcount), heads_(), tails_()
+  { }
+
+ protected:
+  void
+  do_allocate_chunks()
+  {
+    this->heads_.resize(this->chunk_count());
+    this->tails_.resize(this->chunk_count());
+  }
+
+  void
+  do_write_chunk(unsigned char*, unsigned int chunk);
+
+  void
+  do_write_final(unsigned char*);
+
+ private:
+  static const int entry_size = size / 8;
+
+  // The global dynamic symbols.
+  std::vector<Symbol*> dynsyms_;
+  // The number of local dynamic symbols.
+  unsigned int local_dynsym_count_;
+  // The number of hash buckets.
+  unsigned int bucketcount_;
+  // For each chunk, the dynamic symbol index of the first and last
+  // symbol of the chunk in each bucket, or 0.
+  std::vector<std::vector<uint32_t> > heads_;
+  std::vector<std::vector<uint32_t> > tails_;
+};
+
+// Hash the names of the symbols in chunk CHUNK and link each symbol
+// to the one before it in its bucket within the chunk.  The first
+// symbol in each bucket is linked to the previous chunks in
+// do_write_final.
+
+template<int size, bool big_endian>
+void
+Output_data_elf_hash<size, big_endian>::do_write_chunk(unsigned char* pov,
+						      unsigned int chunk)
+{
+  std::vector<uint32_t>& heads(this->heads_[chunk]);
+  std::vector<uint32_t>& tails(this->tails_[chunk]);
+  heads.resize(this->bucketcount_);
+  tails.resize(this->bucketcount_);
 
-  std::vector<uint32_t> bucket(bucketcount);
-  std::vector<uint32_t> chain(local_dynsym_count + dynsym_count);
+  unsigned char* pchain = pov + (2 + this->bucketcount_) * entry_size;
 
-  for (unsigned int i = 0; i < dynsym_count; ++i)
+  unsigned int first;
+  unsigned int last;
+  this->chunk_range(chunk, &first, &last);
+  for (unsigned int i = first; i < last; ++i)
     {
-      unsigned int dynsym_index = dynsyms[i]->dynsym_index();
-      unsigned int bucketpos = dynsym_hashvals[i] % bucketcount;
-      chain[dynsym_index] = bucket[bucketpos];
-      bucket[bucketpos] = dynsym_index;
+      const Symbol* sym = this->dynsyms_[i];
+      unsigned int dynsym_index = sym->dynsym_index();
+      gold_assert(dynsym_index != 0);
+      unsigned int bucketpos = (Dynobj::elf_hash(sym->name())
+				% this->bucketcount_);
+      uint32_t prev = tails[bucketpos];
+      if (prev == 0)
+	heads[bucketpos] = dynsym_index;
+      elfcpp::Swap<size, big_endian>::writeval(pchain
+					       + dynsym_index * entry_size,
+					       prev);
+      tails[bucketpos] = dynsym_index;
     }
+}
 
-  int size = parameters->target().hash_entry_size();
-  unsigned int hashlen = ((2
-			   + bucketcount
-			   + local_dynsym_count
-			   + dynsym_count)
-			  * size / 8);
-  unsigned char* phash = new unsigned char[hashlen];
+// Link the chunks together, and write the header and the buckets.
+// The last symbol in a bucket is at the head of its chain.
+
+template<int size, bool big_endian>
+void
+Output_data_elf_hash<size, big_endian>::do_write_final(unsigned char* pov)
+{
+  const unsigned int bucketcount = this->bucketcount_;
+  const unsigned int chaincount = (this->local_dynsym_count_
+				   + this->dynsyms_.size());
+
+  unsigned char* p = pov;
+  elfcpp::Swap<size, big_endian>::writeval(p, bucketcount);
+  p += entry_size;
+  elfcpp::Swap<size, big_endian>::writeval(p, chaincount);
+  p += entry_size;
+
+  unsigned char* pbucket = p;
+  unsigned char* pchain = pbucket + bucketcount * entry_size;
+
+  std::vector<uint32_t> bucket(this->tails_[0]);
+  for (unsigned int c = 1; c < this->chunk_count(); ++c)
+    {
+      const std::vector<uint32_t>& heads(this->heads_[c]);
+      const std::vector<uint32_t>& tails(this->tails_[c]);
+      for (unsigned int i = 0; i < bucketcount; ++i)
+	{
+	  if (heads[i] == 0)
+	    continue;
+	  elfcpp::Swap<size, big_endian>::writeval(pchain
+						   + heads[i] * entry_size,
+						   bucket[i]);
+	  bucket[i] = tails[i];
+	}
+    }
+
+  for (unsigned int i = 0; i < bucketcount; ++i)
+    {
+      elfcpp::Swap<size, big_endian>::writeval(p, bucket[i]);
+      p += entry_size;
+    }
+
+  // The local symbols are not in the hash table.
+  for (unsigned int i = 0; i < this->local_dynsym_count_; ++i)
+    elfcpp::Swap<size, big_endian>::writeval(pchain + i * entry_size, 0);
 
+  this->heads_.clear();
+  this->tails_.clear();
+}
+
+// Create a standard ELF hash table.  DYNSYMS is a vector with all the
+// global dynamic symbols.  LOCAL_DYNSYM_COUNT is the number of local
+// symbols in the dynamic symbol table.
+
+Output_section_data*
+Dynobj::create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
+			      unsigned int local_dynsym_count)
+{
+  const unsigned int bucketcount =
+    Dynobj::compute_bucket_count(dynsyms.size(), false);
+  const uint64_t addralign = parameters->target().get_size() / 8;
+
+  int size = parameters->target().hash_entry_size();
   bool big_endian = parameters->target().is_big_endian();
   if (size == 32)
     {
       if (big_endian)
 	{
 #if defined(HAVE_TARGET_32_BIG) || defined(HAVE_TARGET_64_BIG)
-	  Dynobj::sized_create_elf_hash_table<32, true>(bucket, chain, phash,
-							hashlen);
+	  return new Output_data_elf_hash<32, true>(dynsyms,
+						    local_dynsym_count,
+						    bucketcount, addralign);
 #else
 	  gold_unreachable();
 #endif
@@ -969,8 +1345,9 @@ Dynobj::create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
       else
 	{
 #if defined(HAVE_TARGET_32_LITTLE) || defined(HAVE_TARGET_64_LITTLE)
-	  Dynobj::sized_create_elf_hash_table<32, false>(bucket, chain, phash,
-							 hashlen);
+	  return new Output_data_elf_hash<32, false>(dynsyms,
+						     local_dynsym_count,
+						     bucketcount, addralign);
 #else
 	  gold_unreachable();
 #endif
@@ -981,8 +1358,9 @@ Dynobj::create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
       if (big_endian)
 	{
 #if defined(HAVE_TARGET_32_BIG) || defined(HAVE_TARGET_64_BIG)
-	  Dynobj::sized_create_elf_hash_table<64, true>(bucket, chain, phash,
-							hashlen);
+	  return new Output_data_elf_hash<64, true>(dynsyms,
+						    local_dynsym_count,
+						    bucketcount, addralign);
 #else
 	  gold_unreachable();
 #endif
@@ -990,8 +1368,9 @@ Dynobj::create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
       else
 	{
 #if defined(HAVE_TARGET_32_LITTLE) || defined(HAVE_TARGET_64_LITTLE)
-	  Dynobj::sized_create_elf_hash_table<64, false>(bucket, chain, phash,
-							 hashlen);
+	  return new Output_data_elf_hash<64, false>(dynsyms,
+						     local_dynsym_count,
+						     bucketcount, addralign);
 #else
 	  gold_unreachable();
 #endif
@@ -999,74 +1378,172 @@ Dynobj::create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
     }
   else
     gold_unreachable();
-
-  *pphash = phash;
-  *phashlen = hashlen;
 }
 
-// Fill in an ELF hash table.
+// A GNU hash table.  The symbols have already been sorted by bucket
+// and given their dynamic symbol indexes; the table only records
+// their hash codes, in dynamic symbol index order.
+
+template<int size, bool big_endian>
+class Output_data_gnu_hash : public Output_data_hash_table
+{
+ public:
+  Output_data_gnu_hash(std::vector<uint32_t>* hashvals,
+		       unsigned int symindx, unsigned int bucketcount,
+		       uint32_t maskbitslog2, uint32_t shift1)
+    : Output_data_hash_table(((4 + bucketcount + hashvals->size()) * 4
+			      + (1U << maskbitslog2) / 8),
+			     size / 8, hashvals->size()),
+      hashvals_(), symindx_(symindx), bucketcount_(bucketcount),
+      shift1_(shift1), shift2_(maskbitslog2), maskbits_(1U << maskbitslog2),
+      maskwords_(1U << (maskbitslog2 - shift1)), bitmasks_()
+  { this->hashvals_.swap(*hashvals); }
+
+ protected:
+  void
+  do_allocate_chunks()
+  { this->bitmasks_.resize(this->chunk_count()); }
+
+  void
+  do_write_chunk(unsigned char*, unsigned int chunk);
+
+  void
+  do_write_final(unsigned char*);
+
+ private:
+  typedef typename elfcpp::Elf_types<size>::Elf_WXword Word;
+
+  // The hash codes of the hashed symbols, in dynamic symbol index
+  // order.
+  std::vector<uint32_t> hashvals_;
+  // The dynamic symbol index of the first hashed symbol.
+  unsigned int symindx_;
+  // The number of hash buckets.
+  unsigned int bucketcount_;
+  // Bloom filter parameters.
+  uint32_t shift1_;
+  uint32_t shift2_;
+  uint32_t maskbits_;
+  uint32_t maskwords_;
+  // The Bloom filter bits set by each chunk.
+  std::vector<std::vector<Word> > bitmasks_;
+};
+
+// Write the buckets which start in chunk CHUNK and the chain entries
+// of its symbols, and set the Bloom filter bits for the chunk.  The
+// symbols are sorted by bucket, so a symbol starts a bucket if the
+// symbol before it is in a different bucket.  Each chunk also writes
+// the empty buckets before each bucket it starts; the last chunk
+// writes the empty buckets at the end.
 
 template<int size, bool big_endian>
 void
-Dynobj::sized_create_elf_hash_table(const std::vector<uint32_t>& bucket,
-				    const std::vector<uint32_t>& chain,
-				    unsigned char* phash,
-				    unsigned int hashlen)
+Output_data_gnu_hash<size, big_endian>::do_write_chunk(unsigned char* pov,
+						      unsigned int chunk)
 {
-  unsigned char* p = phash;
+  std::vector<Word>& bitmask(this->bitmasks_[chunk]);
+  bitmask.resize(this->maskwords_);
 
-  const unsigned int bucketcount = bucket.size();
-  const unsigned int chaincount = chain.size();
+  const unsigned int nsyms = this->hashvals_.size();
+  const unsigned int bucketcount = this->bucketcount_;
+  const uint32_t shift1 = this->shift1_;
+  const uint32_t shift2 = this->shift2_;
+  const uint32_t maskbits = this->maskbits_;
+  const uint32_t mask = (1U << shift1) - 1U;
 
-  elfcpp::Swap<size, big_endian>::writeval(p, bucketcount);
-  p += size / 8;
-  elfcpp::Swap<size, big_endian>::writeval(p, chaincount);
-  p += size / 8;
+  unsigned char* pbucket = pov + 16 + maskbits / 8;
+  unsigned char* pchain = pbucket + bucketcount * 4;
 
-  for (unsigned int i = 0; i < bucketcount; ++i)
+  unsigned int first;
+  unsigned int last;
+  this->chunk_range(chunk, &first, &last);
+
+  // The first bucket which has not been written.
+  unsigned int next_bucket = 0;
+  if (first > 0)
+    next_bucket = this->hashvals_[first - 1] % bucketcount + 1;
+
+  for (unsigned int i = first; i < last; ++i)
     {
-      elfcpp::Swap<size, big_endian>::writeval(p, bucket[i]);
-      p += size / 8;
+      uint32_t hashval = this->hashvals_[i];
+      unsigned int bucket = hashval % bucketcount;
+
+      if (bucket >= next_bucket)
+	{
+	  for (; next_bucket < bucket; ++next_bucket)
+	    elfcpp::Swap<32, big_endian>::writeval(pbucket + next_bucket * 4,
+						   0);
+	  elfcpp::Swap<32, big_endian>::writeval(pbucket + bucket * 4,
+						 this->symindx_ + i);
+	  next_bucket = bucket + 1;
+	}
+
+      unsigned int val = ((hashval >> shift1)
+			  & ((maskbits >> shift1) - 1));
+      bitmask[val] |= (static_cast<Word>(1U)) << (hashval & mask);
+      bitmask[val] |= (static_cast<Word>(1U)) << ((hashval >> shift2) & mask);
+      val = hashval & ~ 1U;
+      if (i + 1 == nsyms || this->hashvals_[i + 1] % bucketcount != bucket)
+	{
+	  // Last element terminates the chain.
+	  val |= 1;
+	}
+      elfcpp::Swap<32, big_endian>::writeval(pchain + i * 4, val);
     }
 
-  for (unsigned int i = 0; i < chaincount; ++i)
+  if (last == nsyms)
     {
-      elfcpp::Swap<size, big_endian>::writeval(p, chain[i]);
-      p += size / 8;
+      for (; next_bucket < bucketcount; ++next_bucket)
+	elfcpp::Swap<32, big_endian>::writeval(pbucket + next_bucket * 4, 0);
     }
-
-  gold_assert(static_cast<unsigned int>(p - phash) == hashlen);
 }
 
-// The hash function used for the GNU hash table.  This hash function
-// must not change, as the dynamic linker uses it also.
+// Write the header and the Bloom filter.
 
-uint32_t
-Dynobj::gnu_hash(const char* name)
+template<int size, bool big_endian>
+void
+Output_data_gnu_hash<size, big_endian>::do_write_final(unsigned char* pov)
 {
-  const unsigned char* nameu = reinterpret_cast<const unsigned char*>(name);
-  uint32_t h = 5381;
-  unsigned char c;
-  while ((c = *nameu++) != '\0')
-    h = (h << 5) + h + c;
-  return h;
+  elfcpp::Swap<32, big_endian>::writeval(pov, this->bucketcount_);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 4, this->symindx_);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 8, this->maskwords_);
+  elfcpp::Swap<32, big_endian>::writeval(pov + 12, this->shift2_);
+
+  std::vector<Word>& bitmask(this->bitmasks_[0]);
+  for (unsigned int c = 1; c < this->chunk_count(); ++c)
+    {
+      const std::vector<Word>& chunk_bitmask(this->bitmasks_[c]);
+      for (unsigned int i = 0; i < this->maskwords_; ++i)
+	bitmask[i] |= chunk_bitmask[i];
+    }
+
+  unsigned char* p = pov + 16;
+  for (unsigned int i = 0; i < this->maskwords_; ++i)
+    {
+      elfcpp::Swap<size, big_endian>::writeval(p, bitmask[i]);
+      p += size / 8;
+    }
+
+  this->bitmasks_.clear();
 }
 
-// Create a GNU hash table, setting *PPHASH and *PHASHLEN.  GNU hash
-// tables are an extension to ELF which are recognized by the GNU
-// dynamic linker.  They are referenced using dynamic tag DT_GNU_HASH.
-// TARGET is the target.  DYNSYMS is a vector with all the global
-// symbols which will be going into the dynamic symbol table.
+// Create a GNU hash table.  GNU hash tables are an extension to ELF
+// which are recognized by the GNU dynamic linker.  They are
+// referenced using dynamic tag DT_GNU_HASH.  DYNSYMS is a vector with
+// all the global symbols which will be going into the dynamic symbol
+// table.  DYNSYM_HASH_CODES holds the hash codes of their names;
+// these are the low 32 bits of gold::string_hash, which is the
+// DT_GNU_HASH function, so we don't hash the names again here.
 // LOCAL_DYNSYM_COUNT is the number of local symbols in the dynamic
 // symbol table.
 
-void
+Output_section_data*
 Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
-			      unsigned int local_dynsym_count,
-			      unsigned char** pphash,
-			      unsigned int* phashlen)
+			      const std::vector<uint32_t>& dynsym_hash_codes,
+			      unsigned int local_dynsym_count)
 {
   const unsigned int count = dynsyms.size();
+  gold_assert(dynsym_hash_codes.size() == count);
 
   // Sort the dynamic symbols into two vectors.  Symbols which we do
   // not want to put into the hash table we store into
@@ -1095,7 +1572,7 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
       else
 	{
 	  hashed_dynsyms.push_back(sym);
-	  dynsym_hashvals.push_back(Dynobj::gnu_hash(sym->name()));
+	  dynsym_hashvals.push_back(dynsym_hash_codes[i]);
 	}
     }
 
@@ -1118,11 +1595,8 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
       if (big_endian)
 	{
 #ifdef HAVE_TARGET_32_BIG
-	  Dynobj::sized_create_gnu_hash_table<32, true>(hashed_dynsyms,
-							dynsym_hashvals,
-							unhashed_dynsym_index,
-							pphash,
-							phashlen);
+	  return Dynobj::sized_create_gnu_hash_table<32, true>(
+	      hashed_dynsyms, &dynsym_hashvals, unhashed_dynsym_index);
 #else
 	  gold_unreachable();
 #endif
@@ -1130,11 +1604,8 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
       else
 	{
 #ifdef HAVE_TARGET_32_LITTLE
-	  Dynobj::sized_create_gnu_hash_table<32, false>(hashed_dynsyms,
-							 dynsym_hashvals,
-							 unhashed_dynsym_index,
-							 pphash,
-							 phashlen);
+	  return Dynobj::sized_create_gnu_hash_table<32, false>(
+	      hashed_dynsyms, &dynsym_hashvals, unhashed_dynsym_index);
 #else
 	  gold_unreachable();
 #endif
@@ -1145,11 +1616,8 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
       if (big_endian)
 	{
 #ifdef HAVE_TARGET_64_BIG
-	  Dynobj::sized_create_gnu_hash_table<64, true>(hashed_dynsyms,
-							dynsym_hashvals,
-							unhashed_dynsym_index,
-							pphash,
-							phashlen);
+	  return Dynobj::sized_create_gnu_hash_table<64, true>(
+	      hashed_dynsyms, &dynsym_hashvals, unhashed_dynsym_index);
 #else
 	  gold_unreachable();
 #endif
@@ -1157,11 +1625,8 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
       else
 	{
 #ifdef HAVE_TARGET_64_LITTLE
-	  Dynobj::sized_create_gnu_hash_table<64, false>(hashed_dynsyms,
-							 dynsym_hashvals,
-							 unhashed_dynsym_index,
-							 pphash,
-							 phashlen);
+	  return Dynobj::sized_create_gnu_hash_table<64, false>(
+	      hashed_dynsyms, &dynsym_hashvals, unhashed_dynsym_index);
 #else
 	  gold_unreachable();
 #endif
@@ -1171,17 +1636,17 @@ Dynobj::create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
     gold_unreachable();
 }
 
-// Create the actual data for a GNU hash table.  This is just a copy
-// of the code from the old GNU linker.
+// Set up a GNU hash table.  The sizes are straight from the old GNU
+// linker.  This sorts the hashed symbols by bucket, with a counting
+// sort, and gives them their dynamic symbol indexes; the table itself
+// is built when it is written.  DYNSYM_HASHVALS is consumed.
 
 template<int size, bool big_endian>
-void
+Output_section_data*
 Dynobj::sized_create_gnu_hash_table(
     const std::vector<Symbol*>& hashed_dynsyms,
-    const std::vector<uint32_t>& dynsym_hashvals,
-    unsigned int unhashed_dynsym_count,
-    unsigned char** pphash,
-    unsigned int* phashlen)
+    std::vector<uint32_t>* dynsym_hashvals,
+    unsigned int unhashed_dynsym_count)
 {
   if (hashed_dynsyms.empty())
     {
@@ -1201,16 +1666,13 @@ Dynobj::sized_create_gnu_hash_table(
       // No hashes in only bucket.
       elfcpp::Swap<32, big_endian>::writeval(phash + 16 + size / 8, 0);
 
-      *phashlen = hashlen;
-      *pphash = phash;
-
-      return;
+      return new Output_data_const_buffer(phash, hashlen, size / 8,
+					  "** hash");
     }
 
-  const unsigned int bucketcount =
-    Dynobj::compute_bucket_count(dynsym_hashvals, true);
-
   const unsigned int nsyms = hashed_dynsyms.size();
+  const unsigned int bucketcount =
+    Dynobj::compute_bucket_count(nsyms, true);
 
   uint32_t maskbitslog2 = 1;
   uint32_t x = nsyms >> 1;
@@ -1235,80 +1697,36 @@ Dynobj::sized_create_gnu_hash_table(
 	maskbitslog2 = 6;
       shift1 = 6;
     }
-  uint32_t mask = (1U << shift1) - 1U;
-  uint32_t shift2 = maskbitslog2;
-  uint32_t maskbits = 1U << maskbitslog2;
-  uint32_t maskwords = 1U << (maskbitslog2 - shift1);
-
-  typedef typename elfcpp::Elf_types<size>::Elf_WXword Word;
-  std::vector<Word> bitmask(maskwords);
-  std::vector<uint32_t> counts(bucketcount);
-  std::vector<uint32_t> indx(bucketcount);
-  uint32_t symindx = unhashed_dynsym_count;
 
   // Count the number of times each hash bucket is used.
+  std::vector<uint32_t> indx(bucketcount);
   for (unsigned int i = 0; i < nsyms; ++i)
-    ++counts[dynsym_hashvals[i] % bucketcount];
+    ++indx[(*dynsym_hashvals)[i] % bucketcount];
 
-  unsigned int cnt = symindx;
+  unsigned int cnt = 0;
   for (unsigned int i = 0; i < bucketcount; ++i)
     {
+      unsigned int n = indx[i];
       indx[i] = cnt;
-      cnt += counts[i];
-    }
-
-  unsigned int hashlen = (4 + bucketcount + nsyms) * 4;
-  hashlen += maskbits / 8;
-  unsigned char* phash = new unsigned char[hashlen];
-
-  elfcpp::Swap<32, big_endian>::writeval(phash, bucketcount);
-  elfcpp::Swap<32, big_endian>::writeval(phash + 4, symindx);
-  elfcpp::Swap<32, big_endian>::writeval(phash + 8, maskwords);
-  elfcpp::Swap<32, big_endian>::writeval(phash + 12, shift2);
-
-  unsigned char* p = phash + 16 + maskbits / 8;
-  for (unsigned int i = 0; i < bucketcount; ++i)
-    {
-      if (counts[i] == 0)
-	elfcpp::Swap<32, big_endian>::writeval(p, 0);
-      else
-	elfcpp::Swap<32, big_endian>::writeval(p, indx[i]);
-      p += 4;
+      cnt += n;
     }
 
+  // Give each symbol its index, keeping the symbols in each bucket in
+  // their original order.
+  std::vector<uint32_t> sorted_hashvals(nsyms);
   for (unsigned int i = 0; i < nsyms; ++i)
     {
-      Symbol* sym = hashed_dynsyms[i];
-      uint32_t hashval = dynsym_hashvals[i];
-
-      unsigned int bucket = hashval % bucketcount;
-      unsigned int val = ((hashval >> shift1)
-			  & ((maskbits >> shift1) - 1));
-      bitmask[val] |= (static_cast<Word>(1U)) << (hashval & mask);
-      bitmask[val] |= (static_cast<Word>(1U)) << ((hashval >> shift2) & mask);
-      val = hashval & ~ 1U;
-      if (counts[bucket] == 1)
-	{
-	  // Last element terminates the chain.
-	  val |= 1;
-	}
-      elfcpp::Swap<32, big_endian>::writeval(p + (indx[bucket] - symindx) * 4,
-					     val);
-      --counts[bucket];
-
-      sym->set_dynsym_index(indx[bucket]);
-      ++indx[bucket];
+      uint32_t hashval = (*dynsym_hashvals)[i];
+      unsigned int pos = indx[hashval % bucketcount]++;
+      sorted_hashvals[pos] = hashval;
+      hashed_dynsyms[i]->set_dynsym_index(unhashed_dynsym_count + pos);
     }
+  dynsym_hashvals->clear();
 
-  p = phash + 16;
-  for (unsigned int i = 0; i < maskwords; ++i)
-    {
-      elfcpp::Swap<size, big_endian>::writeval(p, bitmask[i]);
-      p += size / 8;
-    }
-
-  *phashlen = hashlen;
-  *pphash = phash;
+  return new Output_data_gnu_hash<size, big_endian>(&sorted_hashvals,
+						    unhashed_dynsym_count,
+						    bucketcount, maskbitslog2,
+						    shift1);
 }
 
 // Verdef methods.
@@ -1546,6 +1964,19 @@ Versions::record_version(const Symbol_table* symtab,
     }
 }
 
+// Record a reference to version VERSION of DYNOBJ which is not made
+// by any symbol.
+
+void
+Versions::record_need(Stringpool* dynpool, const Dynobj* dynobj,
+		      const char* version)
+{
+  gold_assert(!this->is_finalized_);
+  Stringpool::Key version_key;
+  version = dynpool->add(version, false, &version_key);
+  this->add_need(dynpool, dynobj->soname(), version, version_key);
+}
+
 // We've found a symbol SYM defined in version VERSION.
 
 void
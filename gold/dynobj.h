@@ -32,6 +32,7 @@ namespace gold
 {
 
 class Version_script_info;
+class Output_section_data;
 
 // A dynamic object (ET_DYN).  This is an abstract base class itself.
 // The implementations is the template class Sized_dynobj.
@@ -86,24 +87,25 @@ class Dynobj : public Object
   static uint32_t
   elf_hash(const char*);
 
-  // Create a standard ELF hash table, setting *PPHASH and *PHASHLEN.
-  // DYNSYMS is the global dynamic symbols.  LOCAL_DYNSYM_COUNT is the
+  // Create a standard ELF hash table, and return the section data
+  // which holds it.  DYNSYMS is the global dynamic symbols.
+  // LOCAL_DYNSYM_COUNT is the number of local dynamic symbols, which
+  // is the index of the first dynamic gobal symbol.
+  static Output_section_data*
+  create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
+			unsigned int local_dynsym_count);
+
+  // Create a GNU hash table, and return the section data which holds
+  // it.  This sets the dynamic symbol indexes of DYNSYMS.  DYNSYMS is
+  // the global dynamic symbols.  DYNSYM_HASH_CODES holds the
+  // DT_GNU_HASH hash code of the name of each of them, as computed by
+  // Symbol_table::set_dynsym_indexes.  LOCAL_DYNSYM_COUNT is the
   // number of local dynamic symbols, which is the index of the first
   // dynamic gobal symbol.
-  static void
-  create_elf_hash_table(const std::vector<Symbol*>& dynsyms,
-			unsigned int local_dynsym_count,
-			unsigned char** pphash,
-			unsigned int* phashlen);
-
-  // Create a GNU hash table, setting *PPHASH and *PHASHLEN.  DYNSYMS
-  // is the global dynamic symbols.  LOCAL_DYNSYM_COUNT is the number
-  // of local dynamic symbols, which is the index of the first dynamic
-  // gobal symbol.
-  static void
+  static Output_section_data*
   create_gnu_hash_table(const std::vector<Symbol*>& dynsyms,
-			unsigned int local_dynsym_count,
-			unsigned char** pphash, unsigned int* phashlen);
+			const std::vector<uint32_t>& dynsym_hash_codes,
+			unsigned int local_dynsym_count);
 
  protected:
   // Return a pointer to this object.
@@ -122,31 +124,16 @@ class Dynobj : public Object
   { this->needed_.push_back(std::string(s)); }
 
  private:
-  // Compute the GNU hash code for a string.
-  static uint32_t
-  gnu_hash(const char*);
-
   // Compute the number of hash buckets to use.
   static unsigned int
-  compute_bucket_count(const std::vector<uint32_t>& hashcodes,
-		       bool for_gnu_hash_table);
-
-  // Sized version of create_elf_hash_table.
-  template<int size, bool big_endian>
-  static void
-  sized_create_elf_hash_table(const std::vector<uint32_t>& bucket,
-			      const std::vector<uint32_t>& chain,
-			      unsigned char* phash,
-			      unsigned int hashlen);
+  compute_bucket_count(unsigned int symcount, bool for_gnu_hash_table);
 
   // Sized version of create_gnu_hash_table.
   template<int size, bool big_endian>
-  static void
+  static Output_section_data*
   sized_create_gnu_hash_table(const std::vector<Symbol*>& hashed_dynsyms,
-			      const std::vector<uint32_t>& dynsym_hashvals,
-			      unsigned int unhashed_dynsym_count,
-			      unsigned char** pphash,
-			      unsigned int* phashlen);
+			      std::vector<uint32_t>* dynsym_hashvals,
+			      unsigned int unhashed_dynsym_count);
 
   // Values for the has_unknown_needed_entries_ field.
   enum Unknown_needed
@@ -569,6 +556,11 @@ class Versions
   void
   record_version(const Symbol_table* symtab, Stringpool*, const Symbol* sym);
 
+  // Record a reference to version VERSION of DYNOBJ which is not
+  // made by any symbol.
+  void
+  record_need(Stringpool*, const Dynobj* dynobj, const char* version);
+
   // Set the version indexes.  DYNSYM_INDEX is the index we should use
   // for the next dynamic symbol.  We add new dynamic symbols to SYMS
   // and return an updated DYNSYM_INDEX.
@@ -25,23 +25,89 @@
 #include "object.h"
 #include "gc.h"
 #include "symtab.h"
+#include "workqueue.h"
 
 namespace gold
 {
 
+// Hand part of a work list to another task once it is this long.
+
+static const size_t gc_mark_split_size = 4096;
+
+// A task to mark the sections reachable from part of the work list.
+
+class Gc_mark_task : public Task
+{
+ public:
+  // WORKLIST is allocated using new, and is deleted after the task
+  // runs.
+  Gc_mark_task(Garbage_collection* gc,
+	       Garbage_collection::Worklist_type* worklist,
+	       Task_token* blocker)
+    : gc_(gc), worklist_(worklist), blocker_(blocker)
+  { }
+
+  ~Gc_mark_task()
+  { delete this->worklist_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->blocker_); }
+
+  void
+  run(Workqueue* workqueue)
+  { this->gc_->mark_sections(this->worklist_, workqueue, this->blocker_); }
+
+  std::string
+  get_name() const
+  { return "Gc_mark_task"; }
+
+ private:
+  Garbage_collection* gc_;
+  Garbage_collection::Worklist_type* worklist_;
+  Task_token* blocker_;
+};
+
+// Set up a mark for each section, and mark the sections on the work
+// list.
+
+void
+Garbage_collection::mark_worklist(const Input_objects* input_objects)
+{
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    this->section_marks_[*p].resize((*p)->shnum(), 0);
+
+  Worklist_type::iterator out = this->worklist().begin();
+  for (Worklist_type::const_iterator p = this->worklist().begin();
+       p != this->worklist().end();
+       ++p)
+    if (this->mark_section(*p))
+      *out++ = *p;
+  this->worklist().erase(out, this->worklist().end());
+}
+
 // Garbage collection uses a worklist style algorithm to determine the 
-// transitive closure of all referenced sections.
-void 
-Garbage_collection::do_transitive_closure()
+// transitive closure of all referenced sections.  A section is marked
+// when it is added to a work list, so each section is only scanned once
+// even when several threads are marking.
+
+void
+Garbage_collection::mark_sections(Worklist_type* worklist,
+				  Workqueue* workqueue,
+				  Task_token* blocker)
 {
-  while (!this->worklist().empty())
+  while (!worklist->empty())
     {
-      // Add elements from the work list to the referenced list
-      // one by one.
-      Section_id entry = this->worklist().back();
-      this->worklist().pop_back();
-      if (!this->referenced_list().insert(entry).second)
-        continue;
+      Section_id entry = worklist->back();
+      worklist->pop_back();
       Garbage_collection::Section_ref::iterator find_it = 
                 this->section_reloc_map().find(entry);
       if (find_it == this->section_reloc_map().end()) 
@@ -54,13 +120,54 @@ Garbage_collection::do_transitive_closure()
            ++it_v)
         {
           // Do not add already processed sections to the work_list. 
-          if (this->referenced_list().find(*it_v)
-              == this->referenced_list().end())
-            {
-              this->worklist().push_back(*it_v);
-            }
+          if (this->mark_section(*it_v))
+            worklist->push_back(*it_v);
+        }
+
+      // Let another thread scan half of a long work list.
+      if (workqueue != NULL && worklist->size() >= 2 * gc_mark_split_size)
+        {
+          size_t half = worklist->size() / 2;
+          Worklist_type* other = new Worklist_type(worklist->begin() + half,
+                                                   worklist->end());
+          worklist->resize(half);
+          workqueue->add_blocker(blocker);
+          workqueue->queue(new Gc_mark_task(this, other, blocker));
         }
     }
+}
+
+void 
+Garbage_collection::do_transitive_closure(const Input_objects* input_objects)
+{
+  this->mark_worklist(input_objects);
+  this->mark_sections(&this->worklist(), NULL, NULL);
+  this->worklist_ready();
+}
+
+// Start the marking with a task for each part of the work list.
+
+void
+Garbage_collection::queue_transitive_closure(
+    const Input_objects* input_objects,
+    Workqueue* workqueue,
+    Task_token* final_blocker)
+{
+  this->mark_worklist(input_objects);
+
+  size_t size = this->worklist().size();
+  final_blocker->add_blockers((size + gc_mark_split_size - 1)
+			      / gc_mark_split_size);
+  for (size_t i = 0; i < size; i += gc_mark_split_size)
+    {
+      Worklist_type::const_iterator p = this->worklist().begin() + i;
+      size_t count = std::min(gc_mark_split_size, size - i);
+      Worklist_type* worklist = new Worklist_type(p, p + count);
+      workqueue->queue(new Gc_mark_task(this, worklist, final_blocker));
+    }
+  this->worklist().clear();
+
+  // All the sections are marked before FINAL_BLOCKER is unblocked.
   this->worklist_ready();
 }
 
@@ -34,6 +34,9 @@ namespace gold
 {
 
 class Object;
+class Input_objects;
+class Task_token;
+class Workqueue;
 
 template<int size, bool big_endian>
 class Sized_relobj_file;
@@ -55,15 +58,11 @@ class Garbage_collection
   typedef std::map<std::string, Sections_reachable> Cident_section_map;
 
   Garbage_collection()
-  : is_worklist_ready_(false)
+  : is_worklist_ready_(false), section_marks_()
   { }
 
   // Accessor methods for the private members.
 
-  Sections_reachable&
-  referenced_list()
-  { return referenced_list_; }
-
   Section_ref&
   section_reloc_map()
   { return this->section_reloc_map_; }
@@ -80,13 +79,30 @@ class Garbage_collection
   worklist_ready()
   { this->is_worklist_ready_ = true; }
 
+  // Mark all the sections of INPUT_OBJECTS reachable from the work
+  // list.
+  void
+  do_transitive_closure(const Input_objects* input_objects);
+
+  // Like do_transitive_closure, but mark the sections in parallel.
+  // FINAL_BLOCKER is unblocked when they have all been marked.
   void
-  do_transitive_closure();
+  queue_transitive_closure(const Input_objects* input_objects,
+			   Workqueue* workqueue, Task_token* final_blocker);
+
+  // Mark the sections reachable from the marked sections in WORKLIST,
+  // emptying it.  If WORKQUEUE is not NULL, part of a long WORKLIST
+  // is handed to a new task, which holds BLOCKER.
+  void
+  mark_sections(Worklist_type* worklist, Workqueue* workqueue,
+		Task_token* blocker);
 
   bool
   is_section_garbage(Relobj* obj, unsigned int shndx)
-  { return (this->referenced_list().find(Section_id(obj, shndx))
-            == this->referenced_list().end()); }
+  {
+    Section_marks::const_iterator p = this->section_marks_.find(obj);
+    return p == this->section_marks_.end() || p->second[shndx] == 0;
+  }
 
   Cident_section_map*
   cident_sections()
@@ -111,10 +127,31 @@ class Garbage_collection
 
  private:
 
+  // A mark for each section of each object, set when the section is
+  // found to be referenced.
+  typedef Unordered_map<const Relobj*, std::vector<unsigned char> >
+    Section_marks;
+
+  // Set up the marks and mark the sections on the work list, dropping
+  // the ones which are already marked.
+  void
+  mark_worklist(const Input_objects* input_objects);
+
+  // Mark the section SECN.  Return true if it was not marked before.
+  // This may be called by several threads at once.
+  bool
+  mark_section(const Section_id& secn)
+  {
+    Section_marks::iterator p = this->section_marks_.find(secn.first);
+    gold_assert(p != this->section_marks_.end());
+    unsigned char* mark = &p->second[secn.second];
+    return *mark == 0 && __sync_bool_compare_and_swap(mark, 0, 1);
+  }
+
   Worklist_type work_list_;
   bool is_worklist_ready_;
   Section_ref section_reloc_map_;
-  Sections_reachable referenced_list_;
+  Section_marks section_marks_;
   Cident_section_map cident_sections_;
 };
 
@@ -27,6 +27,7 @@
 #include "dwarf.h"
 #include "object.h"
 #include "output.h"
+#include "workqueue.h"
 #include "demangle.h"
 
 namespace gold
@@ -153,11 +154,13 @@ class Gdb_hashtab
 };
 
 // The hash function for strings in the mapped index.  This is copied
-// directly from gdb/dwarf2read.c.
+// directly from gdb/dwarf2read.c.  Since we walk the whole string,
+// also set *PLENGTH to its length.
 
 static unsigned int
-mapped_index_string_hash(const unsigned char* str)
+mapped_index_string_hash(const unsigned char* str, size_t* plength)
 {
+  const unsigned char* start = str;
   unsigned int r = 0;
   unsigned char c;
 
@@ -168,9 +171,208 @@ mapped_index_string_hash(const unsigned char* str)
       r = r * 67 + c - 113;
     }
 
+  *plength = str - start - 1;
   return r;
 }
 
+class Gdb_index_info_reader;
+
+// The DWARF information found in the .debug_info and .debug_types
+// sections of one object.  Each object is scanned by a task of its
+// own, so the tables built here are private to that task.
+// Gdb_index::merge_scans adds them to the index afterwards, in the
+// order in which the objects were laid out, which keeps the index
+// independent of the number of threads.
+
+class Gdb_index_scan
+{
+ public:
+  Gdb_index_scan(Relobj* object, const unsigned char* symbols,
+		 off_t symbols_size);
+
+  ~Gdb_index_scan();
+
+  // Return the object.
+  Relobj*
+  object() const
+  { return this->object_; }
+
+  // Record a section to scan.
+  void
+  add_section(bool is_type_unit, unsigned int shndx,
+	      unsigned int reloc_shndx, unsigned int reloc_type)
+  {
+    this->sections_.push_back(Section(is_type_unit, shndx, reloc_shndx,
+				      reloc_type));
+  }
+
+  // Scan the sections.
+  void
+  scan();
+
+  // Add a compilation unit.
+  int
+  add_comp_unit(off_t cu_offset, off_t cu_length)
+  {
+    this->comp_units_.push_back(Gdb_index::Comp_unit(cu_offset, cu_length));
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add a type unit.
+  int
+  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
+  {
+    this->type_units_.push_back(Gdb_index::Type_unit(tu_offset, type_offset,
+						     signature));
+    return this->type_units_.size() - 1;
+  }
+
+  // Add an address range.
+  void
+  add_address_range_list(Relobj* object, unsigned int cu_index,
+			 Dwarf_range_list* ranges)
+  {
+    this->ranges_.push_back(Gdb_index::Per_cu_range_list(object, cu_index,
+							 ranges));
+  }
+
+  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be stored in
+  // the high-byte of the cu_index field.
+  void
+  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
+
+  // Return the offset into the pubnames table for the cu at the given
+  // offset.
+  off_t
+  find_pubname_offset(off_t cu_offset);
+
+  // Return the offset into the pubtypes table for the cu at the
+  // given offset.
+  off_t
+  find_pubtype_offset(off_t cu_offset);
+
+  // Return TRUE if we have already processed the pubnames and types
+  // set of the CUs and TUS associated with the statement list at
+  // OFFSET.
+  bool
+  pubnames_read(off_t offset)
+  { return this->stmt_list_offset_ == offset; }
+
+  // Record that we have already read the pubnames associated with
+  // OFFSET.
+  void
+  set_pubnames_read(off_t offset)
+  { this->stmt_list_offset_ = offset; }
+
+  // Return a pointer to the given table.
+  Dwarf_pubnames_table*
+  pubnames_table()
+  { return pubnames_table_; }
+
+  Dwarf_pubnames_table*
+  pubtypes_table()
+  { return pubtypes_table_; }
+
+  // Count a compilation unit or type unit.
+  void
+  count_unit(bool is_type_unit)
+  {
+    if (is_type_unit)
+      ++this->tu_count_;
+    else
+      ++this->cu_count_;
+  }
+
+  // Count a compilation unit or type unit without pubnames/pubtypes.
+  void
+  count_unit_without_pubnames(bool is_type_unit)
+  {
+    if (is_type_unit)
+      ++this->tu_nopubnames_count_;
+    else
+      ++this->cu_nopubnames_count_;
+  }
+
+ private:
+  friend class Gdb_index;
+
+  // A section to scan.
+  struct Section
+  {
+    Section(bool is_type, unsigned int s, unsigned int rs, unsigned int rt)
+      : is_type_unit(is_type), shndx(s), reloc_shndx(rs), reloc_type(rt)
+    { }
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  // A distinct symbol name found by the scan.  HASHVAL is the
+  // gdb_index hash of NAME and STRING_HASH its Stringpool hash, both
+  // computed here so that the merge does not have to.
+  struct Scan_symbol
+  {
+    const char* name;
+    size_t length;
+    unsigned int hashval;
+    size_t string_hash;
+  };
+
+  // A call to add_symbol.  SYMBOL is an index into SYMBOLS_.
+  struct Symbol_ref
+  {
+    unsigned int symbol;
+    int cu_index;
+    uint8_t flags;
+  };
+
+  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
+
+  // Create a map from dies to pubnames.
+  Dwarf_pubnames_table*
+  map_pubtable_to_dies(unsigned int attr,
+		       Gdb_index_info_reader* dwinfo);
+
+  // Wrapper for map_pubtable_to_dies
+  void
+  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo);
+
+  // The object.
+  Relobj* object_;
+  // A copy of the symbol table of the object.
+  unsigned char* symbols_;
+  off_t symbols_size_;
+  // The sections to scan.
+  std::vector<Section> sections_;
+  // The compilation units, type units and address ranges, indexed
+  // as within this object.
+  std::vector<Gdb_index::Comp_unit> comp_units_;
+  std::vector<Gdb_index::Type_unit> type_units_;
+  std::vector<Gdb_index::Per_cu_range_list> ranges_;
+  // The distinct symbol names.  The Stringpool keys are assigned in
+  // order, so key K is entry K - 1 of SYMBOLS_FOUND_.
+  Stringpool names_;
+  std::vector<Scan_symbol> symbols_found_;
+  // The calls to add_symbol, in order.
+  std::vector<Symbol_ref> symbol_refs_;
+  // Maps from CU offsets to offsets in the pubnames and pubtypes
+  // tables.
+  Pubname_offset_map cu_pubname_map_;
+  Pubname_offset_map cu_pubtype_map_;
+  // Tables to store the pubnames sections of the object.
+  Dwarf_pubnames_table* pubnames_table_;
+  Dwarf_pubnames_table* pubtypes_table_;
+  // Stmt list offset of the CUs and TUs associated with the last
+  // read pubnames and pubtypes sections.
+  off_t stmt_list_offset_;
+  // Statistics.
+  unsigned int cu_count_;
+  unsigned int cu_nopubnames_count_;
+  unsigned int tu_count_;
+  unsigned int tu_nopubnames_count_;
+};
+
 // A specialization of Dwarf_info_reader, for building the .gdb_index.
 
 class Gdb_index_info_reader : public Dwarf_info_reader
@@ -183,19 +385,15 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index_scan* scan)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      scan_(scan), cu_index_(0), cu_language_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
-  // Print usage statistics.
-  static void
-  print_stats();
-
  protected:
   // Visit a compilation unit.
   virtual void
@@ -285,8 +483,8 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
+  // The scan of the object.
+  Gdb_index_scan* scan_;
   // The current CU index (negative for a TU).
   int cu_index_;
   // The language of the current CU or TU.
@@ -294,35 +492,16 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   // Map from DIE offset to (parent offset, name) pair,
   // for DW_AT_specification.
   Declaration_map declarations_;
-
-  // Statistics.
-  // Total number of DWARF compilation units processed.
-  static unsigned int dwarf_cu_count;
-  // Number of DWARF compilation units with pubnames/pubtypes.
-  static unsigned int dwarf_cu_nopubnames_count;
-  // Total number of DWARF type units processed.
-  static unsigned int dwarf_tu_count;
-  // Number of DWARF type units with pubnames/pubtypes.
-  static unsigned int dwarf_tu_nopubnames_count;
 };
 
-// Total number of DWARF compilation units processed.
-unsigned int Gdb_index_info_reader::dwarf_cu_count = 0;
-// Number of DWARF compilation units without pubnames/pubtypes.
-unsigned int Gdb_index_info_reader::dwarf_cu_nopubnames_count = 0;
-// Total number of DWARF type units processed.
-unsigned int Gdb_index_info_reader::dwarf_tu_count = 0;
-// Number of DWARF type units without pubnames/pubtypes.
-unsigned int Gdb_index_info_reader::dwarf_tu_nopubnames_count = 0;
-
 // Process a compilation unit and parse its child DIE.
 
 void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  this->scan_->count_unit(false);
+  this->cu_index_ = this->scan_->add_comp_unit(cu_offset, cu_length);
   this->visit_top_die(root_die);
 }
 
@@ -333,10 +512,10 @@ Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
+  this->scan_->count_unit(true);
   // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  this->cu_index_ = -1 - this->scan_->add_type_unit(tu_offset, type_offset,
+						    signature);
   this->visit_top_die(root_die);
 }
 
@@ -380,10 +559,8 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 			     this->object()->name().c_str());
 		return;
 	      }
-	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
-	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	    this->scan_->count_unit_without_pubnames(
+		die->tag() != elfcpp::DW_TAG_compile_unit);
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -437,8 +614,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_,
-                                           full_name.c_str(), 0);
+	      this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	  }
 	break;
       case elfcpp::DW_TAG_typedef:
@@ -477,8 +653,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
-					     full_name.c_str(), 0);
+		this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	    }
 
 	  // We're interested in the children only for namespaces and
@@ -825,8 +1000,8 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->scan_->add_address_range_list(this->object(),
+					    this->cu_index_, ranges);
       return;
     }
 
@@ -851,8 +1026,8 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->scan_->add_address_range_list(this->object(),
+					      this->cu_index_, ranges);
         }
     }
 }
@@ -877,7 +1052,7 @@ Gdb_index_info_reader::read_pubtable(Dwarf_pubnames_table* table, off_t offset)
       if (name == NULL)
         break;
 
-      this->gdb_index_->add_symbol(this->cu_index_, name, flag_byte);
+      this->scan_->add_symbol(this->cu_index_, name, flag_byte);
     }
   return true;
 }
@@ -916,8 +1091,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
           // have read. If it does, then no need to read the pubnames.
           // If it doesn't, then the caller will have to parse the
           // dies manually to find the names.
-          return this->gdb_index_->pubnames_read(this->object(),
-                                                 stmt_list_off);
+          return this->scan_->pubnames_read(stmt_list_off);
         }
       else
         {
@@ -928,10 +1102,10 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 
   // We found the attribute, so we can check if the corresponding
   // pubnames have been read.
-  if (this->gdb_index_->pubnames_read(this->object(), stmt_list_off))
+  if (this->scan_->pubnames_read(stmt_list_off))
     return true;
 
-  this->gdb_index_->set_pubnames_read(this->object(), stmt_list_off);
+  this->scan_->set_pubnames_read(stmt_list_off);
 
   // We have an attribute, and the pubnames haven't been read, so read
   // them.
@@ -939,12 +1113,12 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
   // In some of the cases, we could rely on the previous value of
   // offset here, but sorting out which cases complicates the logic
   // enough that it isn't worth it. So just look up the offset again.
-  offset = this->gdb_index_->find_pubname_offset(this->cu_offset());
-  names = this->read_pubtable(this->gdb_index_->pubnames_table(), offset);
+  offset = this->scan_->find_pubname_offset(this->cu_offset());
+  names = this->read_pubtable(this->scan_->pubnames_table(), offset);
 
   bool types = false;
-  offset = this->gdb_index_->find_pubtype_offset(this->cu_offset());
-  types = this->read_pubtable(this->gdb_index_->pubtypes_table(), offset);
+  offset = this->scan_->find_pubtype_offset(this->cu_offset());
+  types = this->read_pubtable(this->scan_->pubtypes_table(), offset);
   return names || types;
 }
 
@@ -964,55 +1138,60 @@ Gdb_index_info_reader::clear_declarations()
   this->declarations_.clear();
 }
 
-// Print usage statistics.
-void
-Gdb_index_info_reader::print_stats()
+// Class Gdb_index_scan.
+
+Gdb_index_scan::Gdb_index_scan(Relobj* object, const unsigned char* symbols,
+			       off_t symbols_size)
+  : object_(object), symbols_(NULL), symbols_size_(symbols_size),
+    sections_(), comp_units_(), type_units_(), ranges_(), names_(),
+    symbols_found_(), symbol_refs_(), cu_pubname_map_(), cu_pubtype_map_(),
+    pubnames_table_(NULL), pubtypes_table_(NULL), stmt_list_offset_(-1),
+    cu_count_(0), cu_nopubnames_count_(0), tu_count_(0),
+    tu_nopubnames_count_(0)
 {
-  fprintf(stderr, _("%s: DWARF CUs: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_cu_count);
-  fprintf(stderr, _("%s: DWARF CUs without pubnames/pubtypes: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_cu_nopubnames_count);
-  fprintf(stderr, _("%s: DWARF TUs: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_tu_count);
-  fprintf(stderr, _("%s: DWARF TUs without pubnames/pubtypes: %u\n"),
-          program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
+  // The symbols we are given are freed when the object has been laid
+  // out, so we keep a copy for the scan.
+  if (symbols != NULL)
+    {
+      this->symbols_ = new unsigned char[symbols_size];
+      memcpy(this->symbols_, symbols, symbols_size);
+    }
 }
 
-// Class Gdb_index.
-
-// Construct the .gdb_index section.
-
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
-  : Output_section_data(4),
-    pubnames_table_(NULL),
-    pubtypes_table_(NULL),
-    gdb_index_section_(gdb_index_section),
-    comp_units_(),
-    type_units_(),
-    ranges_(),
-    cu_vector_list_(),
-    cu_vector_offsets_(NULL),
-    stringpool_(),
-    tu_offset_(0),
-    addr_offset_(0),
-    symtab_offset_(0),
-    cu_pool_offset_(0),
-    stringpool_offset_(0),
-    pubnames_object_(NULL),
-    stmt_list_offset_(-1)
+Gdb_index_scan::~Gdb_index_scan()
 {
-  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+  delete[] this->symbols_;
+  delete this->pubnames_table_;
+  delete this->pubtypes_table_;
 }
 
-Gdb_index::~Gdb_index()
+// Scan the .debug_info and .debug_types sections of the object.
+
+void
+Gdb_index_scan::scan()
 {
-  // Free the memory used by the symbol table.
-  delete this->gdb_symtab_;
-  // Free the memory used by the CU vectors.
-  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
-    delete this->cu_vector_list_[i];
-}
+  for (std::vector<Section>::const_iterator p = this->sections_.begin();
+       p != this->sections_.end();
+       ++p)
+    {
+      Gdb_index_info_reader dwinfo(p->is_type_unit, this->object_,
+				   this->symbols_, this->symbols_size_,
+				   p->shndx, p->reloc_shndx,
+				   p->reloc_type, this);
+      if (p == this->sections_.begin())
+	this->map_pubnames_and_types_to_dies(&dwinfo);
+      dwinfo.parse();
+    }
 
+  // Only the tables built by the scan are needed from now on.
+  delete this->pubnames_table_;
+  this->pubnames_table_ = NULL;
+  delete this->pubtypes_table_;
+  this->pubtypes_table_ = NULL;
+  delete[] this->symbols_;
+  this->symbols_ = NULL;
+  this->object_->discard_decompressed_sections(false);
+}
 
 // Scan the pubnames and pubtypes sections and build a map of the
 // various cus and tus they refer to, so we can process the entries
@@ -1020,11 +1199,8 @@ Gdb_index::~Gdb_index()
 // Return the just-read table so it can be cached.
 
 Dwarf_pubnames_table*
-Gdb_index::map_pubtable_to_dies(unsigned int attr,
-                                Gdb_index_info_reader* dwinfo,
-                                Relobj* object,
-                                const unsigned char* symbols,
-                                off_t symbols_size)
+Gdb_index_scan::map_pubtable_to_dies(unsigned int attr,
+				     Gdb_index_info_reader* dwinfo)
 {
   uint64_t section_offset = 0;
   Dwarf_pubnames_table* table;
@@ -1042,7 +1218,8 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
     }
 
   map->clear();
-  if (!table->read_section(object, symbols, symbols_size))
+  if (!table->read_section(this->object_, this->symbols_,
+			   this->symbols_size_))
     return NULL;
 
   while (table->read_header(section_offset))
@@ -1057,30 +1234,19 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
 // Wrapper for map_pubtable_to_dies
 
 void
-Gdb_index::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                          Relobj* object,
-                                          const unsigned char* symbols,
-                                          off_t symbols_size)
+Gdb_index_scan::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo)
 {
-  // This is a new object, so reset the relevant variables.
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = -1;
-
-  delete this->pubnames_table_;
   this->pubnames_table_
-      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo,
-                                   object, symbols, symbols_size);
-  delete this->pubtypes_table_;
+      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo);
   this->pubtypes_table_
-      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo,
-                                   object, symbols, symbols_size);
+      = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo);
 }
 
 // Given a cu_offset, find the associated section of the pubnames
 // table.
 
 off_t
-Gdb_index::find_pubname_offset(off_t cu_offset)
+Gdb_index_scan::find_pubname_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubname_map_.find(cu_offset);
   if (it != this->cu_pubname_map_.end())
@@ -1092,7 +1258,7 @@ Gdb_index::find_pubname_offset(off_t cu_offset)
 // table.
 
 off_t
-Gdb_index::find_pubtype_offset(off_t cu_offset)
+Gdb_index_scan::find_pubtype_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubtype_map_.find(cu_offset);
   if (it != this->cu_pubtype_map_.end())
@@ -1100,36 +1266,279 @@ Gdb_index::find_pubtype_offset(off_t cu_offset)
   return -1;
 }
 
-// Scan a .debug_info or .debug_types input section.
+// Add a symbol.  We only record it here; it is added to the index by
+// Gdb_index::merge_scans.
 
 void
-Gdb_index::scan_debug_info(bool is_type_unit,
-			   Relobj* object,
-			   const unsigned char* symbols,
-			   off_t symbols_size,
-			   unsigned int shndx,
-			   unsigned int reloc_shndx,
-			   unsigned int reloc_type)
+Gdb_index_scan::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  if (object != this->pubnames_object_)
-    map_pubnames_and_types_to_dies(&dwinfo, object, symbols, symbols_size);
-  dwinfo.parse();
+  size_t len;
+  unsigned int hash = mapped_index_string_hash(
+      reinterpret_cast<const unsigned char*>(sym_name), &len);
+  size_t string_hash = gold::string_hash<char>(sym_name, len);
+  Stringpool::Key key;
+  const char* name = this->names_.add_with_hash(sym_name, len, string_hash,
+						true, &key);
+  if (key > this->symbols_found_.size())
+    {
+      gold_assert(key == this->symbols_found_.size() + 1);
+      Scan_symbol sym;
+      sym.name = name;
+      sym.length = len;
+      sym.hashval = hash;
+      sym.string_hash = string_hash;
+      this->symbols_found_.push_back(sym);
+    }
+
+  Symbol_ref ref;
+  ref.symbol = key - 1;
+  ref.cu_index = cu_index;
+  ref.flags = flags;
+  this->symbol_refs_.push_back(ref);
 }
 
-// Add a symbol.
+// This task scans the debug info of one object.
+
+class Gdb_index_scan_task : public Task
+{
+ public:
+  Gdb_index_scan_task(Gdb_index_scan* scan, Task_token* blocker)
+    : scan_(scan), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->scan_->object()->is_locked())
+      return this->scan_->object()->token();
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->scan_->object()->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    this->scan_->scan();
+    this->scan_->object()->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_scan_task " + this->scan_->object()->name(); }
+
+ private:
+  Gdb_index_scan* scan_;
+  Task_token* blocker_;
+};
+
+// This task adds the tables of all the scans to the index, once the
+// scan tasks are done.
+
+class Gdb_index_merge_task : public Task
+{
+ public:
+  Gdb_index_merge_task(Gdb_index* gdb_index, Task_token* scan_blocker,
+		       Task_token* final_blocker)
+    : gdb_index_(gdb_index), scan_blocker_(scan_blocker),
+      final_blocker_(final_blocker)
+  { }
+
+  ~Gdb_index_merge_task()
+  { delete this->scan_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->scan_blocker_->is_blocked())
+      return this->scan_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->gdb_index_->merge_scans(); }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_merge_task"; }
+
+ private:
+  Gdb_index* gdb_index_;
+  Task_token* scan_blocker_;
+  Task_token* final_blocker_;
+};
+
+// Class Gdb_index.
+
+// Total number of DWARF compilation units processed.
+unsigned int Gdb_index::dwarf_cu_count = 0;
+// Number of DWARF compilation units without pubnames/pubtypes.
+unsigned int Gdb_index::dwarf_cu_nopubnames_count = 0;
+// Total number of DWARF type units processed.
+unsigned int Gdb_index::dwarf_tu_count = 0;
+// Number of DWARF type units without pubnames/pubtypes.
+unsigned int Gdb_index::dwarf_tu_nopubnames_count = 0;
+
+// Construct the .gdb_index section.
+
+Gdb_index::Gdb_index(Output_section* gdb_index_section)
+  : Output_section_data(4),
+    gdb_index_section_(gdb_index_section),
+    scans_(),
+    comp_units_(),
+    type_units_(),
+    ranges_(),
+    cu_vector_list_(),
+    cu_vector_offsets_(NULL),
+    stringpool_(),
+    tu_offset_(0),
+    addr_offset_(0),
+    symtab_offset_(0),
+    cu_pool_offset_(0),
+    stringpool_offset_(0)
+{
+  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+}
+
+Gdb_index::~Gdb_index()
+{
+  // Free the memory used by the symbol table.
+  delete this->gdb_symtab_;
+  // Free the memory used by the CU vectors.
+  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
+    delete this->cu_vector_list_[i];
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    delete this->scans_[i];
+}
+
+// Record a .debug_info or .debug_types input section.  All the
+// sections of an object are recorded together, when it is laid out.
 
 void
-Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+Gdb_index::add_debug_info(bool is_type_unit,
+			  Relobj* object,
+			  const unsigned char* symbols,
+			  off_t symbols_size,
+			  unsigned int shndx,
+			  unsigned int reloc_shndx,
+			  unsigned int reloc_type)
+{
+  if (this->scans_.empty() || this->scans_.back()->object() != object)
+    this->scans_.push_back(new Gdb_index_scan(object, symbols,
+					      symbols_size));
+  this->scans_.back()->add_section(is_type_unit, shndx, reloc_shndx,
+				   reloc_type);
+}
+
+// Queue the scan tasks and the merge task.  We use workqueue->add_blocker
+// since FINAL_BLOCKER may already be in use by running tasks.
+
+void
+Gdb_index::queue_scan_tasks(Workqueue* workqueue, Task_token* final_blocker)
+{
+  Task_token* scan_blocker = new Task_token(true);
+  scan_blocker->add_blockers(this->scans_.size());
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    workqueue->queue(new Gdb_index_scan_task(this->scans_[i], scan_blocker));
+
+  workqueue->add_blocker(final_blocker);
+  workqueue->queue(new Gdb_index_merge_task(this, scan_blocker,
+					    final_blocker));
+}
+
+// Add the tables of the scans to the index.  The symbols are added
+// in the same order in which a serial scan of the objects would have
+// added them, so the layout of the hash table does not depend on how
+// the scans were run.
+
+void
+Gdb_index::merge_scans()
+{
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    {
+      Gdb_index_scan* scan = this->scans_[i];
+
+      // The CU indexes of the scan start at zero; a TU index -1 - N
+      // refers to type unit N.
+      int cu_base = this->comp_units_.size();
+      int tu_base = this->type_units_.size();
+
+      this->comp_units_.insert(this->comp_units_.end(),
+			       scan->comp_units_.begin(),
+			       scan->comp_units_.end());
+      this->type_units_.insert(this->type_units_.end(),
+			       scan->type_units_.begin(),
+			       scan->type_units_.end());
+      for (unsigned int j = 0; j < scan->ranges_.size(); ++j)
+	{
+	  Per_cu_range_list r(scan->ranges_[j]);
+	  int cu_index = static_cast<int>(r.cu_index);
+	  r.cu_index = cu_index < 0 ? cu_index - tu_base : cu_index + cu_base;
+	  this->ranges_.push_back(r);
+	}
+
+      std::vector<Gdb_symbol*> syms(scan->symbols_found_.size(), NULL);
+      for (unsigned int j = 0; j < scan->symbol_refs_.size(); ++j)
+	{
+	  const Gdb_index_scan::Symbol_ref& ref(scan->symbol_refs_[j]);
+	  Gdb_symbol* sym = syms[ref.symbol];
+	  if (sym == NULL)
+	    {
+	      const Gdb_index_scan::Scan_symbol& ss(
+		  scan->symbols_found_[ref.symbol]);
+	      sym = this->add_symbol(ss.name, ss.length, ss.hashval,
+				     ss.string_hash);
+	      syms[ref.symbol] = sym;
+	    }
+	  else
+	    {
+	      // Look the symbol up again, as a serial scan would, since
+	      // that may grow the hash table.
+	      Gdb_symbol* found = this->gdb_symtab_->add(sym);
+	      gold_assert(found == sym);
+	    }
+	  int cu_index = (ref.cu_index < 0
+			  ? ref.cu_index - tu_base
+			  : ref.cu_index + cu_base);
+	  this->add_symbol_cu(sym, cu_index, ref.flags);
+	}
+
+      Gdb_index::dwarf_cu_count += scan->cu_count_;
+      Gdb_index::dwarf_cu_nopubnames_count += scan->cu_nopubnames_count_;
+      Gdb_index::dwarf_tu_count += scan->tu_count_;
+      Gdb_index::dwarf_tu_nopubnames_count += scan->tu_nopubnames_count_;
+
+      delete scan;
+    }
+  this->scans_.clear();
+}
+
+// Add a symbol.
+
+Gdb_index::Gdb_symbol*
+Gdb_index::add_symbol(const char* sym_name, size_t len, unsigned int hashval,
+		      size_t string_hash)
 {
-  unsigned int hash = mapped_index_string_hash(
-      reinterpret_cast<const unsigned char*>(sym_name));
   Gdb_symbol* sym = new Gdb_symbol();
-  this->stringpool_.add(sym_name, true, &sym->name_key);
-  sym->hashval = hash;
+  this->stringpool_.add_with_hash(sym_name, len, string_hash, true,
+				  &sym->name_key);
+  sym->hashval = hashval;
   sym->cu_vector_index = 0;
 
   Gdb_symbol* found = this->gdb_symtab_->add(sym);
@@ -1145,36 +1554,20 @@ Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
       // CU index vector.
       delete sym;
     }
-
-  // Add the CU index to the vector list for this symbol,
-  // if it's not already on the list.  We only need to
-  // check the last added entry.
-  Cu_vector* cu_vec = this->cu_vector_list_[found->cu_vector_index];
-  if (cu_vec->size() == 0
-      || cu_vec->back().first != cu_index
-      || cu_vec->back().second != flags)
-    cu_vec->push_back(std::make_pair(cu_index, flags));
-}
-
-// Return TRUE if we have already processed the pubnames associated
-// with the statement list at the given OFFSET.
-
-bool
-Gdb_index::pubnames_read(const Relobj* object, off_t offset)
-{
-  bool ret = (this->pubnames_object_ == object
-	      && this->stmt_list_offset_ == offset);
-  return ret;
+  return found;
 }
 
-// Record that we have processed the pubnames associated with the
-// statement list for OBJECT at the given OFFSET.
+// Add the CU index to the vector list for SYM, if it's not already
+// on the list.  We only need to check the last added entry.
 
 void
-Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
+Gdb_index::add_symbol_cu(Gdb_symbol* sym, int cu_index, uint8_t flags)
 {
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = offset;
+  Cu_vector* cu_vec = this->cu_vector_list_[sym->cu_vector_index];
+  if (cu_vec->size() == 0
+      || cu_vec->back().first != cu_index
+      || cu_vec->back().second != flags)
+    cu_vec->push_back(std::make_pair(cu_index, flags));
 }
 
 // Set the size of the .gdb_index section.
@@ -1352,8 +1745,16 @@ Gdb_index::do_write(Output_file* of)
 void
 Gdb_index::print_stats()
 {
-  if (parameters->options().gdb_index())
-    Gdb_index_info_reader::print_stats();
+  if (!parameters->options().gdb_index())
+    return;
+  fprintf(stderr, _("%s: DWARF CUs: %u\n"),
+          program_name, Gdb_index::dwarf_cu_count);
+  fprintf(stderr, _("%s: DWARF CUs without pubnames/pubtypes: %u\n"),
+          program_name, Gdb_index::dwarf_cu_nopubnames_count);
+  fprintf(stderr, _("%s: DWARF TUs: %u\n"),
+          program_name, Gdb_index::dwarf_tu_count);
+  fprintf(stderr, _("%s: DWARF TUs without pubnames/pubtypes: %u\n"),
+          program_name, Gdb_index::dwarf_tu_nopubnames_count);
 }
 
 } // End namespace gold.
@@ -42,8 +42,9 @@ class Sized_relobj;
 class Dwarf_range_list;
 template <typename T>
 class Gdb_hashtab;
-class Gdb_index_info_reader;
-class Dwarf_pubnames_table;
+class Gdb_index_scan;
+class Workqueue;
+class Task_token;
 
 // This class manages the .gdb_index section, which is a fast
 // lookup table for DWARF information used by the gdb debugger.
@@ -56,114 +57,31 @@ class Gdb_index : public Output_section_data
 
   ~Gdb_index();
 
-  // Scan a .debug_info or .debug_types input section.
-  void scan_debug_info(bool is_type_unit,
-		       Relobj* object,
-		       const unsigned char* symbols,
-		       off_t symbols_size,
-		       unsigned int shndx,
-		       unsigned int reloc_shndx,
-		       unsigned int reloc_type);
-
-  // Add a compilation unit.
-  int
-  add_comp_unit(off_t cu_offset, off_t cu_length)
-  {
-    this->comp_units_.push_back(Comp_unit(cu_offset, cu_length));
-    return this->comp_units_.size() - 1;
-  }
-
-  // Add a type unit.
-  int
-  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
-  {
-    this->type_units_.push_back(Type_unit(tu_offset, type_offset, signature));
-    return this->type_units_.size() - 1;
-  }
-
-  // Add an address range.
+  // Record a .debug_info or .debug_types input section.  The
+  // sections are scanned later by the tasks queued by
+  // queue_scan_tasks.
+  void add_debug_info(bool is_type_unit,
+		      Relobj* object,
+		      const unsigned char* symbols,
+		      off_t symbols_size,
+		      unsigned int shndx,
+		      unsigned int reloc_shndx,
+		      unsigned int reloc_type);
+
+  // Queue a task for each object to scan its .debug_info and
+  // .debug_types sections, and a task to add what they find to the
+  // index.  The tasks hold blockers on FINAL_BLOCKER.
   void
-  add_address_range_list(Relobj* object, unsigned int cu_index,
-			 Dwarf_range_list* ranges)
-  {
-    this->ranges_.push_back(Per_cu_range_list(object, cu_index, ranges));
-  }
+  queue_scan_tasks(Workqueue*, Task_token* final_blocker);
 
-  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be stored in
-  // the high-byte of the cu_index field.
-  void
-  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
-
-  // Return the offset into the pubnames table for the cu at the given
-  // offset.
-  off_t
-  find_pubname_offset(off_t cu_offset);
-
-  // Return the offset into the pubtypes table for the cu at the
-  // given offset.
-  off_t
-  find_pubtype_offset(off_t cu_offset);
-
-  // Return TRUE if we have already processed the pubnames and types
-  // set for OBJECT of the CUs and TUS associated with the statement
-  // list at OFFSET.
-  bool
-  pubnames_read(const Relobj* object, off_t offset);
-
-  // Record that we have already read the pubnames associated with
-  // OBJECT and OFFSET.
+  // Add the tables built by the scan tasks to the index.
   void
-  set_pubnames_read(const Relobj* object, off_t offset);
-
-  // Return a pointer to the given table.
-  Dwarf_pubnames_table*
-  pubnames_table()
-  { return pubnames_table_; }
-
-  Dwarf_pubnames_table*
-  pubtypes_table()
-  { return pubtypes_table_; }
+  merge_scans();
 
   // Print usage statistics.
   static void
   print_stats();
 
- protected:
-  // This is called to update the section size prior to assigning
-  // the address and file offset.
-  void
-  update_data_size()
-  { this->set_final_data_size(); }
-
-  // Set the final data size.
-  void
-  set_final_data_size();
-
-  // Write the data to the file.
-  void
-  do_write(Output_file*);
-
-  // Write to a map file.
-  void
-  do_print_to_mapfile(Mapfile* mapfile) const
-  { mapfile->print_output_data(this, _("** gdb_index")); }
-
-  // Create a map from dies to pubnames.
-  Dwarf_pubnames_table*
-  map_pubtable_to_dies(unsigned int attr,
-                       Gdb_index_info_reader* dwinfo,
-                       Relobj* object,
-                       const unsigned char* symbols,
-                       off_t symbols_size);
-
-  // Wrapper for map_pubtable_to_dies
-  void
-  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                 Relobj* object,
-                                 const unsigned char* symbols,
-                                 off_t symbols_size);
-
- private:
   // An entry in the compilation unit list.
   struct Comp_unit
   {
@@ -196,6 +114,27 @@ class Gdb_index : public Output_section_data
     Dwarf_range_list* ranges;
   };
 
+ protected:
+  // This is called to update the section size prior to assigning
+  // the address and file offset.
+  void
+  update_data_size()
+  { this->set_final_data_size(); }
+
+  // Set the final data size.
+  void
+  set_final_data_size();
+
+  // Write the data to the file.
+  void
+  do_write(Output_file*);
+
+  // Write to a map file.
+  void
+  do_print_to_mapfile(Mapfile* mapfile) const
+  { mapfile->print_output_data(this, _("** gdb_index")); }
+
+ private:
   // A symbol table entry.
   struct Gdb_symbol
   {
@@ -216,23 +155,22 @@ class Gdb_index : public Output_section_data
 
   typedef std::vector<std::pair<int, uint8_t> > Cu_vector;
 
-  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
-  Pubname_offset_map cu_pubname_map_;
-  Pubname_offset_map cu_pubtype_map_;
+  // Add a symbol.  HASHVAL is the gdb_index hash of SYM_NAME and
+  // STRING_HASH its Stringpool hash.  Return the symbol table entry.
+  Gdb_symbol*
+  add_symbol(const char* sym_name, size_t len, unsigned int hashval,
+	     size_t string_hash);
 
-  // Scan the given pubtable and build a map of the various dies it
-  // refers to, so we can process the entries when we encounter the
-  // die.
+  // Add CU_INDEX and FLAGS to the CU vector of SYM.  FLAGS are the
+  // gdb_index version 7 flags to be stored in the high-byte of the
+  // cu_index field.
   void
-  map_pubtable_to_dies(Dwarf_pubnames_table* table,
-                       Pubname_offset_map* map);
-
-  // Tables to store the pubnames section of the current object.
-  Dwarf_pubnames_table* pubnames_table_;
-  Dwarf_pubnames_table* pubtypes_table_;
+  add_symbol_cu(Gdb_symbol* sym, int cu_index, uint8_t flags);
 
   // The .gdb_index section.
   Output_section* gdb_index_section_;
+  // The objects to scan, in the order in which they were laid out.
+  std::vector<Gdb_index_scan*> scans_;
   // The list of DWARF compilation units.
   std::vector<Comp_unit> comp_units_;
   // The list of DWARF type units.
@@ -253,10 +191,16 @@ class Gdb_index : public Output_section_data
   off_t symtab_offset_;
   off_t cu_pool_offset_;
   off_t stringpool_offset_;
-  // Object, stmt list offset of the CUs and TUs associated with the
-  // last read pubnames and pubtypes sections.
-  const Relobj* pubnames_object_;
-  off_t stmt_list_offset_;
+
+  // Statistics.
+  // Total number of DWARF compilation units processed.
+  static unsigned int dwarf_cu_count;
+  // Number of DWARF compilation units without pubnames/pubtypes.
+  static unsigned int dwarf_cu_nopubnames_count;
+  // Total number of DWARF type units processed.
+  static unsigned int dwarf_tu_count;
+  // Number of DWARF type units without pubnames/pubtypes.
+  static unsigned int dwarf_tu_nopubnames_count;
 };
 
 } // End namespace gold.
@@ -0,0 +1,229 @@
+// glob-set.cc -- match a name against a set of glob patterns
+
+// Copyright (C) 2019 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fnmatch.h>
+
+#include "glob-set.h"
+
+namespace gold
+{
+
+// The characters which end a literal prefix or suffix.  A backslash
+// may quote the next character, and a ']' may close a bracket
+// expression, so we stop at those too.
+
+static const char glob_special_chars[] = "*?[]\\";
+
+// Class Glob_set::Trie.
+
+void
+Glob_set::Trie::add(const char* s, size_t len, bool reverse,
+		    unsigned int index)
+{
+  if (this->nodes_.empty())
+    this->nodes_.resize(1);
+
+  unsigned int node = 0;
+  for (size_t i = 0; i < len; ++i)
+    {
+      unsigned char c = s[reverse ? len - 1 - i : i];
+      std::pair<Unordered_map<uint64_t, unsigned int>::iterator, bool> ins =
+	this->edges_.insert(std::make_pair(edge_key(node, c), 0U));
+      if (ins.second)
+	{
+	  ins.first->second = this->nodes_.size();
+	  this->nodes_.resize(this->nodes_.size() + 1);
+	}
+      node = ins.first->second;
+    }
+  this->nodes_[node].push_back(index);
+}
+
+void
+Glob_set::Trie::collect(const char* name, size_t len, bool reverse,
+			std::vector<unsigned int>* indexes) const
+{
+  if (this->nodes_.empty())
+    return;
+
+  unsigned int node = 0;
+  for (size_t i = 0; ; ++i)
+    {
+      const std::vector<unsigned int>& here(this->nodes_[node]);
+      indexes->insert(indexes->end(), here.begin(), here.end());
+      if (i >= len)
+	break;
+      unsigned char c = name[reverse ? len - 1 - i : i];
+      Unordered_map<uint64_t, unsigned int>::const_iterator p =
+	this->edges_.find(edge_key(node, c));
+      if (p == this->edges_.end())
+	break;
+      node = p->second;
+    }
+}
+
+// Class Glob_set.
+
+void
+Glob_set::add(const char* pattern, size_t len, unsigned int id)
+{
+  gold_assert(this->patterns_.empty() || this->patterns_.back().id <= id);
+
+  unsigned int index = this->patterns_.size();
+  this->patterns_.push_back(Pattern(pattern, len, id, PATTERN_LITERAL));
+  Pattern& p(this->patterns_.back());
+  const char* s = p.pattern.c_str();
+
+  if (!is_wildcard_string(s))
+    {
+      this->prefixes_.add(s, len, false, index);
+      return;
+    }
+
+  // Checking a pattern of literals and '*' ourselves is only the same
+  // as fnmatch without flags that give '/' or '.' special meaning.
+  if (strpbrk(s, "?[\\") == NULL
+      && (this->flags_ & ~FNM_NOESCAPE) == 0)
+    p.kind = PATTERN_STARS;
+  else
+    p.kind = PATTERN_FNMATCH;
+
+  size_t prefix_len = strcspn(s, glob_special_chars);
+  if (prefix_len > 0)
+    {
+      this->prefixes_.add(s, prefix_len, false, index);
+      return;
+    }
+
+  size_t suffix_len = 0;
+  while (suffix_len < len
+	 && strchr(glob_special_chars, s[len - 1 - suffix_len]) == NULL)
+    ++suffix_len;
+  if (suffix_len > 0)
+    this->suffixes_.add(s + len - suffix_len, suffix_len, true, index);
+  else
+    this->anywhere_.push_back(index);
+}
+
+// Return whether pattern INDEX matches NAME.
+
+bool
+Glob_set::pattern_matches(unsigned int index, const char* name,
+			  size_t len) const
+{
+  const Pattern& p(this->patterns_[index]);
+  switch (p.kind)
+    {
+    case PATTERN_LITERAL:
+      return p.pattern.length() == len && p.pattern == name;
+
+    case PATTERN_FNMATCH:
+      return fnmatch(p.pattern.c_str(), name, this->flags_) == 0;
+
+    case PATTERN_STARS:
+      {
+	// The text before the first '*' must start the name, the text
+	// after the last '*' must end it, and the pieces in between
+	// must appear in order.  Taking the first place each piece
+	// appears is always right.
+	const char* pat = p.pattern.c_str();
+	const char* first_star = strchr(pat, '*');
+	const char* last_star = strrchr(pat, '*');
+	size_t head = first_star - pat;
+	size_t tail = p.pattern.length() - (last_star + 1 - pat);
+	if (head + tail > len
+	    || memcmp(name, pat, head) != 0
+	    || memcmp(name + len - tail, last_star + 1, tail) != 0)
+	  return false;
+	const char* n = name + head;
+	const char* nend = name + len - tail;
+	const char* piece = first_star + 1;
+	while (piece < last_star)
+	  {
+	    const char* piece_end = strchr(piece, '*');
+	    size_t piece_len = piece_end - piece;
+	    if (piece_len > 0)
+	      {
+		const void* found = memmem(n, nend - n, piece, piece_len);
+		if (found == NULL)
+		  return false;
+		n = static_cast<const char*>(found) + piece_len;
+	      }
+	    piece = piece_end + 1;
+	  }
+	return true;
+      }
+
+    default:
+      gold_unreachable();
+    }
+}
+
+// Find the lowest identifier no less than START of a pattern which
+// matches NAME.
+
+bool
+Glob_set::find_first(const char* name, unsigned int start,
+		     unsigned int* pid) const
+{
+  size_t len = strlen(name);
+  const size_t count = this->patterns_.size();
+
+  if (count < linear_limit)
+    {
+      for (unsigned int i = 0; i < count; ++i)
+	{
+	  if (this->patterns_[i].id >= start
+	      && this->pattern_matches(i, name, len))
+	    {
+	      *pid = this->patterns_[i].id;
+	      return true;
+	    }
+	}
+      return false;
+    }
+
+  std::vector<unsigned int> candidates(this->anywhere_);
+  this->prefixes_.collect(name, len, false, &candidates);
+  this->suffixes_.collect(name, len, true, &candidates);
+  std::sort(candidates.begin(), candidates.end());
+
+  // Identifiers increase with the pattern index, so the first
+  // candidate which matches is the one we want.
+  for (std::vector<unsigned int>::const_iterator p = candidates.begin();
+       p != candidates.end();
+       ++p)
+    {
+      if (this->patterns_[*p].id >= start
+	  && this->pattern_matches(*p, name, len))
+	{
+	  *pid = this->patterns_[*p].id;
+	  return true;
+	}
+    }
+  return false;
+}
+
+} // End namespace gold.
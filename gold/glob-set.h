@@ -0,0 +1,146 @@
+// glob-set.h -- match a name against a set of glob patterns  -*- C++ -*-
+
+// Copyright (C) 2019 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_GLOB_SET_H
+#define GOLD_GLOB_SET_H
+
+#include <string>
+#include <vector>
+
+namespace gold
+{
+
+// A Glob_set holds a list of glob patterns, each with an identifier,
+// and finds the patterns which match a name without trying each one
+// in turn.  This is used for linker script input section patterns
+// and for --section-ordering-file.
+
+// Each pattern is indexed by its literal prefix, the characters
+// before the first wildcard, in a trie.  A pattern which starts with
+// a wildcard is indexed by its literal suffix in a second trie, built
+// from the reversed suffixes.  Walking a name through both tries
+// yields the only patterns which can match it, and only those are
+// checked.  A pattern which uses only '*' is checked directly; other
+// patterns are checked with fnmatch.
+
+class Glob_set
+{
+ public:
+  // FLAGS is passed to fnmatch.
+  Glob_set(int flags)
+    : flags_(flags), patterns_(), prefixes_(), suffixes_(), anywhere_()
+  { }
+
+  // Add the pattern PATTERN of LEN characters with identifier ID.
+  // Identifiers must be added in nondecreasing order.  A pattern with
+  // no wildcard characters only matches itself.
+  void
+  add(const char* pattern, size_t len, unsigned int id);
+
+  // Whether there are no patterns.
+  bool
+  empty() const
+  { return this->patterns_.empty(); }
+
+  // Find the lowest identifier, no less than START, of a pattern
+  // which matches NAME.  If there is one, set *PID and return true.
+  bool
+  find_first(const char* name, unsigned int start, unsigned int* pid) const;
+
+ private:
+  // How a pattern is checked against a name.
+  enum Pattern_kind
+  {
+    // No wildcards: the name must be equal to the pattern.
+    PATTERN_LITERAL,
+    // Only '*' wildcards.
+    PATTERN_STARS,
+    // Anything else: use fnmatch.
+    PATTERN_FNMATCH
+  };
+
+  struct Pattern
+  {
+    Pattern(const char* a_pattern, size_t len, unsigned int a_id,
+	    Pattern_kind a_kind)
+      : pattern(a_pattern, len), id(a_id), kind(a_kind)
+    { }
+
+    std::string pattern;
+    unsigned int id;
+    Pattern_kind kind;
+  };
+
+  // A trie of literal strings.  Node 0 is the root.  Each node lists
+  // the patterns whose literal string ends there.
+  class Trie
+  {
+   public:
+    Trie()
+      : nodes_(), edges_()
+    { }
+
+    // Add S of LEN characters for pattern INDEX.  If REVERSE is true,
+    // add the characters last to first.
+    void
+    add(const char* s, size_t len, bool reverse, unsigned int index);
+
+    // Add to *INDEXES the patterns whose strings are prefixes of
+    // NAME, or suffixes if REVERSE is true.
+    void
+    collect(const char* name, size_t len, bool reverse,
+	    std::vector<unsigned int>* indexes) const;
+
+   private:
+    // Return the key in edges_ for the edge from NODE on C.
+    static uint64_t
+    edge_key(unsigned int node, unsigned char c)
+    { return (static_cast<uint64_t>(node) << 8) | c; }
+
+    // The patterns which end at each node.
+    std::vector<std::vector<unsigned int> > nodes_;
+    // The edges of the trie, mapping edge_key to the child node.
+    Unordered_map<uint64_t, unsigned int> edges_;
+  };
+
+  // Return whether pattern INDEX matches NAME of LEN characters.
+  bool
+  pattern_matches(unsigned int index, const char* name, size_t len) const;
+
+  // With fewer patterns than this we just try each one.
+  static const size_t linear_limit = 8;
+
+  // The flags to pass to fnmatch.
+  int flags_;
+  // The patterns in the order they were added.
+  std::vector<Pattern> patterns_;
+  // Patterns indexed by literal prefix.
+  Trie prefixes_;
+  // Patterns with no literal prefix, indexed by reversed literal
+  // suffix.
+  Trie suffixes_;
+  // Patterns with neither, which must always be checked.
+  std::vector<unsigned int> anywhere_;
+};
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_GLOB_SET_H)
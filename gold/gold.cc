@@ -103,17 +103,24 @@ do_gold_unreachable(const char* filename, int lineno, const char* function)
 }
 
 // This class arranges to run the functions done in the middle of the
-// link.  It is just a closure.
+// link.  It is just a closure.  The middle of the link is queued in
+// parts when some of it runs in parallel; QUEUE_FUNCTION queues the
+// part which this runs.
 
 class Middle_runner : public Task_function_runner
 {
  public:
+  typedef void (*Queue_function)(const General_options&, const Task*,
+				 const Input_objects*, Symbol_table*,
+				 Layout*, Workqueue*, Mapfile*);
+
   Middle_runner(const General_options& options,
 		const Input_objects* input_objects,
 		Symbol_table* symtab,
-		Layout* layout, Mapfile* mapfile)
+		Layout* layout, Mapfile* mapfile,
+		Queue_function queue_function = queue_middle_tasks)
     : options_(options), input_objects_(input_objects), symtab_(symtab),
-      layout_(layout), mapfile_(mapfile)
+      layout_(layout), mapfile_(mapfile), queue_function_(queue_function)
   { }
 
   void
@@ -125,13 +132,15 @@ class Middle_runner : public Task_function_runner
   Symbol_table* symtab_;
   Layout* layout_;
   Mapfile* mapfile_;
+  Queue_function queue_function_;
 };
 
 void
 Middle_runner::run(Workqueue* workqueue, const Task* task)
 {
-  queue_middle_tasks(this->options_, task, this->input_objects_, this->symtab_,
-		     this->layout_, workqueue, this->mapfile_);
+  this->queue_function_(this->options_, task, this->input_objects_,
+			this->symtab_, this->layout_, workqueue,
+			this->mapfile_);
 }
 
 // This class arranges the tasks to process the relocs for garbage collection.
@@ -269,6 +278,15 @@ queue_initial_tasks(const General_options& options,
 	workqueue->queue(tasks[i]);
     }
 
+  // The symbols of the last objects may still be being resolved.
+  {
+    Task_token* next_blocker = new Task_token(true);
+    next_blocker->add_blocker();
+    workqueue->queue(new Wait_for_symbols(symtab, this_blocker,
+					  next_blocker));
+    this_blocker = next_blocker;
+  }
+
   if (options.has_plugins())
     {
       Task_token* next_blocker = new Task_token(true);
@@ -508,6 +526,8 @@ queue_middle_tasks(const General_options& options,
   // objects.
   if (parameters->options().gc_sections())
     {
+      // Keep the exported symbols seen while adding the input files.
+      symtab->gc_mark_added_symbols();
       // Find the start symbol if any.
       Symbol* sym = symtab->lookup(parameters->entry());
       if (sym != NULL)
@@ -522,17 +542,78 @@ queue_middle_tasks(const General_options& options,
       symtab->gc_mark_undef_symbols(layout);
       gold_assert(symtab->gc() != NULL);
       // Do a transitive closure on all references to determine the worklist.
-      symtab->gc()->do_transitive_closure();
+      if (parameters->options().threads())
+	{
+	  // Mark the sections in parallel, and carry on once they have
+	  // all been found.
+	  Task_token* next_blocker = new Task_token(true);
+	  symtab->gc()->queue_transitive_closure(input_objects, workqueue,
+						 next_blocker);
+	  Middle_runner* runner =
+	    new Middle_runner(options, input_objects, symtab, layout, mapfile,
+			      queue_middle_icf_tasks);
+	  workqueue->queue(new Task_function(runner, next_blocker,
+					     "Task_function Middle_runner"));
+	  return;
+	}
+      symtab->gc()->do_transitive_closure(input_objects);
     }
 
+  queue_middle_icf_tasks(options, task, input_objects, symtab, layout,
+			 workqueue, mapfile);
+}
+
+// Queue up the part of the middle set of tasks which does identical
+// code folding, once the garbage sections are known.
+
+void
+queue_middle_icf_tasks(const General_options& options,
+		       const Task* task,
+		       const Input_objects* input_objects,
+		       Symbol_table* symtab,
+		       Layout* layout,
+		       Workqueue* workqueue,
+		       Mapfile* mapfile)
+{
   // If identical code folding (--icf) is chosen it makes sense to do it
   // only after garbage collection (--gc-sections) as we do not want to
   // be folding sections that will be garbage.
   if (parameters->options().icf_enabled())
     {
+      if (parameters->options().threads())
+	{
+	  // Read the candidate sections in parallel, and carry on once
+	  // the identical sections have been found.
+	  Task_token* next_blocker = new Task_token(true);
+	  symtab->icf()->queue_find_identical_sections(input_objects, symtab,
+						       workqueue,
+						       next_blocker);
+	  Middle_runner* runner =
+	    new Middle_runner(options, input_objects, symtab, layout, mapfile,
+			      queue_middle_layout_tasks);
+	  workqueue->queue(new Task_function(runner, next_blocker,
+					     "Task_function Middle_runner"));
+	  return;
+	}
       symtab->icf()->find_identical_sections(input_objects, symtab);
     }
 
+  queue_middle_layout_tasks(options, task, input_objects, symtab, layout,
+			    workqueue, mapfile);
+}
+
+// Queue up the rest of the middle set of tasks, once the sections
+// which are garbage or identical are known.
+
+void
+queue_middle_layout_tasks(const General_options& options,
+			  const Task* task,
+			  const Input_objects* input_objects,
+			  Symbol_table* symtab,
+			  Layout* layout,
+			  Workqueue* workqueue,
+			  Mapfile* mapfile)
+{
   // Call Object::layout for the second time to determine the
   // output_sections for all referenced input sections.  When
   // --gc-sections or --icf is turned on, or when certain input
@@ -777,6 +858,30 @@ queue_middle_tasks(const General_options& options,
 	}
     }
 
+  // Merge the strings of mergeable string sections while the
+  // relocations are read.  The layout task waits for these tasks too.
+  if (parameters->options().threads())
+    layout->queue_merge_tasks(workqueue, this_blocker);
+
+  // Scan the debug information for the .gdb_index section, one task
+  // per object.  The layout task waits for these tasks too.
+  layout->queue_gdb_index_tasks(workqueue, this_blocker);
+
+  // Once the relocations have been scanned, nothing more is added to
+  // most output sections.  Sort their input sections and set their
+  // offsets in parallel, rather than one output section at a time in
+  // Layout::finalize.
+  if (parameters->options().threads())
+    {
+      Task_token* prefinalize_blocker = new Task_token(true);
+      prefinalize_blocker->add_blocker();
+      workqueue->queue(new Task_function(
+	  new Prefinalize_sections_task_runner(layout, prefinalize_blocker),
+	  this_blocker,
+	  "Task_function Prefinalize_sections_task_runner"));
+      this_blocker = prefinalize_blocker;
+    }
+
   // When all those tasks are complete, we can start laying out the
   // output file.
   workqueue->queue(new Task_function(new Layout_task_runner(options,
@@ -836,6 +941,12 @@ queue_final_tasks(const General_options& options,
   if (!any_postprocessing_sections)
     final_blocker->add_blocker();
 
+  // Queue tasks to write out the contents of sections which can be
+  // written in parallel, such as the dynamic relocations.  This must
+  // be done before Write_sections_task is queued.
+  if (options.threads())
+    layout->queue_write_tasks(workqueue, of, final_blocker);
+
   // Queue a task to write out the symbol table.
   workqueue->queue(new Write_symbols_task(layout,
 					  symtab,
@@ -878,15 +989,27 @@ queue_final_tasks(const General_options& options,
     {
       Task_token* new_final_blocker = new Task_token(true);
       new_final_blocker->add_blocker();
-      Task* t = new Write_after_input_sections_task(layout, of,
-						    final_blocker,
-						    new_final_blocker);
-      workqueue->queue(t);
+      if (strcmp(options.compress_debug_sections(), "none") != 0)
+	{
+	  // Compress the sections in parallel before writing them.
+	  Compress_sections_task_runner* r =
+	    new Compress_sections_task_runner(layout, of, new_final_blocker);
+	  const char* name = "Task_function Compress_sections_task_runner";
+	  workqueue->queue(new Task_function(r, final_blocker, name));
+	}
+      else
+	{
+	  Task* t = new Write_after_input_sections_task(layout, of,
+							final_blocker,
+							new_final_blocker);
+	  workqueue->queue(t);
+	}
       final_blocker = new_final_blocker;
     }
 
   // Create tasks for tree-style build ID computation, if necessary.
-  if (strcmp(options.build_id(), "tree") == 0)
+  if (strcmp(options.build_id(), "tree") == 0
+      || strcmp(options.build_id(), "fast") == 0)
     {
       // Queue a task to compute the build id.  This will be blocked by
       // FINAL_BLOCKER, and will in turn schedule the task to close
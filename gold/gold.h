@@ -232,6 +232,28 @@ queue_middle_tasks(const General_options&,
 		   Workqueue*,
 		   Mapfile*);
 
+// Queue up the part of the middle set of tasks which does identical
+// code folding.
+extern void
+queue_middle_icf_tasks(const General_options&,
+		       const Task*,
+		       const Input_objects*,
+		       Symbol_table*,
+		       Layout*,
+		       Workqueue*,
+		       Mapfile*);
+
+// Queue up the part of the middle set of tasks which follows
+// identical code folding.
+extern void
+queue_middle_layout_tasks(const General_options&,
+			  const Task*,
+			  const Input_objects*,
+			  Symbol_table*,
+			  Layout*,
+			  Workqueue*,
+			  Mapfile*);
+
 // Queue up the final set of tasks.
 extern void
 queue_final_tasks(const General_options&,
@@ -275,9 +297,30 @@ string_hash(const Char_type* s, size_t length)
   // for a C++ program with 385,775 global symbols.  This hash
   // function was very slightly worse.  However, it is much faster to
   // compute.  Overall wall clock time was a win.
+  //
+  // The low 32 bits of the result are the DT_GNU_HASH value, so hash
+  // codes computed here are reused for the .gnu.hash section.  Do
+  // not change the function.
+  //
+  // We take eight bytes per step.  This computes the same value as
+  // h = h * 33 + c for each byte, but the products of a step do not
+  // depend on each other, so the CPU can overlap them.
+  const size_t k1 = 33;
+  const size_t k2 = k1 * 33;
+  const size_t k3 = k2 * 33;
+  const size_t k4 = k3 * 33;
+  const size_t k5 = k4 * 33;
+  const size_t k6 = k5 * 33;
+  const size_t k7 = k6 * 33;
+  const size_t k8 = k7 * 33;
   const unsigned char* p = reinterpret_cast<const unsigned char*>(s);
+  size_t n = length * sizeof(Char_type);
   size_t h = 5381;
-  for (size_t i = 0; i < length * sizeof(Char_type); ++i)
+  for (; n >= 8; n -= 8, p += 8)
+    h = (h * k8
+	 + (p[0] * k7 + p[1] * k6 + p[2] * k5 + p[3] * k4)
+	 + (p[4] * k3 + p[5] * k2 + p[6] * k1 + p[7]));
+  for (; n > 0; --n)
     h = h * 33 + *p++;
   return h;
 }
@@ -130,6 +130,14 @@
 // folded causing unpredictable run-time behaviour if the pointers were used
 // in comparisons.
 //
+// Threads :
+// -------
+//
+// With --threads the sections of each object are read, and the
+// checksums of their fixed contents computed, by a separate task.  Only
+// the relocs to foldable sections change from one iteration to the next,
+// so forming the groups is cheap and is done serially, in the same order
+// as without threads, to produce the same output.
 //
 //
 // How to run  : --icf=[safe|all|none]
@@ -143,6 +151,7 @@
 #include "gc.h"
 #include "icf.h"
 #include "symtab.h"
+#include "workqueue.h"
 #include "libiberty.h"
 #include "demangle.h"
 #include "elfcpp.h"
@@ -150,57 +159,31 @@
 
 namespace gold
 {
-
 // This function determines if a section or a group of identical
 // sections has unique contents.  Such unique sections or groups can be
 // declared final and need not be processed any further.
 // Parameters :
-// ID_SECTION : Vector mapping a section index to a Section_id pair.
 // IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
 //                            sections is already known to be unique.
-// SECTION_CONTENTS : Contains the section's text and relocs to sections
-//                    that cannot be folded.   SECTION_CONTENTS are NULL
-//                    implies that this function is being called for the
-//                    first time before the first iteration of icf.
+// SECTION_CKSUMS : The checksum of the contents of each section.  Before
+//                  the first iteration of icf this is the checksum of
+//                  the section's data, after it the checksum of its text
+//                  and relocs to sections that cannot be folded.
 
 static void
-preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
-                               std::vector<bool>* is_secn_or_group_unique,
-                               std::vector<std::string>* section_contents)
+preprocess_for_unique_sections(std::vector<bool>* is_secn_or_group_unique,
+                               const std::vector<uint32_t>& section_cksums)
 {
   Unordered_map<uint32_t, unsigned int> uniq_map;
   std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
     uniq_map_insert;
 
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < section_cksums.size(); i++)
     {
       if ((*is_secn_or_group_unique)[i])
         continue;
 
-      uint32_t cksum;
-      Section_id secn = id_section[i];
-      section_size_type plen;
-      if (section_contents == NULL)
-        {
-          // Lock the object so we can read from it.  This is only called
-          // single-threaded from queue_middle_tasks, so it is OK to lock.
-          // Unfortunately we have no way to pass in a Task token.
-          const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-          Task_lock_obj<Object> tl(dummy_task, secn.first);
-          const unsigned char* contents;
-          contents = secn.first->section_contents(secn.second,
-                                                  &plen,
-                                                  false);
-          cksum = xcrc32(contents, plen, 0xffffffff);
-        }
-      else
-        {
-          const unsigned char* contents_array = reinterpret_cast
-            <const unsigned char*>((*section_contents)[i].c_str());
-          cksum = xcrc32(contents_array, (*section_contents)[i].length(),
-                         0xffffffff);
-        }
-      uniq_map_insert = uniq_map.insert(std::make_pair(cksum, i));
+      uniq_map_insert = uniq_map.insert(std::make_pair(section_cksums[i], i));
       if (uniq_map_insert.second)
         {
           (*is_secn_or_group_unique)[i] = true;
@@ -252,48 +235,96 @@ get_rel_addend(const unsigned char* reloc_addend_ptr,
     }
 }
 
-// This returns the buffer containing the section's contents, both
-// text and relocs.  Relocs are differentiated as those pointing to
-// sections that could be folded and those that cannot.  Only relocs
-// pointing to sections that could be folded are recomputed on
-// subsequent invocations of this function.
+// This appends the contents of a merge section that a reloc points to.
+// Parameters  :
+// OBJECT, SHNDX : The merge section.
+// OFFSET        : The offset of the contents in the merge section.
+// BUFFER        : The buffer to append to.
+
+static void
+append_merge_section_contents(Relobj* object, unsigned int shndx,
+                              long long offset, std::string* buffer)
+{
+  uint64_t secn_flags = object->section_flags(shndx);
+  uint64_t entsize = object->section_entsize(shndx);
+
+  section_size_type secn_len;
+
+  const unsigned char* str_contents =
+  object->section_contents(shndx, &secn_len, false) + offset;
+  gold_assert (offset < (long long) secn_len);
+
+  if ((secn_flags & elfcpp::SHF_STRINGS) != 0)
+    {
+      // String merge section.
+      const char* str_char =
+        reinterpret_cast<const char*>(str_contents);
+      switch(entsize)
+        {
+        case 1:
+          {
+            buffer->append(str_char);
+            break;
+          }
+        case 2:
+          {
+            const uint16_t* ptr_16 =
+              reinterpret_cast<const uint16_t*>(str_char);
+            unsigned int strlen_16 = 0;
+            // Find the NULL character.
+            while(*(ptr_16 + strlen_16) != 0)
+                strlen_16++;
+            buffer->append(str_char, strlen_16 * 2);
+          }
+          break;
+        case 4:
+          {
+            const uint32_t* ptr_32 =
+              reinterpret_cast<const uint32_t*>(str_char);
+            unsigned int strlen_32 = 0;
+            // Find the NULL character.
+            while(*(ptr_32 + strlen_32) != 0)
+                strlen_32++;
+            buffer->append(str_char, strlen_32 * 4);
+          }
+          break;
+        default:
+          gold_unreachable();
+        }
+    }
+  else
+    {
+      // Use the entsize to determine the length to copy.
+      uint64_t bufsize = entsize;
+      // If entsize is too big, copy all the remaining bytes.
+      if ((offset + entsize) > secn_len)
+        bufsize = secn_len - offset;
+      buffer->append(reinterpret_cast<const char*>(str_contents),
+                     bufsize);
+    }
+}
+
+// This computes the section's contents, text and relocs to sections
+// that cannot be folded, which do not change from one iteration to the
+// next.  Relocs pointing to sections that could be folded are stored
+// separately in SECTION_RELOCS, as are relocs pointing to merge sections
+// in other objects, since only the object containing SECN is locked.
 // Parameters  :
-// FIRST_ITERATION    : true if it is the first invocation.
 // SECN               : Section for which contents are desired.
-// SECTION_NUM        : Unique section number of this section.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
-// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
+// BUFFER             : Store the section's text and relocs to non-ICF
 //                      sections.
+// SECTION_RELOCS     : Store the relocs to ICF sections and to merge
+//                      sections in other objects.
 
-static std::string
-get_section_contents(bool first_iteration,
-                     const Section_id& secn,
-                     unsigned int section_num,
-                     unsigned int* num_tracked_relocs,
+static void
+get_section_contents(const Section_id& secn,
                      Symbol_table* symtab,
-                     const std::vector<unsigned int>& kept_section_id,
-                     std::vector<std::string>* section_contents)
+                     std::string* buffer,
+                     Icf::Section_relocs* section_relocs)
 {
-  // Lock the object so we can read from it.  This is only called
-  // single-threaded from queue_middle_tasks, so it is OK to lock.
-  // Unfortunately we have no way to pass in a Task token.
-  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-  Task_lock_obj<Object> tl(dummy_task, secn.first);
-
   section_size_type plen;
   const unsigned char* contents = NULL;
-  if (first_iteration)
-    contents = secn.first->section_contents(secn.second, &plen, false);
-
-  // The buffer to hold all the contents including relocs.  A checksum
-  // is then computed on this buffer.
-  std::string buffer;
-  std::string icf_reloc_buffer;
-
-  if (num_tracked_relocs)
-    *num_tracked_relocs = 0;
+  contents = secn.first->section_contents(secn.second, &plen, false);
 
   Icf::Reloc_info_list& reloc_info_list = 
     symtab->icf()->reloc_info_list();
@@ -301,8 +332,7 @@ get_section_contents(bool first_iteration,
   Icf::Reloc_info_list::iterator it_reloc_info_list =
     reloc_info_list.find(secn);
 
-  buffer.clear();
-  icf_reloc_buffer.clear();
+  buffer->clear();
 
   // Process relocs and put them into the buffer.
 
@@ -337,8 +367,7 @@ get_section_contents(bool first_iteration,
 	      gsym = NULL;
 	    }
 
-	  if (first_iteration
-	      && it_v->first != NULL)
+	  if (it_v->first != NULL)
 	    {
 	      Symbol_location loc;
 	      loc.object = it_v->first;
@@ -374,15 +403,12 @@ get_section_contents(bool first_iteration,
 	  // object is NULL.
 	  if (it_v->first == NULL)
             {
-	      if (first_iteration)
-                {
-		  // If the symbol name is available, use it.
-                  if (gsym != NULL)
-                      buffer.append(gsym->name());
-                  // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
-		}
+	      // If the symbol name is available, use it.
+	      if (gsym != NULL)
+		  buffer->append(gsym->name());
+	      // Append the addend.
+	      buffer->append(addend_str);
+	      buffer->append("@");
 	      continue;
 	    }
 
@@ -393,12 +419,9 @@ get_section_contents(bool first_iteration,
           if (reloc_secn.first == secn.first
               && reloc_secn.second == secn.second)
             {
-              if (first_iteration)
-                {
-                  buffer.append("R");
-                  buffer.append(addend_str);
-                  buffer.append("@");
-                }
+              buffer->append("R");
+              buffer->append(addend_str);
+              buffer->append("@");
               continue;
             }
           Icf::Uniq_secn_id_map& section_id_map =
@@ -413,38 +436,25 @@ get_section_contents(bool first_iteration,
               && section_id_map_it != section_id_map.end())
             {
               // This is a reloc to a section that might be folded.
-              if (num_tracked_relocs)
-                (*num_tracked_relocs)++;
-
-              char kept_section_str[10];
-              unsigned int secn_id = section_id_map_it->second;
-              snprintf(kept_section_str, sizeof(kept_section_str), "%u",
-                       kept_section_id[secn_id]);
-              if (first_iteration)
-                {
-                  buffer.append("ICF_R");
-                  buffer.append(addend_str);
-                }
-              icf_reloc_buffer.append(kept_section_str);
+              // The kept section it refers to is filled in on each
+              // iteration.
+              section_relocs->icf_sections.push_back(
+                  section_id_map_it->second);
+              buffer->append("ICF_R");
+              buffer->append(addend_str);
               // Append the addend.
-              icf_reloc_buffer.append(addend_str);
-              icf_reloc_buffer.append("@");
+              section_relocs->icf_addends.append(addend_str);
+              section_relocs->icf_addends.append("@");
             }
           else
             {
               // This is a reloc to a section that cannot be folded.
-              // Process it only in the first iteration.
-              if (!first_iteration)
-                continue;
-
               uint64_t secn_flags = (it_v->first)->section_flags(it_v->second);
               // This reloc points to a merge section.  Hash the
               // contents of this section.
               if ((secn_flags & elfcpp::SHF_MERGE) != 0
 		  && parameters->target().can_icf_inline_merge_sections())
                 {
-                  uint64_t entsize =
-                    (it_v->first)->section_entsize(it_v->second);
 		  long long offset = it_a->first;
 
 		  // Handle SHT_RELA and SHT_REL addends. Only one of these
@@ -482,106 +492,96 @@ get_section_contents(bool first_iteration,
 			offset = offset + reloc_addend_value;
 		    }
 
-                  section_size_type secn_len;
-
-                  const unsigned char* str_contents =
-                  (it_v->first)->section_contents(it_v->second,
-                                                  &secn_len,
-                                                  false) + offset;
-		  gold_assert (offset < (long long) secn_len);
-
-                  if ((secn_flags & elfcpp::SHF_STRINGS) != 0)
-                    {
-                      // String merge section.
-                      const char* str_char =
-                        reinterpret_cast<const char*>(str_contents);
-                      switch(entsize)
-                        {
-                        case 1:
-                          {
-                            buffer.append(str_char);
-                            break;
-                          }
-                        case 2:
-                          {
-                            const uint16_t* ptr_16 =
-                              reinterpret_cast<const uint16_t*>(str_char);
-                            unsigned int strlen_16 = 0;
-                            // Find the NULL character.
-                            while(*(ptr_16 + strlen_16) != 0)
-                                strlen_16++;
-                            buffer.append(str_char, strlen_16 * 2);
-                          }
-                          break;
-                        case 4:
-                          {
-                            const uint32_t* ptr_32 =
-                              reinterpret_cast<const uint32_t*>(str_char);
-                            unsigned int strlen_32 = 0;
-                            // Find the NULL character.
-                            while(*(ptr_32 + strlen_32) != 0)
-                                strlen_32++;
-                            buffer.append(str_char, strlen_32 * 4);
-                          }
-                          break;
-                        default:
-                          gold_unreachable();
-                        }
-                    }
-                  else
-                    {
-                      // Use the entsize to determine the length to copy.
-		      uint64_t bufsize = entsize;
-		      // If entsize is too big, copy all the remaining bytes.
-		      if ((offset + entsize) > secn_len)
-			bufsize = secn_len - offset;
-                      buffer.append(reinterpret_cast<const
-                                                     char*>(str_contents),
-                                    bufsize);
-                    }
-		  buffer.append("@");
+		  if (it_v->first == secn.first)
+		    append_merge_section_contents(it_v->first, it_v->second,
+						  offset, buffer);
+		  else
+		    {
+		      Icf::Merge_reloc merge_reloc;
+		      merge_reloc.position = buffer->length();
+		      merge_reloc.object = it_v->first;
+		      merge_reloc.shndx = it_v->second;
+		      merge_reloc.offset = offset;
+		      section_relocs->merge_relocs.push_back(merge_reloc);
+		    }
+		  buffer->append("@");
                 }
               else if (gsym != NULL)
                 {
                   // If symbol name is available use that.
-                  buffer.append(gsym->name());
+                  buffer->append(gsym->name());
                   // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
+                  buffer->append(addend_str);
+                  buffer->append("@");
                 }
               else
                 {
                   // Symbol name is not available, like for a local symbol,
                   // use object and section id.
-                  buffer.append(it_v->first->name());
+                  buffer->append(it_v->first->name());
                   char secn_id[10];
                   snprintf(secn_id, sizeof(secn_id), "%u",it_v->second);
-                  buffer.append(secn_id);
+                  buffer->append(secn_id);
                   // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
+                  buffer->append(addend_str);
+                  buffer->append("@");
                 }
             }
         }
     }
 
-  if (first_iteration)
-    {
-      buffer.append("Contents = ");
-      buffer.append(reinterpret_cast<const char*>(contents), plen);
-      // Store the section contents that don't change to avoid recomputing
-      // during the next call to this function.
-      (*section_contents)[section_num] = buffer;
-    }
-  else
+  buffer->append("Contents = ");
+  buffer->append(reinterpret_cast<const char*>(contents), plen);
+}
+
+// This returns the part of the section's contents made of its relocs
+// to sections that might be folded, using the section each of them is
+// currently folded into.
+// Parameters  :
+// SECTION_RELOCS     : The relocs of the section.
+// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
+// BUFFER             : Store the relocs.
+
+static void
+get_icf_reloc_contents(const Icf::Section_relocs& section_relocs,
+                       const std::vector<unsigned int>& kept_section_id,
+                       std::string* buffer)
+{
+  const std::string& addends(section_relocs.icf_addends);
+  size_t pos = 0;
+  for (std::vector<unsigned int>::const_iterator p =
+         section_relocs.icf_sections.begin();
+       p != section_relocs.icf_sections.end();
+       ++p)
     {
-      gold_assert(buffer.empty());
-      // Reuse the contents computed in the previous iteration.
-      buffer.append((*section_contents)[section_num]);
+      char kept_section_str[10];
+      snprintf(kept_section_str, sizeof(kept_section_str), "%u",
+               kept_section_id[*p]);
+      buffer->append(kept_section_str);
+      // Append the addend and its terminating '@'.
+      size_t end = addends.find('@', pos);
+      gold_assert(end != std::string::npos);
+      buffer->append(addends, pos, end + 1 - pos);
+      pos = end + 1;
     }
+}
+
+// This returns true if the contents of two sections are identical.
+// The contents of each section are its fixed contents followed by its
+// relocs to sections that might be folded.
 
-  buffer.append(icf_reloc_buffer);
-  return buffer;
+static bool
+section_contents_equal(const std::string& contents1,
+                       const std::string& icf_relocs1,
+                       const std::string& contents2,
+                       const std::string& icf_relocs2)
+{
+  if (contents1.length() + icf_relocs1.length()
+      != contents2.length() + icf_relocs2.length())
+    return false;
+  if (contents1.length() == contents2.length())
+    return contents1 == contents2 && icf_relocs1 == icf_relocs2;
+  return contents1 + icf_relocs1 == contents2 + icf_relocs2;
 }
 
 // This function computes a checksum on each section to detect and form
@@ -597,83 +597,73 @@ get_section_contents(bool first_iteration,
 // identical sections.  A section is added to a group only after its
 // contents are explicitly compared with the kept section of the group.
 //
+// The checksum of the contents which do not change has already been
+// computed when the sections were read, so each iteration only needs to
+// extend it with the relocs to sections that might be folded.  This
+// stays serial: the contents of a section depend on which sections were
+// folded before it in the same iteration.
+//
 // Parameters  :
 // ITERATION_NUM           : Invocation instance of this function.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
 // KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// ID_SECTION         : Vector mapping a section to an unique integer.
+// SECTION_ADDRALIGNS : The alignment of each section.
 // IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
 //                            sections is already known to be unique.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
+// SECTION_CONTENTS   : The section's text and relocs to non-ICF
 //                      sections.
+// SECTION_CKSUMS     : The checksum of SECTION_CONTENTS.
+// SECTION_RELOCS     : The section's relocs to ICF sections.
 
 static bool
 match_sections(unsigned int iteration_num,
-               Symbol_table* symtab,
-               std::vector<unsigned int>* num_tracked_relocs,
                std::vector<unsigned int>* kept_section_id,
-               const std::vector<Section_id>& id_section,
 	       const std::vector<uint64_t>& section_addraligns,
                std::vector<bool>* is_secn_or_group_unique,
-               std::vector<std::string>* section_contents)
+               const std::vector<std::string>& section_contents,
+               const std::vector<uint32_t>& section_cksums,
+               const std::vector<Icf::Section_relocs>& section_relocs)
 {
   Unordered_multimap<uint32_t, unsigned int> section_cksum;
   std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
             Unordered_multimap<uint32_t, unsigned int>::iterator> key_range;
   bool converged = true;
 
-  if (iteration_num == 1)
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   NULL);
-  else
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   section_contents);
+  // The sections were checked for unique contents before they were
+  // read for the first iteration.
+  if (iteration_num > 1)
+    preprocess_for_unique_sections(is_secn_or_group_unique,
+                                   section_cksums);
 
-  std::vector<std::string> full_section_contents;
+  // The relocs to ICF sections of the kept section of each group.
+  std::vector<std::string> icf_reloc_contents(section_contents.size());
 
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < section_contents.size(); i++)
     {
-      full_section_contents.push_back("");
       if ((*is_secn_or_group_unique)[i])
         continue;
 
-      Section_id secn = id_section[i];
-      std::string this_secn_contents;
-      uint32_t cksum;
-      if (iteration_num == 1)
-        {
-          unsigned int num_relocs = 0;
-          this_secn_contents = get_section_contents(true, secn, i, &num_relocs,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
-          (*num_tracked_relocs)[i] = num_relocs;
-        }
-      else
+      if (iteration_num > 1 && (*kept_section_id)[i] != i)
         {
-          if ((*kept_section_id)[i] != i)
-            {
-              // This section is already folded into something.
-              continue;
-            }
-          this_secn_contents = get_section_contents(false, secn, i, NULL,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
+          // This section is already folded into something.
+          continue;
         }
 
-      const unsigned char* this_secn_contents_array =
-            reinterpret_cast<const unsigned char*>(this_secn_contents.c_str());
-      cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
-                     0xffffffff);
+      std::string this_icf_reloc_contents;
+      get_icf_reloc_contents(section_relocs[i], *kept_section_id,
+                             &this_icf_reloc_contents);
+
+      const unsigned char* this_icf_reloc_contents_array =
+        reinterpret_cast<const unsigned char*>(this_icf_reloc_contents.data());
+      uint32_t cksum = xcrc32(this_icf_reloc_contents_array,
+                              this_icf_reloc_contents.length(),
+                              section_cksums[i]);
       size_t count = section_cksum.count(cksum);
 
       if (count == 0)
         {
           // Start a group with this cksum.
           section_cksum.insert(std::make_pair(cksum, i));
-          full_section_contents[i] = this_secn_contents;
+          icf_reloc_contents[i].swap(this_icf_reloc_contents);
         }
       else
         {
@@ -683,12 +673,10 @@ match_sections(unsigned int iteration_num,
           for (it = key_range.first; it != key_range.second; ++it)
             {
               unsigned int kept_section = it->second;
-              if (full_section_contents[kept_section].length()
-                  != this_secn_contents.length())
-                  continue;
-              if (memcmp(full_section_contents[kept_section].c_str(),
-                         this_secn_contents.c_str(),
-                         this_secn_contents.length()) != 0)
+              if (!section_contents_equal(section_contents[kept_section],
+                                          icf_reloc_contents[kept_section],
+                                          section_contents[i],
+                                          this_icf_reloc_contents))
                   continue;
 
 	      // Check section alignment here.
@@ -705,8 +693,8 @@ match_sections(unsigned int iteration_num,
 		{
 		  (*kept_section_id)[kept_section] = i;
 		  it->second = i;
-		  full_section_contents[kept_section].swap(
-		      full_section_contents[i]);
+		  icf_reloc_contents[kept_section].clear();
+		  icf_reloc_contents[i].swap(this_icf_reloc_contents);
 		}
 
               converged = false;
@@ -716,18 +704,18 @@ match_sections(unsigned int iteration_num,
             {
               // Create a new group for this cksum.
               section_cksum.insert(std::make_pair(cksum, i));
-              full_section_contents[i] = this_secn_contents;
+              icf_reloc_contents[i].swap(this_icf_reloc_contents);
             }
         }
       // If there are no relocs to foldable sections do not process
       // this section any further.
-      if (iteration_num == 1 && (*num_tracked_relocs)[i] == 0)
+      if (iteration_num == 1 && section_relocs[i].icf_sections.empty())
         (*is_secn_or_group_unique)[i] = true;
     }
 
   // If a section was folded into another section that was later folded
   // again then the former has to be updated.
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < kept_section_id->size(); i++)
     {
       // Find the end of the folding chain
       unsigned int kept = i;
@@ -766,23 +754,213 @@ is_function_ctor_or_dtor(const std::string& section_name)
   return false;
 }
 
-// This is the main ICF function called in gold.cc.  This does the
-// initialization and calls match_sections repeatedly (twice by default)
-// which computes the crc checksums and detects identical functions.
+// A task to compute the checksums of the candidate sections of one
+// object.
+
+class Icf_checksum_task : public Task
+{
+ public:
+  Icf_checksum_task(Icf* icf, Relobj* object, unsigned int first,
+		    unsigned int last, Task_token* next_blocker)
+    : icf_(icf), object_(object), first_(first), last_(last),
+      next_blocker_(next_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->object_->is_locked())
+      return this->object_->token();
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    tl->add(this, this->object_->token());
+    tl->add(this, this->next_blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    this->icf_->checksum_sections(this->first_, this->last_);
+    this->object_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Icf_checksum_task " + this->object_->name(); }
+
+ private:
+  Icf* icf_;
+  Relobj* object_;
+  unsigned int first_;
+  unsigned int last_;
+  Task_token* next_blocker_;
+};
+
+// A task to read the contents and relocs of the candidate sections of
+// one object.
+
+class Icf_read_sections_task : public Task
+{
+ public:
+  Icf_read_sections_task(Icf* icf, Symbol_table* symtab, Relobj* object,
+			 unsigned int first, unsigned int last,
+			 Task_token* next_blocker)
+    : icf_(icf), symtab_(symtab), object_(object), first_(first),
+      last_(last), next_blocker_(next_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->object_->is_locked())
+      return this->object_->token();
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    tl->add(this, this->object_->token());
+    tl->add(this, this->next_blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    this->icf_->read_sections(this->symtab_, this->first_, this->last_);
+    this->object_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Icf_read_sections_task " + this->object_->name(); }
+
+ private:
+  Icf* icf_;
+  Symbol_table* symtab_;
+  Relobj* object_;
+  unsigned int first_;
+  unsigned int last_;
+  Task_token* next_blocker_;
+};
+
+// A task to find the unique sections once all the checksums have been
+// computed, and then to queue the tasks which read the sections.
+
+class Icf_unique_task : public Task
+{
+ public:
+  Icf_unique_task(Icf* icf, Symbol_table* symtab, Task_token* this_blocker,
+		  Task_token* next_blocker)
+    : icf_(icf), symtab_(symtab), this_blocker_(this_blocker),
+      next_blocker_(next_blocker)
+  { }
+
+  ~Icf_unique_task()
+  { delete this->this_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->this_blocker_->is_blocked())
+      return this->this_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue* workqueue)
+  {
+    this->icf_->find_unique_sections();
+    for (unsigned int i = 0; i < this->icf_->object_count(); ++i)
+      {
+	unsigned int first;
+	unsigned int last;
+	Relobj* obj = this->icf_->object_sections(i, &first, &last);
+	workqueue->add_blocker(this->next_blocker_);
+	workqueue->queue(new Icf_read_sections_task(this->icf_, this->symtab_,
+						    obj, first, last,
+						    this->next_blocker_));
+      }
+  }
+
+  std::string
+  get_name() const
+  { return "Icf_unique_task"; }
+
+ private:
+  Icf* icf_;
+  Symbol_table* symtab_;
+  Task_token* this_blocker_;
+  Task_token* next_blocker_;
+};
+
+// A task to form the groups of identical sections once all the
+// sections have been read.
+
+class Icf_fold_task : public Task
+{
+ public:
+  Icf_fold_task(Icf* icf, Symbol_table* symtab, Task_token* this_blocker,
+		Task_token* next_blocker)
+    : icf_(icf), symtab_(symtab), this_blocker_(this_blocker),
+      next_blocker_(next_blocker)
+  { }
+
+  ~Icf_fold_task()
+  { delete this->this_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->this_blocker_->is_blocked())
+      return this->this_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->icf_->fold_sections(this->symtab_); }
+
+  std::string
+  get_name() const
+  { return "Icf_fold_task"; }
+
+ private:
+  Icf* icf_;
+  Symbol_table* symtab_;
+  Task_token* this_blocker_;
+  Task_token* next_blocker_;
+};
+
+// Decide which sections are possible candidates for folding.
 
 void
-Icf::find_identical_sections(const Input_objects* input_objects,
+Icf::find_candidate_sections(const Input_objects* input_objects,
                              Symbol_table* symtab)
 {
   unsigned int section_num = 0;
-  std::vector<unsigned int> num_tracked_relocs;
-  std::vector<uint64_t> section_addraligns;
-  std::vector<bool> is_secn_or_group_unique;
-  std::vector<std::string> section_contents;
   const Target& target = parameters->target();
 
-  // Decide which sections are possible candidates first.
-
   for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
        p != input_objects->relobj_end();
        ++p)
@@ -793,6 +971,7 @@ Icf::find_identical_sections(const Input_objects* input_objects,
       const Task* dummy_task = reinterpret_cast<const Task*>(-1);
       Task_lock_obj<Object> tl(dummy_task, *p);
 
+      unsigned int first_section_num = section_num;
       for (unsigned int i = 0;i < (*p)->shnum(); ++i)
         {
 	  const std::string section_name = (*p)->section_name(i);
@@ -816,12 +995,103 @@ Icf::find_identical_sections(const Input_objects* input_objects,
           this->id_section_.push_back(Section_id(*p, i));
           this->section_id_[Section_id(*p, i)] = section_num;
           this->kept_section_id_.push_back(section_num);
-          num_tracked_relocs.push_back(0);
-	  section_addraligns.push_back((*p)->section_addralign(i));
-          is_secn_or_group_unique.push_back(false);
-          section_contents.push_back("");
+	  this->section_addraligns_.push_back((*p)->section_addralign(i));
           section_num++;
         }
+      if (section_num != first_section_num)
+        this->object_sections_.push_back(first_section_num);
+    }
+  this->object_sections_.push_back(section_num);
+
+  this->is_secn_or_group_unique_.resize(section_num, false);
+  this->section_cksums_.resize(section_num);
+  this->section_contents_.resize(section_num);
+  this->section_relocs_.resize(section_num);
+}
+
+// Compute the checksums of the data of the candidate sections FIRST to
+// LAST.
+
+void
+Icf::checksum_sections(unsigned int first, unsigned int last)
+{
+  for (unsigned int i = first; i < last; ++i)
+    {
+      Section_id secn = this->id_section_[i];
+      section_size_type plen;
+      const unsigned char* contents;
+      contents = secn.first->section_contents(secn.second, &plen, false);
+      this->section_cksums_[i] = xcrc32(contents, plen, 0xffffffff);
+    }
+}
+
+// Sections whose data is unique cannot be folded and need not be read.
+
+void
+Icf::find_unique_sections()
+{
+  preprocess_for_unique_sections(&this->is_secn_or_group_unique_,
+                                 this->section_cksums_);
+}
+
+// Read the candidate sections FIRST to LAST that might be folded.
+
+void
+Icf::read_sections(Symbol_table* symtab, unsigned int first,
+                   unsigned int last)
+{
+  for (unsigned int i = first; i < last; ++i)
+    {
+      if (this->is_secn_or_group_unique_[i])
+        continue;
+
+      std::string* contents = &this->section_contents_[i];
+      get_section_contents(this->id_section_[i], symtab, contents,
+                           &this->section_relocs_[i]);
+      // The checksum of a section referring to merge sections in other
+      // objects is computed once their contents have been added.
+      if (this->section_relocs_[i].merge_relocs.empty())
+        this->section_cksums_[i] =
+          xcrc32(reinterpret_cast<const unsigned char*>(contents->data()),
+                 contents->length(), 0xffffffff);
+    }
+}
+
+// This does the folding once all the sections have been read, and
+// calls match_sections repeatedly (twice by default) which computes the
+// crc checksums and detects identical functions.
+
+void
+Icf::fold_sections(Symbol_table* symtab)
+{
+  // Add the contents of merge sections in other objects.
+  for (unsigned int i = 0; i < this->section_contents_.size(); ++i)
+    {
+      std::vector<Merge_reloc>& merge_relocs =
+        this->section_relocs_[i].merge_relocs;
+      if (merge_relocs.empty())
+        continue;
+
+      std::string& contents(this->section_contents_[i]);
+      for (std::vector<Merge_reloc>::reverse_iterator p =
+             merge_relocs.rbegin();
+           p != merge_relocs.rend();
+           ++p)
+        {
+          // Lock the object so we can read from it.  This is only
+          // called after all the tasks reading sections are done, so
+          // it is OK to lock.
+          const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+          Task_lock_obj<Object> tl(dummy_task, p->object);
+
+          std::string merge_contents;
+          append_merge_section_contents(p->object, p->shndx, p->offset,
+                                        &merge_contents);
+          contents.insert(p->position, merge_contents);
+        }
+      this->section_cksums_[i] =
+        xcrc32(reinterpret_cast<const unsigned char*>(contents.data()),
+               contents.length(), 0xffffffff);
     }
 
   unsigned int num_iterations = 0;
@@ -836,10 +1106,12 @@ Icf::find_identical_sections(const Input_objects* input_objects,
   while (!converged && (num_iterations < max_iterations))
     {
       num_iterations++;
-      converged = match_sections(num_iterations, symtab,
-                                 &num_tracked_relocs, &this->kept_section_id_,
-                                 this->id_section_, section_addraligns,
-                                 &is_secn_or_group_unique, &section_contents);
+      converged = match_sections(num_iterations, &this->kept_section_id_,
+                                 this->section_addraligns_,
+                                 &this->is_secn_or_group_unique_,
+                                 this->section_contents_,
+                                 this->section_cksums_,
+                                 this->section_relocs_);
     }
 
   if (parameters->options().print_icf_sections())
@@ -878,9 +1150,84 @@ Icf::find_identical_sections(const Input_objects* input_objects,
 
     }
 
+  // The contents are not needed any more.
+  std::vector<std::string>().swap(this->section_contents_);
+  std::vector<Section_relocs>().swap(this->section_relocs_);
+
   this->icf_ready();
 }
 
+// This is the main ICF function called in gold.cc.  This does the
+// initialization, reads the candidate sections and then folds the
+// identical ones.
+
+void
+Icf::find_identical_sections(const Input_objects* input_objects,
+                             Symbol_table* symtab)
+{
+  this->find_candidate_sections(input_objects, symtab);
+
+  // Lock each object so we can read from it.  This is only called
+  // single-threaded from queue_middle_tasks, so it is OK to lock.
+  // Unfortunately we have no way to pass in a Task token.
+  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+
+  for (unsigned int i = 0; i < this->object_count(); ++i)
+    {
+      unsigned int first;
+      unsigned int last;
+      Relobj* obj = this->object_sections(i, &first, &last);
+      Task_lock_obj<Object> tl(dummy_task, obj);
+      this->checksum_sections(first, last);
+    }
+
+  this->find_unique_sections();
+
+  for (unsigned int i = 0; i < this->object_count(); ++i)
+    {
+      unsigned int first;
+      unsigned int last;
+      Relobj* obj = this->object_sections(i, &first, &last);
+      Task_lock_obj<Object> tl(dummy_task, obj);
+      this->read_sections(symtab, first, last);
+    }
+
+  this->fold_sections(symtab);
+}
+
+// Like find_identical_sections, but the sections of each object are
+// checksummed and read by a separate task.  The checksums of all the
+// sections are needed before they are read, to skip the unique ones.
+
+void
+Icf::queue_find_identical_sections(const Input_objects* input_objects,
+                                   Symbol_table* symtab,
+                                   Workqueue* workqueue,
+                                   Task_token* final_blocker)
+{
+  this->find_candidate_sections(input_objects, symtab);
+
+  Task_token* checksum_blocker = new Task_token(true);
+  checksum_blocker->add_blockers(this->object_count());
+  for (unsigned int i = 0; i < this->object_count(); ++i)
+    {
+      unsigned int first;
+      unsigned int last;
+      Relobj* obj = this->object_sections(i, &first, &last);
+      workqueue->queue(new Icf_checksum_task(this, obj, first, last,
+                                             checksum_blocker));
+    }
+
+  Task_token* read_blocker = new Task_token(true);
+  read_blocker->add_blocker();
+  workqueue->queue(new Icf_unique_task(this, symtab, checksum_blocker,
+                                       read_blocker));
+
+  final_blocker->add_blocker();
+  workqueue->queue(new Icf_fold_task(this, symtab, read_blocker,
+                                     final_blocker));
+}
+
 // Unfolds the section denoted by OBJ and SHNDX if folded.
 
 void
@@ -35,6 +35,8 @@ namespace gold
 class Object;
 class Input_objects;
 class Symbol_table;
+class Task_token;
+class Workqueue;
 
 class Icf
 {
@@ -64,9 +66,38 @@ class Icf
   typedef Unordered_map<Section_id, Reloc_info,
                         Section_id_hash> Reloc_info_list;
 
+  // A reloc to a merge section in another object.  The contents it
+  // refers to are only added once all the sections have been read,
+  // since the other object may be locked by another task.
+  struct Merge_reloc
+  {
+    // Where the contents go in the section contents.
+    size_t position;
+    // The merge section and the offset of the contents in it.
+    Relobj* object;
+    unsigned int shndx;
+    long long offset;
+  };
+
+  // The relocs of a section which are not simply part of its
+  // contents.
+  struct Section_relocs
+  {
+    // The section numbers of the foldable sections that the relocs
+    // refer to.  These are replaced by the kept section of each on
+    // every iteration.
+    std::vector<unsigned int> icf_sections;
+    // The addends of those relocs, each terminated by '@'.
+    std::string icf_addends;
+    // The relocs to merge sections in other objects.
+    std::vector<Merge_reloc> merge_relocs;
+  };
+
   Icf()
   : id_section_(), section_id_(), kept_section_id_(),
-    fptr_section_id_(),
+    fptr_section_id_(), object_sections_(), section_addraligns_(),
+    is_secn_or_group_unique_(), section_cksums_(), section_contents_(),
+    section_relocs_(),
     icf_ready_(false),
     reloc_info_list_()
   { }
@@ -82,6 +113,51 @@ class Icf
   find_identical_sections(const Input_objects* input_objects,
                           Symbol_table* symtab);
 
+  // Like find_identical_sections, but read the candidate sections of
+  // each object in a separate task.  FINAL_BLOCKER is unblocked when
+  // the groups have been formed.
+  void
+  queue_find_identical_sections(const Input_objects* input_objects,
+                                Symbol_table* symtab, Workqueue* workqueue,
+                                Task_token* final_blocker);
+
+  // Compute the checksums of the contents of the candidate sections
+  // FIRST to LAST, which all come from the same object.  The object
+  // must be locked.
+  void
+  checksum_sections(unsigned int first, unsigned int last);
+
+  // Mark the candidate sections whose contents are unique.
+  void
+  find_unique_sections();
+
+  // Read the contents and the relocs of the candidate sections FIRST
+  // to LAST, which all come from the same object.  The object must be
+  // locked.
+  void
+  read_sections(Symbol_table* symtab, unsigned int first, unsigned int last);
+
+  // Form the groups of identical sections from the contents read by
+  // read_sections.
+  void
+  fold_sections(Symbol_table* symtab);
+
+  // Return the number of objects with candidate sections.
+  unsigned int
+  object_count() const
+  { return this->object_sections_.size() - 1; }
+
+  // Return the object with candidate sections number I, and set
+  // *PFIRST and *PLAST to the range of its candidate sections.
+  Relobj*
+  object_sections(unsigned int i, unsigned int* pfirst,
+                  unsigned int* plast) const
+  {
+    *pfirst = this->object_sections_[i];
+    *plast = this->object_sections_[i + 1];
+    return this->id_section_[*pfirst].first;
+  }
+
   // This is set when ICF has been run and the groups of
   // identical sections have been formed.
   void
@@ -144,6 +220,11 @@ class Icf
 
  private:
 
+  // Decide which sections are candidates for folding.
+  void
+  find_candidate_sections(const Input_objects* input_objects,
+                          Symbol_table* symtab);
+
   // Maps integers to sections.
   std::vector<Section_id> id_section_;
   // Does the reverse.
@@ -156,6 +237,24 @@ class Icf
   // function is taken in which case it is dangerous to fold
   // this function.
   Secn_fptr_taken_set fptr_section_id_;
+  // The number of the first candidate section of each object, followed
+  // by the number of candidate sections.  The candidate sections of an
+  // object are numbered consecutively.
+  std::vector<unsigned int> object_sections_;
+  // The alignment of each candidate section.
+  std::vector<uint64_t> section_addraligns_;
+  // Whether each section, or the group it is kept for, is known to be
+  // unique.
+  std::vector<bool> is_secn_or_group_unique_;
+  // The checksum of the contents of each section.  This is the
+  // checksum of the section data until read_sections replaces it with
+  // the checksum of SECTION_CONTENTS_.
+  std::vector<uint32_t> section_cksums_;
+  // The contents of each section which do not change when sections are
+  // folded: its data and its relocs to sections that cannot be folded.
+  std::vector<std::string> section_contents_;
+  // The relocs of each section that are not part of SECTION_CONTENTS_.
+  std::vector<Section_relocs> section_relocs_;
   // Flag to indicate if ICF has been run.
   bool icf_ready_;
   // This list is populated by gc_process_relocs in gc.h.
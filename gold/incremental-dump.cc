@@ -96,7 +96,7 @@ dump_incremental_inputs(const char* argv0, const char* filename,
   Incremental_inputs_reader<size, big_endian>
       incremental_inputs(inc->inputs_reader());
 
-  if (incremental_inputs.version() != 2)
+  if (incremental_inputs.version() != 3)
     {
       fprintf(stderr, "%s: %s: unknown incremental version %d\n", argv0,
               filename, incremental_inputs.version());
@@ -159,6 +159,14 @@ dump_incremental_inputs(const char* argv0, const char* filename,
 		 input_file.get_dyn_reloc_count());
 	  printf("    COMDAT group count: %d\n",
 		 input_file.get_comdat_group_count());
+	  if (input_file.get_content_hash() != NULL)
+	    {
+	      const unsigned char* hash = input_file.get_content_hash();
+	      printf("    Content hash: ");
+	      for (unsigned int j = 0; j < INCREMENTAL_CONTENT_HASH_SIZE; ++j)
+		printf("%02x", hash[j]);
+	      printf("\n");
+	    }
 	  break;
 	case INCREMENTAL_INPUT_ARCHIVE:
 	  printf("Archive\n");
@@ -24,7 +24,10 @@
 
 #include <set>
 #include <cstdarg>
+#include <fcntl.h>
+#include <unistd.h>
 #include "libiberty.h"
+#include "sha1.h"
 
 #include "elfcpp.h"
 #include "options.h"
@@ -36,6 +39,7 @@
 #include "target-select.h"
 #include "target.h"
 #include "fileread.h"
+#include "descriptors.h"
 #include "script.h"
 
 namespace gold {
@@ -43,7 +47,8 @@ namespace gold {
 // Version number for the .gnu_incremental_inputs section.
 // Version 1 was the initial checkin.
 // Version 2 adds some padding to ensure 8-byte alignment where necessary.
-const unsigned int INCREMENTAL_LINK_VERSION = 2;
+// Version 3 adds a SHA-1 digest of the contents of each relocatable object.
+const unsigned int INCREMENTAL_LINK_VERSION = 3;
 
 // This class manages the .gnu_incremental_inputs section, which holds
 // the header information, a directory of input files, and separate
@@ -155,6 +160,30 @@ explain_no_incremental(const char* format, ...)
   va_end(args);
 }
 
+// Store the SHA-1 digest of the contents of the unopened file
+// FILENAME in DIGEST.  Return false if the file can not be read.
+
+static bool
+get_content_hash(const char* filename, unsigned char* digest)
+{
+  int descriptor = open_descriptor(-1, filename, O_RDONLY);
+  if (descriptor < 0)
+    return false;
+
+  sha1_ctx ctx;
+  sha1_init_ctx(&ctx);
+  char buf[64 * 1024];
+  ssize_t got;
+  while ((got = ::read(descriptor, buf, sizeof buf)) > 0)
+    sha1_process_bytes(buf, got, &ctx);
+  release_descriptor(descriptor, true);
+  if (got < 0)
+    return false;
+
+  sha1_finish_ctx(&ctx, digest);
+  return true;
+}
+
 // Report an error.
 
 void
@@ -475,9 +504,10 @@ Sized_incremental_binary<size, big_endian>::do_check_inputs(
 template<int size, bool big_endian>
 bool
 Sized_incremental_binary<size, big_endian>::do_file_has_changed(
-    unsigned int n) const
+    unsigned int n)
 {
   Input_entry_reader input_file = this->inputs_reader_.input_file(n);
+  const unsigned int input_file_index = n;
   Incremental_disposition disp = INCREMENTAL_CHECK;
 
   // For files named in scripts, find the file that was actually named
@@ -511,12 +541,30 @@ Sized_incremental_binary<size, big_endian>::do_file_has_changed(
       return true;
     }
 
-  if (new_mtime.seconds > old_mtime.seconds)
-    return true;
-  if (new_mtime.seconds == old_mtime.seconds
-      && new_mtime.nanoseconds > old_mtime.nanoseconds)
-    return true;
-  return false;
+  if (new_mtime.seconds < old_mtime.seconds
+      || (new_mtime.seconds == old_mtime.seconds
+	  && new_mtime.nanoseconds <= old_mtime.nanoseconds))
+    return false;
+
+  // The file is newer than the last link.  A relocatable object which
+  // was rebuilt with the same contents need not be read again, so
+  // compare its contents with the digest recorded by that link.
+  if (input_file.type() == INCREMENTAL_INPUT_OBJECT)
+    {
+      const unsigned char* old_hash = input_file.get_content_hash();
+      unsigned char new_hash[INCREMENTAL_CONTENT_HASH_SIZE];
+      if (old_hash != NULL
+	  && get_content_hash(filename, new_hash)
+	  && memcmp(old_hash, new_hash, INCREMENTAL_CONTENT_HASH_SIZE) == 0)
+	{
+	  gold_debug(DEBUG_INCREMENTAL, "%s: contents unchanged", filename);
+	  // Record the new timestamp so that the next link need not
+	  // compute the digest again.
+	  this->unchanged_mtimes_[input_file_index] = new_mtime;
+	  return false;
+	}
+    }
+  return true;
 }
 
 // Initialize the layout of the output file based on the existing
@@ -1118,6 +1166,14 @@ Incremental_inputs::report_object(Object* obj, unsigned int arg_serial,
 	  gold_assert(arch_entry != NULL);
 	  arch_entry->add_object(this->current_object_entry_);
 	}
+      else
+	{
+	  // Record the contents of a standalone object, so that a
+	  // later update can tell whether a newer file really changed.
+	  unsigned char digest[INCREMENTAL_CONTENT_HASH_SIZE];
+	  obj->get_content_hash(digest);
+	  this->current_object_entry_->set_content_hash(digest);
+	}
     }
   else
     {
@@ -1576,8 +1632,9 @@ Output_section_incremental_inputs<size, big_endian>::write_info_blocks(
 	    Swap32::writeval(pov + 16, first_dynrel);
 	    Swap32::writeval(pov + 20, ndynrel);
 	    Swap32::writeval(pov + 24, ncomdat);
-	    Swap32::writeval(pov + 28, 0);
-	    gold_assert(this->object_info_size == 32);
+	    memcpy(pov + 28, entry->content_hash(),
+		   INCREMENTAL_CONTENT_HASH_SIZE);
+	    gold_assert(this->object_info_size == 48);
 	    pov += this->object_info_size;
 
 	    // Build a temporary array to map input section indexes
@@ -2018,6 +2075,20 @@ Sized_relobj_incr<size, big_endian>::Sized_relobj_incr(
   ibase->set_input_object(input_file_index, this);
 }
 
+// Return the SHA-1 digest recorded for the file by the last link.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_incr<size, big_endian>::do_get_content_hash(
+    unsigned char* digest)
+{
+  const unsigned char* p = this->input_reader_.get_content_hash();
+  if (p == NULL)
+    memset(digest, 0, INCREMENTAL_CONTENT_HASH_SIZE);
+  else
+    memcpy(digest, p, INCREMENTAL_CONTENT_HASH_SIZE);
+}
+
 // Read the symbols.
 
 template<int size, bool big_endian>
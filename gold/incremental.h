@@ -81,6 +81,19 @@ enum Incremental_shlib_symbol_flags
 
 static const int INCREMENTAL_SHLIB_SYM_FLAGS_SHIFT = 30;
 
+// The size of the SHA-1 digest of the contents of a relocatable
+// object, which is stored in its supplemental info block.  An
+// incremental update treats an object whose digest matches as
+// unchanged, and replays the reloc scan results (GOT and PLT entries,
+// copy relocs, dynamic relocs) recorded in the previous output instead
+// of reading its .rela sections.  The output file is the only cache of
+// these results.  They depend on how the whole link resolved the
+// global symbols, so they can't be keyed by the contents of one object,
+// and a normal link must read every .rela section anyway to apply the
+// relocations.
+
+static const unsigned int INCREMENTAL_CONTENT_HASH_SIZE = 20;
+
 // Return TRUE if a section of type SH_TYPE can be updated in place
 // during an incremental update.
 bool
@@ -354,7 +367,10 @@ class Incremental_object_entry : public Incremental_input_entry
 			   unsigned int arg_serial, Timespec mtime)
     : Incremental_input_entry(filename_key, arg_serial, mtime), obj_(obj),
       is_member_(false), sections_(), groups_()
-  { this->sections_.reserve(obj->shnum()); }
+  {
+    this->sections_.reserve(obj->shnum());
+    memset(this->content_hash_, 0, INCREMENTAL_CONTENT_HASH_SIZE);
+  }
 
   // Get the object.
   Object*
@@ -371,6 +387,17 @@ class Incremental_object_entry : public Incremental_input_entry
   is_member() const
   { return this->is_member_; }
 
+  // Record the SHA-1 digest of the contents of the object file.
+  void
+  set_content_hash(const unsigned char* digest)
+  { memcpy(this->content_hash_, digest, INCREMENTAL_CONTENT_HASH_SIZE); }
+
+  // Return the SHA-1 digest of the contents of the object file.  This
+  // is all zeroes if it was not recorded, as for archive members.
+  const unsigned char*
+  content_hash() const
+  { return this->content_hash_; }
+
   // Add an input section.
   void
   add_input_section(unsigned int shndx, Stringpool::Key name_key, off_t sh_size)
@@ -446,6 +473,9 @@ class Incremental_object_entry : public Incremental_input_entry
 
   // COMDAT groups.
   std::vector<Stringpool::Key> groups_;
+
+  // SHA-1 digest of the contents of the object file.
+  unsigned char content_hash_[INCREMENTAL_CONTENT_HASH_SIZE];
 };
 
 // Class for recording shared library input files.
@@ -764,8 +794,8 @@ class Incremental_inputs_reader
   static const unsigned int input_entry_size = 24;
   // Size of the first part of the supplemental info block for
   // relocatable objects and archive members.
-  // (7 x 4-byte fields, plus 4 bytes padding.)
-  static const unsigned int object_info_size = 32;
+  // (7 x 4-byte fields, plus a 20-byte SHA-1 digest.)
+  static const unsigned int object_info_size = 48;
   // Size of an input section entry.
   // (2 x 4-byte fields, 2 x address-sized fields.)
   static const unsigned int input_section_entry_size = 8 + 2 * size / 8;
@@ -955,6 +985,21 @@ class Incremental_inputs_reader
       return Swap32::readval(this->inputs_->p_ + this->info_offset_ + 24);
     }
 
+    // Return the SHA-1 digest of the contents of the file, or NULL if
+    // none was recorded -- for objects only.
+    const unsigned char*
+    get_content_hash() const
+    {
+      gold_assert(this->type() == INCREMENTAL_INPUT_OBJECT
+		  || this->type() == INCREMENTAL_INPUT_ARCHIVE_MEMBER);
+
+      const unsigned char* p = this->inputs_->p_ + this->info_offset_ + 28;
+      for (unsigned int i = 0; i < INCREMENTAL_CONTENT_HASH_SIZE; ++i)
+	if (p[i] != 0)
+	  return p;
+      return NULL;
+    }
+
     // Return the object count -- for scripts only.
     unsigned int
     get_object_count() const
@@ -1431,7 +1476,7 @@ class Incremental_binary
 
   // Return TRUE if the input file N has changed since the last link.
   bool
-  file_has_changed(unsigned int n) const
+  file_has_changed(unsigned int n)
   { return this->do_file_has_changed(n); }
 
   // Return the Input_argument for input file N.  Returns NULL if
@@ -1544,7 +1589,7 @@ class Incremental_binary
 
   // Return TRUE if input file N has changed since the last incremental link.
   virtual bool
-  do_file_has_changed(unsigned int n) const = 0;
+  do_file_has_changed(unsigned int n) = 0;
 
   // Initialize the layout of the output file based on the existing
   // output file.
@@ -1599,7 +1644,7 @@ class Sized_incremental_binary : public Incremental_binary
       input_objects_(), section_map_(), symbol_map_(), copy_relocs_(),
       main_symtab_loc_(), main_strtab_loc_(), has_incremental_info_(false),
       inputs_reader_(), symtab_reader_(), relocs_reader_(), got_plt_reader_(),
-      input_entry_readers_()
+      input_entry_readers_(), unchanged_mtimes_()
   { this->setup_readers(); }
 
   // Returns TRUE if the file contains incremental info.
@@ -1621,6 +1666,18 @@ class Sized_incremental_binary : public Incremental_binary
     return this->input_objects_[n];
   }
 
+  // Return the modification time to record for input file N.  This
+  // is the current time of a file whose timestamp changed but whose
+  // contents did not, and the time recorded by the last link otherwise.
+  Timespec
+  input_file_mtime(unsigned int n) const
+  {
+    typename Mtime_map::const_iterator p = this->unchanged_mtimes_.find(n);
+    if (p != this->unchanged_mtimes_.end())
+      return p->second;
+    return this->inputs_reader_.input_file(n).get_mtime();
+  }
+
   // Return the Output_section for section index SHNDX.
   Output_section*
   output_section(unsigned int shndx)
@@ -1678,7 +1735,7 @@ class Sized_incremental_binary : public Incremental_binary
 
   // Return TRUE if input file N has changed since the last incremental link.
   virtual bool
-  do_file_has_changed(unsigned int n) const;
+  do_file_has_changed(unsigned int n);
 
   // Initialize the layout of the output file based on the existing
   // output file.
@@ -1775,6 +1832,9 @@ class Sized_incremental_binary : public Incremental_binary
   };
   typedef std::vector<Copy_reloc> Copy_relocs;
 
+  // Map from an input file index to its current modification time.
+  typedef std::map<unsigned int, Timespec> Mtime_map;
+
   bool
   find_incremental_inputs_sections(unsigned int* p_inputs_shndx,
 				   unsigned int* p_symtab_shndx,
@@ -1812,6 +1872,9 @@ class Sized_incremental_binary : public Incremental_binary
   Incremental_relocs_reader<size, big_endian> relocs_reader_;
   Incremental_got_plt_reader<big_endian> got_plt_reader_;
   std::vector<Sized_input_reader> input_entry_readers_;
+
+  // Current modification times of the files found unchanged by digest.
+  Mtime_map unchanged_mtimes_;
 };
 
 // An incremental Relobj.  This class represents a relocatable object
@@ -1874,7 +1937,11 @@ class Sized_relobj_incr : public Sized_relobj<size, big_endian>
   // Return the last modified time of the file.
   Timespec
   do_get_mtime()
-  { return this->input_reader_.get_mtime(); }
+  { return this->ibase_->input_file_mtime(this->input_file_index_); }
+
+  // Return the SHA-1 digest recorded for the file.
+  void
+  do_get_content_hash(unsigned char* digest);
 
   // Read the symbols.
   void
@@ -239,17 +239,111 @@ Free_list::print_stats()
 	  program_name, Free_list::num_allocate_visits);
 }
 
-// A Hash_task computes the MD5 checksum of an array of char.
+// Compute the 128-bit hash used by --build-id=fast of the LEN bytes
+// at BUFFER, and store it at RESBLOCK.  This is MurmurHash3_x64_128
+// with a seed of zero.  It is not a cryptographic hash, but it is
+// several times faster than MD5, and it is good enough to tell
+// different link outputs apart.  The bytes are read as little endian
+// values and the result is stored as two little endian values, so the
+// hash does not depend on the host.  The signature is that of
+// md5_buffer, so that Hash_task may use either.
+
+static void*
+fast_hash_buffer(const char* buffer, size_t len, void* resblock)
+{
+  const uint64_t c1 = 0x87c37b91114253d5ULL;
+  const uint64_t c2 = 0x4cf5ad432745937fULL;
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(buffer);
+  const unsigned char* pend = p + (len & ~static_cast<size_t>(15));
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+
+#define ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+  for (; p < pend; p += 16)
+    {
+      uint64_t k1 = elfcpp::Swap_unaligned<64, false>::readval(p);
+      uint64_t k2 = elfcpp::Swap_unaligned<64, false>::readval(p + 8);
+
+      k1 *= c1;
+      k1 = ROTL64(k1, 31);
+      k1 *= c2;
+      h1 ^= k1;
+      h1 = ROTL64(h1, 27);
+      h1 += h2;
+      h1 = h1 * 5 + 0x52dce729;
+
+      k2 *= c2;
+      k2 = ROTL64(k2, 33);
+      k2 *= c1;
+      h2 ^= k2;
+      h2 = ROTL64(h2, 31);
+      h2 += h1;
+      h2 = h2 * 5 + 0x38495ab5;
+    }
+
+  // Mixing in the zero padding of the tail is the same as leaving it
+  // out, so pad the tail to a full block.
+  if ((len & 15) != 0)
+    {
+      unsigned char tail[16];
+      memset(tail, 0, sizeof tail);
+      memcpy(tail, pend, len & 15);
+      uint64_t k1 = elfcpp::Swap_unaligned<64, false>::readval(tail);
+      uint64_t k2 = elfcpp::Swap_unaligned<64, false>::readval(tail + 8);
+
+      k2 *= c2;
+      k2 = ROTL64(k2, 33);
+      k2 *= c1;
+      h2 ^= k2;
+
+      k1 *= c1;
+      k1 = ROTL64(k1, 31);
+      k1 *= c2;
+      h1 ^= k1;
+    }
+
+#undef ROTL64
+
+  h1 ^= len;
+  h2 ^= len;
+  h1 += h2;
+  h2 += h1;
+  uint64_t* h[2] = { &h1, &h2 };
+  for (int i = 0; i < 2; ++i)
+    {
+      uint64_t k = *h[i];
+      k ^= k >> 33;
+      k *= 0xff51afd7ed558ccdULL;
+      k ^= k >> 33;
+      k *= 0xc4ceb9fe1a85ec53ULL;
+      k ^= k >> 33;
+      *h[i] = k;
+    }
+  h1 += h2;
+  h2 += h1;
+
+  unsigned char* res = static_cast<unsigned char*>(resblock);
+  elfcpp::Swap_unaligned<64, false>::writeval(res, h1);
+  elfcpp::Swap_unaligned<64, false>::writeval(res + 8, h2);
+  return resblock;
+}
+
+// A Hash_task computes a 16 byte checksum of an array of char, using
+// MD5 for --build-id=tree and fast_hash_buffer for --build-id=fast.
 
 class Hash_task : public Task
 {
  public:
+  typedef void* (*Hash_function)(const char*, size_t, void*);
+
   Hash_task(Output_file* of,
 	    size_t offset,
 	    size_t size,
 	    unsigned char* dst,
+	    Hash_function hash,
 	    Task_token* final_blocker)
-    : of_(of), offset_(offset), size_(size), dst_(dst),
+    : of_(of), offset_(offset), size_(size), dst_(dst), hash_(hash),
       final_blocker_(final_blocker)
   { }
 
@@ -258,7 +352,7 @@ class Hash_task : public Task
   {
     const unsigned char* iv =
 	this->of_->get_input_view(this->offset_, this->size_);
-    md5_buffer(reinterpret_cast<const char*>(iv), this->size_, this->dst_);
+    this->hash_(reinterpret_cast<const char*>(iv), this->size_, this->dst_);
     this->of_->free_input_view(this->offset_, this->size_, iv);
   }
 
@@ -280,6 +374,7 @@ class Hash_task : public Task
   const size_t offset_;
   const size_t size_;
   unsigned char* const dst_;
+  const Hash_function hash_;
   Task_token* const final_blocker_;
 };
 
@@ -359,6 +454,17 @@ Layout::Relaxation_debug_check::verify_sections(
     }
 }
 
+// Prefinalize_sections_task_runner methods.
+
+// Queue the tasks which sort the input sections and set their
+// offsets.
+
+void
+Prefinalize_sections_task_runner::run(Workqueue* workqueue, const Task*)
+{
+  this->layout_->queue_prefinalize_tasks(workqueue, this->final_blocker_);
+}
+
 // Layout_task_runner methods.
 
 // Lay out the sections.  This is called after all the input objects
@@ -473,6 +579,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     section_segment_map_(),
     input_section_position_(),
     input_section_glob_(),
+    input_section_glob_set_(FNM_NOESCAPE),
     incremental_base_(NULL),
     free_list_(),
     gnu_properties_()
@@ -1621,8 +1728,9 @@ Layout::remove_eh_frame_for_plt(Output_data* plt, const unsigned char* cie_data,
 					       fde_data, fde_length);
 }
 
-// Scan a .debug_info or .debug_types section, and add summary
-// information to the .gdb_index section.
+// Record a .debug_info or .debug_types section, to be scanned for
+// the .gdb_index section by the tasks queued by
+// queue_gdb_index_tasks.
 
 template<int size, bool big_endian>
 void
@@ -1648,9 +1756,19 @@ Layout::add_to_gdb_index(bool is_type_unit,
       os->set_after_input_sections();
     }
 
-  this->gdb_index_data_->scan_debug_info(is_type_unit, object, symbols,
-					 symbols_size, shndx, reloc_shndx,
-					 reloc_type);
+  this->gdb_index_data_->add_debug_info(is_type_unit, object, symbols,
+					symbols_size, shndx, reloc_shndx,
+					reloc_type);
+}
+
+// Queue the tasks which scan the debug information for the
+// .gdb_index section.
+
+void
+Layout::queue_gdb_index_tasks(Workqueue* workqueue, Task_token* final_blocker)
+{
+  if (this->gdb_index_data_ != NULL)
+    this->gdb_index_data_->queue_scan_tasks(workqueue, final_blocker);
 }
 
 // Add POSD to an output section using NAME, TYPE, and FLAGS.  Return
@@ -2891,18 +3009,14 @@ Layout::find_section_order_index(const std::string& section_name)
   if (map_it != this->input_section_position_.end())
     return map_it->second;
 
-  // Absolute match failed.  Linear search the glob patterns.
-  std::vector<std::string>::iterator it;
-  for (it = this->input_section_glob_.begin();
-       it != this->input_section_glob_.end();
-       ++it)
+  // Absolute match failed.  Find the first glob pattern which matches.
+  unsigned int i;
+  if (this->input_section_glob_set_.find_first(section_name.c_str(), 0, &i))
     {
-       if (fnmatch((*it).c_str(), section_name.c_str(), FNM_NOESCAPE) == 0)
-	 {
-	   map_it = this->input_section_position_.find(*it);
-	   gold_assert(map_it != this->input_section_position_.end());
-	   return map_it->second;
-	 }
+      const std::string& pattern(this->input_section_glob_[i]);
+      map_it = this->input_section_position_.find(pattern);
+      gold_assert(map_it != this->input_section_position_.end());
+      return map_it->second;
     }
   return 0;
 }
@@ -2939,7 +3053,11 @@ Layout::read_layout_from_file()
       this->input_section_position_[line] = position;
       // Store all glob patterns in a vector.
       if (is_wildcard_string(line.c_str()))
-	this->input_section_glob_.push_back(line);
+	{
+	  this->input_section_glob_set_.add(line.c_str(), line.length(),
+					    this->input_section_glob_.size());
+	  this->input_section_glob_.push_back(line);
+	}
       position++;
       std::getline(in, line);
     }
@@ -3418,7 +3536,7 @@ Layout::create_build_id()
   // set DESC to the note descriptor contents.
   size_t descsz;
   std::string desc;
-  if (strcmp(style, "md5") == 0)
+  if (strcmp(style, "md5") == 0 || strcmp(style, "fast") == 0)
     descsz = 128 / 8;
   else if ((strcmp(style, "sha1") == 0) || (strcmp(style, "tree") == 0))
     descsz = 160 / 8;
@@ -4634,9 +4752,17 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
   unsigned int local_symcount = index;
   unsigned int forced_local_count = 0;
 
+  // The GNU dynamic linker only accepts a SHT_RELR section in an
+  // object which depends on the GLIBC_ABI_DT_RELR version of libc.
+  // This must be recorded before set_dynsym_indexes finalizes the
+  // versions.
+  if (parameters->options().pack_relative_relocs())
+    this->add_relr_version_need(input_objects, pversions);
+
+  std::vector<uint32_t> dynsym_hash_codes;
   index = symtab->set_dynsym_indexes(index, &forced_local_count,
-				     pdynamic_symbols, &this->dynpool_,
-				     pversions);
+				     pdynamic_symbols, &dynsym_hash_codes,
+				     &this->dynpool_, pversions);
 
   *plocal_dynamic_count = local_symcount;
   *pforced_local_dynamic_count = forced_local_count;
@@ -4756,11 +4882,9 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
   if (strcmp(parameters->options().hash_style(), "gnu") == 0
       || strcmp(parameters->options().hash_style(), "both") == 0)
     {
-      unsigned char* phash;
-      unsigned int hashlen;
-      Dynobj::create_gnu_hash_table(*pdynamic_symbols,
-				    local_symcount + forced_local_count,
-				    &phash, &hashlen);
+      Output_section_data* hashdata =
+	Dynobj::create_gnu_hash_table(*pdynamic_symbols, dynsym_hash_codes,
+				      local_symcount + forced_local_count);
 
       Output_section* hashsec =
 	this->choose_output_section(NULL, ".gnu.hash", elfcpp::SHT_GNU_HASH,
@@ -4768,10 +4892,6 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
 				    ORDER_DYNAMIC_LINKER, false, false,
 				    false);
 
-      Output_section_data* hashdata = new Output_data_const_buffer(phash,
-								   hashlen,
-								   align,
-								   "** hash");
       if (hashsec != NULL && hashdata != NULL)
 	hashsec->add_output_section_data(hashdata);
 
@@ -4794,11 +4914,9 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
   if (strcmp(parameters->options().hash_style(), "sysv") == 0
       || strcmp(parameters->options().hash_style(), "both") == 0)
     {
-      unsigned char* phash;
-      unsigned int hashlen;
-      Dynobj::create_elf_hash_table(*pdynamic_symbols,
-				    local_symcount + forced_local_count,
-				    &phash, &hashlen);
+      Output_section_data* hashdata =
+	Dynobj::create_elf_hash_table(*pdynamic_symbols,
+				      local_symcount + forced_local_count);
 
       Output_section* hashsec =
 	this->choose_output_section(NULL, ".hash", elfcpp::SHT_HASH,
@@ -4806,10 +4924,6 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
 				    ORDER_DYNAMIC_LINKER, false, false,
 				    false);
 
-      Output_section_data* hashdata = new Output_data_const_buffer(phash,
-								   hashlen,
-								   align,
-								   "** hash");
       if (hashsec != NULL && hashdata != NULL)
 	hashsec->add_output_section_data(hashdata);
 
@@ -5003,6 +5117,41 @@ Layout::sized_create_version_sections(
     }
 }
 
+// If there is a SHT_RELR section, add a reference to the
+// GLIBC_ABI_DT_RELR version of libc to VERSIONS.
+
+void
+Layout::add_relr_version_need(const Input_objects* input_objects,
+			      Versions* versions)
+{
+  bool any_relr = false;
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    {
+      if ((*p)->type() == elfcpp::SHT_RELR)
+	{
+	  any_relr = true;
+	  break;
+	}
+    }
+  if (!any_relr)
+    return;
+
+  for (Input_objects::Dynobj_iterator p = input_objects->dynobj_begin();
+       p != input_objects->dynobj_end();
+       ++p)
+    {
+      if ((*p)->as_needed() && !(*p)->is_needed())
+	continue;
+      if (strncmp((*p)->soname(), "libc.so.", 8) == 0)
+	{
+	  versions->record_need(&this->dynpool_, *p, "GLIBC_ABI_DT_RELR");
+	  return;
+	}
+    }
+}
+
 // Create the .interp section and PT_INTERP segment.
 
 void
@@ -5876,11 +6025,22 @@ Layout::write_build_id(Output_file* of, unsigned char* array_of_hashes,
 	sha1_buffer(reinterpret_cast<const char*>(iv), output_file_size, ov);
       else if (strcmp(style, "md5") == 0)
 	md5_buffer(reinterpret_cast<const char*>(iv), output_file_size, ov);
+      else if (strcmp(style, "fast") == 0)
+	fast_hash_buffer(reinterpret_cast<const char*>(iv), output_file_size,
+			 ov);
       else
 	gold_unreachable();
 
       of->free_input_view(0, output_file_size, iv);
     }
+  else if (strcmp(parameters->options().build_id(), "fast") == 0)
+    {
+      // Non-overlapping substrings of the output file have been hashed.
+      // Hash the hashes the same way.
+      fast_hash_buffer(reinterpret_cast<const char*>(array_of_hashes),
+		       size_of_hashes, ov);
+      delete[] array_of_hashes;
+    }
   else
     {
       // Non-overlapping substrings of the output file have been hashed.
@@ -5974,6 +6134,231 @@ Layout::print_stats() const
     (*p)->print_merge_stats();
 }
 
+// Queue tasks to merge the contents of merge sections in parallel.
+
+void
+Layout::queue_merge_tasks(Workqueue* workqueue, Task_token* final_blocker)
+{
+  for (Section_list::iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    (*p)->queue_merge_tasks(workqueue, final_blocker);
+}
+
+// This task reads the names of some of the input sections of one
+// object, for Layout::queue_prefinalize_tasks.
+
+class Read_section_names_task : public Task
+{
+ public:
+  typedef std::vector<std::pair<unsigned int, std::string*> > Requests;
+
+  Read_section_names_task(Relobj* object, const Requests* requests,
+			  Task_token* blocker)
+    : object_(object), requests_(requests), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->object_->is_locked())
+      return this->object_->token();
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->object_->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    for (Requests::const_iterator p = this->requests_->begin();
+	 p != this->requests_->end();
+	 ++p)
+      *p->second = this->object_->section_name(p->first);
+    this->object_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Read_section_names_task " + this->object_->name(); }
+
+ private:
+  Relobj* object_;
+  const Requests* requests_;
+  Task_token* blocker_;
+};
+
+// This task sorts the input sections of one output section and sets
+// their offsets.
+
+class Prefinalize_section_task : public Task
+{
+ public:
+  Prefinalize_section_task(Output_section* os, Task_token* final_blocker)
+    : os_(os), final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->os_->prefinalize_input_sections(); }
+
+  std::string
+  get_name() const
+  { return std::string("Prefinalize_section_task ") + this->os_->name(); }
+
+ private:
+  Output_section* os_;
+  Task_token* final_blocker_;
+};
+
+// This task runs once the names of the input sections have been read,
+// and queues a Prefinalize_section_task for each output section.
+
+class Prefinalize_sections_task : public Task
+{
+ public:
+  Prefinalize_sections_task(std::vector<Output_section*>* sections,
+			    Output_section::Section_name_requests* requests,
+			    Task_token* names_blocker,
+			    Task_token* final_blocker)
+    : sections_(sections), requests_(requests),
+      names_blocker_(names_blocker), final_blocker_(final_blocker)
+  { }
+
+  ~Prefinalize_sections_task()
+  {
+    delete this->sections_;
+    delete this->requests_;
+    delete this->names_blocker_;
+  }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->names_blocker_->is_blocked())
+      return this->names_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue* workqueue)
+  {
+    // We hold FINAL_BLOCKER_ until we return, so nothing else can
+    // release it while we add the blockers for the new tasks.
+    this->final_blocker_->add_blockers(this->sections_->size());
+    for (std::vector<Output_section*>::const_iterator p =
+	   this->sections_->begin();
+	 p != this->sections_->end();
+	 ++p)
+      workqueue->queue(new Prefinalize_section_task(*p,
+						    this->final_blocker_));
+  }
+
+  std::string
+  get_name() const
+  { return "Prefinalize_sections_task"; }
+
+ private:
+  std::vector<Output_section*>* sections_;
+  Output_section::Section_name_requests* requests_;
+  Task_token* names_blocker_;
+  Task_token* final_blocker_;
+};
+
+// Queue tasks to sort the input sections of each output section and
+// set their offsets, which is otherwise done one output section after
+// another by set_final_data_size during finalize.  Sorting by name
+// needs the names of the input sections, which are read first, one
+// task per object.  A linker script may move input sections from one
+// output section to another, and relaxation may replace them, so we
+// leave those cases to finalize.
+
+void
+Layout::queue_prefinalize_tasks(Workqueue* workqueue,
+				Task_token* final_blocker)
+{
+  std::vector<Output_section*>* sections = new std::vector<Output_section*>;
+  Output_section::Section_name_requests* requests =
+    new Output_section::Section_name_requests;
+
+  if (!this->script_options_->saw_sections_clause()
+      && !parameters->target().may_relax()
+      && !parameters->incremental())
+    {
+      for (Section_list::iterator p = this->section_list_.begin();
+	   p != this->section_list_.end();
+	   ++p)
+	if ((*p)->prepare_to_prefinalize(requests))
+	  sections->push_back(*p);
+    }
+
+  Task_token* names_blocker = new Task_token(true);
+  for (Output_section::Section_name_requests::const_iterator p =
+	 requests->begin();
+       p != requests->end();
+       ++p)
+    {
+      names_blocker->add_blocker();
+      workqueue->queue(new Read_section_names_task(p->first, &p->second,
+						   names_blocker));
+    }
+
+  workqueue->queue(new Prefinalize_sections_task(sections, requests,
+						 names_blocker,
+						 final_blocker));
+}
+
+// Queue tasks to compress the contents of compressed sections in
+// parallel.
+
+void
+Layout::queue_compress_tasks(Workqueue* workqueue, Task_token* final_blocker)
+{
+  for (Section_list::iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    if ((*p)->requires_postprocessing())
+      (*p)->queue_compress_tasks(workqueue, final_blocker);
+}
+
+// Queue tasks to write the contents of output sections in parallel.
+
+void
+Layout::queue_write_tasks(Workqueue* workqueue, Output_file* of,
+			  Task_token* final_blocker)
+{
+  for (Section_list::iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    if (!(*p)->requires_postprocessing())
+      (*p)->queue_write_tasks(workqueue, of, final_blocker);
+}
+
 // Write_sections_task methods.
 
 // We can always run this task.
@@ -6086,9 +6471,27 @@ Write_after_input_sections_task::run(Workqueue*)
   this->layout_->write_sections_after_input_sections(this->of_);
 }
 
+// Compress_sections_task_runner methods.
+
+// Queue the tasks to compress the sections, and then the task to
+// write the sections after the input sections, which will size the
+// compressed sections from the compressed chunks.
+
+void
+Compress_sections_task_runner::run(Workqueue* workqueue, const Task*)
+{
+  Task_token* compress_blocker = new Task_token(true);
+  this->layout_->queue_compress_tasks(workqueue, compress_blocker);
+  workqueue->queue(new Write_after_input_sections_task(this->layout_,
+						       this->of_,
+						       compress_blocker,
+						       this->final_blocker_));
+}
+
 // Build IDs can be computed as a "flat" sha1 or md5 of a string of bytes,
 // or as a "tree" where each chunk of the string is hashed and then those
 // hashes are put into a (much smaller) string which is hashed with sha1.
+// A "fast" build ID is a tree of 128-bit fast_hash_buffer hashes.
 // We compute a checksum over the entire file because that is simplest.
 
 void
@@ -6102,27 +6505,37 @@ Build_id_task_runner::run(Workqueue* workqueue, const Task*)
   unsigned char* array_of_hashes = NULL;
   size_t size_of_hashes = 0;
 
-  if (strcmp(this->options_->build_id(), "tree") == 0
+  // --build-id=fast always hashes the file in chunks; there is no
+  // compatibility with a flat hash to preserve for small files.
+  const bool is_fast = strcmp(this->options_->build_id(), "fast") == 0;
+  if ((is_fast || strcmp(this->options_->build_id(), "tree") == 0)
       && this->options_->build_id_chunk_size_for_treehash() > 0
       && filesize > 0
-      && (filesize >= this->options_->build_id_min_file_size_for_treehash()))
+      && (is_fast
+	  || (filesize
+	      >= this->options_->build_id_min_file_size_for_treehash())))
     {
-      static const size_t MD5_OUTPUT_SIZE_IN_BYTES = 16;
+      // Both MD5 and fast_hash_buffer produce 16 bytes.
+      static const size_t HASH_OUTPUT_SIZE_IN_BYTES = 16;
       const size_t chunk_size =
 	  this->options_->build_id_chunk_size_for_treehash();
       const size_t num_hashes = ((filesize - 1) / chunk_size) + 1;
+      Hash_task::Hash_function hash = (is_fast
+				       ? fast_hash_buffer
+				       : md5_buffer);
       post_hash_tasks_blocker->add_blockers(num_hashes);
-      size_of_hashes = num_hashes * MD5_OUTPUT_SIZE_IN_BYTES;
+      size_of_hashes = num_hashes * HASH_OUTPUT_SIZE_IN_BYTES;
       array_of_hashes = new unsigned char[size_of_hashes];
       unsigned char *dst = array_of_hashes;
       for (size_t i = 0, src_offset = 0; i < num_hashes;
-	   i++, dst += MD5_OUTPUT_SIZE_IN_BYTES, src_offset += chunk_size)
+	   i++, dst += HASH_OUTPUT_SIZE_IN_BYTES, src_offset += chunk_size)
 	{
 	  size_t size = std::min(chunk_size, filesize - src_offset);
 	  workqueue->queue(new Hash_task(of,
 					 src_offset,
 					 size,
 					 dst,
+					 hash,
 					 post_hash_tasks_blocker));
 	}
     }
@@ -35,6 +35,7 @@
 #include "object.h"
 #include "dynobj.h"
 #include "stringpool.h"
+#include "glob-set.h"
 
 namespace gold
 {
@@ -163,6 +164,26 @@ class Free_list
   static unsigned int num_allocate_visits;
 };
 
+// This task function queues the tasks which sort the input sections
+// and set their offsets before Layout_task_runner runs, once the
+// relocations have been scanned.  See Layout::queue_prefinalize_tasks.
+
+class Prefinalize_sections_task_runner : public Task_function_runner
+{
+ public:
+  Prefinalize_sections_task_runner(Layout* layout, Task_token* final_blocker)
+    : layout_(layout), final_blocker_(final_blocker)
+  { }
+
+  // Run the operation.
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  Layout* layout_;
+  Task_token* final_blocker_;
+};
+
 // This task function handles mapping the input sections to output
 // sections and laying them out in memory.
 
@@ -673,8 +694,9 @@ class Layout
 			  size_t cie_length, const unsigned char* fde_data,
 			  size_t fde_length);
 
-  // Scan a .debug_info or .debug_types section, and add summary
-  // information to the .gdb_index section.
+  // Record a .debug_info or .debug_types section, to be scanned for
+  // the .gdb_index section by the tasks queued by
+  // queue_gdb_index_tasks.
   template<int size, bool big_endian>
   void
   add_to_gdb_index(bool is_type_unit,
@@ -961,6 +983,35 @@ class Layout
   void
   print_stats() const;
 
+  // Queue tasks to merge the contents of merge sections in parallel.
+  // The tasks hold blockers on FINAL_BLOCKER.
+  void
+  queue_merge_tasks(Workqueue*, Task_token* final_blocker);
+
+  // Queue tasks to compress the contents of compressed sections in
+  // parallel.  The tasks hold blockers on FINAL_BLOCKER.
+  void
+  queue_compress_tasks(Workqueue*, Task_token* final_blocker);
+
+  // Queue tasks to write the contents of output sections in
+  // parallel, where the contents support it.  This must be called
+  // before the tasks which write the output sections are queued.
+  // The tasks hold blockers on FINAL_BLOCKER.
+  void
+  queue_write_tasks(Workqueue*, Output_file*, Task_token* final_blocker);
+
+  // Queue tasks to scan the debug information for the .gdb_index
+  // section.  The tasks hold blockers on FINAL_BLOCKER.
+  void
+  queue_gdb_index_tasks(Workqueue*, Task_token* final_blocker);
+
+  // Queue tasks to sort the input sections of the output sections
+  // and set their offsets in parallel, ahead of finalize.  The last
+  // of the tasks releases FINAL_BLOCKER, which must already have a
+  // blocker added for it.
+  void
+  queue_prefinalize_tasks(Workqueue*, Task_token* final_blocker);
+
   // A list of segments.
 
   typedef std::vector<Output_segment*> Segment_list;
@@ -1137,6 +1188,11 @@ class Layout
 			std::vector<Symbol*>* pdynamic_symbols,
 			Versions* versions);
 
+  // Add a reference to the GLIBC_ABI_DT_RELR version of libc if
+  // there is a SHT_RELR section.
+  void
+  add_relr_version_need(const Input_objects*, Versions*);
+
   // Assign offsets to each local portion of the dynamic symbol table.
   void
   assign_local_dynsym_offsets(const Input_objects*);
@@ -1500,6 +1556,9 @@ class Layout
   Unordered_map<std::string, unsigned int> input_section_position_;
   // Vector of glob only patterns in the section_ordering file.
   std::vector<std::string> input_section_glob_;
+  // The same patterns, identified by their index in
+  // input_section_glob_.
+  Glob_set input_section_glob_set_;
   // For incremental links, the base file to be modified.
   Incremental_binary* incremental_base_;
   // For incremental links, a list of free space within the file.
@@ -1660,8 +1719,32 @@ class Write_after_input_sections_task : public Task
   Task_token* final_blocker_;
 };
 
+// This task function handles compression of the output sections
+// which are compressed, such as the debug sections with
+// --compress-debug-sections.  It schedules a task for each chunk of
+// those sections, and then Write_after_input_sections_task.  This
+// task cannot run until all the input sections have been written.
+
+class Compress_sections_task_runner : public Task_function_runner
+{
+ public:
+  Compress_sections_task_runner(Layout* layout, Output_file* of,
+				Task_token* final_blocker)
+    : layout_(layout), of_(of), final_blocker_(final_blocker)
+  { }
+
+  // Run the operation.
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  Layout* layout_;
+  Output_file* of_;
+  Task_token* final_blocker_;
+};
+
 // This task function handles computation of the build id.
-// When using --build-id=tree, it schedules the tasks that
+// When using --build-id=tree or fast, it schedules the tasks that
 // compute the hashes for each chunk of the file. This task
 // cannot run until we have finalized the size of the output
 // file, after the completion of Write_after_input_sections_task.
@@ -304,6 +304,7 @@ main(int argc, char** argv)
       layout.print_stats();
       Gdb_index::print_stats();
       Free_list::print_stats();
+      workqueue.print_stats();
     }
 
   // Issue defined symbol report.
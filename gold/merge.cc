@@ -25,6 +25,8 @@
 #include <cstdlib>
 #include <algorithm>
 
+#include "parameters.h"
+#include "options.h"
 #include "merge.h"
 #include "compressed_output.h"
 
@@ -489,6 +491,17 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
     ++count;
   merged_strings.reserve(count + 1);
 
+  // When merging in parallel, keep a copy of the contents for the
+  // merge tasks, and leave the strings out of the Stringpool for now.
+  Pending_section* pending_section = NULL;
+  if (this->merge_in_parallel(sec_len))
+    {
+      Char_type* contents = new Char_type[sec_len / sizeof(Char_type)];
+      memcpy(contents, pdata, sec_len);
+      pending_section = new Pending_section(merged_strings_list, contents);
+      this->pending_sections_.push_back(pending_section);
+    }
+
   // The index I is in bytes, not characters.
   section_size_type i = 0;
 
@@ -509,8 +522,9 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 	      != init_align_modulo))
 	  has_misaligned_strings = true;
 
-      Stringpool::Key key;
-      this->stringpool_.add_with_length(p, len, true, &key);
+      Stringpool::Key key = 0;
+      if (pending_section == NULL)
+	this->stringpool_.add_with_length(p, len, true, &key);
 
       merged_strings.push_back(Merged_string(i, key));
       p += len + 1;
@@ -540,6 +554,282 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   return true;
 }
 
+// Return whether to merge the strings of a new input section of
+// SEC_LEN bytes in parallel.  We can't do that if we keep the input
+// sections, since script processing and relaxation may add them again
+// later.  The sections are only copied for the merge tasks once there
+// is enough input to queue them; the strings of the earlier sections
+// go into the Stringpool right away, which keeps them in input order.
+
+template<typename Char_type>
+bool
+Output_merge_string<Char_type>::merge_in_parallel(
+    section_size_type sec_len) const
+{
+  return (parameters->options().threads()
+	  && !this->keeps_input_sections()
+	  && (!this->pending_sections_.empty()
+	      || this->input_size_ + sec_len >= min_parallel_size));
+}
+
+// A task to hash the strings of a group of input sections of an
+// Output_merge_string, and sort them by shard.
+
+template<typename Char_type>
+class Hash_merged_strings_task : public Task
+{
+ public:
+  Hash_merged_strings_task(Output_merge_string<Char_type>* pomb,
+			   unsigned int group, Task_token* blocker)
+    : pomb_(pomb), group_(group), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->pomb_->hash_strings(this->group_); }
+
+  std::string
+  get_name() const
+  { return "Hash_merged_strings_task"; }
+
+ private:
+  Output_merge_string<Char_type>* pomb_;
+  unsigned int group_;
+  Task_token* blocker_;
+};
+
+// A task to find the distinct strings in one shard of an
+// Output_merge_string.  This runs after all the strings have been
+// hashed.
+
+template<typename Char_type>
+class Merge_strings_task : public Task
+{
+ public:
+  Merge_strings_task(Output_merge_string<Char_type>* pomb,
+		     unsigned int shard, Task_token* hash_blocker,
+		     Task_token* final_blocker)
+    : pomb_(pomb), shard_(shard), hash_blocker_(hash_blocker),
+      final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->hash_blocker_->is_blocked())
+      return this->hash_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->pomb_->merge_shard(this->shard_); }
+
+  std::string
+  get_name() const
+  { return "Merge_strings_task"; }
+
+ private:
+  Output_merge_string<Char_type>* pomb_;
+  unsigned int shard_;
+  Task_token* hash_blocker_;
+  Task_token* final_blocker_;
+};
+
+// Queue the tasks which merge the strings of the pending sections.
+// The sections are split into groups of about the same size, each of
+// which is hashed by one task.  Then one task per shard finds the
+// distinct strings in that shard.  The strings are added to the
+// Stringpool in finalize_merged_data.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::do_queue_merge_tasks(Workqueue* workqueue,
+						     Task_token* final_blocker)
+{
+  // The sections are only pending once the input is large enough.
+  if (this->pending_sections_.empty() || !this->hash_groups_.empty())
+    return;
+  gold_assert(this->input_size_ >= min_parallel_size);
+
+  unsigned int count = this->pending_sections_.size();
+  size_t group_size = this->input_size_ / merge_shard_count + 1;
+  unsigned int first = 0;
+  size_t size = 0;
+  for (unsigned int i = 0; i < count; ++i)
+    {
+      Pending_section* ps = this->pending_sections_[i];
+      size += ps->merged_strings_list->merged_strings.back().offset;
+      if (size >= group_size || i + 1 == count)
+	{
+	  this->hash_groups_.push_back(Hash_group(first, i + 1));
+	  first = i + 1;
+	  size = 0;
+	}
+    }
+  this->hashed_section_count_ = count;
+
+  this->hash_blocker_ = new Task_token(true);
+  for (size_t i = 0; i < this->hash_groups_.size(); ++i)
+    this->hash_blocker_->add_blocker();
+
+  for (size_t i = 0; i < this->hash_groups_.size(); ++i)
+    workqueue->queue(new Hash_merged_strings_task<Char_type>(this, i,
+							     this->hash_blocker_));
+  for (unsigned int i = 0; i < merge_shard_count; ++i)
+    {
+      workqueue->add_blocker(final_blocker);
+      workqueue->queue(new Merge_strings_task<Char_type>(this, i,
+							 this->hash_blocker_,
+							 final_blocker));
+    }
+}
+
+// Hash the strings in the pending sections of hash group GROUP.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::hash_strings(unsigned int group)
+{
+  Hash_group& hg(this->hash_groups_[group]);
+  for (unsigned int i = hg.first; i < hg.last; ++i)
+    {
+      Pending_section* ps = this->pending_sections_[i];
+      const Merged_strings& merged_strings(
+	  ps->merged_strings_list->merged_strings);
+      size_t count = merged_strings.size() - 1;
+      ps->hash_codes.resize(count);
+      for (size_t j = 0; j < count; ++j)
+	{
+	  const Merged_string& ms(merged_strings[j]);
+	  const Char_type* p = ps->contents + ms.offset / sizeof(Char_type);
+	  size_t len = ((merged_strings[j + 1].offset - ms.offset)
+			/ sizeof(Char_type)) - 1;
+	  size_t hash_code = string_hash<Char_type>(p, len);
+	  ps->hash_codes[j] = hash_code;
+	  hg.shards[hash_code % merge_shard_count].push_back(Shard_entry(i, j));
+	}
+    }
+}
+
+// Find the distinct strings in shard SHARD.  We look at the strings
+// in the order in which they appear in the input, and record in the
+// stringpool_key of each one the index of the distinct string and
+// whether this is its first occurrence.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::merge_shard(unsigned int shard)
+{
+  typedef Unordered_map<Shard_key, size_t, Shard_key_hash,
+			Shard_key_eq> Shard_table;
+  Shard_table table;
+
+  for (typename Hash_groups::iterator pg = this->hash_groups_.begin();
+       pg != this->hash_groups_.end();
+       ++pg)
+    {
+      Shard_entries& entries(pg->shards[shard]);
+      for (typename Shard_entries::const_iterator pe = entries.begin();
+	   pe != entries.end();
+	   ++pe)
+	{
+	  Pending_section* ps = this->pending_sections_[pe->section];
+	  Merged_strings& merged_strings(ps->merged_strings_list->merged_strings);
+	  Merged_string& ms(merged_strings[pe->string]);
+	  const Char_type* p = ps->contents + ms.offset / sizeof(Char_type);
+	  size_t len = ((merged_strings[pe->string + 1].offset - ms.offset)
+			/ sizeof(Char_type)) - 1;
+
+	  std::pair<typename Shard_table::iterator, bool> ins =
+	    table.insert(std::make_pair(Shard_key(p, len,
+						  ps->hash_codes[pe->string]),
+					table.size()));
+	  Stringpool::Key code = ins.first->second << 1;
+	  if (ins.second)
+	    code |= 1;
+	  ms.stringpool_key = code;
+	}
+
+      // Save some memory.
+      Shard_entries().swap(entries);
+    }
+}
+
+// Add the strings of the pending sections to the Stringpool, in the
+// order in which the sections were added.  For the sections handled
+// by the merge tasks we only need to add the first occurrence of each
+// string; the others reuse its key.  Adding the strings in input
+// order means that the output is the same as when merging serially.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::add_pending_strings()
+{
+  std::vector<std::vector<Stringpool::Key> > shard_keys(merge_shard_count);
+  for (unsigned int i = 0; i < this->pending_sections_.size(); ++i)
+    {
+      Pending_section* ps = this->pending_sections_[i];
+      Merged_strings& merged_strings(ps->merged_strings_list->merged_strings);
+      size_t count = merged_strings.size() - 1;
+      for (size_t j = 0; j < count; ++j)
+	{
+	  Merged_string& ms(merged_strings[j]);
+	  const Char_type* p = ps->contents + ms.offset / sizeof(Char_type);
+	  size_t len = ((merged_strings[j + 1].offset - ms.offset)
+			/ sizeof(Char_type)) - 1;
+
+	  Stringpool::Key key;
+	  if (i >= this->hashed_section_count_)
+	    this->stringpool_.add_with_length(p, len, true, &key);
+	  else
+	    {
+	      std::vector<Stringpool::Key>& keys(
+		  shard_keys[ps->hash_codes[j] % merge_shard_count]);
+	      Stringpool::Key code = ms.stringpool_key;
+	      if ((code & 1) == 0)
+		key = keys[code >> 1];
+	      else
+		{
+		  gold_assert(keys.size() == (code >> 1));
+		  this->stringpool_.add_with_hash(p, len, ps->hash_codes[j],
+						  true, &key);
+		  keys.push_back(key);
+		}
+	    }
+	  ms.stringpool_key = key;
+	}
+
+      delete[] ps->contents;
+      delete ps;
+    }
+
+  this->pending_sections_.clear();
+  this->hash_groups_.clear();
+  this->hashed_section_count_ = 0;
+  if (this->hash_blocker_ != NULL)
+    {
+      delete this->hash_blocker_;
+      this->hash_blocker_ = NULL;
+    }
+}
+
 // Finalize the mappings from the input sections to the output
 // section, and return the final data size.
 
@@ -547,6 +837,7 @@ template<typename Char_type>
 section_size_type
 Output_merge_string<Char_type>::finalize_merged_data()
 {
+  this->add_pending_strings();
   this->stringpool_.set_string_offsets();
 
   for (typename Merged_strings_lists::const_iterator l =
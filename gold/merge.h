@@ -235,6 +235,12 @@ class Output_merge_base : public Output_section_data
     gold_assert(this->keeps_input_sections_);
     return this->input_sections_.end();
   }
+
+  // Queue tasks to merge the contents in parallel.  Each task added
+  // holds a blocker on FINAL_BLOCKER until it completes.
+  void
+  queue_merge_tasks(Workqueue* workqueue, Task_token* final_blocker)
+  { this->do_queue_merge_tasks(workqueue, final_blocker); }
  
  protected:
   // Return the output offset for an input offset.
@@ -253,6 +259,11 @@ class Output_merge_base : public Output_section_data
   do_set_keeps_input_sections()
   { this->keeps_input_sections_ = true; }
 
+  // This may be overridden by the child class.
+  virtual void
+  do_queue_merge_tasks(Workqueue*, Task_token*)
+  { }
+
   // Record the merged input section for script processing.
   void
   record_input_section(Relobj* relobj, unsigned int shndx);
@@ -402,11 +413,23 @@ class Output_merge_string : public Output_merge_base
  public:
   Output_merge_string(uint64_t addralign)
     : Output_merge_base(sizeof(Char_type), addralign), stringpool_(addralign),
-      merged_strings_lists_(), input_count_(0), input_size_(0)
+      merged_strings_lists_(), input_count_(0), input_size_(0),
+      pending_sections_(), hash_groups_(), hashed_section_count_(0),
+      hash_blocker_(NULL)
   {
     this->stringpool_.set_no_zero_null();
   }
 
+  // Hash the strings of the pending sections in hash group GROUP, and
+  // sort them by shard.  This is called by a task.
+  void
+  hash_strings(unsigned int group);
+
+  // Find the distinct strings in shard SHARD, after all the hash
+  // groups have been hashed.  This is called by a task.
+  void
+  merge_shard(unsigned int shard);
+
  protected:
   // Add an input section.
   bool
@@ -461,11 +484,32 @@ class Output_merge_string : public Output_merge_base
     Output_merge_base::do_set_keeps_input_sections();
   }
 
+  // Queue the tasks which merge the strings in parallel.
+  void
+  do_queue_merge_tasks(Workqueue*, Task_token*);
+
  private:
+  // The number of shards used to merge strings in parallel.  A string
+  // goes to the shard given by its hash code.
+  static const unsigned int merge_shard_count = 64;
+
+  // The total size of the input sections below which they are merged
+  // serially; the tasks would cost more than they save.
+  static const size_t min_parallel_size = 1024 * 1024;
+
   // The name of the string type, for stats.
   const char*
   string_name();
 
+  // Whether to merge the strings of a new input section of SEC_LEN
+  // bytes in parallel.
+  bool
+  merge_in_parallel(section_size_type sec_len) const;
+
+  // Add the strings of the pending sections to the Stringpool.
+  void
+  add_pending_strings();
+
   // As we see input sections, we build a mapping from object, section
   // index and offset to strings.
   struct Merged_string
@@ -498,6 +542,95 @@ class Output_merge_string : public Output_merge_base
 
   typedef std::vector<Merged_strings_list*> Merged_strings_lists;
 
+  // When merging in parallel, we keep a copy of the contents of each
+  // input section, since the input file may be released by the time
+  // the strings are merged.  Until finalize_merged_data adds the
+  // strings to the Stringpool, the stringpool_key of each
+  // Merged_string holds the index of the string among the distinct
+  // strings of its shard, shifted left by one, with the low bit set
+  // for the first occurrence of the string.
+  struct Pending_section
+  {
+    // The offsets of the strings.
+    Merged_strings_list* merged_strings_list;
+    // The section contents.
+    Char_type* contents;
+    // The hash code of each string, set by hash_strings.
+    std::vector<size_t> hash_codes;
+
+    Pending_section(Merged_strings_list* merged_strings_lista,
+		    Char_type* contentsa)
+      : merged_strings_list(merged_strings_lista), contents(contentsa),
+	hash_codes()
+    { }
+  };
+
+  typedef std::vector<Pending_section*> Pending_sections;
+
+  // A string in a pending section, as the index of the section and
+  // the index of the string in its Merged_strings.
+  struct Shard_entry
+  {
+    unsigned int section;
+    unsigned int string;
+
+    Shard_entry(unsigned int sectiona, unsigned int stringa)
+      : section(sectiona), string(stringa)
+    { }
+  };
+
+  typedef std::vector<Shard_entry> Shard_entries;
+
+  // A range of pending sections hashed by one task, and the strings
+  // found in them for each shard, in order.
+  struct Hash_group
+  {
+    // The first pending section.
+    unsigned int first;
+    // One past the last pending section.
+    unsigned int last;
+    // The strings in each shard.
+    std::vector<Shard_entries> shards;
+
+    Hash_group(unsigned int firsta, unsigned int lasta)
+      : first(firsta), last(lasta), shards(merge_shard_count)
+    { }
+  };
+
+  typedef std::vector<Hash_group> Hash_groups;
+
+  // A string in the table used by merge_shard to find the distinct
+  // strings.
+  struct Shard_key
+  {
+    const Char_type* string;
+    size_t length;
+    size_t hash_code;
+
+    Shard_key(const Char_type* stringa, size_t lengtha, size_t hash_codea)
+      : string(stringa), length(lengtha), hash_code(hash_codea)
+    { }
+  };
+
+  struct Shard_key_hash
+  {
+    size_t
+    operator()(const Shard_key& key) const
+    { return key.hash_code; }
+  };
+
+  struct Shard_key_eq
+  {
+    bool
+    operator()(const Shard_key& key1, const Shard_key& key2) const
+    {
+      return (key1.hash_code == key2.hash_code
+	      && key1.length == key2.length
+	      && memcmp(key1.string, key2.string,
+			key1.length * sizeof(Char_type)) == 0);
+    }
+  };
+
   // As we see the strings, we add them to a Stringpool.
   Stringpool_template<Char_type> stringpool_;
   // Map from a location in an input object to an entry in the
@@ -507,6 +640,17 @@ class Output_merge_string : public Output_merge_base
   size_t input_count_;
   // The total size of input sections.
   size_t input_size_;
+  // Input sections whose strings have not yet been added to the
+  // Stringpool.
+  Pending_sections pending_sections_;
+  // The hash groups, if we have queued tasks to merge in parallel.
+  Hash_groups hash_groups_;
+  // The number of pending sections handled by those tasks.  Sections
+  // added later are merged serially.
+  unsigned int hashed_section_count_;
+  // Blocker which the merge_shard tasks wait on until the strings
+  // have been hashed.
+  Task_token* hash_blocker_;
 };
 
 } // End namespace gold.
@@ -2454,6 +2454,15 @@ class Mips_output_data_reloc : public Output_data_reloc<sh_type, dynamic,
         big_endian> Writer;
     this->template do_write_generic<Writer>(of);
   }
+
+  // Write out the sorted relocs from FIRST up to LAST.
+  void
+  do_write_reloc_range(Output_file* of, size_t first, size_t last)
+  {
+    typedef Mips_output_reloc_writer<sh_type, dynamic, size,
+        big_endian> Writer;
+    this->template write_reloc_range<Writer>(of, first, last);
+  }
 };
 
 
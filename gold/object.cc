@@ -27,6 +27,7 @@
 #include <cstdarg>
 #include "demangle.h"
 #include "libiberty.h"
+#include "sha1.h"
 
 #include "gc.h"
 #include "target-select.h"
@@ -267,6 +268,19 @@ Object::handle_split_stack_section(const char* name)
   return false;
 }
 
+// Compute the SHA-1 digest of the file.  This is only used for
+// objects which are not archive members, so the object is the whole
+// file.
+
+void
+Object::do_get_content_hash(unsigned char* digest)
+{
+  gold_assert(this->offset_ == 0);
+  off_t filesize = this->input_file()->file().filesize();
+  const unsigned char* p = this->get_view(0, filesize, false, false);
+  sha1_buffer(reinterpret_cast<const char*>(p), filesize, digest);
+}
+
 // Class Relobj
 
 template<int size>
@@ -680,20 +694,13 @@ need_decompressed_section(const char* name)
     {
       // We will need .zdebug_str if this is not an incremental link
       // (i.e., we are processing string merge sections) or if we need
-      // to build a gdb index.
+      // to build a gdb index.  The other sections read when building
+      // a gdb index are not needed now: they are scanned after the
+      // object has been laid out, when these buffers have already
+      // been discarded.
       if ((!parameters->incremental() || parameters->options().gdb_index())
 	  && strcmp(name, "str") == 0)
 	return true;
-
-      // We will need these other sections when building a gdb index.
-      if (parameters->options().gdb_index()
-	  && (strcmp(name, "info") == 0
-	      || strcmp(name, "types") == 0
-	      || strcmp(name, "pubnames") == 0
-	      || strcmp(name, "pubtypes") == 0
-	      || strcmp(name, "ranges") == 0
-	      || strcmp(name, "abbrev") == 0))
-	return true;
     }
 #endif
 
@@ -770,6 +777,7 @@ build_compressed_section_map(
 	      info.size = convert_to_section_size_type(uncompressed_size);
 	      info.flag = shdr.get_sh_flags();
 	      info.contents = NULL;
+	      info.keep_for_gdb_index = false;
 	      if (uncompressed_size != -1ULL)
 		{
 		  unsigned char* uncompressed_data = NULL;
@@ -781,7 +789,12 @@ build_compressed_section_map(
 						   uncompressed_size,
 						   size, big_endian,
 						   shdr.get_sh_flags()))
-			info.contents = uncompressed_data;
+			{
+			  info.contents = uncompressed_data;
+			  info.keep_for_gdb_index =
+			      (parameters->options().gdb_index()
+			       && strcmp(name, "_str") == 0);
+			}
 		      else
 			delete[] uncompressed_data;
 		    }
@@ -3123,10 +3136,12 @@ Object::decompressed_section_contents(
 }
 
 // Discard any buffers of uncompressed sections.  This is done
-// at the end of the Add_symbols task.
+// at the end of the Add_symbols task, which keeps the buffers that
+// the gdb index scan will read if KEEP_FOR_GDB_INDEX is true, and
+// again once that scan is done.
 
 void
-Object::discard_decompressed_sections()
+Object::discard_decompressed_sections(bool keep_for_gdb_index)
 {
   if (this->compressed_sections_ == NULL)
     return;
@@ -3135,7 +3150,8 @@ Object::discard_decompressed_sections()
        p != this->compressed_sections_->end();
        ++p)
     {
-      if (p->second.contents != NULL)
+      if (p->second.contents != NULL
+	  && (!keep_for_gdb_index || !p->second.keep_for_gdb_index))
 	{
 	  delete[] p->second.contents;
 	  p->second.contents = NULL;
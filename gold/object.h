@@ -375,6 +375,9 @@ struct Compressed_section_info
   elfcpp::Elf_Xword flag;
   uint64_t addralign;
   const unsigned char* contents;
+  // Whether CONTENTS are kept after the Add_symbols task, for the gdb
+  // index scan.
+  bool keep_for_gdb_index;
 };
 typedef std::map<unsigned int, Compressed_section_info> Compressed_section_map;
 
@@ -544,6 +547,13 @@ class Object
   get_mtime()
   { return this->do_get_mtime(); }
 
+  // Store the SHA-1 digest of the contents of the file in the 20
+  // bytes at DIGEST.  This is recorded for incremental linking.  The
+  // object must be locked.
+  void
+  get_content_hash(unsigned char* digest)
+  { this->do_get_content_hash(digest); }
+
   // Get the number of sections.
   unsigned int
   shnum() const
@@ -835,9 +845,10 @@ class Object
 				bool* is_cached, uint64_t* palign = NULL);
 
   // Discard any buffers of decompressed sections.  This is done
-  // at the end of the Add_symbols task.
+  // at the end of the Add_symbols task, and again after the gdb index
+  // scan if KEEP_FOR_GDB_INDEX kept the buffers it reads.
   void
-  discard_decompressed_sections();
+  discard_decompressed_sections(bool keep_for_gdb_index);
 
   // Return the index of the first incremental relocation for symbol SYMNDX.
   unsigned int
@@ -881,6 +892,12 @@ class Object
   do_get_mtime()
   { return this->input_file()->file().get_mtime(); }
 
+  // Compute the SHA-1 digest of the file.  This method may be
+  // overridden for subclasses that don't use an actual file (e.g.,
+  // Incremental objects).
+  virtual void
+  do_get_content_hash(unsigned char* digest);
+
   // Read the symbols--implemented by child class.
   virtual void
   do_read_symbols(Read_symbols_data*) = 0;
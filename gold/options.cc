@@ -1350,6 +1350,12 @@ General_options::finalize()
 	gold_fatal(_("incremental linking is not compatible with -z relro"));
       if (this->pie())
 	gold_fatal(_("incremental linking is not compatible with -pie"));
+      if (this->pack_relative_relocs())
+	{
+	  gold_warning(_("ignoring -z pack-relative-relocs for an "
+			 "incremental link"));
+	  this->set_pack_relative_relocs(false);
+	}
       if (this->gc_sections())
 	{
 	  gold_warning(_("ignoring --gc-sections for an incremental link"));
@@ -1368,6 +1374,12 @@ General_options::finalize()
 	}
     }
 
+#ifndef HAVE_ZSTD
+  if (strcmp(this->compress_debug_sections(), "zstd") == 0)
+    gold_fatal(_("--compress-debug-sections=zstd: gold was built "
+		 "without zstd support"));
+#endif
+
   // --rosegment-gap implies --rosegment.
   if (this->user_set_rosegment_gap())
     this->set_rosegment(true);
@@ -1236,6 +1236,343 @@ Output_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>::write(
   orel.put_r_addend(addend);
 }
 
+// Class Output_data_reloc_generic.
+
+// This task computes the sort keys of one chunk of the dynamic relocs
+// and sorts them.
+
+class Sort_reloc_chunk_task : public Task
+{
+ public:
+  Sort_reloc_chunk_task(Output_data_reloc_generic* relocs, unsigned int chunk,
+			Task_token* sort_blocker)
+    : relocs_(relocs), chunk_(chunk), sort_blocker_(sort_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->sort_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->relocs_->sort_reloc_chunk(this->chunk_); }
+
+  std::string
+  get_name() const
+  { return "Sort_reloc_chunk_task"; }
+
+ private:
+  Output_data_reloc_generic* relocs_;
+  unsigned int chunk_;
+  Task_token* sort_blocker_;
+};
+
+// This task writes out one chunk of the sorted dynamic relocs.
+
+class Write_reloc_chunk_task : public Task
+{
+ public:
+  Write_reloc_chunk_task(Output_data_reloc_generic* relocs, Output_file* of,
+			 unsigned int chunk, Task_token* final_blocker)
+    : relocs_(relocs), of_(of), chunk_(chunk), final_blocker_(final_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->relocs_->write_reloc_chunk(this->of_, this->chunk_); }
+
+  std::string
+  get_name() const
+  { return "Write_reloc_chunk_task"; }
+
+ private:
+  Output_data_reloc_generic* relocs_;
+  Output_file* of_;
+  unsigned int chunk_;
+  Task_token* final_blocker_;
+};
+
+// This task runs after every chunk of the dynamic relocs has been
+// sorted.  It merges the chunks, and then queues the tasks which
+// write them out.
+
+class Merge_reloc_chunks_task : public Task
+{
+ public:
+  Merge_reloc_chunks_task(Output_data_reloc_generic* relocs, Output_file* of,
+			  unsigned int chunk_count, Task_token* sort_blocker,
+			  Task_token* final_blocker)
+    : relocs_(relocs), of_(of), chunk_count_(chunk_count),
+      sort_blocker_(sort_blocker), final_blocker_(final_blocker)
+  { }
+
+  ~Merge_reloc_chunks_task()
+  { delete this->sort_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->sort_blocker_->is_blocked())
+      return this->sort_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  void
+  run(Workqueue* workqueue)
+  {
+    this->relocs_->merge_reloc_chunks();
+    for (unsigned int i = 0; i < this->chunk_count_; ++i)
+      {
+	workqueue->add_blocker(this->final_blocker_);
+	workqueue->queue(new Write_reloc_chunk_task(this->relocs_, this->of_,
+						    i, this->final_blocker_));
+      }
+  }
+
+  std::string
+  get_name() const
+  { return "Merge_reloc_chunks_task"; }
+
+ private:
+  Output_data_reloc_generic* relocs_;
+  Output_file* of_;
+  unsigned int chunk_count_;
+  Task_token* sort_blocker_;
+  Task_token* final_blocker_;
+};
+
+// Queue the tasks which sort and write out COUNT dynamic relocs.
+// Each chunk of the relocs is sorted by a separate task.  When they
+// are all done, a single task merges the chunks and queues a task to
+// write out each chunk.
+
+void
+Output_data_reloc_generic::queue_reloc_tasks(Workqueue* workqueue,
+					     Output_file* of,
+					     Task_token* final_blocker,
+					     size_t count)
+{
+  // Small sections are sorted and written serially; the tasks would
+  // cost more than they save.
+  if (!this->sort_relocs_ || count <= reloc_chunk_size)
+    return;
+
+  gold_assert(this->chunk_count_ == 0 && this->sort_keys_.empty());
+  this->sort_keys_.resize(count);
+  this->chunk_count_ = (count + reloc_chunk_size - 1) / reloc_chunk_size;
+
+  Task_token* sort_blocker = new Task_token(true);
+  sort_blocker->add_blockers(this->chunk_count_);
+  for (unsigned int i = 0; i < this->chunk_count_; ++i)
+    workqueue->queue(new Sort_reloc_chunk_task(this, i, sort_blocker));
+
+  workqueue->add_blocker(final_blocker);
+  workqueue->queue(new Merge_reloc_chunks_task(this, of, this->chunk_count_,
+					       sort_blocker, final_blocker));
+}
+
+// Return the range of relocs in chunk CHUNK.
+
+void
+Output_data_reloc_generic::reloc_chunk(unsigned int chunk, size_t* first,
+				       size_t* last) const
+{
+  gold_assert(chunk < this->chunk_count_);
+  *first = chunk * reloc_chunk_size;
+  *last = std::min(*first + reloc_chunk_size, this->sort_keys_.size());
+}
+
+// Compute the sort keys of the relocs in chunk CHUNK and sort them.
+// The chunks are independent of each other, so this may run in
+// parallel for different chunks.
+
+void
+Output_data_reloc_generic::sort_reloc_chunk(unsigned int chunk)
+{
+  size_t first;
+  size_t last;
+  this->reloc_chunk(chunk, &first, &last);
+  Sort_key* keys = &this->sort_keys_[0];
+  this->do_compute_sort_keys(first, last, keys + first);
+  Output_data_reloc_generic::radix_sort(keys + first, keys + last);
+}
+
+// Order sort keys by MAJOR and ADDRESS.
+
+struct Reloc_sort_key_less
+{
+  template<typename Sort_key>
+  bool
+  operator()(const Sort_key& k1, const Sort_key& k2) const
+  {
+    if (k1.major != k2.major)
+      return k1.major < k2.major;
+    return k1.address < k2.address;
+  }
+};
+
+// Merge the sorted chunks of the relocs.  std::merge takes equal
+// elements from the first range first, so the merge keeps relocs
+// with equal keys in their original order.
+
+void
+Output_data_reloc_generic::merge_reloc_chunks()
+{
+  const size_t count = this->sort_keys_.size();
+  Sort_keys tmp(count);
+  Sort_key* from = &this->sort_keys_[0];
+  Sort_key* to = &tmp[0];
+  for (size_t width = reloc_chunk_size; width < count; width *= 2)
+    {
+      for (size_t i = 0; i < count; i += 2 * width)
+	{
+	  size_t mid = std::min(i + width, count);
+	  size_t end = std::min(i + 2 * width, count);
+	  std::merge(from + i, from + mid, from + mid, from + end, to + i,
+		     Reloc_sort_key_less());
+	}
+      std::swap(from, to);
+    }
+  if (from != &this->sort_keys_[0])
+    this->sort_keys_.swap(tmp);
+
+  this->sort_ties();
+}
+
+// Write out chunk CHUNK of the sorted relocs.
+
+void
+Output_data_reloc_generic::write_reloc_chunk(Output_file* of,
+					     unsigned int chunk)
+{
+  size_t first;
+  size_t last;
+  this->reloc_chunk(chunk, &first, &last);
+  this->do_write_reloc_range(of, first, last);
+}
+
+// Sort the COUNT relocs in the section without using any tasks.
+
+void
+Output_data_reloc_generic::sort_relocs_serially(size_t count)
+{
+  gold_assert(this->chunk_count_ == 0);
+  if (count == 0)
+    return;
+  this->sort_keys_.resize(count);
+  Sort_key* keys = &this->sort_keys_[0];
+  this->do_compute_sort_keys(0, count, keys);
+  Output_data_reloc_generic::radix_sort(keys, keys + count);
+  this->sort_ties();
+}
+
+// Sort the keys in [FIRST, LAST) by MAJOR and then by ADDRESS.  This
+// is a least significant digit first radix sort, so keys which
+// compare equal stay in the order in which they appear.  Digits
+// which are the same in every key are skipped; in practice the
+// addresses only differ in their low few bytes, and the relative
+// relocs all have the same MAJOR field.
+
+void
+Output_data_reloc_generic::radix_sort(Sort_key* first, Sort_key* last)
+{
+  const size_t count = last - first;
+  if (count < 256)
+    {
+      std::stable_sort(first, last, Reloc_sort_key_less());
+      return;
+    }
+
+  uint64_t major_and = ~static_cast<uint64_t>(0);
+  uint64_t major_or = 0;
+  uint64_t address_and = ~static_cast<uint64_t>(0);
+  uint64_t address_or = 0;
+  for (const Sort_key* p = first; p != last; ++p)
+    {
+      major_and &= p->major;
+      major_or |= p->major;
+      address_and &= p->address;
+      address_or |= p->address;
+    }
+  const uint64_t major_bits = major_and ^ major_or;
+  const uint64_t address_bits = address_and ^ address_or;
+
+  Sort_keys tmp(count);
+  Sort_key* from = first;
+  Sort_key* to = &tmp[0];
+  for (unsigned int pass = 0; pass < 16; ++pass)
+    {
+      const bool is_major = pass >= 8;
+      const unsigned int shift = (pass % 8) * 8;
+      if ((((is_major ? major_bits : address_bits) >> shift) & 0xff) == 0)
+	continue;
+
+      size_t starts[256];
+      memset(starts, 0, sizeof starts);
+      for (const Sort_key* p = from; p != from + count; ++p)
+	++starts[((is_major ? p->major : p->address) >> shift) & 0xff];
+      size_t start = 0;
+      for (unsigned int i = 0; i < 256; ++i)
+	{
+	  size_t c = starts[i];
+	  starts[i] = start;
+	  start += c;
+	}
+      for (const Sort_key* p = from; p != from + count; ++p)
+	{
+	  uint64_t key = is_major ? p->major : p->address;
+	  to[starts[(key >> shift) & 0xff]++] = *p;
+	}
+
+      std::swap(from, to);
+    }
+
+  if (from != first)
+    std::copy(from, from + count, first);
+}
+
+// Once the keys are sorted by MAJOR and ADDRESS, finish sorting each
+// run of keys which are equal in those fields.  These runs are rare
+// and short.
+
+void
+Output_data_reloc_generic::sort_ties()
+{
+  Sort_key* p = &this->sort_keys_[0];
+  Sort_key* const end = p + this->sort_keys_.size();
+  while (p != end)
+    {
+      Sort_key* q = p + 1;
+      while (q != end && q->major == p->major && q->address == p->address)
+	++q;
+      if (q - p > 1)
+	this->do_sort_key_ties(p, q);
+      p = q;
+    }
+}
+
 // Output_data_reloc_base methods.
 
 // Adjust the output section.
@@ -1288,6 +1625,238 @@ Output_data_reloc_base<sh_type, dynamic, size, big_endian>::do_write(
   this->do_write_generic<Writer>(of);
 }
 
+// Queue tasks to sort and write out the relocs in parallel.  Only
+// dynamic relocs are sorted.
+
+template<int sh_type, bool dynamic, int size, bool big_endian>
+void
+Output_data_reloc_base<sh_type, dynamic, size, big_endian>
+    ::do_queue_write_tasks(Workqueue* workqueue, Output_file* of,
+			   Task_token* final_blocker)
+{
+  if (dynamic)
+    this->queue_reloc_tasks(workqueue, of, final_blocker,
+			    this->relocs_.size());
+}
+
+// Set the sort keys of the relocs from FIRST up to LAST.  The keys
+// order the relocs as Output_reloc::compare does, except for the
+// final tie breakers, which are left to do_sort_key_ties.
+
+template<int sh_type, bool dynamic, int size, bool big_endian>
+void
+Output_data_reloc_base<sh_type, dynamic, size, big_endian>
+    ::do_compute_sort_keys(size_t first, size_t last, Sort_key* keys)
+{
+  for (size_t i = first; i < last; ++i, ++keys)
+    {
+      const Output_reloc_type& reloc(this->relocs_[i]);
+      if (reloc.is_relative())
+	keys->major = 0;
+      else
+	keys->major = ((static_cast<uint64_t>(1) << 32)
+		       | reloc.get_symbol_index());
+      // Output_reloc::compare compares addresses as signed values.
+      uint64_t address = reloc.get_address();
+      if (size == 64)
+	address ^= static_cast<uint64_t>(1) << 63;
+      keys->address = address;
+      keys->index = i;
+    }
+}
+
+// Sort relocs with the same MAJOR and ADDRESS sort key fields by the
+// remaining fields, keeping relocs which are the same in their
+// original order.
+
+template<int sh_type, bool dynamic, int size, bool big_endian>
+void
+Output_data_reloc_base<sh_type, dynamic, size, big_endian>
+    ::do_sort_key_ties(Sort_key* first, Sort_key* last)
+{
+  std::stable_sort(first, last, Sort_keys_comparison(&this->relocs_));
+}
+
+// Write out the sorted relocs from FIRST up to LAST.
+
+template<int sh_type, bool dynamic, int size, bool big_endian>
+void
+Output_data_reloc_base<sh_type, dynamic, size, big_endian>
+    ::do_write_reloc_range(Output_file* of, size_t first, size_t last)
+{
+  typedef Output_reloc_writer<sh_type, dynamic, size, big_endian> Writer;
+  this->template write_reloc_range<Writer>(of, first, last);
+}
+
+// Class Output_data_relr.
+
+// Set the entry size of the output section.
+
+template<int size, bool big_endian>
+void
+Output_data_relr<size, big_endian>::do_adjust_output_section(
+    Output_section* os)
+{
+  os->set_entsize(word_size);
+}
+
+// Add a relative reloc at OFFSET within input section SHNDX of
+// RELOBJ.  The reloc can only be packed if it relocates an aligned
+// word of an input section which is not specially mapped.
+
+template<int size, bool big_endian>
+bool
+Output_data_relr<size, big_endian>::add_input_section_reloc(
+    Relobj* relobj,
+    unsigned int shndx,
+    Address offset)
+{
+  if (offset % word_size != 0
+      || relobj->is_output_section_offset_invalid(shndx)
+      || relobj->section_addralign(shndx) < static_cast<uint64_t>(word_size))
+    return false;
+
+  std::pair<typename Input_section_groups::iterator, bool> ins =
+    this->input_section_groups_.insert(std::make_pair(Section_id(relobj,
+								 shndx),
+						      this->groups_.size()));
+  if (ins.second)
+    this->groups_.push_back(Group(relobj, shndx, NULL));
+  this->groups_[ins.first->second].offsets.push_back(offset);
+  return true;
+}
+
+// Add a relative reloc at OFFSET within OD.
+
+template<int size, bool big_endian>
+bool
+Output_data_relr<size, big_endian>::add_output_data_reloc(Output_data* od,
+							  Address offset)
+{
+  if (od == NULL
+      || offset % word_size != 0
+      || od->addralign() < static_cast<uint64_t>(word_size))
+    return false;
+
+  std::pair<typename Output_data_groups::iterator, bool> ins =
+    this->output_data_groups_.insert(std::make_pair(od,
+						    this->groups_.size()));
+  if (ins.second)
+    this->groups_.push_back(Group(NULL, 0, od));
+  this->groups_[ins.first->second].offsets.push_back(offset);
+  return true;
+}
+
+// Return the address of the start of a group.
+
+template<int size, bool big_endian>
+typename Output_data_relr<size, big_endian>::Address
+Output_data_relr<size, big_endian>::group_address(const Group& group) const
+{
+  if (group.relobj == NULL)
+    return group.od->address();
+  Output_section* os = group.relobj->output_section(group.shndx);
+  gold_assert(os != NULL
+	      && !group.relobj->is_output_section_offset_invalid(group.shndx));
+  return os->address() + group.relobj->output_section_offset(group.shndx);
+}
+
+// Encode the relocs at the sorted OFFSETS from ADDRESS.  Write the
+// entries to POV if it is not NULL, and return the number of entries.
+// An address entry relocates one word.  Each bitmap entry after it
+// relocates some of the next SIZE - 1 words, and the low bit marks
+// the entry as a bitmap.
+
+template<int size, bool big_endian>
+size_t
+Output_data_relr<size, big_endian>::encode(
+    const std::vector<Address>& offsets,
+    Address address,
+    unsigned char* pov)
+{
+  const Address bitmap_span = (size - 1) * word_size;
+  size_t count = 0;
+  typename std::vector<Address>::const_iterator p = offsets.begin();
+  while (p != offsets.end())
+    {
+      if (pov != NULL)
+	elfcpp::Swap<size, big_endian>::writeval(pov + count * word_size,
+						 address + *p);
+      ++count;
+      Address next = *p + word_size;
+      ++p;
+
+      while (p != offsets.end())
+	{
+	  Address bitmap = 0;
+	  while (p != offsets.end() && *p - next < bitmap_span)
+	    {
+	      bitmap |= static_cast<Address>(1) << ((*p - next) / word_size);
+	      ++p;
+	    }
+	  if (bitmap == 0)
+	    break;
+	  if (pov != NULL)
+	    elfcpp::Swap<size, big_endian>::writeval(pov + count * word_size,
+						     (bitmap << 1) | 1);
+	  ++count;
+	  next += bitmap_span;
+	}
+    }
+  return count;
+}
+
+// Set the final data size.  Since each group is encoded starting from
+// its own address entry, and the start of each group is aligned to a
+// word, the size does not depend on the group addresses.
+
+template<int size, bool big_endian>
+void
+Output_data_relr<size, big_endian>::set_final_data_size()
+{
+  size_t count = 0;
+  for (typename std::vector<Group>::iterator p = this->groups_.begin();
+       p != this->groups_.end();
+       ++p)
+    {
+      std::vector<Address>& offsets(p->offsets);
+      std::sort(offsets.begin(), offsets.end());
+      offsets.erase(std::unique(offsets.begin(), offsets.end()),
+		    offsets.end());
+      count += Output_data_relr::encode(offsets, 0, NULL);
+    }
+  this->set_data_size(count * word_size);
+}
+
+// Write out the data, with the groups in address order.
+
+template<int size, bool big_endian>
+void
+Output_data_relr<size, big_endian>::do_write(Output_file* of)
+{
+  const off_t off = this->offset();
+  const off_t oview_size = this->data_size();
+  unsigned char* const oview = of->get_output_view(off, oview_size);
+
+  std::vector<std::pair<Address, unsigned int> > order;
+  order.reserve(this->groups_.size());
+  for (unsigned int i = 0; i < this->groups_.size(); ++i)
+    order.push_back(std::make_pair(this->group_address(this->groups_[i]), i));
+  std::sort(order.begin(), order.end());
+
+  unsigned char* pov = oview;
+  for (size_t i = 0; i < order.size(); ++i)
+    {
+      const Group& group(this->groups_[order[i].second]);
+      pov += (Output_data_relr::encode(group.offsets, order[i].first, pov)
+	      * word_size);
+    }
+
+  gold_assert(pov - oview == oview_size);
+
+  of->write_output_view(off, oview_size, oview);
+}
+
 // Class Output_relocatable_relocs.
 
 template<int sh_type, int size, bool big_endian>
@@ -2392,6 +2961,7 @@ Output_section::Output_section(const char* name, elfcpp::Elf_Word type,
     extra_segment_flags_(0),
     segment_alignment_(0),
     checkpoint_(NULL),
+    prefinalized_(NULL),
     lookup_maps_(new Output_section_lookup_maps),
     free_list_(),
     free_space_fill_(NULL),
@@ -2408,6 +2978,7 @@ Output_section::Output_section(const char* name, elfcpp::Elf_Word type,
 Output_section::~Output_section()
 {
   delete this->checkpoint_;
+  delete this->prefinalized_;
 }
 
 // Set the entry size.
@@ -3171,7 +3742,7 @@ Output_section::set_final_data_size()
 
   if (this->input_sections_.empty())
     data_size = this->current_data_size_for_child();
-  else
+  else if (!this->use_prefinalized_input_sections(&data_size))
     {
       if (this->must_sort_attached_input_sections()
 	  || this->input_section_order_specified())
@@ -3309,6 +3880,14 @@ class Output_section::Input_section_sort_entry
       }
   }
 
+  // This is used when the section name has already been read.
+  Input_section_sort_entry(const Input_section& input_section,
+			   unsigned int index,
+			   const std::string& section_name)
+    : input_section_(input_section), index_(index),
+      section_name_(section_name)
+  { }
+
   // Return the Input_section.
   const Input_section&
   input_section() const
@@ -3642,42 +4221,208 @@ Output_section::sort_attached_input_sections()
 			    this->must_sort_attached_input_sections(),
 			    this->name()));
 
+  // Sort the input sections, and copy them back to our list.
+  this->input_sections_.clear();
+  this->sort_input_section_list(&sort_list, &this->input_sections_);
+
+  // Remember that we sorted the input sections, since we might get
+  // called again.
+  this->attached_input_sections_are_sorted_ = true;
+}
+
+// Sort the input sections in SORT_LIST, which was built from the
+// input sections attached to this output section, and append them to
+// *SORTED in their new order.
+
+void
+Output_section::sort_input_section_list(
+    std::vector<Input_section_sort_entry>* sort_list,
+    Input_section_list* sorted)
+{
   // Sort the input sections.
   if (this->must_sort_attached_input_sections())
     {
       if (this->type() == elfcpp::SHT_PREINIT_ARRAY
 	  || this->type() == elfcpp::SHT_INIT_ARRAY
 	  || this->type() == elfcpp::SHT_FINI_ARRAY)
-	std::sort(sort_list.begin(), sort_list.end(),
+	std::sort(sort_list->begin(), sort_list->end(),
 		  Input_section_sort_init_fini_compare());
       else if (strcmp(parameters->options().sort_section(), "name") == 0)
-	std::sort(sort_list.begin(), sort_list.end(),
+	std::sort(sort_list->begin(), sort_list->end(),
 		  Input_section_sort_section_name_compare());
       else if (strcmp(this->name(), ".text") == 0)
-	std::sort(sort_list.begin(), sort_list.end(),
+	std::sort(sort_list->begin(), sort_list->end(),
 		  Input_section_sort_section_prefix_special_ordering_compare());
       else
-	std::sort(sort_list.begin(), sort_list.end(),
+	std::sort(sort_list->begin(), sort_list->end(),
 		  Input_section_sort_compare());
     }
   else
     {
       gold_assert(this->input_section_order_specified());
-      std::sort(sort_list.begin(), sort_list.end(),
+      std::sort(sort_list->begin(), sort_list->end(),
 		Input_section_sort_section_order_index_compare());
     }
 
-  // Copy the sorted input sections back to our list.
-  this->input_sections_.clear();
-  for (std::vector<Input_section_sort_entry>::iterator p = sort_list.begin();
-       p != sort_list.end();
+  // Copy the sorted input sections to the new list.
+  for (std::vector<Input_section_sort_entry>::iterator p = sort_list->begin();
+       p != sort_list->end();
        ++p)
-    this->input_sections_.push_back(p->input_section());
-  sort_list.clear();
+    sorted->push_back(p->input_section());
+  sort_list->clear();
 
-  // Remember that we sorted the input sections, since we might get
-  // called again.
-  this->attached_input_sections_are_sorted_ = true;
+}
+
+// Prepare to lay out the input sections ahead of Layout::finalize.
+// This is only done when each input section is an ordinary input
+// section or an Output_section_data whose size is already known, such
+// as a code fill.  Reading the names of the input sections needs the
+// objects to be locked, so the caller reads them, one task per object.
+
+bool
+Output_section::prepare_to_prefinalize(Section_name_requests* requests)
+{
+  if (this->input_sections_.empty()
+      || this->requires_postprocessing()
+      || this->checkpoint_ != NULL)
+    return false;
+
+  for (Input_section_list::const_iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    {
+      if (!p->is_input_section()
+	  && (!p->is_output_section_data()
+	      || !p->output_section_data()->is_data_size_valid()))
+	return false;
+    }
+
+  gold_assert(this->prefinalized_ == NULL);
+  Prefinalized_input_sections* pf = new Prefinalized_input_sections();
+  this->prefinalized_ = pf;
+
+  if (this->must_sort_attached_input_sections()
+      && !this->attached_input_sections_are_sorted_)
+    {
+      pf->names.resize(this->input_sections_.size());
+      unsigned int i = 0;
+      for (Input_section_list::const_iterator p =
+	     this->input_sections_.begin();
+	   p != this->input_sections_.end();
+	   ++p, ++i)
+	{
+	  // Linker generated data is sorted by the output section name.
+	  if (p->is_input_section())
+	    (*requests)[p->relobj()].push_back(std::make_pair(p->shndx(),
+							      &pf->names[i]));
+	  else
+	    pf->names[i].assign(this->name());
+	}
+    }
+
+  return true;
+}
+
+// Sort the input sections and set their offsets, as
+// set_final_data_size would.  The offset of an input section within
+// the output section does not depend on the address of the output
+// section, so this can be done before the addresses are known.  The
+// sorted list is kept to one side until set_final_data_size, in case
+// more sections are added in the meantime.
+
+void
+Output_section::prefinalize_input_sections()
+{
+  Prefinalized_input_sections* pf = this->prefinalized_;
+  gold_assert(pf != NULL);
+
+  const Input_section_list* input_sections = &this->input_sections_;
+  if ((this->must_sort_attached_input_sections()
+       || this->input_section_order_specified())
+      && !this->attached_input_sections_are_sorted_)
+    {
+      bool have_names = !pf->names.empty();
+      std::vector<Input_section_sort_entry> sort_list;
+      sort_list.reserve(this->input_sections_.size());
+      unsigned int i = 0;
+      for (Input_section_list::const_iterator p =
+	     this->input_sections_.begin();
+	   p != this->input_sections_.end();
+	   ++p, ++i)
+	sort_list.push_back(Input_section_sort_entry(*p, i,
+						     (have_names
+						      ? pf->names[i]
+						      : std::string())));
+      std::vector<std::string>().swap(pf->names);
+
+      pf->sorted.reserve(sort_list.size());
+      this->sort_input_section_list(&sort_list, &pf->sorted);
+      input_sections = &pf->sorted;
+    }
+
+  // An Output_section_data needs its address, which we don't know
+  // yet, so we just remember its offset.
+  off_t off = this->first_input_offset_;
+  for (Input_section_list::const_iterator p = input_sections->begin();
+       p != input_sections->end();
+       ++p)
+    {
+      off = align_address(off, p->addralign());
+      if (p->is_input_section())
+	p->relobj()->set_section_offset(p->shndx(), off);
+      else
+	pf->data.push_back(Prefinalized_data(p->output_section_data(), off,
+					     p->data_size()));
+      off += p->data_size();
+    }
+
+  pf->count = this->input_sections_.size();
+  pf->first_input_offset = this->first_input_offset_;
+  pf->data_size = off;
+}
+
+// Use the results of prefinalize_input_sections, if there are any and
+// nothing has been added to the section since.  Otherwise
+// set_final_data_size lays out the input sections again, which also
+// resets the offsets set by prefinalize_input_sections.
+
+bool
+Output_section::use_prefinalized_input_sections(off_t* data_size)
+{
+  Prefinalized_input_sections* pf = this->prefinalized_;
+  if (pf == NULL)
+    return false;
+  this->prefinalized_ = NULL;
+
+  bool ret = (pf->data_size >= 0
+	      && pf->count == this->input_sections_.size()
+	      && pf->first_input_offset == this->first_input_offset_);
+  for (std::vector<Prefinalized_data>::const_iterator p = pf->data.begin();
+       ret && p != pf->data.end();
+       ++p)
+    ret = (p->posd->is_data_size_valid()
+	   && p->posd->data_size() == p->data_size);
+  if (ret)
+    {
+      uint64_t address = this->address();
+      off_t startoff = this->offset();
+      for (std::vector<Prefinalized_data>::const_iterator p =
+	     pf->data.begin();
+	   p != pf->data.end();
+	   ++p)
+	p->posd->set_address_and_file_offset(address + p->offset,
+					     startoff + p->offset);
+
+      if (!pf->sorted.empty())
+	{
+	  this->input_sections_.swap(pf->sorted);
+	  this->attached_input_sections_are_sorted_ = true;
+	}
+      *data_size = pf->data_size;
+    }
+
+  delete pf;
+  return ret;
 }
 
 // Write the section header to *OSHDR.
@@ -4069,6 +4814,38 @@ Output_section::print_merge_stats()
     p->print_merge_stats(this->name_);
 }
 
+// Queue tasks to merge the contents of merge sections in parallel.
+
+void
+Output_section::queue_merge_tasks(Workqueue* workqueue,
+				  Task_token* final_blocker)
+{
+  for (Input_section_list::iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    {
+      if (p->is_merge_section())
+	p->output_merge_base()->queue_merge_tasks(workqueue, final_blocker);
+    }
+}
+
+// Queue tasks to write the contents of the Output_section_data
+// objects in parallel.
+
+void
+Output_section::queue_write_tasks(Workqueue* workqueue, Output_file* of,
+				  Task_token* final_blocker)
+{
+  for (Input_section_list::iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    {
+      if (p->is_output_section_data())
+	p->output_section_data()->queue_write_tasks(workqueue, of,
+						    final_blocker);
+    }
+}
+
 // Set a fixed layout for the section.  Used for incremental update links.
 
 void
@@ -5540,6 +6317,26 @@ template
 class Output_data_reloc<elfcpp::SHT_RELA, true, 64, true>;
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+class Output_data_relr<32, false>;
+#endif
+
+#ifdef HAVE_TARGET_32_BIG
+template
+class Output_data_relr<32, true>;
+#endif
+
+#ifdef HAVE_TARGET_64_LITTLE
+template
+class Output_data_relr<64, false>;
+#endif
+
+#ifdef HAVE_TARGET_64_BIG
+template
+class Output_data_relr<64, true>;
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 class Output_relocatable_relocs<elfcpp::SHT_REL, 32, false>;
@@ -812,6 +812,15 @@ class Output_section_data : public Output_data
   print_merge_stats(const char* section_name)
   { this->do_print_merge_stats(section_name); }
 
+  // Queue tasks to write the contents in parallel.  This is called
+  // before any of the output sections are written.  If any tasks are
+  // queued, they write the contents rather than write.  Each task
+  // added holds a blocker on FINAL_BLOCKER until it completes.
+  void
+  queue_write_tasks(Workqueue* workqueue, Output_file* of,
+		    Task_token* final_blocker)
+  { this->do_queue_write_tasks(workqueue, of, final_blocker); }
+
  protected:
   // The child class must implement do_write.
 
@@ -845,6 +854,11 @@ class Output_section_data : public Output_data
   do_print_merge_stats(const char*)
   { gold_unreachable(); }
 
+  // The child class may implement queue_write_tasks.
+  virtual void
+  do_queue_write_tasks(Workqueue*, Output_file*, Task_token*)
+  { }
+
   // Return the required alignment.
   uint64_t
   do_addralign() const
@@ -1254,6 +1268,32 @@ class Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>
     return this->u2_.relobj;
   }
 
+  // If this relocation is against an input section, return the index
+  // of the input section.
+  unsigned int
+  get_shndx() const
+  {
+    gold_assert(this->shndx_ != INVALID_CODE);
+    return this->shndx_;
+  }
+
+  // If this relocation is not against an input section, return the
+  // output data which holds the reloc address.  This may be NULL if
+  // the reloc address is absolute.
+  Output_data*
+  get_output_data() const
+  {
+    if (this->shndx_ != INVALID_CODE)
+      return NULL;
+    return this->u2_.od;
+  }
+
+  // Return the offset of the reloc address within the input section
+  // or the output data.
+  Address
+  get_offset() const
+  { return this->address_; }
+
   // Write the reloc entry to an output view.
   void
   write(unsigned char* pov) const;
@@ -1457,6 +1497,11 @@ class Output_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
     : rel_(type, arg, relobj, shndx, address), addend_(addend)
   { }
 
+  // Return the reloc type.
+  unsigned int
+  type() const
+  { return this->rel_.type(); }
+
   // Return whether this is a RELATIVE relocation.
   bool
   is_relative() const
@@ -1474,6 +1519,34 @@ class Output_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
   get_relobj() const
   { return this->rel_.get_relobj(); }
 
+  // If this relocation is against an input section, return the index
+  // of the input section.
+  unsigned int
+  get_shndx() const
+  { return this->rel_.get_shndx(); }
+
+  // If this relocation is not against an input section, return the
+  // output data which holds the reloc address.
+  Output_data*
+  get_output_data() const
+  { return this->rel_.get_output_data(); }
+
+  // Return the offset of the reloc address within the input section
+  // or the output data.
+  Address
+  get_offset() const
+  { return this->rel_.get_offset(); }
+
+  // Return the symbol index.
+  unsigned int
+  get_symbol_index() const
+  { return this->rel_.get_symbol_index(); }
+
+  // Return the output address.
+  Address
+  get_address() const
+  { return this->rel_.get_address(); }
+
   // Write the reloc entry to an output view.
   void
   write(unsigned char* pov) const;
@@ -1509,7 +1582,8 @@ class Output_data_reloc_generic : public Output_section_data_build
  public:
   Output_data_reloc_generic(int size, bool sort_relocs)
     : Output_section_data_build(Output_data::default_alignment_for_size(size)),
-      relative_reloc_count_(0), sort_relocs_(sort_relocs)
+      relative_reloc_count_(0), sort_relocs_(sort_relocs), sort_keys_(),
+      chunk_count_(0)
   { }
 
   // Return the number of relative relocs in this section.
@@ -1571,21 +1645,120 @@ class Output_data_reloc_generic : public Output_section_data_build
 			     unsigned int shndx, uint64_t address,
 			     uint64_t addend) = 0;
 
+  // Compute the sort keys of the relocs in chunk CHUNK, and sort
+  // them.  This is called by a task queued by queue_write_tasks.
+  void
+  sort_reloc_chunk(unsigned int chunk);
+
+  // Merge the sorted chunks.  This is called by a task queued by
+  // queue_write_tasks, once every chunk has been sorted.
+  void
+  merge_reloc_chunks();
+
+  // Write out the relocs in chunk CHUNK of the sorted relocs.  This
+  // is called by a task queued by queue_write_tasks.
+  void
+  write_reloc_chunk(Output_file* of, unsigned int chunk);
+
  protected:
+  // The key used to sort a dynamic reloc.  MAJOR puts the relative
+  // relocs first, and then orders the others by symbol index.
+  // ADDRESS is the address of the reloc, biased so that it orders
+  // like a signed value.  INDEX is the position of the reloc in the
+  // section.
+  struct Sort_key
+  {
+    uint64_t major;
+    uint64_t address;
+    unsigned int index;
+  };
+
+  typedef std::vector<Sort_key> Sort_keys;
+
   // Note that we've added another relative reloc.
   void
   bump_relative_reloc_count()
   { ++this->relative_reloc_count_; }
 
+  // Queue the tasks which sort and write out COUNT relocs in
+  // parallel.
+  void
+  queue_reloc_tasks(Workqueue*, Output_file*, Task_token* final_blocker,
+		    size_t count);
+
+  // Return whether the relocs are written out by the tasks queued by
+  // queue_reloc_tasks rather than by do_write.
+  bool
+  is_written_by_tasks() const
+  { return this->chunk_count_ != 0; }
+
+  // Sort the COUNT relocs in this section for the dynamic linker.
+  // Afterward sort_key(I).index is the index of the I'th reloc to
+  // write out.
+  void
+  sort_relocs_serially(size_t count);
+
+  // Return the I'th sort key.
+  const Sort_key&
+  sort_key(size_t i) const
+  { return this->sort_keys_[i]; }
+
+  // Whether sort_key may be used.
+  bool
+  have_sort_keys() const
+  { return !this->sort_keys_.empty(); }
+
+  // Free the sort keys.
+  void
+  clear_sort_keys()
+  { Sort_keys().swap(this->sort_keys_); }
+
+  // Set the sort keys of the relocs from FIRST up to LAST.
+  virtual void
+  do_compute_sort_keys(size_t first, size_t last, Sort_key* keys) = 0;
+
+  // Sort the relocs whose keys are [FIRST, LAST), which have the same
+  // MAJOR and ADDRESS fields, into their final order.
+  virtual void
+  do_sort_key_ties(Sort_key* first, Sort_key* last) = 0;
+
+  // Write out the sorted relocs from FIRST up to LAST.
+  virtual void
+  do_write_reloc_range(Output_file*, size_t first, size_t last) = 0;
+
  private:
+  // The number of relocs in a chunk handled by one task.
+  static const size_t reloc_chunk_size = 64 * 1024;
+
+  // Return the range of relocs in chunk CHUNK.
+  void
+  reloc_chunk(unsigned int chunk, size_t* first, size_t* last) const;
+
+  // Sort the keys in [FIRST, LAST) by MAJOR and ADDRESS.
+  static void
+  radix_sort(Sort_key* first, Sort_key* last);
+
+  // Finish sorting the keys once they are ordered by MAJOR and
+  // ADDRESS.
+  void
+  sort_ties();
+
   // The number of relative relocs added to this section.  This is to
   // support DT_RELCOUNT.
   size_t relative_reloc_count_;
   // Whether to sort the relocations when writing them out, to make
   // the dynamic linker more efficient.
   bool sort_relocs_;
+  // The keys used to sort the relocs.
+  Sort_keys sort_keys_;
+  // The number of chunks written out by tasks, or 0 if the relocs
+  // are written out by do_write.
+  unsigned int chunk_count_;
 };
 
+template<int size, bool big_endian>
+class Output_data_relr;
+
 // Output_data_reloc is used to manage a section containing relocs.
 // SH_TYPE is either elfcpp::SHT_REL or elfcpp::SHT_RELA.  DYNAMIC
 // indicates whether this is a dynamic relocation or a normal
@@ -1604,9 +1777,15 @@ class Output_data_reloc_base : public Output_data_reloc_generic
 
   // Construct the section.
   Output_data_reloc_base(bool sort_relocs)
-    : Output_data_reloc_generic(size, sort_relocs)
+    : Output_data_reloc_generic(size, sort_relocs), relr_(NULL)
   { }
 
+  // Pack the relative relocs added to this section into the SHT_RELR
+  // section RELR where possible, rather than adding them here.
+  void
+  set_relr_section(Output_data_relr<size, big_endian>* relr)
+  { this->relr_ = relr; }
+
  protected:
   // Write out the data.
   void
@@ -1618,22 +1797,43 @@ class Output_data_reloc_base : public Output_data_reloc_generic
   void
   do_write_generic(Output_file* of)
   {
-    const off_t off = this->offset();
-    const off_t oview_size = this->data_size();
-    unsigned char* const oview = of->get_output_view(off, oview_size);
+    // The relocs may have been written out by tasks.
+    if (this->is_written_by_tasks())
+      return;
+
+    const size_t count = this->relocs_.size();
+    gold_assert(static_cast<off_t>(count * reloc_size) == this->data_size());
 
     if (this->sort_relocs())
       {
 	gold_assert(dynamic);
-	std::sort(this->relocs_.begin(), this->relocs_.end(),
-		  Sort_relocs_comparison());
+	this->sort_relocs_serially(count);
       }
 
+    this->template write_reloc_range<Output_reloc_writer>(of, 0, count);
+
+    // We no longer need the relocation entries.
+    this->relocs_.clear();
+    this->clear_sort_keys();
+  }
+
+  // Write out the relocs from FIRST up to LAST, in sorted order if
+  // they have been sorted.  This may be called for different ranges
+  // at the same time.
+  template<class Output_reloc_writer>
+  void
+  write_reloc_range(Output_file* of, size_t first, size_t last)
+  {
+    const off_t off = this->offset() + first * reloc_size;
+    const off_t oview_size = (last - first) * reloc_size;
+    unsigned char* const oview = of->get_output_view(off, oview_size);
+
     unsigned char* pov = oview;
-    for (typename Relocs::const_iterator p = this->relocs_.begin();
-	 p != this->relocs_.end();
-	 ++p)
+    const bool sorted = this->have_sort_keys();
+    for (size_t i = first; i < last; ++i)
       {
+	typename Relocs::const_iterator p = this->relocs_.begin();
+	p += sorted ? this->sort_key(i).index : i;
 	Output_reloc_writer::write(p, pov);
 	pov += reloc_size;
       }
@@ -1641,11 +1841,24 @@ class Output_data_reloc_base : public Output_data_reloc_generic
     gold_assert(pov - oview == oview_size);
 
     of->write_output_view(off, oview_size, oview);
-
-    // We no longer need the relocation entries.
-    this->relocs_.clear();
   }
 
+  // Queue tasks to sort and write out the relocs in parallel.
+  void
+  do_queue_write_tasks(Workqueue*, Output_file*, Task_token* final_blocker);
+
+  // Set the sort keys of the relocs from FIRST up to LAST.
+  void
+  do_compute_sort_keys(size_t first, size_t last, Sort_key* keys);
+
+  // Sort relocs with the same MAJOR and ADDRESS sort key fields.
+  void
+  do_sort_key_ties(Sort_key* first, Sort_key* last);
+
+  // Write out the sorted relocs from FIRST up to LAST.
+  void
+  do_write_reloc_range(Output_file*, size_t first, size_t last);
+
   // Set the entry size and the link.
   void
   do_adjust_output_section(Output_section* os);
@@ -1664,6 +1877,14 @@ class Output_data_reloc_base : public Output_data_reloc_generic
   void
   add(Output_data* od, const Output_reloc_type& reloc)
   {
+    if (this->relr_ != NULL
+	&& reloc.is_relative()
+	&& this->relr_->add(reloc))
+      {
+	od->add_dynamic_reloc();
+	return;
+      }
+
     this->relocs_.push_back(reloc);
     this->set_current_data_size(this->relocs_.size() * reloc_size);
     if (dynamic)
@@ -1678,16 +1899,29 @@ class Output_data_reloc_base : public Output_data_reloc_generic
  private:
   typedef std::vector<Output_reloc_type> Relocs;
 
-  // The class used to sort the relocations.
-  struct Sort_relocs_comparison
+  // The class used to sort the sort keys of relocations which have
+  // the same symbol and address.
+  struct Sort_keys_comparison
   {
+    Sort_keys_comparison(const Relocs* relocs)
+      : relocs_(relocs)
+    { }
+
     bool
-    operator()(const Output_reloc_type& r1, const Output_reloc_type& r2) const
-    { return r1.sort_before(r2); }
+    operator()(const Sort_key& k1, const Sort_key& k2) const
+    {
+      const Output_reloc_type& r1((*this->relocs_)[k1.index]);
+      const Output_reloc_type& r2((*this->relocs_)[k2.index]);
+      return r1.sort_before(r2);
+    }
+
+    const Relocs* relocs_;
   };
 
   // The relocations in this section.
   Relocs relocs_;
+  // The SHT_RELR section for relative relocs, if any.
+  Output_data_relr<size, big_endian>* relr_;
 };
 
 // The class which callers actually create.
@@ -2344,6 +2578,121 @@ class Output_data_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
   }
 };
 
+// Output_data_relr is used to manage a section of relative relocs in
+// the compact SHT_RELR format, for -z pack-relative-relocs.  Each
+// entry is either the even address of a word to relocate, or an odd
+// bitmap saying which of the words after the previous entry to
+// relocate.  The relocs are kept in groups, one for each input
+// section or Output_data.  Each group is encoded starting with an
+// address entry of its own, so that the size of the section does
+// not depend on the addresses chosen by the layout.
+
+template<int size, bool big_endian>
+class Output_data_relr : public Output_section_data
+{
+ public:
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+  static const int word_size = size / 8;
+
+  // RELATIVE_TYPE is the target's RELATIVE reloc type.
+  Output_data_relr(unsigned int relative_type)
+    : Output_section_data(word_size), relative_type_(relative_type),
+      groups_(), input_section_groups_(), output_data_groups_()
+  { }
+
+  // Add the relative reloc RELOC.  Return false if it can not be
+  // packed, in which case it must be added to the RELA or REL
+  // section as usual.  This is called while the relocs of the object
+  // holding the reloc address, if any, are being scanned.
+  template<typename Output_reloc_type>
+  bool
+  add(const Output_reloc_type& reloc)
+  {
+    if (reloc.type() != this->relative_type_)
+      return false;
+    Relobj* relobj = reloc.get_relobj();
+    if (relobj != NULL)
+      return this->add_input_section_reloc(relobj, reloc.get_shndx(),
+					   reloc.get_offset());
+    return this->add_output_data_reloc(reloc.get_output_data(),
+				       reloc.get_offset());
+  }
+
+  // Return whether any reloc was packed.
+  bool
+  any_relocs() const
+  { return !this->groups_.empty(); }
+
+ protected:
+  // Set the final data size.
+  void
+  set_final_data_size();
+
+  // Write out the data.
+  void
+  do_write(Output_file*);
+
+  // Set the entry size.
+  void
+  do_adjust_output_section(Output_section* os);
+
+  // Write to a map file.
+  void
+  do_print_to_mapfile(Mapfile* mapfile) const
+  { mapfile->print_output_data(this, _("** relative relocs")); }
+
+ private:
+  // The relocs in one input section or Output_data.
+  struct Group
+  {
+    Group(Relobj* relobj_arg, unsigned int shndx_arg, Output_data* od_arg)
+      : relobj(relobj_arg), shndx(shndx_arg), od(od_arg), offsets()
+    { }
+
+    // The object holding the input section, or NULL.
+    Relobj* relobj;
+    // The index of the input section.
+    unsigned int shndx;
+    // The Output_data, if RELOBJ is NULL.
+    Output_data* od;
+    // The offsets of the relocs within the input section or
+    // Output_data.  These are sorted by set_final_data_size.
+    std::vector<Address> offsets;
+  };
+
+  typedef Unordered_map<Section_id, unsigned int, Section_id_hash>
+    Input_section_groups;
+  typedef Unordered_map<const Output_data*, unsigned int> Output_data_groups;
+
+  // Add a reloc at OFFSET within input section SHNDX of RELOBJ.
+  bool
+  add_input_section_reloc(Relobj* relobj, unsigned int shndx,
+			  Address offset);
+
+  // Add a reloc at OFFSET within OD.
+  bool
+  add_output_data_reloc(Output_data* od, Address offset);
+
+  // Return the address of a group.
+  Address
+  group_address(const Group&) const;
+
+  // Encode the sorted OFFSETS, relative to ADDRESS, into POV, which
+  // may be NULL.  Return the number of entries.
+  static size_t
+  encode(const std::vector<Address>& offsets, Address address,
+	 unsigned char* pov);
+
+  // The RELATIVE reloc type.
+  unsigned int relative_type_;
+  // The groups of relocs.
+  std::vector<Group> groups_;
+  // Map an input section to its group.
+  Input_section_groups input_section_groups_;
+  // Map an Output_data to its group.
+  Output_data_groups output_data_groups_;
+};
+
 // Output_relocatable_relocs represents a relocation section in a
 // relocatable link.  The actual data is written out in the target
 // hook relocate_relocs.  This just saves space for it.
@@ -3496,6 +3845,26 @@ class Output_section : public Output_data
   void
   sort_attached_input_sections();
 
+  // Requests for the names of input sections, grouped by object.
+  // Each entry is a section index and where to store its name.
+  typedef Unordered_map<Relobj*,
+			std::vector<std::pair<unsigned int, std::string*> > >
+    Section_name_requests;
+
+  // Prepare to sort the input sections and set their offsets in
+  // prefinalize_input_sections, before Layout::finalize.  Return
+  // false if that can not be done for this section.  Otherwise add
+  // to *REQUESTS the input section names needed to sort them; the
+  // names must be read before calling prefinalize_input_sections.
+  bool
+  prepare_to_prefinalize(Section_name_requests* requests);
+
+  // Sort the input sections and set their offsets, recording the
+  // results for set_final_data_size.  This does not look at any
+  // other output section, so it may be run in a task.
+  void
+  prefinalize_input_sections();
+
   // Return whether the input sections sections attachd to this output
   // section may require sorting.  This is used to handle constructor
   // priorities compatibly with GNU ld.
@@ -4090,6 +4459,21 @@ class Output_section : public Output_data
   void
   print_merge_stats();
 
+  // Queue tasks to merge the contents of merge sections in parallel.
+  void
+  queue_merge_tasks(Workqueue*, Task_token* final_blocker);
+
+  // Queue tasks to compress the contents of the section in parallel,
+  // once the contents of the input sections have been written.
+  void
+  queue_compress_tasks(Workqueue* workqueue, Task_token* final_blocker)
+  { this->do_queue_compress_tasks(workqueue, final_blocker); }
+
+  // Queue tasks to write the contents of the Output_section_data
+  // objects in this section in parallel.
+  void
+  queue_write_tasks(Workqueue*, Output_file*, Task_token* final_blocker);
+
   // Set a fixed layout for the section.  Used for incremental update links.
   void
   set_fixed_layout(uint64_t sh_addr, off_t sh_offset, off_t sh_size,
@@ -4202,6 +4586,12 @@ class Output_section : public Output_data
   virtual void
   do_write(Output_file*);
 
+  // Queue tasks to compress the section.  Only a section whose
+  // contents are compressed does anything here.
+  virtual void
+  do_queue_compress_tasks(Workqueue*, Task_token*)
+  { }
+
   // Return the address alignment--function required by parent class.
   uint64_t
   do_addralign() const
@@ -4372,6 +4762,54 @@ class Output_section : public Output_data
   // This class is used to sort the input sections.
   class Input_section_sort_entry;
 
+  // Sort SORT_LIST and copy the sorted input sections to *SORTED.
+  void
+  sort_input_section_list(std::vector<Input_section_sort_entry>* sort_list,
+			  Input_section_list* sorted);
+
+  // An Output_section_data laid out by prefinalize_input_sections,
+  // with its offset in the section and the size it had then.
+  struct Prefinalized_data
+  {
+    Prefinalized_data(Output_section_data* a_posd, off_t a_offset,
+		      off_t a_data_size)
+      : posd(a_posd), offset(a_offset), data_size(a_data_size)
+    { }
+
+    Output_section_data* posd;
+    off_t offset;
+    off_t data_size;
+  };
+
+  // The results of prefinalize_input_sections.
+  struct Prefinalized_input_sections
+  {
+    Prefinalized_input_sections()
+      : names(), sorted(), data(), count(0), first_input_offset(0),
+	data_size(-1)
+    { }
+
+    // The names of the input sections, if they are sorted by name.
+    std::vector<std::string> names;
+    // The sorted input sections, if they had to be sorted.
+    Input_section_list sorted;
+    // The Output_section_data entries, which still need addresses.
+    std::vector<Prefinalized_data> data;
+    // The number of input sections and the offset of the first one
+    // when they were laid out.
+    size_t count;
+    off_t first_input_offset;
+    // The total size of the input sections, or -1 if they have not
+    // been laid out yet.
+    off_t data_size;
+  };
+
+  // If the input sections were laid out by
+  // prefinalize_input_sections and nothing has changed since, use
+  // that layout, set *DATA_SIZE and return true.
+  bool
+  use_prefinalized_input_sections(off_t* data_size);
+
   // This is the sort comparison function for ctors and dtors.
   struct Input_section_sort_compare
   {
@@ -4624,6 +5062,8 @@ class Output_section : public Output_data
   uint64_t segment_alignment_;
   // Saved checkpoint.
   Checkpoint_output_section* checkpoint_;
+  // The results of prefinalize_input_sections, if it was run.
+  Prefinalized_input_sections* prefinalized_;
   // Fast lookup maps for merged and relaxed input sections.
   Output_section_lookup_maps* lookup_maps_;
   // List of available regions within the section, for incremental
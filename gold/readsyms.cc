@@ -576,6 +576,12 @@ Add_symbols::is_runnable()
     return this->this_blocker_;
   if (this->object_->is_locked())
     return this->object_->token();
+  // A dynamic object or a plugin object resolves its symbols right
+  // away, so it has to wait for any symbols of earlier relocatable
+  // objects which are still being resolved.
+  if ((this->object_->is_dynamic() || this->object_->pluginobj() != NULL)
+      && this->symtab_->resolve_blocker()->is_blocked())
+    return this->symtab_->resolve_blocker();
   return NULL;
 }
 
@@ -591,7 +597,7 @@ Add_symbols::locks(Task_locker* tl)
 // Add the symbols in the object to the symbol table.
 
 void
-Add_symbols::run(Workqueue*)
+Add_symbols::run(Workqueue* workqueue)
 {
   Pluginobj* pluginobj = this->object_->pluginobj();
   if (pluginobj != NULL)
@@ -602,7 +608,7 @@ Add_symbols::run(Workqueue*)
 
   if (!this->input_objects_->add_object(this->object_))
     {
-      this->object_->discard_decompressed_sections();
+      this->object_->discard_decompressed_sections(false);
       gold_assert(this->sd_ != NULL);
       delete this->sd_;
       this->sd_ = NULL;
@@ -632,8 +638,14 @@ Add_symbols::run(Workqueue*)
 					    this->library_, script_info);
 	}
       this->object_->layout(this->symtab_, this->layout_, this->sd_);
+      // The symbols of a relocatable object may be resolved by tasks
+      // of their own.
+      if (!this->object_->is_dynamic())
+	this->symtab_->set_resolve_workqueue(workqueue);
       this->object_->add_symbols(this->symtab_, this->sd_, this->layout_);
-      this->object_->discard_decompressed_sections();
+      this->symtab_->set_resolve_workqueue(NULL);
+      // The gdb index scan reads .debug_str after the object is laid out.
+      this->object_->discard_decompressed_sections(true);
       delete this->sd_;
       this->sd_ = NULL;
       this->object_->release();
@@ -793,6 +805,9 @@ Start_group::is_runnable()
 {
   if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
     return this->this_blocker_;
+  // We count the undefined symbols, so they must all be resolved.
+  if (this->symtab_->resolve_blocker()->is_blocked())
+    return this->symtab_->resolve_blocker();
   return NULL;
 }
 
@@ -827,6 +842,10 @@ Finish_group::is_runnable()
 {
   if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
     return this->this_blocker_;
+  // The archives are searched for the undefined symbols, so they
+  // must all be resolved.
+  if (this->symtab_->resolve_blocker()->is_blocked())
+    return this->symtab_->resolve_blocker();
   return NULL;
 }
 
@@ -929,6 +948,33 @@ Read_script::run(Workqueue* workqueue)
     }
 }
 
+// Class Wait_for_symbols.
+
+Wait_for_symbols::~Wait_for_symbols()
+{
+  if (this->this_blocker_ != NULL)
+    delete this->this_blocker_;
+}
+
+// We are blocked by this_blocker_, and by any symbols which are still
+// being resolved.
+
+Task_token*
+Wait_for_symbols::is_runnable()
+{
+  if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
+    return this->this_blocker_;
+  if (this->symtab_->resolve_blocker()->is_blocked())
+    return this->symtab_->resolve_blocker();
+  return NULL;
+}
+
+void
+Wait_for_symbols::locks(Task_locker* tl)
+{
+  tl->add(this, this->next_blocker_);
+}
+
 // Return a debugging name for a Read_script task.
 
 std::string
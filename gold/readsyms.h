@@ -486,6 +486,44 @@ class Read_script : public Task
   Task_token* next_blocker_;
 };
 
+// This class waits until the symbols of all the input files have been
+// resolved, which may still be going on after the last Add_symbols
+// task has run.  It runs after the last input file, and unblocks
+// NEXT_BLOCKER when the symbol table is complete.
+
+class Wait_for_symbols : public Task
+{
+ public:
+  Wait_for_symbols(Symbol_table* symtab, Task_token* this_blocker,
+		   Task_token* next_blocker)
+    : symtab_(symtab), this_blocker_(this_blocker),
+      next_blocker_(next_blocker)
+  { }
+
+  ~Wait_for_symbols();
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*)
+  { }
+
+  std::string
+  get_name() const
+  { return "Wait_for_symbols"; }
+
+ private:
+  Symbol_table* symtab_;
+  Task_token* this_blocker_;
+  Task_token* next_blocker_;
+};
+
 } // end namespace gold
 
 #endif // !defined(GOLD_READSYMS_H)
@@ -285,10 +285,7 @@ Symbol_table::resolve(Sized_symbol<size>* to,
       if (sym.get_st_type() == elfcpp::STT_COMMON
 	  && (is_ordinary || !Symbol::is_common_shndx(st_shndx)))
 	{
-	  gold_warning(_("STT_COMMON symbol '%s' in %s "
-			 "is not in a common section"),
-		       to->demangled_name().c_str(),
-		       to->object()->name().c_str());
+	  this->report_common_problem(to);
 	  return;
 	}
       // Record that we've seen this symbol in a regular object.
@@ -390,9 +387,9 @@ Symbol_table::resolve(Sized_symbol<size>* to,
   bool adjust_common_sizes;
   bool adjust_dyndef;
   typename Sized_symbol<size>::Size_type tosize = to->symsize();
-  if (Symbol_table::should_override(to, frombits, fromtype, OBJECT,
-				    object, &adjust_common_sizes,
-				    &adjust_dyndef, is_default_version))
+  if (this->should_override(to, frombits, fromtype, OBJECT,
+			    object, &adjust_common_sizes,
+			    &adjust_dyndef, is_default_version))
     {
       elfcpp::STB orig_tobinding = to->binding();
       typename Sized_symbol<size>::Value_type tovalue = to->value();
@@ -439,19 +436,19 @@ Symbol_table::resolve(Sized_symbol<size>* to,
   if (adjust_common_sizes && parameters->options().warn_common())
     {
       if (tosize > sym.get_st_size())
-	Symbol_table::report_resolve_problem(false,
-					     _("common of '%s' overriding "
-					       "smaller common"),
-					     to, OBJECT, object);
+	this->report_resolve_problem(false,
+				     _("common of '%s' overriding "
+				       "smaller common"),
+				     to, OBJECT, object);
       else if (tosize < sym.get_st_size())
-	Symbol_table::report_resolve_problem(false,
-					     _("common of '%s' overidden by "
-					       "larger common"),
-					     to, OBJECT, object);
+	this->report_resolve_problem(false,
+				     _("common of '%s' overidden by "
+				       "larger common"),
+				     to, OBJECT, object);
       else
-	Symbol_table::report_resolve_problem(false,
-					     _("multiple common of '%s'"),
-					     to, OBJECT, object);
+	this->report_resolve_problem(false,
+				     _("multiple common of '%s'"),
+				     to, OBJECT, object);
     }
 }
 
@@ -488,10 +485,10 @@ Symbol_table::should_override(const Symbol* to, unsigned int frombits,
 
   if ((to->type() == elfcpp::STT_TLS) ^ (fromtype == elfcpp::STT_TLS)
       && !to->is_placeholder())
-    Symbol_table::report_resolve_problem(true,
-					 _("symbol '%s' used as both __thread "
-					   "and non-__thread"),
-					 to, defined, object);
+    this->report_resolve_problem(true,
+				 _("symbol '%s' used as both __thread "
+				   "and non-__thread"),
+				 to, defined, object);
 
   // We use a giant switch table for symbol resolution.  This code is
   // unwieldy, but: 1) it is efficient; 2) we definitely handle all
@@ -531,9 +528,9 @@ Symbol_table::should_override(const Symbol* to, unsigned int frombits,
         return false;
 
       if (!parameters->options().muldefs())
-	Symbol_table::report_resolve_problem(true,
-					     _("multiple definition of '%s'"),
-					     to, defined, object);
+	this->report_resolve_problem(true,
+				     _("multiple definition of '%s'"),
+				     to, defined, object);
       return false;
 
     case WEAK_DEF * 16 + DEF:
@@ -570,10 +567,10 @@ Symbol_table::should_override(const Symbol* to, unsigned int frombits,
       // We've seen a common symbol and now we see a definition.  The
       // definition overrides.
       if (parameters->options().warn_common())
-	Symbol_table::report_resolve_problem(false,
-					     _("definition of '%s' overriding "
-					       "common"),
-					     to, defined, object);
+	this->report_resolve_problem(false,
+				     _("definition of '%s' overriding "
+				       "common"),
+				     to, defined, object);
       return true;
 
     case DEF * 16 + WEAK_DEF:
@@ -605,10 +602,10 @@ Symbol_table::should_override(const Symbol* to, unsigned int frombits,
       // A weak definition does override a definition in a dynamic
       // object.
       if (parameters->options().warn_common())
-	Symbol_table::report_resolve_problem(false,
-					     _("definition of '%s' overriding "
-					       "dynamic common definition"),
-					     to, defined, object);
+	this->report_resolve_problem(false,
+				     _("definition of '%s' overriding "
+				       "dynamic common definition"),
+				     to, defined, object);
       return true;
 
     case DEF * 16 + DYN_DEF:
@@ -781,10 +778,10 @@ Symbol_table::should_override(const Symbol* to, unsigned int frombits,
     case DEF * 16 + COMMON:
       // A common symbol does not override a definition.
       if (parameters->options().warn_common())
-	Symbol_table::report_resolve_problem(false,
-					     _("common '%s' overridden by "
-					       "previous definition"),
-					     to, defined, object);
+	this->report_resolve_problem(false,
+				     _("common '%s' overridden by "
+				       "previous definition"),
+				     to, defined, object);
       return false;
 
     case WEAK_DEF * 16 + COMMON:
@@ -934,20 +931,51 @@ Symbol_table::report_resolve_problem(bool is_error, const char* msg,
       gold_unreachable();
     }
 
-  if (is_error)
-    gold_error("%s: %s", objname, buf);
-  else
-    gold_warning("%s: %s", objname, buf);
-
+  std::string message(objname);
+  message += ": ";
+  message += buf;
   delete[] buf;
 
   if (to->source() == Symbol::FROM_OBJECT)
     objname = to->object()->name().c_str();
   else
     objname = _("command line");
+
+  // A Resolve_symbols task queues the problem, so that it comes out
+  // in the order of the input files.
+  if (this->defer_resolve_problem(to, is_error, message, objname))
+    return;
+
+  if (is_error)
+    gold_error("%s", message.c_str());
+  else
+    gold_warning("%s", message.c_str());
   gold_info("%s: %s: previous definition here", program_name, objname);
 }
 
+// Warn about the STT_COMMON symbol TO, which is not in a common
+// section.  Like report_resolve_problem, a Resolve_symbols task queues
+// the warning so that it comes out in the order of the input files.
+
+void
+Symbol_table::report_common_problem(const Symbol* to)
+{
+  std::string demangled(to->demangled_name());
+  const char* msg = _("STT_COMMON symbol '%s' in %s "
+		      "is not in a common section");
+  const std::string& objname(to->object()->name());
+  size_t len = strlen(msg) + demangled.length() + objname.length();
+  char* buf = new char[len];
+  snprintf(buf, len, msg, demangled.c_str(), objname.c_str());
+  std::string message(buf);
+  delete[] buf;
+
+  if (this->defer_resolve_problem(to, false, message, ""))
+    return;
+
+  gold_warning("%s", message.c_str());
+}
+
 // Completely override existing symbol.  Everything bar name_,
 // version_, and is_forced_local_ flag are copied.  version_ is
 // cleared if from->version_ is clear.  Returns true if this symbol
@@ -1015,9 +1043,9 @@ Symbol_table::should_override_with_special(const Symbol* to,
   bool adjust_common_sizes;
   bool adjust_dyn_def;
   unsigned int frombits = global_flag | regular_flag | def_flag;
-  bool ret = Symbol_table::should_override(to, frombits, fromtype, defined,
-					   NULL, &adjust_common_sizes,
-					   &adjust_dyn_def, false);
+  bool ret = this->should_override(to, frombits, fromtype, defined,
+				   NULL, &adjust_common_sizes,
+				   &adjust_dyn_def, false);
   gold_assert(!adjust_common_sizes && !adjust_dyn_def);
   return ret;
 }
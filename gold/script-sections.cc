@@ -37,6 +37,7 @@
 #include "script-c.h"
 #include "script.h"
 #include "script-sections.h"
+#include "glob-set.h"
 
 // Support for the SECTIONS clause in linker scripts.
 
@@ -1293,6 +1294,11 @@ class Output_section_element_input : public Output_section_element
   bool
   match_name(const char* file_name, const char* section_name, bool* keep) const;
 
+  // Add the section name patterns to SET with identifier ID.  If there
+  // are no patterns, every section name matches.
+  void
+  add_section_patterns(Glob_set* set, unsigned int id) const;
+
   // Set the section address.
   void
   set_section_addresses(Symbol_table* symtab, Layout* layout, Output_section*,
@@ -1309,13 +1315,11 @@ class Output_section_element_input : public Output_section_element
   struct Input_section_pattern
   {
     std::string pattern;
-    bool pattern_is_wildcard;
     Sort_wildcard sort;
 
     Input_section_pattern(const char* patterna, size_t patternlena,
 			  Sort_wildcard sorta)
       : pattern(patterna, patternlena),
-	pattern_is_wildcard(is_wildcard_string(this->pattern.c_str())),
 	sort(sorta)
     { }
   };
@@ -1352,6 +1356,9 @@ class Output_section_element_input : public Output_section_element
   Filename_exclusions filename_exclusions_;
   // The list of input section patterns.
   Input_section_patterns input_section_patterns_;
+  // The same patterns, identified by their index in
+  // input_section_patterns_.
+  Glob_set input_section_globs_;
   // Whether to keep this section when garbage collecting.
   bool keep_;
   // The value of dot after including all matching sections.
@@ -1373,6 +1380,7 @@ Output_section_element_input::Output_section_element_input(
     filename_sort_(spec->file.sort),
     filename_exclusions_(),
     input_section_patterns_(),
+    input_section_globs_(0),
     keep_(keep),
     final_dot_value_(0),
     final_dot_section_(NULL)
@@ -1404,8 +1412,12 @@ Output_section_element_input::Output_section_element_input(
 	     spec->input_sections.sections->begin();
 	   p != spec->input_sections.sections->end();
 	   ++p)
-	isp.push_back(Input_section_pattern(p->name.value, p->name.length,
-					    p->sort));
+	{
+	  this->input_section_globs_.add(p->name.value, p->name.length,
+					 isp.size());
+	  isp.push_back(Input_section_pattern(p->name.value, p->name.length,
+					      p->sort));
+	}
     }
 }
 
@@ -1461,17 +1473,23 @@ Output_section_element_input::match_name(const char* file_name,
     return true;
 
   // See whether we match the section name patterns.
+  unsigned int i;
+  return this->input_section_globs_.find_first(section_name, 0, &i);
+}
+
+// Add the section name patterns to SET.
+
+void
+Output_section_element_input::add_section_patterns(Glob_set* set,
+						   unsigned int id) const
+{
+  if (this->input_section_patterns_.empty())
+    set->add("*", 1, id);
   for (Input_section_patterns::const_iterator p =
 	 this->input_section_patterns_.begin();
        p != this->input_section_patterns_.end();
        ++p)
-    {
-      if (match(section_name, p->pattern.c_str(), p->pattern_is_wildcard))
-	return true;
-    }
-
-  // We didn't match any section names, so we didn't match.
-  return false;
+    set->add(p->pattern.data(), p->pattern.length(), id);
 }
 
 // Information we use to sort the input sections.
@@ -1737,15 +1755,10 @@ Output_section_element_input::set_section_addresses(
 	}
       else
 	{
-	  size_t i;
-	  for (i = 0; i < input_pattern_count; ++i)
-	    {
-	      const Input_section_pattern&
-		isp(this->input_section_patterns_[i]);
-	      if (match(isi.section_name().c_str(), isp.pattern.c_str(),
-			isp.pattern_is_wildcard))
-		break;
-	    }
+	  unsigned int i;
+	  if (!this->input_section_globs_.find_first(isi.section_name().c_str(),
+						     0, &i))
+	    i = input_pattern_count;
 
 	  if (i >= input_pattern_count)
 	    ++p;
@@ -2097,6 +2110,9 @@ class Output_section_definition : public Sections_element
   String_list* phdrs_;
   // The list of elements defining the section.
   Output_section_elements elements_;
+  // The section name patterns of the input section elements,
+  // identified by the index of the element in elements_.
+  Glob_set input_section_globs_;
   // The Output_section created for this definition.  This will be
   // NULL if none was created.
   Output_section* output_section_;
@@ -2127,6 +2143,7 @@ Output_section_definition::Output_section_definition(
     fill_(NULL),
     phdrs_(NULL),
     elements_(),
+    input_section_globs_(0),
     output_section_(NULL),
     evaluated_address_(0),
     evaluated_load_address_(0),
@@ -2209,7 +2226,10 @@ void
 Output_section_definition::add_input_section(const Input_section_spec* spec,
 					     bool keep)
 {
-  Output_section_element* p = new Output_section_element_input(spec, keep);
+  Output_section_element_input* p = new Output_section_element_input(spec,
+								     keep);
+  p->add_section_patterns(&this->input_section_globs_,
+			  this->elements_.size());
   this->elements_.push_back(p);
 }
 
@@ -2303,12 +2323,12 @@ Output_section_definition::output_section_name(
       return this->name_.c_str();
     }
 
-  // Ask each element whether it matches NAME.
-  for (Output_section_elements::const_iterator p = this->elements_.begin();
-       p != this->elements_.end();
-       ++p)
+  // Ask each element whose section patterns match NAME whether it
+  // matches.  Only input section elements can match.
+  unsigned int i = 0;
+  while (this->input_section_globs_.find_first(section_name, i, &i))
     {
-      if ((*p)->match_name(file_name, section_name, keep))
+      if (this->elements_[i]->match_name(file_name, section_name, keep))
 	{
 	  // We found a match for NAME, which means that it should go
 	  // into this output section.
@@ -2316,6 +2336,7 @@ Output_section_definition::output_section_name(
 	  *psection_type = this->section_type();
 	  return this->name_.c_str();
 	}
+      ++i;
     }
 
   // We don't know about this section name.
@@ -2652,13 +2673,58 @@ Output_section_definition::set_section_addresses(Symbol_table* symtab,
       *dot_value = address;
     }
 
+  // Each input section goes to the first element which matches it.
+  // Sort them out here, so that each element only has to look at its
+  // own sections rather than at every remaining section.
+  std::vector<Input_section_list> element_sections(this->elements_.size());
+  Input_section_list::iterator pis = input_sections.begin();
+  while (pis != input_sections.end())
+    {
+      Relobj* relobj = pis->relobj();
+      std::string section_name;
+      {
+	const Task* task = reinterpret_cast<const Task*>(-1);
+	Task_lock_obj<Object> tl(task, relobj);
+	section_name = relobj->section_name(pis->shndx());
+      }
+
+      unsigned int i = 0;
+      bool found = false;
+      while (this->input_section_globs_.find_first(section_name.c_str(), i,
+						   &i))
+	{
+	  bool keep;
+	  if (this->elements_[i]->match_name(relobj->name().c_str(),
+					     section_name.c_str(), &keep))
+	    {
+	      found = true;
+	      break;
+	    }
+	  ++i;
+	}
+
+      if (!found)
+	++pis;
+      else
+	{
+	  Input_section_list::iterator next = pis;
+	  ++next;
+	  element_sections[i].splice(element_sections[i].end(),
+				     input_sections, pis);
+	  pis = next;
+	}
+    }
+
   Output_section* dot_section = this->output_section_;
-  for (Output_section_elements::iterator p = this->elements_.begin();
-       p != this->elements_.end();
-       ++p)
-    (*p)->set_section_addresses(symtab, layout, this->output_section_,
-				subalign, dot_value, dot_alignment,
-				&dot_section, &fill, &input_sections);
+  for (size_t i = 0; i < this->elements_.size(); ++i)
+    {
+      this->elements_[i]->set_section_addresses(symtab, layout,
+						this->output_section_,
+						subalign, dot_value,
+						dot_alignment, &dot_section,
+						&fill, &element_sections[i]);
+      gold_assert(element_sections[i].empty());
+    }
 
   gold_assert(input_sections.empty());
 
@@ -229,12 +229,25 @@ class Stringpool_template
   const Stringpool_char*
   add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey);
 
+  // Add string S of length LEN characters to the pool, where
+  // HASH_CODE is gold::string_hash(S, LEN).  This saves hashing the
+  // string again when the caller has already done so.
+  const Stringpool_char*
+  add_with_hash(const Stringpool_char* s, size_t len, size_t hash_code,
+		bool copy, Key* pkey);
+
   // If the string S is present in the pool, return the canonical
   // string pointer.  Otherwise, return NULL.  If PKEY is not NULL,
   // set *PKEY to the key.
   const Stringpool_char*
   find(const Stringpool_char* s, Key* pkey) const;
 
+  // Like find, for string S of length LEN characters whose hash code
+  // is HASH_CODE.
+  const Stringpool_char*
+  find_with_hash(const Stringpool_char* s, size_t len, size_t hash_code,
+		 Key* pkey) const;
+
   // Turn the stringpool into a string table: determine the offsets of
   // all the strings.  After this is called, no more strings may be
   // added to the stringpool.
@@ -353,6 +366,10 @@ class Stringpool_template
     Hashkey(const Stringpool_char* s, size_t len)
       : string(s), length(len), hash_code(string_hash(s, len))
     { }
+
+    Hashkey(const Stringpool_char* s, size_t len, size_t hash)
+      : string(s), length(len), hash_code(hash)
+    { }
   };
 
   // Hash function.  This is trivial, since we have already computed
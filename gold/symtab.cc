@@ -37,6 +37,7 @@
 #include "output.h"
 #include "target.h"
 #include "workqueue.h"
+#include "gold-threads.h"
 #include "symtab.h"
 #include "script.h"
 #include "plugin.h"
@@ -565,17 +566,29 @@ Symbol::set_undefined()
 
 Symbol_table::Symbol_table(unsigned int count,
                            const Version_script_info& version_script)
-  : saw_undefined_(0), offset_(0), table_(count), namepool_(),
-    forwarders_(), commons_(), tls_commons_(), small_commons_(),
-    large_commons_(), forced_locals_(), warnings_(),
-    version_script_(version_script), gc_(NULL), icf_(NULL),
+  : offset_(0), forwarders_(), forwarders_lock_(new Lock()),
+    weak_aliases_(), resolve_workqueue_(NULL),
+    resolve_blocker_(new Task_token(true)), pending_lock_(new Lock()),
+    pending_count_(0), resolved_pending_(), next_pending_report_(0),
+    warnings_(), version_script_(version_script), gc_(NULL), icf_(NULL),
     target_symbols_()
 {
-  namepool_.reserve(count);
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      Symbol_table_shard* shard = &this->shards_[i];
+      reserve_unordered_map(&shard->table, count / shard_count);
+      shard->namepool.reserve(count / shard_count);
+      shard->lock = new Lock();
+    }
 }
 
 Symbol_table::~Symbol_table()
 {
+  for (unsigned int i = 0; i < shard_count; ++i)
+    delete this->shards_[i].lock;
+  delete this->forwarders_lock_;
+  delete this->resolve_blocker_;
+  delete this->pending_lock_;
 }
 
 // The symbol table key equality function.  This is called with
@@ -664,13 +677,31 @@ Symbol_table::gc_mark_symbol(Symbol* sym)
 }
 
 // When doing garbage collection, keep symbols that have been seen in
-// dynamic objects.
+// dynamic objects.  The symbols are only recorded here, since the
+// shard may be resolved in the background; gc_mark_added_symbols
+// marks them.
 inline void 
-Symbol_table::gc_mark_dyn_syms(Symbol* sym)
+Symbol_table::gc_mark_dyn_syms(Symbol_table_shard* shard, Symbol* sym)
 {
   if (sym->in_dyn() && sym->source() == Symbol::FROM_OBJECT
       && !sym->object()->is_dynamic())
-    this->gc_mark_symbol(sym);
+    shard->gc_symbols.push_back(sym);
+}
+
+// Mark the symbols recorded while adding symbols.
+
+void
+Symbol_table::gc_mark_added_symbols()
+{
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      std::vector<Symbol*>* gc_symbols = &this->shards_[i].gc_symbols;
+      for (std::vector<Symbol*>::const_iterator p = gc_symbols->begin();
+	   p != gc_symbols->end();
+	   ++p)
+	this->gc_mark_symbol(*p);
+      gc_symbols->clear();
+    }
 }
 
 // Make TO a symbol which forwards to FROM.
@@ -680,7 +711,10 @@ Symbol_table::make_forwarder(Symbol* from, Symbol* to)
 {
   gold_assert(from != to);
   gold_assert(!from->is_forwarder() && !to->is_forwarder());
-  this->forwarders_[from] = to;
+  {
+    Hold_lock hl(*this->forwarders_lock_);
+    this->forwarders_[from] = to;
+  }
   from->set_forwarder();
 }
 
@@ -701,26 +735,52 @@ Symbol_table::resolve_forwards(const Symbol* from) const
 Symbol*
 Symbol_table::lookup(const char* name, const char* version) const
 {
+  size_t len = strlen(name);
+  size_t hash_code = gold::string_hash<char>(name, len);
+  const Symbol_table_shard* shard = &this->shards_[shard_index(hash_code)];
+
   Stringpool::Key name_key;
-  name = this->namepool_.find(name, &name_key);
+  name = shard->namepool.find_with_hash(name, len, hash_code, &name_key);
   if (name == NULL)
     return NULL;
 
   Stringpool::Key version_key = 0;
   if (version != NULL)
     {
-      version = this->namepool_.find(version, &version_key);
+      version = shard->namepool.find(version, &version_key);
       if (version == NULL)
 	return NULL;
     }
 
   Symbol_table_key key(name_key, version_key);
-  Symbol_table::Symbol_table_type::const_iterator p = this->table_.find(key);
-  if (p == this->table_.end())
+  Symbol_table::Symbol_table_type::const_iterator p = shard->table.find(key);
+  if (p == shard->table.end())
     return NULL;
   return p->second;
 }
 
+// Canonicalize a symbol name.  This may be called while symbols are
+// resolved in the background.
+
+const char*
+Symbol_table::canonicalize_name(const char* name)
+{
+  Symbol_table_shard* shard = this->get_shard(name);
+  Hold_lock hl(*shard->lock);
+  return shard->namepool.add(name, true, NULL);
+}
+
+// Return the count of undefined symbols seen.
+
+size_t
+Symbol_table::saw_undefined() const
+{
+  size_t count = 0;
+  for (unsigned int i = 0; i < shard_count; ++i)
+    count += this->shards_[i].saw_undefined;
+  return count;
+}
+
 // Resolve a Symbol with another Symbol.  This is only used in the
 // unusual case where there are references to both an unversioned
 // symbol and a symbol with a version, and we then discover that that
@@ -746,8 +806,6 @@ Symbol_table::resolve(Sized_symbol<size>* to, const Sized_symbol<size>* from)
     to->set_in_reg();
   if (from->in_dyn())
     to->set_in_dyn();
-  if (parameters->options().gc_sections())
-    this->gc_mark_dyn_syms(to);
 }
 
 // Record that a symbol is forced to be local by a version script or
@@ -755,6 +813,12 @@ Symbol_table::resolve(Sized_symbol<size>* to, const Sized_symbol<size>* from)
 
 void
 Symbol_table::force_local(Symbol* sym)
+{
+  this->force_local(this->get_shard(sym->name()), sym);
+}
+
+void
+Symbol_table::force_local(Symbol_table_shard* shard, Symbol* sym)
 {
   if (!sym->is_defined() && !sym->is_common())
     return;
@@ -764,15 +828,16 @@ Symbol_table::force_local(Symbol* sym)
       return;
     }
   sym->set_is_forced_local();
-  this->forced_locals_.push_back(sym);
+  shard->forced_locals.push_back(sym);
 }
 
-// Adjust NAME for wrapping, and update *NAME_KEY if necessary.  This
-// is only called for undefined symbols, when at least one --wrap
-// option was used.
+// Adjust NAME for wrapping, and update *PSHARD and *NAME_KEY if
+// necessary.  This is only called for undefined symbols, when at
+// least one --wrap option was used.
 
 const char*
-Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key)
+Symbol_table::wrap_symbol(const char* name, Symbol_table_shard** pshard,
+			  Stringpool::Key* name_key)
 {
   // For some targets, we need to ignore a specific character when
   // wrapping, and add it back later.
@@ -792,10 +857,10 @@ Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key)
       s += "__wrap_";
       s += name;
 
-      // This will give us both the old and new name in NAMEPOOL_, but
-      // that is OK.  Only the versions we need will wind up in the
-      // real string table in the output file.
-      return this->namepool_.add(s.c_str(), true, name_key);
+      // This will give us both the old and new name in the string
+      // pools, but that is OK.  Only the versions we need will wind up
+      // in the real string table in the output file.
+      return this->add_name(s.c_str(), s.length(), pshard, name_key);
     }
 
   const char* const real_prefix = "__real_";
@@ -808,7 +873,7 @@ Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key)
       if (prefix != '\0')
 	s += prefix;
       s += name + real_prefix_length;
-      return this->namepool_.add(s.c_str(), true, name_key);
+      return this->add_name(s.c_str(), s.length(), pshard, name_key);
     }
 
   return name;
@@ -818,11 +883,13 @@ Symbol_table::wrap_symbol(const char* name, Stringpool::Key* name_key)
 // already exists in the symbol table, and VERSION is marked as being
 // the default version.  SYM is the NAME/VERSION symbol we just added.
 // DEFAULT_IS_NEW is true if this is the first time we have seen the
-// symbol NAME/NULL.  PDEF points to the entry for NAME/NULL.
+// symbol NAME/NULL.  PDEF points to the entry for NAME/NULL in the
+// table of SHARD.
 
 template<int size, bool big_endian>
 void
-Symbol_table::define_default_version(Sized_symbol<size>* sym,
+Symbol_table::define_default_version(Symbol_table_shard* shard,
+				     Sized_symbol<size>* sym,
 				     bool default_is_new,
 				     Symbol_table_type::iterator pdef)
 {
@@ -891,6 +958,8 @@ Symbol_table::define_default_version(Sized_symbol<size>* sym,
 	  const Sized_symbol<size>* symdef;
 	  symdef = this->get_sized_symbol<size>(pdef->second);
 	  Symbol_table::resolve<size, big_endian>(sym, symdef);
+	  if (parameters->options().gc_sections())
+	    this->gc_mark_dyn_syms(shard, sym);
 	  this->make_forwarder(pdef->second, sym);
 	  pdef->second = sym;
 	  sym->set_is_default();
@@ -899,7 +968,8 @@ Symbol_table::define_default_version(Sized_symbol<size>* sym,
 }
 
 // Add one symbol from OBJECT to the symbol table.  NAME is symbol
-// name and VERSION is the version; both are canonicalized.  DEF is
+// name and VERSION is the version; both are canonicalized in SHARD,
+// the shard for NAME.  DEF is
 // whether this is the default version.  ST_SHNDX is the symbol's
 // section index; IS_ORDINARY is whether this is a normal section
 // rather than a special code.
@@ -930,7 +1000,8 @@ Symbol_table::define_default_version(Sized_symbol<size>* sym,
 
 template<int size, bool big_endian>
 Sized_symbol<size>*
-Symbol_table::add_from_object(Object* object,
+Symbol_table::add_from_object(Symbol_table_shard* shard,
+			      Object* object,
 			      const char* name,
 			      Stringpool::Key name_key,
 			      const char* version,
@@ -955,7 +1026,7 @@ Symbol_table::add_from_object(Object* object,
   if (orig_st_shndx == elfcpp::SHN_UNDEF
       && parameters->options().any_wrap())
     {
-      const char* wrap_name = this->wrap_symbol(name, &name_key);
+      const char* wrap_name = this->wrap_symbol(name, &shard, &name_key);
       if (wrap_name != name)
 	{
 	  // If we see a reference to malloc with version GLIBC_2.0,
@@ -969,19 +1040,20 @@ Symbol_table::add_from_object(Object* object,
 	}
     }
 
+  Symbol_table_type* table = &shard->table;
   Symbol* const snull = NULL;
   std::pair<typename Symbol_table_type::iterator, bool> ins =
-    this->table_.insert(std::make_pair(std::make_pair(name_key, version_key),
-				       snull));
+    table->insert(std::make_pair(std::make_pair(name_key, version_key),
+				 snull));
 
   std::pair<typename Symbol_table_type::iterator, bool> insdefault =
-    std::make_pair(this->table_.end(), false);
+    std::make_pair(table->end(), false);
   if (is_default_version)
     {
       const Stringpool::Key vnull_key = 0;
-      insdefault = this->table_.insert(std::make_pair(std::make_pair(name_key,
-								     vnull_key),
-						      snull));
+      insdefault = table->insert(std::make_pair(std::make_pair(name_key,
+							       vnull_key),
+						snull));
     }
 
   // ins.first: an iterator, which is a pointer to a pair.
@@ -1005,10 +1077,11 @@ Symbol_table::add_from_object(Object* object,
       this->resolve(ret, sym, st_shndx, is_ordinary, orig_st_shndx, object,
 		    version, is_default_version);
       if (parameters->options().gc_sections())
-        this->gc_mark_dyn_syms(ret);
+        this->gc_mark_dyn_syms(shard, ret);
 
       if (is_default_version)
-	this->define_default_version<size, big_endian>(ret, insdefault.second,
+	this->define_default_version<size, big_endian>(shard, ret,
+						       insdefault.second,
 						       insdefault.first);
       else
 	{
@@ -1034,7 +1107,7 @@ Symbol_table::add_from_object(Object* object,
 	      // (See PR gold/18703.)
 	      ret->set_is_not_default();
 	      const Stringpool::Key vnull_key = 0;
-	      this->table_.erase(std::make_pair(name_key, vnull_key));
+	      table->erase(std::make_pair(name_key, vnull_key));
 	    }
 	}
     }
@@ -1079,7 +1152,7 @@ Symbol_table::add_from_object(Object* object,
 	      this->resolve(ret, sym, st_shndx, is_ordinary, orig_st_shndx,
 			    object, version, is_default_version);
 	      if (parameters->options().gc_sections())
-		this->gc_mark_dyn_syms(ret);
+		this->gc_mark_dyn_syms(shard, ret);
 	      ins.first->second = ret;
 	    }
 	}
@@ -1102,13 +1175,12 @@ Symbol_table::add_from_object(Object* object,
 		  // This means that we don't want a symbol table
 		  // entry after all.
 		  if (!is_default_version)
-		    this->table_.erase(ins.first);
+		    table->erase(ins.first);
 		  else
 		    {
-		      this->table_.erase(insdefault.first);
+		      table->erase(insdefault.first);
 		      // Inserting INSDEFAULT invalidated INS.
-		      this->table_.erase(std::make_pair(name_key,
-							version_key));
+		      table->erase(std::make_pair(name_key, version_key));
 		    }
 		  return NULL;
 		}
@@ -1135,7 +1207,7 @@ Symbol_table::add_from_object(Object* object,
   // because undefined symbols only in dynamic objects should't trigger rescans.
   if (!was_undefined_in_reg && ret->is_undefined() && ret->in_reg())
     {
-      ++this->saw_undefined_;
+      ++shard->saw_undefined;
       if (parameters->options().has_plugins())
 	parameters->options().plugins()->new_undefined_symbol(ret);
     }
@@ -1147,15 +1219,15 @@ Symbol_table::add_from_object(Object* object,
   if (!was_common && ret->is_common() && ret->object()->pluginobj() == NULL)
     {
       if (ret->type() == elfcpp::STT_TLS)
-	this->tls_commons_.push_back(ret);
+	shard->tls_commons.push_back(ret);
       else if (!is_ordinary
 	       && st_shndx == parameters->target().small_common_shndx())
-	this->small_commons_.push_back(ret);
+	shard->small_commons.push_back(ret);
       else if (!is_ordinary
 	       && st_shndx == parameters->target().large_common_shndx())
-	this->large_commons_.push_back(ret);
+	shard->large_commons.push_back(ret);
       else
-	this->commons_.push_back(ret);
+	shard->commons.push_back(ret);
     }
 
   // If we're not doing a relocatable link, then any symbol with
@@ -1166,12 +1238,383 @@ Symbol_table::add_from_object(Object* object,
 	  || ret->binding() == elfcpp::STB_GNU_UNIQUE
 	  || ret->binding() == elfcpp::STB_WEAK)
       && !parameters->options().relocatable())
-    this->force_local(ret);
+    this->force_local(shard, ret);
 
   return ret;
 }
 
-// Add all the symbols in a relocatable object to the hash table.
+// The global symbols of one relocatable object which add_from_relobj
+// has left to be resolved in the background, grouped by shard.  The
+// symbols and their names are copied, since the object's views are
+// released before the symbols are resolved.
+
+struct Pending_symbols
+{
+  // One symbol.
+  struct Entry
+  {
+    // The index of the symbol in SYMPOINTERS and SYMS.
+    unsigned int index;
+    // The offset and length of the symbol name in NAMES.
+    unsigned int name;
+    unsigned int namelen;
+    // The hash code of the symbol name.
+    size_t name_hash;
+    // The offset and length of the version in NAMES; VERSION is -1U
+    // if there is no version.
+    unsigned int version;
+    unsigned int verlen;
+    // The arguments to add_relobj_symbol.
+    unsigned int st_shndx;
+    unsigned int orig_st_shndx;
+    bool is_ordinary;
+    bool is_default_version;
+    bool is_forced_local;
+    bool is_defined_in_discarded_section;
+  };
+
+  // A problem found while resolving one of the symbols.
+  struct Problem
+  {
+    // The index of the symbol.
+    unsigned int index;
+    // Whether this is an error rather than a warning.
+    bool is_error;
+    // The message, and the file of the previous definition, which is
+    // empty if the problem does not involve one.
+    std::string message;
+    std::string previous;
+  };
+
+  Pending_symbols(Relobj* a_object, Relobj::Symbols* a_sympointers)
+    : object(a_object), sympointers(a_sympointers), syms(), names(),
+      entries(), shard_start(), refs(0), serial(0), problems()
+  { }
+
+  // The object the symbols come from.
+  Relobj* object;
+  // Where to store the resolved symbols.
+  Relobj::Symbols* sympointers;
+  // A copy of the symbols.
+  std::vector<unsigned char> syms;
+  // A copy of the symbol names and versions.
+  std::string names;
+  // The symbols, sorted by shard and then by index.
+  std::vector<Entry> entries;
+  // The index in ENTRIES of the first symbol of each shard, followed
+  // by the number of entries.
+  std::vector<unsigned int> shard_start;
+  // The number of shards which have not resolved their symbols yet.
+  unsigned int refs;
+  // The position of the object among those whose symbols are
+  // resolved in the background.
+  unsigned int serial;
+  // The problems found while resolving the symbols, which are
+  // reported in the order of the input files.
+  std::vector<Problem> problems;
+};
+
+// Sort the problems of a Pending_symbols by symbol index.
+
+struct Pending_problem_compare
+{
+  bool
+  operator()(const Pending_symbols::Problem& a,
+	     const Pending_symbols::Problem& b) const
+  { return a.index < b.index; }
+};
+
+// A task which resolves the deferred symbols of one shard of the
+// symbol table.  The shard is only worked on by one of these at a
+// time, so its symbols are resolved in the order in which their
+// objects were added, on every run.
+
+class Resolve_symbols : public Task
+{
+ public:
+  Resolve_symbols(Symbol_table* symtab, unsigned int shard)
+    : symtab_(symtab), shard_(shard)
+  { }
+
+  // The blocker was incremented when this task was queued.
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->symtab_->resolve_blocker()); }
+
+  void
+  run(Workqueue*)
+  { this->symtab_->resolve_shard(this->shard_); }
+
+  std::string
+  get_name() const
+  { return "Resolve_symbols"; }
+
+ private:
+  Symbol_table* symtab_;
+  unsigned int shard_;
+};
+
+// Return whether add_from_relobj may leave the symbols of an object
+// to be resolved in the background.  That only pays off with
+// threads, and it is only safe when resolving a symbol never looks at
+// a symbol with a different name: --wrap renames symbols, weak
+// aliases from a dynamic object are overridden together, and some
+// targets keep their own symbol state.  The files added by a plugin
+// are read after the symbols have been waited for, incremental links
+// and -r look symbols up while adding objects, --trace-symbol
+// messages have to come out in order, and --detect-odr-violations
+// collects the candidates in a map shared by all the shards.
+
+bool
+Symbol_table::can_defer_resolution() const
+{
+  return (parameters->options().threads()
+	  && !parameters->options().relocatable()
+	  && !parameters->options().any_wrap()
+	  && !parameters->options().any_trace_symbol()
+	  && !parameters->options().detect_odr_violations()
+	  && (!parameters->options().has_plugins()
+	      || !parameters->options().plugins()->in_replacement_phase())
+	  && !parameters->incremental()
+	  && !parameters->target().has_make_symbol()
+	  && !parameters->target().has_resolve()
+	  && this->weak_aliases_.empty());
+}
+
+// Turn deferred resolution on or off.
+
+void
+Symbol_table::set_resolve_workqueue(Workqueue* workqueue)
+{
+  if (workqueue != NULL && !this->can_defer_resolution())
+    workqueue = NULL;
+  this->resolve_workqueue_ = workqueue;
+}
+
+// Resolve the deferred symbols of shard SHARD.
+
+void
+Symbol_table::resolve_shard(unsigned int shard)
+{
+  Symbol_table_shard* pshard = &this->shards_[shard];
+  while (true)
+    {
+      Pending_symbols* pending;
+      {
+	Hold_lock hl(*pshard->lock);
+	if (pshard->pending.empty())
+	  {
+	    pshard->is_resolving = false;
+	    return;
+	  }
+	pending = pshard->pending.front();
+	pshard->pending.pop_front();
+
+	switch (parameters->size_and_endianness())
+	  {
+#ifdef HAVE_TARGET_32_LITTLE
+	  case Parameters::TARGET_32_LITTLE:
+	    this->resolve_pending<32, false>(shard, pending);
+	    break;
+#endif
+#ifdef HAVE_TARGET_32_BIG
+	  case Parameters::TARGET_32_BIG:
+	    this->resolve_pending<32, true>(shard, pending);
+	    break;
+#endif
+#ifdef HAVE_TARGET_64_LITTLE
+	  case Parameters::TARGET_64_LITTLE:
+	    this->resolve_pending<64, false>(shard, pending);
+	    break;
+#endif
+#ifdef HAVE_TARGET_64_BIG
+	  case Parameters::TARGET_64_BIG:
+	    this->resolve_pending<64, true>(shard, pending);
+	    break;
+#endif
+	  default:
+	    gold_unreachable();
+	  }
+      }
+
+      Hold_lock hl(*this->pending_lock_);
+      gold_assert(pending->refs > 0);
+      --pending->refs;
+      if (pending->refs == 0)
+	this->report_deferred_problems(pending);
+    }
+}
+
+// If the symbol TO is being resolved by a Resolve_symbols task, queue
+// the problem found while resolving it and return true.  The problems
+// of the different shards are reported together once all the earlier
+// objects have been resolved, so the messages come out in the same
+// order as when the symbols are resolved one at a time.
+
+bool
+Symbol_table::defer_resolve_problem(const Symbol* to, bool is_error,
+				    const std::string& message,
+				    const std::string& previous)
+{
+  // The caller holds the lock of the shard, so RESOLVING is stable.
+  Symbol_table_shard* shard = this->get_shard(to->name());
+  Pending_symbols* pending = shard->resolving;
+  if (pending == NULL)
+    return false;
+
+  Pending_symbols::Problem problem;
+  problem.index = shard->resolving_index;
+  problem.is_error = is_error;
+  problem.message = message;
+  problem.previous = previous;
+
+  Hold_lock hl(*this->pending_lock_);
+  pending->problems.push_back(problem);
+  return true;
+}
+
+// PENDING has been resolved by all of its shards.  Report its
+// problems and those of the later objects which are already done, as
+// long as no earlier object is still being resolved, and free them.
+
+void
+Symbol_table::report_deferred_problems(Pending_symbols* pending)
+{
+  if (pending->serial != this->next_pending_report_)
+    {
+      // Only the problems are needed from here on.
+      std::vector<unsigned char>().swap(pending->syms);
+      std::string().swap(pending->names);
+      std::vector<Pending_symbols::Entry>().swap(pending->entries);
+      this->resolved_pending_[pending->serial] = pending;
+      return;
+    }
+
+  while (true)
+    {
+      std::stable_sort(pending->problems.begin(), pending->problems.end(),
+		       Pending_problem_compare());
+      for (std::vector<Pending_symbols::Problem>::const_iterator p =
+	     pending->problems.begin();
+	   p != pending->problems.end();
+	   ++p)
+	{
+	  if (p->is_error)
+	    gold_error("%s", p->message.c_str());
+	  else
+	    gold_warning("%s", p->message.c_str());
+	  if (!p->previous.empty())
+	    gold_info("%s: %s: previous definition here", program_name,
+		      p->previous.c_str());
+	}
+      delete pending;
+      ++this->next_pending_report_;
+
+      std::map<unsigned int, Pending_symbols*>::iterator p =
+	this->resolved_pending_.find(this->next_pending_report_);
+      if (p == this->resolved_pending_.end())
+	return;
+      pending = p->second;
+      this->resolved_pending_.erase(p);
+    }
+}
+
+// Resolve the symbols of PENDING which belong to shard SHARD.  This
+// is called with the shard lock held.
+
+template<int size, bool big_endian>
+void
+Symbol_table::resolve_pending(unsigned int shard, Pending_symbols* pending)
+{
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+  Symbol_table_shard* pshard = &this->shards_[shard];
+  const char* names = pending->names.data();
+  const unsigned char* syms = &pending->syms[0];
+  unsigned int end = pending->shard_start[shard + 1];
+  for (unsigned int i = pending->shard_start[shard]; i < end; ++i)
+    {
+      const Pending_symbols::Entry& e(pending->entries[i]);
+      elfcpp::Sym<size, big_endian> sym(syms + e.index * sym_size);
+      const char* ver = (e.version == -1U ? NULL : names + e.version);
+      pshard->resolving = pending;
+      pshard->resolving_index = e.index;
+      this->add_relobj_symbol(pshard, pending->object, names + e.name,
+			      e.namelen, e.name_hash, ver, e.verlen,
+			      e.is_default_version, e.is_forced_local,
+			      e.is_defined_in_discarded_section, sym,
+			      e.st_shndx, e.is_ordinary, e.orig_st_shndx,
+			      &(*pending->sympointers)[e.index]);
+    }
+  pshard->resolving = NULL;
+}
+
+// Add one symbol from a relocatable object to the symbol table.  This
+// is the part of add_from_relobj which may be deferred.
+
+template<int size, bool big_endian>
+void
+Symbol_table::add_relobj_symbol(Symbol_table_shard* shard,
+				Object* object,
+				const char* name,
+				size_t namelen,
+				size_t name_hash,
+				const char* ver,
+				size_t verlen,
+				bool is_default_version,
+				bool is_forced_local,
+				bool is_defined_in_discarded_section,
+				const elfcpp::Sym<size, big_endian>& sym,
+				unsigned int st_shndx,
+				bool is_ordinary,
+				unsigned int orig_st_shndx,
+				Symbol** sympointer)
+{
+  Stringpool::Key ver_key = 0;
+  if (ver != NULL)
+    ver = shard->namepool.add_with_length(ver, verlen, true, &ver_key);
+
+  Stringpool::Key name_key;
+  name = shard->namepool.add_with_hash(name, namelen, name_hash, true,
+				       &name_key);
+
+  Sized_symbol<size>* res;
+  res = this->add_from_object(shard, object, name, name_key, ver, ver_key,
+			      is_default_version, sym, st_shndx,
+			      is_ordinary, orig_st_shndx);
+
+  if (res == NULL)
+    return;
+
+  // Only undefined symbols are wrapped, so SHARD is still the shard
+  // of RES if it is forced local.
+  if (is_forced_local)
+    this->force_local(shard, res);
+
+  // Do not treat this symbol as garbage if this symbol will be
+  // exported to the dynamic symbol table.  This is true when
+  // building a shared library or using --export-dynamic and
+  // the symbol is externally visible.
+  if (parameters->options().gc_sections()
+      && res->is_externally_visible()
+      && !res->is_from_dynobj()
+      && (parameters->options().shared()
+	  || parameters->options().export_dynamic()
+	  || parameters->options().in_dynamic_list(res->name())))
+    shard->gc_symbols.push_back(res);
+
+  if (is_defined_in_discarded_section)
+    res->set_is_defined_in_discarded_section();
+
+  *sympointer = res;
+}
+
+// Add all the symbols in a relocatable object to the hash table.  If
+// a resolve workqueue is set, the names are only split up here, and
+// the symbols are resolved by Resolve_symbols tasks.
 
 template<int size, bool big_endian>
 void
@@ -1193,6 +1636,16 @@ Symbol_table::add_from_relobj(
 
   const bool just_symbols = relobj->just_symbols();
 
+  Pending_symbols* pending = NULL;
+  std::vector<unsigned int> shards;
+  if (this->resolve_workqueue_ != NULL)
+    {
+      pending = new Pending_symbols(relobj, sympointers);
+      pending->syms.assign(syms, syms + count * sym_size);
+      shards.reserve(count);
+    }
+  std::vector<Pending_symbols::Entry> entries;
+
   const unsigned char* p = syms;
   for (size_t i = 0; i < count; ++i, p += sym_size)
     {
@@ -1244,12 +1697,14 @@ Symbol_table::add_from_relobj(
       // name from the version name.  If there are two '@' characters,
       // this is the default version.
       const char* ver = strchr(name, '@');
-      Stringpool::Key ver_key = 0;
+      size_t verlen = 0;
       int namelen = 0;
       // IS_DEFAULT_VERSION: is the version default?
       // IS_FORCED_LOCAL: is the symbol forced local?
       bool is_default_version = false;
       bool is_forced_local = false;
+      // The version assigned by the version script, if any.
+      std::string version;
 
       // FIXME: For incremental links, we don't store version information,
       // so we need to ignore version symbols for now.
@@ -1269,7 +1724,7 @@ Symbol_table::add_from_relobj(
 	      is_default_version = true;
 	      ++ver;
 	    }
-	  ver = this->namepool_.add(ver, true, &ver_key);
+	  verlen = strlen(ver);
         }
       // We don't want to assign a version to an undefined symbol,
       // even if it is listed in the version script.  FIXME: What
@@ -1282,7 +1737,6 @@ Symbol_table::add_from_relobj(
 	    {
 	      // The symbol name did not have a version, but the
 	      // version script may assign a version anyway.
-	      std::string version;
 	      bool is_global;
 	      if (this->version_script_.get_symbol_version(name, &version,
 							   &is_global))
@@ -1291,10 +1745,8 @@ Symbol_table::add_from_relobj(
 		    is_forced_local = true;
 		  else if (!version.empty())
 		    {
-		      ver = this->namepool_.add_with_length(version.c_str(),
-							    version.length(),
-							    true,
-							    &ver_key);
+		      ver = version.c_str();
+		      verlen = version.length();
 		      is_default_version = true;
 		    }
 		}
@@ -1347,37 +1799,97 @@ Symbol_table::add_from_relobj(
 	    }
         }
 
-      Stringpool::Key name_key;
-      name = this->namepool_.add_with_length(name, namelen, true,
-					     &name_key);
+      // Hash the name once, for both the shard and its name pool.
+      size_t name_hash = gold::string_hash<char>(name, namelen);
 
-      Sized_symbol<size>* res;
-      res = this->add_from_object(relobj, name, name_key, ver, ver_key,
-				  is_default_version, *psym, st_shndx,
-				  is_ordinary, orig_st_shndx);
-
-      if (res == NULL)
-	continue;
-      
-      if (is_forced_local)
-	this->force_local(res);
+      if (pending == NULL)
+	{
+	  this->add_relobj_symbol(&this->shards_[shard_index(name_hash)],
+				  relobj, name, namelen, name_hash, ver, verlen,
+				  is_default_version, is_forced_local,
+				  is_defined_in_discarded_section, *psym,
+				  st_shndx, is_ordinary, orig_st_shndx,
+				  &(*sympointers)[i]);
+	  continue;
+	}
 
-      // Do not treat this symbol as garbage if this symbol will be
-      // exported to the dynamic symbol table.  This is true when
-      // building a shared library or using --export-dynamic and
-      // the symbol is externally visible.
-      if (parameters->options().gc_sections()
-	  && res->is_externally_visible()
-	  && !res->is_from_dynobj()
-          && (parameters->options().shared()
-	      || parameters->options().export_dynamic()
-	      || parameters->options().in_dynamic_list(res->name())))
-        this->gc_mark_symbol(res);
+      // Save the symbol to be resolved later.
+      if (psym == &sym2)
+	memcpy(&pending->syms[i * sym_size], symbuf, sym_size);
+      Pending_symbols::Entry e;
+      e.index = i;
+      e.name = pending->names.length();
+      e.namelen = namelen;
+      e.name_hash = name_hash;
+      pending->names.append(name, namelen);
+      if (ver == NULL)
+	{
+	  e.version = -1U;
+	  e.verlen = 0;
+	}
+      else
+	{
+	  e.version = pending->names.length();
+	  e.verlen = verlen;
+	  pending->names.append(ver, verlen);
+	}
+      e.st_shndx = st_shndx;
+      e.orig_st_shndx = orig_st_shndx;
+      e.is_ordinary = is_ordinary;
+      e.is_default_version = is_default_version;
+      e.is_forced_local = is_forced_local;
+      e.is_defined_in_discarded_section = is_defined_in_discarded_section;
+      entries.push_back(e);
+      shards.push_back(shard_index(name_hash));
+    }
 
-      if (is_defined_in_discarded_section)
-	res->set_is_defined_in_discarded_section();
+  if (pending == NULL)
+    return;
 
-      (*sympointers)[i] = res;
+  // Sort the symbols by shard, keeping them in order within a shard.
+  // Once the first shard has been handed its symbols, PENDING may be
+  // freed under us, so we keep our own copy of the shard bounds.
+  std::vector<unsigned int> start(shard_count + 1, 0);
+  for (size_t i = 0; i < shards.size(); ++i)
+    ++start[shards[i] + 1];
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      if (start[i + 1] != 0)
+	++pending->refs;
+      start[i + 1] += start[i];
+    }
+  if (pending->refs == 0)
+    {
+      delete pending;
+      return;
+    }
+  pending->entries.resize(entries.size());
+  std::vector<unsigned int> next(start.begin(), start.end() - 1);
+  for (size_t i = 0; i < entries.size(); ++i)
+    pending->entries[next[shards[i]]++] = entries[i];
+  pending->shard_start = start;
+  // Objects are added one at a time, in the order of the input files.
+  pending->serial = this->pending_count_++;
+
+  // Hand the symbols to the shards, and start a task for each shard
+  // which is not being worked on.
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      if (start[i] == start[i + 1])
+	continue;
+      Symbol_table_shard* shard = &this->shards_[i];
+      bool start_task;
+      {
+	Hold_lock hl(*shard->lock);
+	shard->pending.push_back(pending);
+	start_task = !shard->is_resolving;
+	shard->is_resolving = true;
+      }
+      if (start_task)
+	{
+	  this->resolve_workqueue_->add_blocker(this->resolve_blocker_);
+	  this->resolve_workqueue_->queue_soon(new Resolve_symbols(this, i));
+	}
     }
 }
 
@@ -1394,13 +1906,14 @@ Symbol_table::add_from_pluginobj(
   unsigned int st_shndx = sym->get_st_shndx();
   bool is_ordinary = st_shndx < elfcpp::SHN_LORESERVE;
 
+  Symbol_table_shard* shard = this->get_shard(name);
   Stringpool::Key ver_key = 0;
   bool is_default_version = false;
   bool is_forced_local = false;
 
   if (ver != NULL)
     {
-      ver = this->namepool_.add(ver, true, &ver_key);
+      ver = shard->namepool.add(ver, true, &ver_key);
     }
   // We don't want to assign a version to an undefined symbol,
   // even if it is listed in the version script.  FIXME: What
@@ -1421,7 +1934,7 @@ Symbol_table::add_from_pluginobj(
 		is_forced_local = true;
 	      else if (!version.empty())
                 {
-                  ver = this->namepool_.add_with_length(version.c_str(),
+                  ver = shard->namepool.add_with_length(version.c_str(),
                                                         version.length(),
                                                         true,
                                                         &ver_key);
@@ -1432,10 +1945,10 @@ Symbol_table::add_from_pluginobj(
     }
 
   Stringpool::Key name_key;
-  name = this->namepool_.add(name, true, &name_key);
+  name = shard->namepool.add(name, true, &name_key);
 
   Sized_symbol<size>* res;
-  res = this->add_from_object(obj, name, name_key, ver, ver_key,
+  res = this->add_from_object(shard, obj, name, name_key, ver, ver_key,
 		              is_default_version, *sym, st_shndx,
 			      is_ordinary, st_shndx);
 
@@ -1443,7 +1956,7 @@ Symbol_table::add_from_pluginobj(
     return NULL;
 
   if (is_forced_local)
-    this->force_local(res);
+    this->force_local(shard, res);
 
   return res;
 }
@@ -1554,9 +2067,10 @@ Symbol_table::add_from_dynobj(
 
       if (versym == NULL)
 	{
+	  Symbol_table_shard* shard;
 	  Stringpool::Key name_key;
-	  name = this->namepool_.add(name, true, &name_key);
-	  res = this->add_from_object(dynobj, name, name_key, NULL, 0,
+	  name = this->add_name(name, strlen(name), &shard, &name_key);
+	  res = this->add_from_object(shard, dynobj, name, name_key, NULL, 0,
 				      false, *psym, st_shndx, is_ordinary,
 				      st_shndx);
 	}
@@ -1584,16 +2098,17 @@ Symbol_table::add_from_dynobj(
 	    }
 
 	  // At this point we are definitely going to add this symbol.
+	  Symbol_table_shard* shard;
 	  Stringpool::Key name_key;
-	  name = this->namepool_.add(name, true, &name_key);
+	  name = this->add_name(name, strlen(name), &shard, &name_key);
 
 	  if (v == static_cast<unsigned int>(elfcpp::VER_NDX_LOCAL)
 	      || v == static_cast<unsigned int>(elfcpp::VER_NDX_GLOBAL))
 	    {
 	      // This symbol does not have a version.
-	      res = this->add_from_object(dynobj, name, name_key, NULL, 0,
-					  false, *psym, st_shndx, is_ordinary,
-					  st_shndx);
+	      res = this->add_from_object(shard, dynobj, name, name_key,
+					  NULL, 0, false, *psym, st_shndx,
+					  is_ordinary, st_shndx);
 	    }
 	  else
 	    {
@@ -1613,7 +2128,7 @@ Symbol_table::add_from_dynobj(
 		}
 
 	      Stringpool::Key version_key;
-	      version = this->namepool_.add(version, true, &version_key);
+	      version = shard->namepool.add(version, true, &version_key);
 
 	      // If this is an absolute symbol, and the version name
 	      // and symbol name are the same, then this is the
@@ -1623,17 +2138,17 @@ Symbol_table::add_from_dynobj(
 	      if (st_shndx == elfcpp::SHN_ABS
 		  && !is_ordinary
 		  && name_key == version_key)
-		res = this->add_from_object(dynobj, name, name_key, NULL, 0,
-					    false, *psym, st_shndx, is_ordinary,
-					    st_shndx);
+		res = this->add_from_object(shard, dynobj, name, name_key,
+					    NULL, 0, false, *psym, st_shndx,
+					    is_ordinary, st_shndx);
 	      else
 		{
 		  const bool is_default_version =
 		    !hidden && st_shndx != elfcpp::SHN_UNDEF;
-		  res = this->add_from_object(dynobj, name, name_key, version,
-					      version_key, is_default_version,
-					      *psym, st_shndx,
-					      is_ordinary, st_shndx);
+		  res = this->add_from_object(shard, dynobj, name, name_key,
+					      version, version_key,
+					      is_default_version, *psym,
+					      st_shndx, is_ordinary, st_shndx);
 		}
 	    }
 	}
@@ -1680,11 +2195,12 @@ Symbol_table::add_from_incrobj(
   Stringpool::Key ver_key = 0;
   bool is_default_version = false;
 
+  Symbol_table_shard* shard;
   Stringpool::Key name_key;
-  name = this->namepool_.add(name, true, &name_key);
+  name = this->add_name(name, strlen(name), &shard, &name_key);
 
   Sized_symbol<size>* res;
-  res = this->add_from_object(obj, name, name_key, ver, ver_key,
+  res = this->add_from_object(shard, obj, name, name_key, ver, ver_key,
 		              is_default_version, *sym, st_shndx,
 			      is_ordinary, st_shndx);
 
@@ -1816,10 +2332,12 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
   Symbol* oldsym;
   Sized_symbol<size>* sym;
 
+  Symbol_table_shard* shard = this->get_shard(*pname);
+  Symbol_table_type* table = &shard->table;
   bool add_to_table = false;
-  typename Symbol_table_type::iterator add_loc = this->table_.end();
+  typename Symbol_table_type::iterator add_loc = table->end();
   bool add_def_to_table = false;
-  typename Symbol_table_type::iterator add_def_loc = this->table_.end();
+  typename Symbol_table_type::iterator add_def_loc = table->end();
 
   if (only_if_ref)
     {
@@ -1844,7 +2362,7 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
 
       *pname = oldsym->name();
       if (is_default_version)
-	*pversion = this->namepool_.add(*pversion, true, NULL);
+	*pversion = shard->namepool.add(*pversion, true, NULL);
       else
 	*pversion = oldsym->version();
     }
@@ -1852,27 +2370,25 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
     {
       // Canonicalize NAME and VERSION.
       Stringpool::Key name_key;
-      *pname = this->namepool_.add(*pname, true, &name_key);
+      *pname = shard->namepool.add(*pname, true, &name_key);
 
       Stringpool::Key version_key = 0;
       if (*pversion != NULL)
-	*pversion = this->namepool_.add(*pversion, true, &version_key);
+	*pversion = shard->namepool.add(*pversion, true, &version_key);
 
       Symbol* const snull = NULL;
       std::pair<typename Symbol_table_type::iterator, bool> ins =
-	this->table_.insert(std::make_pair(std::make_pair(name_key,
-							  version_key),
-					   snull));
+	table->insert(std::make_pair(std::make_pair(name_key, version_key),
+				     snull));
 
       std::pair<typename Symbol_table_type::iterator, bool> insdefault =
-	std::make_pair(this->table_.end(), false);
+	std::make_pair(table->end(), false);
       if (is_default_version)
 	{
 	  const Stringpool::Key vnull = 0;
-	  insdefault =
-	    this->table_.insert(std::make_pair(std::make_pair(name_key,
-							      vnull),
-					       snull));
+	  insdefault = table->insert(std::make_pair(std::make_pair(name_key,
+								   vnull),
+						    snull));
 	}
 
       if (!ins.second)
@@ -1885,7 +2401,7 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
 	    {
 	      Sized_symbol<size>* soldsym =
 		this->get_sized_symbol<size>(oldsym);
-	      this->define_default_version<size, big_endian>(soldsym,
+	      this->define_default_version<size, big_endian>(shard, soldsym,
 							     insdefault.second,
 							     insdefault.first);
 	    }
@@ -2057,7 +2573,7 @@ Symbol_table::do_define_in_output_data(
       return sym;
     }
 
-  if (Symbol_table::should_override_with_special(oldsym, type, defined))
+  if (this->should_override_with_special(oldsym, type, defined))
     this->override_with_special(oldsym, sym);
 
   if (resolve_oldsym)
@@ -2180,7 +2696,7 @@ Symbol_table::do_define_in_output_segment(
       return sym;
     }
 
-  if (Symbol_table::should_override_with_special(oldsym, type, defined))
+  if (this->should_override_with_special(oldsym, type, defined))
     this->override_with_special(oldsym, sym);
 
   if (resolve_oldsym)
@@ -2307,7 +2823,7 @@ Symbol_table::do_define_as_constant(
     }
 
   if (force_override
-      || Symbol_table::should_override_with_special(oldsym, type, defined))
+      || this->should_override_with_special(oldsym, type, defined))
     this->override_with_special(oldsym, sym);
 
   if (resolve_oldsym)
@@ -2531,41 +3047,48 @@ Symbol_table::add_undefined_symbol_from_command_line(const char* name)
 
   sym->init_undefined(name, version, 0, elfcpp::STT_NOTYPE, elfcpp::STB_GLOBAL,
 		      elfcpp::STV_DEFAULT, 0);
-  ++this->saw_undefined_;
+  ++this->get_shard(name)->saw_undefined;
 }
 
 // Set the dynamic symbol indexes.  INDEX is the index of the first
 // global dynamic symbol.  Pointers to the global symbols are stored
-// into the vector SYMS.  The names are added to DYNPOOL.
+// into the vector SYMS, and the low 32 bits of the hash codes of
+// their names, which are their DT_GNU_HASH values, into HASH_CODES.
+// The names are added to DYNPOOL, which uses the same hash codes.
 // This returns an updated dynamic symbol index.
 
 unsigned int
 Symbol_table::set_dynsym_indexes(unsigned int index,
 				 unsigned int* pforced_local_count,
 				 std::vector<Symbol*>* syms,
+				 std::vector<uint32_t>* hash_codes,
 				 Stringpool* dynpool,
 				 Versions* versions)
 {
   // First process all the symbols which have been forced to be local,
   // as they must appear before all global symbols.
   unsigned int forced_local_count = 0;
-  for (Forced_locals::iterator p = this->forced_locals_.begin();
-       p != this->forced_locals_.end();
-       ++p)
+  for (unsigned int i = 0; i < shard_count; ++i)
     {
-      Symbol* sym = *p;
-      gold_assert(sym->is_forced_local());
-      if (sym->has_dynsym_index())
-        continue;
-      if (!sym->should_add_dynsym_entry(this))
-	sym->set_dynsym_index(-1U);
-      else
-        {
-          sym->set_dynsym_index(index);
-          ++index;
-          ++forced_local_count;
-	  dynpool->add(sym->name(), false, NULL);
-        }
+      Forced_locals& forced_locals(this->shards_[i].forced_locals);
+      for (Forced_locals::iterator p = forced_locals.begin();
+	   p != forced_locals.end();
+	   ++p)
+	{
+	  Symbol* sym = *p;
+	  gold_assert(sym->is_forced_local());
+	  if (sym->has_dynsym_index())
+	    continue;
+	  if (!sym->should_add_dynsym_entry(this))
+	    sym->set_dynsym_index(-1U);
+	  else
+	    {
+	      sym->set_dynsym_index(index);
+	      ++index;
+	      ++forced_local_count;
+	      dynpool->add(sym->name(), false, NULL);
+	    }
+	}
     }
   *pforced_local_count = forced_local_count;
 
@@ -2573,63 +3096,79 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
   if (parameters->target().has_custom_set_dynsym_indexes())
     {
       std::vector<Symbol*> dyn_symbols;
-      for (Symbol_table_type::iterator p = this->table_.begin();
-           p != this->table_.end();
-           ++p)
-        {
-          Symbol* sym = p->second;
-          if (sym->is_forced_local())
-	    continue;
-          if (!sym->should_add_dynsym_entry(this))
-            sym->set_dynsym_index(-1U);
-          else
-            dyn_symbols.push_back(sym);
-        }
+      for (unsigned int i = 0; i < shard_count; ++i)
+	{
+	  Symbol_table_type& table(this->shards_[i].table);
+	  for (Symbol_table_type::iterator p = table.begin();
+	       p != table.end();
+	       ++p)
+	    {
+	      Symbol* sym = p->second;
+	      if (sym->is_forced_local())
+		continue;
+	      if (!sym->should_add_dynsym_entry(this))
+		sym->set_dynsym_index(-1U);
+	      else
+		dyn_symbols.push_back(sym);
+	    }
+	}
 
-      return parameters->target().set_dynsym_indexes(&dyn_symbols, index, syms,
-                                                     dynpool, versions, this);
+      index = parameters->target().set_dynsym_indexes(&dyn_symbols, index,
+						      syms, dynpool, versions,
+						      this);
+      for (size_t i = hash_codes->size(); i < syms->size(); ++i)
+	hash_codes->push_back(gold::string_hash<char>((*syms)[i]->name()));
+      return index;
     }
 
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
+  for (unsigned int i = 0; i < shard_count; ++i)
     {
-      Symbol* sym = p->second;
+      Symbol_table_type& table(this->shards_[i].table);
+      for (Symbol_table_type::iterator p = table.begin();
+	   p != table.end();
+	   ++p)
+	{
+	  Symbol* sym = p->second;
 
-      if (sym->is_forced_local())
-        continue;
+	  if (sym->is_forced_local())
+	    continue;
 
-      // Note that SYM may already have a dynamic symbol index, since
-      // some symbols appear more than once in the symbol table, with
-      // and without a version.
+	  // Note that SYM may already have a dynamic symbol index, since
+	  // some symbols appear more than once in the symbol table, with
+	  // and without a version.
 
-      if (!sym->should_add_dynsym_entry(this))
-	sym->set_dynsym_index(-1U);
-      else if (!sym->has_dynsym_index())
-	{
-	  sym->set_dynsym_index(index);
-	  ++index;
-	  syms->push_back(sym);
-	  dynpool->add(sym->name(), false, NULL);
-
-	  // Record any version information, except those from
-	  // as-needed libraries not seen to be needed.  Note that the
-	  // is_needed state for such libraries can change in this loop.
-	  if (sym->version() != NULL)
+	  if (!sym->should_add_dynsym_entry(this))
+	    sym->set_dynsym_index(-1U);
+	  else if (!sym->has_dynsym_index())
 	    {
-	      if (!sym->is_from_dynobj()
-		  || !sym->object()->as_needed()
-		  || sym->object()->is_needed())
-		versions->record_version(this, dynpool, sym);
-	      else
+	      sym->set_dynsym_index(index);
+	      ++index;
+	      syms->push_back(sym);
+	      const char* name = sym->name();
+	      size_t len = strlen(name);
+	      size_t hash_code = gold::string_hash<char>(name, len);
+	      hash_codes->push_back(hash_code);
+	      dynpool->add_with_hash(name, len, hash_code, false, NULL);
+
+	      // Record any version information, except those from
+	      // as-needed libraries not seen to be needed.  Note that the
+	      // is_needed state for such libraries can change in this loop.
+	      if (sym->version() != NULL)
 		{
-		  if (parameters->options().warn_drop_version())
-		    gold_warning(_("discarding version information for "
-				   "%s@%s, defined in unused shared library %s "
-				   "(linked with --as-needed)"),
-				 sym->name(), sym->version(),
-				 sym->object()->name().c_str());
-		  sym->clear_version();
+		  if (!sym->is_from_dynobj()
+		      || !sym->object()->as_needed()
+		      || sym->object()->is_needed())
+		    versions->record_version(this, dynpool, sym);
+		  else
+		    {
+		      if (parameters->options().warn_drop_version())
+			gold_warning(_("discarding version information for "
+				       "%s@%s, defined in unused shared library %s "
+				       "(linked with --as-needed)"),
+				     sym->name(), sym->version(),
+				     sym->object()->name().c_str());
+		      sym->clear_version();
+		    }
 		}
 	    }
 	}
@@ -2638,6 +3177,8 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
   // Finish up the versions.  In some cases this may add new dynamic
   // symbols.
   index = versions->finalize(this, index, syms);
+  for (size_t i = hash_codes->size(); i < syms->size(); ++i)
+    hash_codes->push_back(gold::string_hash<char>((*syms)[i]->name()));
 
   // Process target-specific symbols.
   for (std::vector<Symbol*>::iterator p = this->target_symbols_.begin();
@@ -2647,7 +3188,11 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
       (*p)->set_dynsym_index(index);
       ++index;
       syms->push_back(*p);
-      dynpool->add((*p)->name(), false, NULL);
+      const char* name = (*p)->name();
+      size_t len = strlen(name);
+      size_t hash_code = gold::string_hash<char>(name, len);
+      hash_codes->push_back(hash_code);
+      dynpool->add_with_hash(name, len, hash_code, false, NULL);
     }
 
   return index;
@@ -2737,27 +3282,35 @@ Symbol_table::sized_finalize(off_t off, Stringpool* pool,
 
   // First do all the symbols which have been forced to be local, as
   // they must appear before all global symbols.
-  for (Forced_locals::iterator p = this->forced_locals_.begin();
-       p != this->forced_locals_.end();
-       ++p)
+  for (unsigned int i = 0; i < shard_count; ++i)
     {
-      Symbol* sym = *p;
-      gold_assert(sym->is_forced_local());
-      if (this->sized_finalize_symbol<size>(sym))
+      Forced_locals& forced_locals(this->shards_[i].forced_locals);
+      for (Forced_locals::iterator p = forced_locals.begin();
+	   p != forced_locals.end();
+	   ++p)
 	{
-	  this->add_to_final_symtab<size>(sym, pool, &index, &off);
-	  ++*plocal_symcount;
+	  Symbol* sym = *p;
+	  gold_assert(sym->is_forced_local());
+	  if (this->sized_finalize_symbol<size>(sym))
+	    {
+	      this->add_to_final_symtab<size>(sym, pool, &index, &off);
+	      ++*plocal_symcount;
+	    }
 	}
     }
 
   // Now do all the remaining symbols.
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
+  for (unsigned int i = 0; i < shard_count; ++i)
     {
-      Symbol* sym = p->second;
-      if (this->sized_finalize_symbol<size>(sym))
-	this->add_to_final_symtab<size>(sym, pool, &index, &off);
+      Symbol_table_type& table(this->shards_[i].table);
+      for (Symbol_table_type::iterator p = table.begin();
+	   p != table.end();
+	   ++p)
+	{
+	  Symbol* sym = p->second;
+	  if (this->sized_finalize_symbol<size>(sym))
+	    this->add_to_final_symtab<size>(sym, pool, &index, &off);
+	}
     }
 
   // Now do target-specific symbols.
@@ -3067,184 +3620,188 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
   else
     dynamic_view = of->get_output_view(this->dynamic_offset_, dynamic_size);
 
-  for (Symbol_table_type::const_iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
+  for (unsigned int i = 0; i < shard_count; ++i)
     {
-      Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
+      const Symbol_table_type& table(this->shards_[i].table);
+      for (Symbol_table_type::const_iterator p = table.begin();
+	   p != table.end();
+	   ++p)
+	{
+	  Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
 
-      // Possibly warn about unresolved symbols in shared libraries.
-      this->warn_about_undefined_dynobj_symbol(sym);
+	  // Possibly warn about unresolved symbols in shared libraries.
+	  this->warn_about_undefined_dynobj_symbol(sym);
 
-      unsigned int sym_index = sym->symtab_index();
-      unsigned int dynsym_index;
-      if (dynamic_view == NULL)
-	dynsym_index = -1U;
-      else
-	dynsym_index = sym->dynsym_index();
+	  unsigned int sym_index = sym->symtab_index();
+	  unsigned int dynsym_index;
+	  if (dynamic_view == NULL)
+	    dynsym_index = -1U;
+	  else
+	    dynsym_index = sym->dynsym_index();
 
-      if (sym_index == -1U && dynsym_index == -1U)
-	{
-	  // This symbol is not included in the output file.
-	  continue;
-	}
+	  if (sym_index == -1U && dynsym_index == -1U)
+	    {
+	      // This symbol is not included in the output file.
+	      continue;
+	    }
 
-      unsigned int shndx;
-      typename elfcpp::Elf_types<size>::Elf_Addr sym_value = sym->value();
-      typename elfcpp::Elf_types<size>::Elf_Addr dynsym_value = sym_value;
-      elfcpp::STB binding = sym->binding();
-
-      // If --weak-unresolved-symbols is set, change binding of unresolved
-      // global symbols to STB_WEAK.
-      if (parameters->options().weak_unresolved_symbols()
-	  && binding == elfcpp::STB_GLOBAL
-	  && sym->is_undefined())
-	binding = elfcpp::STB_WEAK;
-
-      // If --no-gnu-unique is set, change STB_GNU_UNIQUE to STB_GLOBAL.
-      if (binding == elfcpp::STB_GNU_UNIQUE
-	  && !parameters->options().gnu_unique())
-	binding = elfcpp::STB_GLOBAL;
+	  unsigned int shndx;
+	  typename elfcpp::Elf_types<size>::Elf_Addr sym_value = sym->value();
+	  typename elfcpp::Elf_types<size>::Elf_Addr dynsym_value = sym_value;
+	  elfcpp::STB binding = sym->binding();
 
-      switch (sym->source())
-	{
-	case Symbol::FROM_OBJECT:
-	  {
-	    bool is_ordinary;
-	    unsigned int in_shndx = sym->shndx(&is_ordinary);
+	  // If --weak-unresolved-symbols is set, change binding of unresolved
+	  // global symbols to STB_WEAK.
+	  if (parameters->options().weak_unresolved_symbols()
+	      && binding == elfcpp::STB_GLOBAL
+	      && sym->is_undefined())
+	    binding = elfcpp::STB_WEAK;
 
-	    if (!is_ordinary
-		&& in_shndx != elfcpp::SHN_ABS
-		&& !Symbol::is_common_shndx(in_shndx))
-	      {
-		gold_error(_("%s: unsupported symbol section 0x%x"),
-			   sym->demangled_name().c_str(), in_shndx);
-		shndx = in_shndx;
-	      }
-	    else
+	  // If --no-gnu-unique is set, change STB_GNU_UNIQUE to STB_GLOBAL.
+	  if (binding == elfcpp::STB_GNU_UNIQUE
+	      && !parameters->options().gnu_unique())
+	    binding = elfcpp::STB_GLOBAL;
+
+	  switch (sym->source())
+	    {
+	    case Symbol::FROM_OBJECT:
 	      {
-		Object* symobj = sym->object();
-		if (symobj->is_dynamic())
+		bool is_ordinary;
+		unsigned int in_shndx = sym->shndx(&is_ordinary);
+
+		if (!is_ordinary
+		    && in_shndx != elfcpp::SHN_ABS
+		    && !Symbol::is_common_shndx(in_shndx))
 		  {
-		    if (sym->needs_dynsym_value())
-		      dynsym_value = target.dynsym_value(sym);
-		    shndx = elfcpp::SHN_UNDEF;
-		    if (sym->is_undef_binding_weak())
-		      binding = elfcpp::STB_WEAK;
-		    else
-		      binding = elfcpp::STB_GLOBAL;
+		    gold_error(_("%s: unsupported symbol section 0x%x"),
+			       sym->demangled_name().c_str(), in_shndx);
+		    shndx = in_shndx;
 		  }
-		else if (symobj->pluginobj() != NULL)
-		  shndx = elfcpp::SHN_UNDEF;
-		else if (in_shndx == elfcpp::SHN_UNDEF
-			 || (!is_ordinary
-			     && (in_shndx == elfcpp::SHN_ABS
-				 || Symbol::is_common_shndx(in_shndx))))
-		  shndx = in_shndx;
 		else
 		  {
-		    Relobj* relobj = static_cast<Relobj*>(symobj);
-		    Output_section* os = relobj->output_section(in_shndx);
-                    if (this->is_section_folded(relobj, in_shndx))
-                      {
-                        // This global symbol must be written out even though
-                        // it is folded.
-                        // Get the os of the section it is folded onto.
-                        Section_id folded =
-                             this->icf_->get_folded_section(relobj, in_shndx);
-                        gold_assert(folded.first !=NULL);
-                        Relobj* folded_obj = 
-                          reinterpret_cast<Relobj*>(folded.first);
-                        os = folded_obj->output_section(folded.second);  
-                        gold_assert(os != NULL);
-                      }
-		    gold_assert(os != NULL);
-		    shndx = os->out_shndx();
-
-		    if (shndx >= elfcpp::SHN_LORESERVE)
+		    Object* symobj = sym->object();
+		    if (symobj->is_dynamic())
 		      {
-			if (sym_index != -1U)
-			  symtab_xindex->add(sym_index, shndx);
-			if (dynsym_index != -1U)
-			  dynsym_xindex->add(dynsym_index, shndx);
-			shndx = elfcpp::SHN_XINDEX;
+			if (sym->needs_dynsym_value())
+			  dynsym_value = target.dynsym_value(sym);
+			shndx = elfcpp::SHN_UNDEF;
+			if (sym->is_undef_binding_weak())
+			  binding = elfcpp::STB_WEAK;
+			else
+			  binding = elfcpp::STB_GLOBAL;
+		      }
+		    else if (symobj->pluginobj() != NULL)
+		      shndx = elfcpp::SHN_UNDEF;
+		    else if (in_shndx == elfcpp::SHN_UNDEF
+			     || (!is_ordinary
+				 && (in_shndx == elfcpp::SHN_ABS
+				     || Symbol::is_common_shndx(in_shndx))))
+		      shndx = in_shndx;
+		    else
+		      {
+			Relobj* relobj = static_cast<Relobj*>(symobj);
+			Output_section* os = relobj->output_section(in_shndx);
+			if (this->is_section_folded(relobj, in_shndx))
+			  {
+			    // This global symbol must be written out even though
+			    // it is folded.
+			    // Get the os of the section it is folded onto.
+			    Section_id folded =
+				 this->icf_->get_folded_section(relobj, in_shndx);
+			    gold_assert(folded.first !=NULL);
+			    Relobj* folded_obj = 
+			      reinterpret_cast<Relobj*>(folded.first);
+			    os = folded_obj->output_section(folded.second);  
+			    gold_assert(os != NULL);
+			  }
+			gold_assert(os != NULL);
+			shndx = os->out_shndx();
+
+			if (shndx >= elfcpp::SHN_LORESERVE)
+			  {
+			    if (sym_index != -1U)
+			      symtab_xindex->add(sym_index, shndx);
+			    if (dynsym_index != -1U)
+			      dynsym_xindex->add(dynsym_index, shndx);
+			    shndx = elfcpp::SHN_XINDEX;
+			  }
+
+			// In object files symbol values are section
+			// relative.
+			if (parameters->options().relocatable())
+			  sym_value -= os->address();
 		      }
-
-		    // In object files symbol values are section
-		    // relative.
-		    if (parameters->options().relocatable())
-		      sym_value -= os->address();
 		  }
 	      }
-	  }
-	  break;
+	      break;
 
-	case Symbol::IN_OUTPUT_DATA:
-	  {
-	    Output_data* od = sym->output_data();
-
-	    shndx = od->out_shndx();
-	    if (shndx >= elfcpp::SHN_LORESERVE)
+	    case Symbol::IN_OUTPUT_DATA:
 	      {
-		if (sym_index != -1U)
-		  symtab_xindex->add(sym_index, shndx);
-		if (dynsym_index != -1U)
-		  dynsym_xindex->add(dynsym_index, shndx);
-		shndx = elfcpp::SHN_XINDEX;
+		Output_data* od = sym->output_data();
+
+		shndx = od->out_shndx();
+		if (shndx >= elfcpp::SHN_LORESERVE)
+		  {
+		    if (sym_index != -1U)
+		      symtab_xindex->add(sym_index, shndx);
+		    if (dynsym_index != -1U)
+		      dynsym_xindex->add(dynsym_index, shndx);
+		    shndx = elfcpp::SHN_XINDEX;
+		  }
+
+		// In object files symbol values are section
+		// relative.
+		if (parameters->options().relocatable())
+		  {
+		    Output_section* os = od->output_section();
+		    gold_assert(os != NULL);
+		    sym_value -= os->address();
+		  }
 	      }
+	      break;
 
-	    // In object files symbol values are section
-	    // relative.
-	    if (parameters->options().relocatable())
+	    case Symbol::IN_OUTPUT_SEGMENT:
 	      {
-		Output_section* os = od->output_section();
-		gold_assert(os != NULL);
-		sym_value -= os->address();
+		Output_segment* oseg = sym->output_segment();
+		Output_section* osect = oseg->first_section();
+		if (osect == NULL)
+		  shndx = elfcpp::SHN_ABS;
+		else
+		  shndx = osect->out_shndx();
 	      }
-	  }
-	  break;
+	      break;
 
-	case Symbol::IN_OUTPUT_SEGMENT:
-	  {
-	    Output_segment* oseg = sym->output_segment();
-	    Output_section* osect = oseg->first_section();
-	    if (osect == NULL)
+	    case Symbol::IS_CONSTANT:
 	      shndx = elfcpp::SHN_ABS;
-	    else
-	      shndx = osect->out_shndx();
-	  }
-	  break;
+	      break;
 
-	case Symbol::IS_CONSTANT:
-	  shndx = elfcpp::SHN_ABS;
-	  break;
-
-	case Symbol::IS_UNDEFINED:
-	  shndx = elfcpp::SHN_UNDEF;
-	  break;
+	    case Symbol::IS_UNDEFINED:
+	      shndx = elfcpp::SHN_UNDEF;
+	      break;
 
-	default:
-	  gold_unreachable();
-	}
+	    default:
+	      gold_unreachable();
+	    }
 
-      if (sym_index != -1U)
-	{
-	  sym_index -= first_global_index;
-	  gold_assert(sym_index < output_count);
-	  unsigned char* ps = psyms + (sym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, sym_value, shndx,
-						     binding, sympool, ps);
-	}
+	  if (sym_index != -1U)
+	    {
+	      sym_index -= first_global_index;
+	      gold_assert(sym_index < output_count);
+	      unsigned char* ps = psyms + (sym_index * sym_size);
+	      this->sized_write_symbol<size, big_endian>(sym, sym_value, shndx,
+							 binding, sympool, ps);
+	    }
 
-      if (dynsym_index != -1U)
-	{
-	  dynsym_index -= first_dynamic_global_index;
-	  gold_assert(dynsym_index < dynamic_count);
-	  unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, dynsym_value, shndx,
-						     binding, dynpool, pd);
-          // Allow a target to adjust dynamic symbol value.
-          parameters->target().adjust_dyn_symbol(sym, pd);
+	  if (dynsym_index != -1U)
+	    {
+	      dynsym_index -= first_dynamic_global_index;
+	      gold_assert(dynsym_index < dynamic_count);
+	      unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
+	      this->sized_write_symbol<size, big_endian>(sym, dynsym_value, shndx,
+							 binding, dynpool, pd);
+	      // Allow a target to adjust dynamic symbol value.
+	      parameters->target().adjust_dyn_symbol(sym, pd);
+	    }
 	}
     }
 
@@ -3448,14 +4005,29 @@ Symbol_table::sized_write_section_symbol(const Output_section* os,
 void
 Symbol_table::print_stats() const
 {
+  size_t entries = 0;
+#if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+  size_t buckets = 0;
+#endif
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      entries += this->shards_[i].table.size();
+#if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+      buckets += this->shards_[i].table.bucket_count();
+#endif
+    }
 #if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
   fprintf(stderr, _("%s: symbol table entries: %zu; buckets: %zu\n"),
-	  program_name, this->table_.size(), this->table_.bucket_count());
+	  program_name, entries, buckets);
 #else
   fprintf(stderr, _("%s: symbol table entries: %zu\n"),
-	  program_name, this->table_.size());
+	  program_name, entries);
 #endif
-  this->namepool_.print_stats("symbol table stringpool");
+  fprintf(stderr, _("%s: symbol table shards: %u\n"),
+	  program_name, shard_count);
+  // The shards are filled evenly, so the first stringpool is
+  // representative of the others.
+  this->shards_[0].namepool.print_stats("symbol table stringpool (shard 0)");
 }
 
 // We check for ODR violations by looking for symbols with the same
@@ -26,6 +26,8 @@
 #ifndef GOLD_SYMTAB_H
 #define GOLD_SYMTAB_H
 
+#include <deque>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -60,6 +62,10 @@ class Output_file;
 class Output_symtab_xindex;
 class Garbage_collection;
 class Icf;
+class Lock;
+class Task_token;
+class Workqueue;
+struct Pending_symbols;
 
 // The base class of an entry in the symbol table.  The symbol table
 // can have a lot of entries, so we don't want this class too big.
@@ -1456,17 +1462,20 @@ class Symbol_table
   void
   gc_mark_symbol(Symbol* sym);
 
-  // During garbage collection, this keeps sections that correspond to 
-  // symbols seen in dynamic objects.
-  inline void
-  gc_mark_dyn_syms(Symbol* sym);
+  // Pass the symbols which add_from_object and add_from_relobj found
+  // must be kept to gc_mark_symbol.  This is called once all the
+  // input files have been read.
+  void
+  gc_mark_added_symbols();
 
   // Add COUNT external symbols from the relocatable object RELOBJ to
   // the symbol table.  SYMS is the symbols, SYMNDX_OFFSET is the
   // offset in the symbol table of the first symbol, SYM_NAMES is
   // their names, SYM_NAME_SIZE is the size of SYM_NAMES.  This sets
   // SYMPOINTERS to point to the symbols in the symbol table.  It sets
-  // *DEFINED to the number of defined symbols.
+  // *DEFINED to the number of defined symbols.  If deferred
+  // resolution is on, the symbols may be resolved later, and
+  // SYMPOINTERS is only valid once resolve_blocker is unblocked.
   template<int size, bool big_endian>
   void
   add_from_relobj(Sized_relobj_file<size, big_endian>* relobj,
@@ -1476,6 +1485,26 @@ class Symbol_table
 		  typename Sized_relobj_file<size, big_endian>::Symbols*,
 		  size_t* defined);
 
+  // Let add_from_relobj leave the symbols of an object to be resolved
+  // by Resolve_symbols tasks queued on WORKQUEUE, one per shard, while
+  // the following input files are read.  This is only done when it
+  // is safe; see can_defer_resolution.  Passing NULL turns it off.
+  void
+  set_resolve_workqueue(Workqueue* workqueue);
+
+  // Return a blocker which is blocked while there are symbols whose
+  // resolution has been deferred.  A task which looks at the symbol
+  // table must wait for it.
+  Task_token*
+  resolve_blocker() const
+  { return this->resolve_blocker_; }
+
+  // Resolve the deferred symbols of shard SHARD, in the order in
+  // which their objects were added.  This is called by the
+  // Resolve_symbols task.
+  void
+  resolve_shard(unsigned int shard);
+
   // Add one external symbol from the plugin object OBJ to the symbol table.
   // Returns a pointer to the resolved symbol in the symbol table.
   template<int size, bool big_endian>
@@ -1577,8 +1606,7 @@ class Symbol_table
 
   // Return the count of undefined symbols seen.
   size_t
-  saw_undefined() const
-  { return this->saw_undefined_; }
+  saw_undefined() const;
 
   // Allocate the common symbols
   void
@@ -1592,8 +1620,7 @@ class Symbol_table
 
   // Canonicalize a symbol name for use in the hash table.
   const char*
-  canonicalize_name(const char* name)
-  { return this->namepool_.add(name, true, NULL); }
+  canonicalize_name(const char* name);
 
   // Possibly issue a warning for a reference to SYM at LOCATION which
   // is in OBJ.
@@ -1622,11 +1649,14 @@ class Symbol_table
   // Set the dynamic symbol indexes.  INDEX is the index of the first
   // global dynamic symbol.  Return the count of forced-local symbols in
   // *PFORCED_LOCAL_COUNT.  Pointers to the symbols are stored into
-  // the vector.  The names are stored into the Stringpool.  This
+  // the vector SYMS, and the DT_GNU_HASH hash codes of their names
+  // into HASH_CODES.  The names are stored into the Stringpool.  This
   // returns an updated dynamic symbol index.
   unsigned int
   set_dynsym_indexes(unsigned int index, unsigned int* pforced_local_count,
-		     std::vector<Symbol*>*, Stringpool*, Versions*);
+		     std::vector<Symbol*>* syms,
+		     std::vector<uint32_t>* hash_codes, Stringpool*,
+		     Versions*);
 
   // Finalize the symbol table after we have set the final addresses
   // of all the input sections.  This sets the final symbol indexes,
@@ -1693,12 +1723,17 @@ class Symbol_table
   void
   for_all_symbols(F f) const
   {
-    for (Symbol_table_type::const_iterator p = this->table_.begin();
-         p != this->table_.end();
-         ++p)
+    for (unsigned int i = 0; i < shard_count; ++i)
       {
-	Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
-	f(sym);
+	const Symbol_table_type& table(this->shards_[i].table);
+	for (Symbol_table_type::const_iterator p = table.begin();
+	     p != table.end();
+	     ++p)
+	  {
+	    Sized_symbol<size>* sym =
+	      static_cast<Sized_symbol<size>*>(p->second);
+	    f(sym);
+	  }
       }
   }
 
@@ -1750,6 +1785,100 @@ class Symbol_table
   typedef Unordered_map<Symbol_table_key, Symbol*, Symbol_table_hash,
 			Symbol_table_eq> Symbol_table_type;
 
+  // The type of the list of symbols which have been forced local.
+  typedef std::vector<Symbol*> Forced_locals;
+
+  // The number of shards of the symbol table.  Symbols are put in a
+  // shard by the hash of their name, so all the versions of a name
+  // are in the same shard, and symbols in different shards can be
+  // resolved in parallel.  This does not depend on the number of
+  // threads, so that neither does the output.
+  static const unsigned int shard_count = 64;
+
+  // One shard of the symbol table.  Everything here is only
+  // changed by one thread at a time, in the order of the input
+  // files, so the keys in the string pool and the order of the lists
+  // are the same on every run.
+  struct Symbol_table_shard
+  {
+    Symbol_table_shard()
+      : table(), namepool(), commons(), tls_commons(), small_commons(),
+	large_commons(), forced_locals(), gc_symbols(), saw_undefined(0),
+	pending(), is_resolving(false), resolving(NULL), resolving_index(0),
+	lock(NULL)
+    { }
+
+    // The symbol hash table.
+    Symbol_table_type table;
+    // A pool of symbol names and versions.  Entries in the hash table
+    // point into this pool.
+    Stringpool namepool;
+    // We don't expect there to be very many common symbols, so we
+    // keep a list of them.  When we find a common symbol we add it to
+    // this list.  It is possible that by the time we process the list
+    // the symbol is no longer a common symbol.  It may also have
+    // become a forwarder.
+    Commons_type commons;
+    // This is like the commons field, except that it holds TLS common
+    // symbols.
+    Commons_type tls_commons;
+    // This is for small common symbols.
+    Commons_type small_commons;
+    // This is for large common symbols.
+    Commons_type large_commons;
+    // A list of symbols which have been forced to be local.  We don't
+    // expect there to be very many of them, so we keep a list of them
+    // rather than walking the whole table to find them.
+    Forced_locals forced_locals;
+    // Symbols seen in dynamic objects or exported, to pass to
+    // gc_mark_symbol once all the input files have been read.
+    std::vector<Symbol*> gc_symbols;
+    // We increment this every time we see a new undefined symbol, for
+    // use in archive groups.
+    size_t saw_undefined;
+    // Objects whose symbols in this shard have not been resolved yet.
+    std::deque<Pending_symbols*> pending;
+    // Whether a Resolve_symbols task is working on this shard.
+    bool is_resolving;
+    // The object whose symbol the Resolve_symbols task is resolving,
+    // and the index of the symbol.
+    Pending_symbols* resolving;
+    unsigned int resolving_index;
+    // Held while the shard is changed when symbols are resolved in
+    // the background.
+    Lock* lock;
+  };
+
+  // Return the index of the shard for a symbol name whose hash code,
+  // as computed by gold::string_hash, is HASH_CODE.  The same hash
+  // code is used by the shard's name pool.
+  static unsigned int
+  shard_index(size_t hash_code)
+  { return (hash_code ^ (hash_code >> 12)) % shard_count; }
+
+  // Return the shard for the symbol name NAME of length LEN.
+  Symbol_table_shard*
+  get_shard(const char* name, size_t len)
+  { return &this->shards_[shard_index(gold::string_hash<char>(name, len))]; }
+
+  // Return the shard for the symbol name NAME.
+  Symbol_table_shard*
+  get_shard(const char* name)
+  { return this->get_shard(name, strlen(name)); }
+
+  // Add the symbol name NAME to the name pool of its shard, hashing
+  // it only once for both.  Set *PSHARD to the shard and *PNAME_KEY
+  // to the key, and return the canonical name.
+  const char*
+  add_name(const char* name, size_t len, Symbol_table_shard** pshard,
+	   Stringpool::Key* pname_key)
+  {
+    size_t hash_code = gold::string_hash<char>(name, len);
+    *pshard = &this->shards_[shard_index(hash_code)];
+    return (*pshard)->namepool.add_with_hash(name, len, hash_code, true,
+					     pname_key);
+  }
+
   typedef Unordered_map<const char*,
                         Unordered_set<Symbol_location, Symbol_location_hash> >
   Odr_map;
@@ -1758,10 +1887,11 @@ class Symbol_table
   void
   make_forwarder(Symbol* from, Symbol* to);
 
-  // Add a symbol.
+  // Add a symbol.  NAME and VERSION are canonical in SHARD.
   template<int size, bool big_endian>
   Sized_symbol<size>*
-  add_from_object(Object*, const char* name, Stringpool::Key name_key,
+  add_from_object(Symbol_table_shard* shard, Object*,
+		  const char* name, Stringpool::Key name_key,
 		  const char* version, Stringpool::Key version_key,
 		  bool def, const elfcpp::Sym<size, big_endian>& sym,
 		  unsigned int st_shndx, bool is_ordinary,
@@ -1770,9 +1900,37 @@ class Symbol_table
   // Define a default symbol.
   template<int size, bool big_endian>
   void
-  define_default_version(Sized_symbol<size>*, bool,
+  define_default_version(Symbol_table_shard*, Sized_symbol<size>*, bool,
 			 Symbol_table_type::iterator);
 
+  // Add one symbol from a relocatable object, once NAME and VERSION,
+  // of length NAMELEN and VERLEN, have been split up.  NAME_HASH is
+  // the hash code of NAME.  This sets *SYMPOINTER.
+  template<int size, bool big_endian>
+  void
+  add_relobj_symbol(Symbol_table_shard*, Object*, const char* name,
+		    size_t namelen, size_t name_hash,
+		    const char* version, size_t verlen,
+		    bool is_default_version, bool is_forced_local,
+		    bool is_defined_in_discarded_section,
+		    const elfcpp::Sym<size, big_endian>& sym,
+		    unsigned int st_shndx, bool is_ordinary,
+		    unsigned int orig_st_shndx, Symbol** sympointer);
+
+  // Resolve the symbols of PENDING in shard SHARD.
+  template<int size, bool big_endian>
+  void
+  resolve_pending(unsigned int shard, Pending_symbols* pending);
+
+  // Whether add_from_relobj may leave symbols to be resolved later.
+  bool
+  can_defer_resolution() const;
+
+  // During garbage collection, this keeps sections that correspond to
+  // symbols seen in dynamic objects.
+  inline void
+  gc_mark_dyn_syms(Symbol_table_shard*, Symbol* sym);
+
   // Resolve symbols.
   template<int size, bool big_endian>
   void
@@ -1792,21 +1950,44 @@ class Symbol_table
   void
   force_local(Symbol*);
 
-  // Adjust NAME and *NAME_KEY for wrapping.
+  // Likewise, for a symbol in SHARD.
+  void
+  force_local(Symbol_table_shard*, Symbol*);
+
+  // Adjust NAME, *PSHARD and *NAME_KEY for wrapping.
   const char*
-  wrap_symbol(const char* name, Stringpool::Key* name_key);
+  wrap_symbol(const char* name, Symbol_table_shard** pshard,
+	      Stringpool::Key* name_key);
 
   // Whether we should override a symbol, based on flags in
   // resolve.cc.
-  static bool
+  bool
   should_override(const Symbol*, unsigned int, elfcpp::STT, Defined,
 		  Object*, bool*, bool*, bool);
 
   // Report a problem in symbol resolution.
-  static void
+  void
   report_resolve_problem(bool is_error, const char* msg, const Symbol* to,
 			 Defined, Object* object);
 
+  // Warn about an STT_COMMON symbol which is not in a common section.
+  void
+  report_common_problem(const Symbol* to);
+
+  // Queue a problem found by a Resolve_symbols task while resolving
+  // TO.  PREVIOUS is the file of the previous definition, or empty.
+  // Returns false if TO is not being resolved in the background.
+  bool
+  defer_resolve_problem(const Symbol* to, bool is_error,
+			const std::string& message,
+			const std::string& previous);
+
+  // Report the problems queued while resolving the symbols of
+  // PENDING and of any later objects which are done, in the order of
+  // the input files.  This is called with pending_lock_ held.
+  void
+  report_deferred_problems(Pending_symbols* pending);
+
   // Override a symbol.
   template<int size, bool big_endian>
   void
@@ -1817,7 +1998,7 @@ class Symbol_table
 
   // Whether we should override a symbol with a special symbol which
   // is automatically defined by the linker.
-  static bool
+  bool
   should_override_with_special(const Symbol*, elfcpp::STT, Defined);
 
   // Override a symbol with a special symbol.
@@ -1956,16 +2137,10 @@ class Symbol_table
   sized_write_section_symbol(const Output_section*, Output_symtab_xindex*,
 			     Output_file*, off_t) const;
 
-  // The type of the list of symbols which have been forced local.
-  typedef std::vector<Symbol*> Forced_locals;
-
   // A map from symbols with COPY relocs to the dynamic objects where
   // they are defined.
   typedef Unordered_map<const Symbol*, Dynobj*> Copied_symbol_dynobjs;
 
-  // We increment this every time we see a new undefined symbol, for
-  // use in archive groups.
-  size_t saw_undefined_;
   // The index of the first global symbol in the output file.
   unsigned int first_global_index_;
   // The file offset within the output symtab section where we should
@@ -1981,33 +2156,31 @@ class Symbol_table
   // The number of global dynamic symbols (including forced-local symbols),
   // or 0 if none.
   unsigned int dynamic_count_;
-  // The symbol hash table.
-  Symbol_table_type table_;
-  // A pool of symbol names.  This is used for all global symbols.
-  // Entries in the hash table point into this pool.
-  Stringpool namepool_;
+  // The symbol hash table, split up by name.
+  Symbol_table_shard shards_[shard_count];
   // Forwarding symbols.
   Unordered_map<const Symbol*, Symbol*> forwarders_;
+  // Held while adding to forwarders_ when symbols are resolved in
+  // the background.
+  Lock* forwarders_lock_;
   // Weak aliases.  A symbol in this list points to the next alias.
   // The aliases point to each other in a circular list.
   Unordered_map<Symbol*, Symbol*> weak_aliases_;
-  // We don't expect there to be very many common symbols, so we keep
-  // a list of them.  When we find a common symbol we add it to this
-  // list.  It is possible that by the time we process the list the
-  // symbol is no longer a common symbol.  It may also have become a
-  // forwarder.
-  Commons_type commons_;
-  // This is like the commons_ field, except that it holds TLS common
-  // symbols.
-  Commons_type tls_commons_;
-  // This is for small common symbols.
-  Commons_type small_commons_;
-  // This is for large common symbols.
-  Commons_type large_commons_;
-  // A list of symbols which have been forced to be local.  We don't
-  // expect there to be very many of them, so we keep a list of them
-  // rather than walking the whole table to find them.
-  Forced_locals forced_locals_;
+  // If not NULL, add_from_relobj queues the resolution of symbols
+  // here rather than doing it right away.
+  Workqueue* resolve_workqueue_;
+  // Blocked while there are Resolve_symbols tasks.
+  Task_token* resolve_blocker_;
+  // Held while changing the reference count or the problems of a
+  // Pending_symbols.
+  Lock* pending_lock_;
+  // The number of Pending_symbols handed to the shards so far.
+  unsigned int pending_count_;
+  // The Pending_symbols which have been resolved but whose problems
+  // wait for an earlier object, by serial number.
+  std::map<unsigned int, Pending_symbols*> resolved_pending_;
+  // The serial number of the next Pending_symbols to report.
+  unsigned int next_pending_report_;
   // Manage symbol warnings.
   Warnings warnings_;
   // Manage potential One Definition Rule (ODR) violations.
@@ -0,0 +1,18 @@
+# amo_relocs.s -- one use of each AMO relocation, for amo_relocs.sh
+
+	.text
+	.global	_start
+_start:
+	mov	r1, $0x12345678		; R_AMO_LITERAL into the literal pool
+	mov	r2, $0			; R_AMO_21 against small_value
+	.reloc	. - 4, R_AMO_21, small_value
+	beq	r1, r2, done		; R_AMO_PCREL
+	jmp	done			; R_AMO_28
+	.ltorg
+done:
+	ret	lr
+
+	.data
+	.global	pointer
+pointer:
+	.word	done			; R_AMO_32
@@ -0,0 +1,56 @@
+#!/bin/sh
+
+# amo_relocs.sh -- test the AMO relocations applied by gold.
+
+# Copyright (C) 2019 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# This file goes with amo_relocs.s, which uses each reloc of the AMO
+# target once, and is linked with small_value defined on the command
+# line.
+
+check()
+{
+    file=$1
+    pattern=$2
+
+    found=`grep "$pattern" $file`
+    if test -z "$found"; then
+	echo "pattern \"$pattern\" not found in file $file."
+	exit 1
+    fi
+}
+
+# There are tabs in the grep patterns.
+
+# R_AMO_LITERAL: the load reaches the literal pool 0x10 bytes on.
+check amo_relocs.stdout "ldr  r1, \[\$0xc\]"
+check amo_relocs.stdout "sub  r20, r17, \$0x5678"
+
+# R_AMO_21: the mov immediate holds small_value.
+check amo_relocs.stdout "34 12 40 50 	mov  r2, \$0x1234"
+
+# R_AMO_PCREL and R_AMO_28 both reach done.
+check amo_relocs.stdout "02 00 22 68 	beq  r1, r2, \$0x8"
+check amo_relocs.stdout "78 	jmp  \$0x1088"
+
+# R_AMO_32: pointer holds the address of done.
+check amo_relocs.stdout "^ [0-9a-f]* 88100000 "
+
+exit 0
@@ -0,0 +1,150 @@
+// glob_set_unittest.cc -- test Glob_set
+
+// Copyright (C) 2019 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cstring>
+#include <fnmatch.h>
+
+#include "glob-set.h"
+
+#include "test.h"
+
+namespace gold_testsuite
+{
+
+using namespace gold;
+
+static const char* const patterns[] =
+{
+  ".text.hot",
+  ".text.hot.*",
+  "*.unlikely",
+  ".text.*foo*bar",
+  ".data.[ab]*",
+  "*",
+  ".text.f?o",
+  "*.cold.*",
+  ".text.\\*x",
+  ".text.[]x]",
+  "*foo*",
+  ".bss",
+  "**.rodata*.str1.*",
+  ".text.*",
+};
+
+static const char* const names[] =
+{
+  "",
+  ".text",
+  ".text.hot",
+  ".text.hot.x",
+  ".text.hotter",
+  ".text.unlikely",
+  ".text.xfooybar",
+  ".text.foobar",
+  ".text.foobarbar",
+  ".text.foobarx",
+  ".data.a1",
+  ".data.c1",
+  ".text.fxo",
+  ".text.cold.1",
+  ".text.*x",
+  ".text.\\*x",
+  ".text.]",
+  ".text.x",
+  ".bss",
+  ".bss.foo",
+  ".rodata.str1.1",
+  ".rodata.cst8.str1.8",
+};
+
+// Return the index of the first pattern at or after START which
+// matches NAME, by calling fnmatch on each pattern in turn.
+
+static unsigned int
+first_match(const char* name, unsigned int start, unsigned int count,
+	    int flags)
+{
+  for (unsigned int i = start; i < count; ++i)
+    {
+      const char* p = patterns[i];
+      bool matches = (is_wildcard_string(p)
+		      ? fnmatch(p, name, flags) == 0
+		      : strcmp(p, name) == 0);
+      if (matches)
+	return i;
+    }
+  return count;
+}
+
+// Check a Glob_set holding the first COUNT patterns against fnmatch.
+
+static bool
+check_glob_set(unsigned int count, int flags)
+{
+  Glob_set set(flags);
+  for (unsigned int i = 0; i < count; ++i)
+    set.add(patterns[i], strlen(patterns[i]), i);
+
+  for (unsigned int n = 0; n < sizeof(names) / sizeof(names[0]); ++n)
+    {
+      for (unsigned int start = 0; start <= count; ++start)
+	{
+	  unsigned int want = first_match(names[n], start, count, flags);
+	  unsigned int got;
+	  if (!set.find_first(names[n], start, &got))
+	    got = count;
+	  CHECK(got == want);
+	}
+    }
+  return true;
+}
+
+bool
+Glob_set_test(Test_report*)
+{
+  const unsigned int count = sizeof(patterns) / sizeof(patterns[0]);
+
+  // A few patterns are checked one at a time, more through the tries.
+  CHECK(check_glob_set(3, 0));
+  CHECK(check_glob_set(count, 0));
+  CHECK(check_glob_set(count, FNM_NOESCAPE));
+
+  // Several patterns may share an identifier.
+  Glob_set set(0);
+  set.add(".a*", 3, 0);
+  set.add(".b*", 3, 0);
+  for (unsigned int i = 0; i < 10; ++i)
+    set.add(".c", 2, 1);
+  set.add("*", 1, 2);
+  unsigned int id;
+  CHECK(set.find_first(".b1", 0, &id) && id == 0);
+  CHECK(set.find_first(".c", 0, &id) && id == 1);
+  CHECK(set.find_first(".b1", 1, &id) && id == 2);
+  CHECK(!set.find_first(".b1", 3, &id));
+
+  return true;
+}
+
+Register_test glob_set_register("Glob_set", Glob_set_test);
+
+} // End namespace gold_testsuite.
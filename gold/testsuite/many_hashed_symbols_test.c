@@ -0,0 +1,39 @@
+/* many_hashed_symbols_test.c -- test .gnu.hash with many symbols
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* This program calls every function of a shared library linked with
+   --hash-style=gnu and --threads.  gold builds the .gnu.hash section
+   from the hash codes it computed when it added the names to the
+   symbol table, so the dynamic linker only finds the functions if
+   those codes are the DT_GNU_HASH hashes of the names.  The names have
+   every length modulo 8.  */
+
+#include "many_hashed_symbols_decls.h"
+
+int
+main (void)
+{
+  int n = 0;
+
+#include "many_hashed_symbols_calls.h"
+
+  return n == 4000 ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+/* muldef_order.c -- a test case for gold
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* This file is compiled several times and the objects are linked
+   together, so that every symbol is defined more than once.  There
+   are enough symbols to spread over the shards of the symbol table.  */
+
+#define DEF(n) int muldef_order_##n (void) { return VALUE + n; }
+#define DEF8(n) DEF(n##0) DEF(n##1) DEF(n##2) DEF(n##3) \
+  DEF(n##4) DEF(n##5) DEF(n##6) DEF(n##7)
+
+DEF8(1) DEF8(2) DEF8(3) DEF8(4) DEF8(5) DEF8(6) DEF8(7) DEF8(8)
+
+int muldef_order_data = VALUE;
@@ -0,0 +1,53 @@
+#!/bin/sh
+
+# muldef_order.sh -- check that multiple definition errors come out
+# in the same order with and without threads.
+
+# Copyright (C) 2019 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# With threads, the symbols of each object are resolved by several
+# tasks.  The errors they find are queued and reported in the order
+# of the input files, so the output matches a link without threads.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected error in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual error output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check muldef_order_nothreads.err "muldef_order_2.o: multiple definition of 'muldef_order_10'"
+check muldef_order_nothreads.err "muldef_order_1.o: previous definition here"
+check muldef_order_nothreads.err "muldef_order_3.o: multiple definition of 'muldef_order_data'"
+
+if ! cmp -s muldef_order_nothreads.err muldef_order_threads.err
+then
+    echo "Errors differ with threads:"
+    diff muldef_order_nothreads.err muldef_order_threads.err
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,46 @@
+/* pack_relative_relocs_none.c -- test -z pack-relative-relocs with
+   nothing to pack
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* The only relative reloc of this shared library is for an unaligned
+   pointer, which can't be packed, so the library must not have a
+   .relr.dyn section.  It is linked without the startup files, which
+   have aligned pointers of their own.  It calls abort so that it
+   depends on libc, which must not be given a GLIBC_ABI_DT_RELR
+   version need.  */
+
+#include <stdlib.h>
+
+static int i;
+
+struct __attribute__((packed)) Unaligned
+{
+  char c;
+  int* p;
+};
+
+struct Unaligned unaligned_ptr = { 0, &i };
+
+void
+fail (void)
+{
+  abort ();
+}
@@ -0,0 +1,67 @@
+// pack_relative_relocs_test.cc -- test -z pack-relative-relocs for gold
+
+// Copyright (C) 2019 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// This file is compiled into both the shared library and the PIE,
+// with CHECK_FUNCTION naming the function which checks its pointers.
+// Each pointer needs a relative reloc.  The adjacent pointers are
+// encoded in bitmap entries of .relr.dyn, while the sparse ones are
+// far enough apart that each needs an address entry.  The unaligned
+// pointer can't be encoded in .relr.dyn and stays in .rela.dyn.
+
+static int ints[32];
+
+static int* adjacent_ptrs[] =
+{
+  &ints[0], &ints[1], &ints[2], &ints[3], &ints[4],
+  &ints[5], &ints[6], &ints[7], &ints[8], &ints[9]
+};
+
+struct Sparse
+{
+  int* p;
+  char pad[1024];
+};
+
+static Sparse sparse_ptrs[] =
+{
+  { &ints[10], { 0 } }, { &ints[11], { 0 } },
+  { &ints[12], { 0 } }, { &ints[13], { 0 } }
+};
+
+struct __attribute__((packed)) Unaligned
+{
+  char c;
+  int* p;
+};
+
+static Unaligned unaligned_ptr = { 0, &ints[14] };
+
+bool
+CHECK_FUNCTION()
+{
+  for (int i = 0; i < 10; ++i)
+    if (adjacent_ptrs[i] != &ints[i])
+      return false;
+  for (int i = 0; i < 4; ++i)
+    if (sparse_ptrs[i].p != &ints[10 + i])
+      return false;
+  return unaligned_ptr.p == &ints[14];
+}
@@ -0,0 +1,90 @@
+#!/bin/sh
+
+# pack_relative_relocs_test.sh -- test -z pack-relative-relocs.
+
+# Copyright (C) 2019 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The PIE and the shared libraries are all linked with
+# -z pack-relative-relocs.  Check that the aligned relative relocs
+# went into a .relr.dyn section described by the DT_RELR tags, and
+# that only the unaligned one is left in .rela.dyn.  The library in
+# pack_relative_relocs_none.stdout has no reloc which can be packed,
+# so it must not have a .relr.dyn section at all.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_missing()
+{
+    if grep -q "$2" "$1"
+    then
+	echo "Found unexpected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_count()
+{
+    if test "`grep -c "$2" "$1"`" != "$3"
+    then
+	echo "Did not find expected number of $2 in $1:"
+	echo "   $3"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+for f in pack_relative_relocs_test.stdout pack_relative_relocs_test_so.stdout
+do
+    check $f "\.relr\.dyn *RELR"
+    check $f "(RELR) "
+    check $f "(RELRSZ) "
+    check $f "(RELRENT) *8 (bytes)"
+    check_count $f "R_X86_64_RELATIVE" 1
+done
+
+# glibc refuses to load a program using DT_RELR unless it depends on
+# the GLIBC_ABI_DT_RELR version.
+check pack_relative_relocs_test.stdout "GLIBC_ABI_DT_RELR"
+
+f=pack_relative_relocs_none.stdout
+check_missing $f "\.relr\.dyn"
+check_missing $f "(RELR"
+check_missing $f "GLIBC_ABI_DT_RELR"
+check_count $f "R_X86_64_RELATIVE" 1
+check $f "libc\.so"
+
+exit 0
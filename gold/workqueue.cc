@@ -22,6 +22,8 @@
 
 #include "gold.h"
 
+#include <sys/time.h>
+
 #include "debug.h"
 #include "options.h"
 #include "timer.h"
@@ -114,16 +116,31 @@ class Workqueue_threader_single : public Workqueue_threader
   { return false; }
 };
 
+// Return the current time in microseconds.  This is used for the
+// --stats counters, for which Timer is too coarse.
+
+static inline long long
+get_usec()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
 // Workqueue methods.
 
 Workqueue::Workqueue(const General_options& options)
   : lock_(),
     first_tasks_(),
-    tasks_(),
+    queued_(0),
+    next_run_queue_(0),
+    thread_stats_(),
     running_(0),
     waiting_(0),
     condvar_(this->lock_),
-    threader_(NULL)
+    threader_(NULL),
+    run_queue_count_(1),
+    collect_stats_(options.stats())
 {
   bool threads = options.threads();
 #ifndef ENABLE_THREADS
@@ -135,6 +152,7 @@ Workqueue::Workqueue(const General_options& options)
     {
 #ifdef ENABLE_THREADS
       this->threader_ = new Workqueue_threader_threadpool(this);
+      this->run_queue_count_ = max_run_queues;
 #else
       gold_unreachable();
 #endif
@@ -146,7 +164,8 @@ Workqueue::~Workqueue()
 }
 
 // Add a task to the end of a specific queue, or put it on the list
-// waiting for a Token.
+// waiting for a Token.  If QUEUE is NULL, add the task to the run
+// queues, spreading tasks over them in turn.
 
 void
 Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
@@ -164,21 +183,31 @@ Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
     }
   else
     {
-      if (front)
-	queue->push_front(t);
+      if (queue != NULL)
+	{
+	  if (front)
+	    queue->push_front(t);
+	  else
+	    queue->push_back(t);
+	}
       else
-	queue->push_back(t);
+	{
+	  this->push_run_queue(this->next_run_queue_, t, front);
+	  ++this->next_run_queue_;
+	  if (this->next_run_queue_ >= this->run_queue_count_)
+	    this->next_run_queue_ = 0;
+	}
       // Tell any waiting thread that there is work to do.
       this->condvar_.signal();
     }
 }
 
-// Add a task to the queue.
+// Add a task to the run queues.
 
 void
 Workqueue::queue(Task* t)
 {
-  this->add_to_queue(&this->tasks_, t, false);
+  this->add_to_queue(NULL, t, false);
 }
 
 // Queue a task which should run soon.
@@ -207,6 +236,100 @@ Workqueue::should_cancel_thread(int thread_number)
   return this->threader_->should_cancel_thread(thread_number);
 }
 
+// Return the statistics for THREAD_NUMBER.  The workqueue lock must
+// be held when this is called.
+
+Workqueue::Thread_stats*
+Workqueue::thread_stats(int thread_number)
+{
+  gold_assert(thread_number >= 0);
+  if (static_cast<size_t>(thread_number) >= this->thread_stats_.size())
+    this->thread_stats_.resize(thread_number + 1);
+  return &this->thread_stats_[thread_number];
+}
+
+// Return the start time for add_lock_wait.
+
+inline long long
+Workqueue::stats_time() const
+{
+  return this->collect_stats_ ? get_usec() : 0;
+}
+
+// Add the time since START to the lock wait time of THREAD_NUMBER.
+// The workqueue lock must be held when this is called.
+
+inline void
+Workqueue::add_lock_wait(int thread_number, long long start)
+{
+  if (this->collect_stats_)
+    this->thread_stats(thread_number)->lock_wait += get_usec() - start;
+}
+
+// Add T to run queue RUN_QUEUE.  The workqueue lock must be held when
+// this is called.
+
+void
+Workqueue::push_run_queue(int run_queue, Task* t, bool front)
+{
+  Run_queue* rq = &this->run_queues_[run_queue];
+  {
+    Hold_lock hl(rq->lock);
+    if (front)
+      rq->tasks.push_front(t);
+    else
+      rq->tasks.push_back(t);
+  }
+  ++this->queued_;
+}
+
+// Take a task from the run queue of THREAD_NUMBER, or if that is
+// empty steal one from another run queue.  Set *STOLEN if we stole
+// it.  Return NULL if all the run queues are empty.  This is called
+// without the workqueue lock, and the caller must decrement queued_
+// once it has the lock.
+
+Task*
+Workqueue::take_task(int thread_number, bool* stolen)
+{
+  int home = this->home_run_queue(thread_number);
+  for (int i = 0; i < this->run_queue_count_; ++i)
+    {
+      int n = home + i;
+      if (n >= this->run_queue_count_)
+	n -= this->run_queue_count_;
+      Run_queue* rq = &this->run_queues_[n];
+
+      Task* t;
+      {
+	Hold_lock hl(rq->lock);
+	t = rq->tasks.pop_front();
+      }
+      if (t != NULL)
+	{
+	  *stolen = i != 0;
+	  return t;
+	}
+    }
+  return NULL;
+}
+
+// Return whether all the run queues are empty.  The workqueue lock
+// must be held when this is called, so that no task can be added.
+
+bool
+Workqueue::run_queues_empty()
+{
+  for (int i = 0; i < this->run_queue_count_; ++i)
+    {
+      Run_queue* rq = &this->run_queues_[i];
+      Hold_lock hl(rq->lock);
+      if (!rq->tasks.empty())
+	return false;
+    }
+  return true;
+}
+
 // Find a runnable task in TASKS.  Return NULL if none could be found.
 // If we find a Task waiting for a Token, add it to the list for that
 // Token.  The workqueue lock must be held when this is called.
@@ -230,53 +353,108 @@ Workqueue::find_runnable_in_list(Task_list* tasks)
   return NULL;
 }
 
-// Find a runnable task.  Return NULL if none could be found.  The
-// workqueue lock must be held when this is called.
+// Find a runnable task to run next on THREAD_NUMBER, looking only at
+// the tasks to run soon and at the thread's own run queue.  Return
+// NULL if none could be found.  The workqueue lock must be held when
+// this is called.
 
 Task*
-Workqueue::find_runnable()
+Workqueue::find_runnable(int thread_number)
 {
   Task* t = this->find_runnable_in_list(&this->first_tasks_);
-  if (t == NULL)
-    t = this->find_runnable_in_list(&this->tasks_);
-  return t;
+  if (t != NULL)
+    return t;
+
+  Run_queue* rq = &this->run_queues_[this->home_run_queue(thread_number)];
+  while (true)
+    {
+      {
+	Hold_lock hl(rq->lock);
+	t = rq->tasks.pop_front();
+      }
+      if (t == NULL)
+	return NULL;
+      --this->queued_;
+
+      Task_token* token = t->is_runnable();
+      if (token == NULL)
+	return t;
+
+      token->add_waiting(t);
+      ++this->waiting_;
+    }
 }
 
-// Find a runnable a task, and wait until we find one.  Return NULL if
-// we should exit.  The workqueue lock must be held when this is
-// called.
+// Pick the task to run given CANDIDATE, a task which this thread took
+// from a run queue, or NULL.  Tasks to run soon take precedence over
+// CANDIDATE, which then goes back on the thread's run queue.  If there
+// is nothing to run, wait for something to change.  Return NULL if we
+// should look at the run queues again, and also set *PEXIT if we
+// should exit.  The workqueue lock must be held when this is called.
 
 Task*
-Workqueue::find_runnable_or_wait(int thread_number)
+Workqueue::find_runnable_or_wait(int thread_number, Task* candidate,
+				 bool* pexit)
 {
-  Task* t = this->find_runnable();
+  *pexit = false;
 
-  while (t == NULL)
+  Task* t = this->find_runnable_in_list(&this->first_tasks_);
+  if (t != NULL)
     {
-      if (this->running_ == 0
-	  && this->first_tasks_.empty()
-	  && this->tasks_.empty())
+      if (candidate != NULL)
 	{
-	  // Kick all the threads to make them exit.
-	  this->condvar_.broadcast();
-
-	  gold_assert(this->waiting_ == 0);
-	  return NULL;
+	  this->push_run_queue(this->home_run_queue(thread_number),
+			       candidate, true);
+	  this->condvar_.signal();
 	}
+      return t;
+    }
 
-      if (this->should_cancel_thread(thread_number))
-	return NULL;
+  if (candidate != NULL)
+    {
+      Task_token* token = candidate->is_runnable();
+      if (token == NULL)
+	return candidate;
+      token->add_waiting(candidate);
+      ++this->waiting_;
+      return NULL;
+    }
 
-      gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
+  // Another thread may have queued a task after we looked.  If the
+  // run queues are empty, the queued tasks were taken by threads which
+  // do not have the workqueue lock yet, so wait for them to run or to
+  // requeue the tasks rather than looking again and again.
+  if (this->queued_ > 0 && !this->run_queues_empty())
+    return NULL;
 
-      this->condvar_.wait();
+  if (this->queued_ == 0
+      && this->running_ == 0
+      && this->first_tasks_.empty())
+    {
+      // Kick all the threads to make them exit.
+      this->condvar_.broadcast();
 
-      gold_debug(DEBUG_TASK, "%3d awake", thread_number);
+      gold_assert(this->waiting_ == 0);
+      *pexit = true;
+      return NULL;
+    }
 
-      t = this->find_runnable();
+  if (this->should_cancel_thread(thread_number))
+    {
+      *pexit = true;
+      return NULL;
     }
 
-  return t;
+  gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
+
+  long long start = this->stats_time();
+  this->condvar_.wait();
+  if (this->collect_stats_)
+    this->thread_stats(thread_number)->idle += get_usec() - start;
+
+  gold_debug(DEBUG_TASK, "%3d awake", thread_number);
+
+  return NULL;
 }
 
 // Find and run tasks.  If we can't find a runnable task, wait for one
@@ -291,21 +469,42 @@ Workqueue::find_and_run_task(int thread_number)
   Task* t;
   Task_locker tl;
 
-  {
-    Hold_lock hl(this->lock_);
+  while (true)
+    {
+      // Take a task from the run queues before we get the workqueue
+      // lock, so that threads only contend for that lock to check
+      // whether the task can run.
+      bool stolen = false;
+      Task* candidate = this->take_task(thread_number, &stolen);
 
-    // Find a runnable task.
-    t = this->find_runnable_or_wait(thread_number);
+      long long start = this->stats_time();
+      Hold_lock hl(this->lock_);
+      this->add_lock_wait(thread_number, start);
 
-    if (t == NULL)
-      return false;
+      if (candidate != NULL)
+	{
+	  --this->queued_;
+	  if (stolen && this->collect_stats_)
+	    ++this->thread_stats(thread_number)->steals;
+	}
 
-    // Get the locks for the task.  This must be called while we are
-    // still holding the Workqueue lock.
-    t->locks(&tl);
+      // Find a runnable task.
+      bool exit;
+      t = this->find_runnable_or_wait(thread_number, candidate, &exit);
 
-    ++this->running_;
-  }
+      if (exit)
+	return false;
+
+      if (t != NULL)
+	{
+	  // Get the locks for the task.  This must be called while we
+	  // are still holding the Workqueue lock.
+	  t->locks(&tl);
+
+	  ++this->running_;
+	  break;
+	}
+    }
 
   while (t != NULL)
     {
@@ -333,16 +532,20 @@ Workqueue::find_and_run_task(int thread_number)
 
       Task* next;
       {
+	long long start = this->stats_time();
 	Hold_lock hl(this->lock_);
+	this->add_lock_wait(thread_number, start);
 
 	--this->running_;
+	if (this->collect_stats_)
+	  ++this->thread_stats(thread_number)->tasks;
 
 	// Release the locks for the task.  This must be done with the
 	// workqueue lock held.  Get the next Task to run if any.
-	next = this->release_locks(t, &tl);
+	next = this->release_locks(t, &tl, thread_number);
 
 	if (next == NULL)
-	  next = this->find_runnable();
+	  next = this->find_runnable(thread_number);
 
 	// If we have another Task to run, get the Locks.  This must
 	// be called while we are still holding the Workqueue lock.
@@ -389,12 +592,16 @@ Workqueue::find_and_run_task(int thread_number)
 // 6) Otherwise, there are no other tasks to run, so we might as well
 // run this one now.
 
+// Runnable tasks which are not run soon go on the run queue of
+// THREAD_NUMBER, from which other threads may steal them.
+
 // This function must be called with the Workqueue lock held.
 
 // Return true if we set *PRET to T, false otherwise.
 
 bool
-Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
+Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret,
+			   int thread_number)
 {
   Task_token* token = t->is_runnable();
 
@@ -414,7 +621,7 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
     should_return = true;
   else if (t->should_run_soon())
     should_return = true;
-  else if (!this->first_tasks_.empty() || !this->tasks_.empty())
+  else if (!this->first_tasks_.empty() || this->queued_ > 0)
     should_queue = true;
   else
     should_return = true;
@@ -430,7 +637,7 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
       if (t->should_run_soon())
 	this->first_tasks_.push_back(t);
       else
-	this->tasks_.push_back(t);
+	this->push_run_queue(this->home_run_queue(thread_number), t, false);
       this->condvar_.signal();
       return false;
     }
@@ -444,7 +651,7 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
 // called with the Workqueue lock held.
 
 Task*
-Workqueue::release_locks(Task* t, Task_locker* tl)
+Workqueue::release_locks(Task* t, Task_locker* tl, int thread_number)
 {
   Task* ret = NULL;
   for (Task_locker::iterator p = tl->begin(); p != tl->end(); ++p)
@@ -460,7 +667,7 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 	      while ((t = token->remove_first_waiting()) != NULL)
 		{
 		  --this->waiting_;
-		  this->return_or_queue(t, true, &ret);
+		  this->return_or_queue(t, true, &ret, thread_number);
 		}
 	    }
 	}
@@ -477,7 +684,7 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 	  while ((t = token->remove_first_waiting()) != NULL)
 	    {
 	      --this->waiting_;
-	      if (this->return_or_queue(t, false, &ret))
+	      if (this->return_or_queue(t, false, &ret, thread_number))
 		break;
 	    }
 	}
@@ -518,4 +725,22 @@ Workqueue::add_blocker(Task_token* token)
   token->add_blocker();
 }
 
+// Print statistics to stderr.
+
+void
+Workqueue::print_stats()
+{
+  Hold_lock hl(this->lock_);
+  for (size_t i = 0; i < this->thread_stats_.size(); ++i)
+    {
+      const Thread_stats& ts(this->thread_stats_[i]);
+      fprintf(stderr,
+	      _("%s: workqueue thread %zu: tasks: %zu; steals: %zu; "
+		"lock wait: %lld.%06lld; idle: %lld.%06lld\n"),
+	      program_name, i, ts.tasks, ts.steals,
+	      ts.lock_wait / 1000000, ts.lock_wait % 1000000,
+	      ts.idle / 1000000, ts.idle % 1000000);
+    }
+}
+
 } // End namespace gold.
@@ -28,6 +28,7 @@
 #define GOLD_WORKQUEUE_H
 
 #include <string>
+#include <vector>
 
 #include "gold-threads.h"
 #include "token.h"
@@ -233,22 +234,77 @@ class Workqueue
   void
   add_blocker(Task_token*);
 
+  // Print statistics about the scheduling of tasks to stderr, for
+  // --stats.
+  void
+  print_stats();
+
  private:
   // This class can not be copied.
   Workqueue(const Workqueue&);
   Workqueue& operator=(const Workqueue&);
 
-  // Add a task to a queue.
+  // The maximum number of run queues.  Threads beyond this share
+  // run queues.
+  static const int max_run_queues = 64;
+
+  // A list of runnable tasks.  Each thread takes tasks from its own
+  // run queue first, and steals them from the other run queues when
+  // that one is empty.  The queues have their own locks so that
+  // taking a task does not need the master lock.
+  struct Run_queue
+  {
+    Run_queue()
+      : lock(), tasks()
+    { }
+
+    // Controls access to TASKS.
+    Lock lock;
+    // The tasks.
+    Task_list tasks;
+  };
+
+  // Statistics for a single thread, collected for --stats.  Times are
+  // in microseconds.
+  struct Thread_stats
+  {
+    Thread_stats()
+      : tasks(0), steals(0), lock_wait(0), idle(0)
+    { }
+
+    // Number of tasks run.
+    size_t tasks;
+    // Number of tasks taken from another thread's run queue.
+    size_t steals;
+    // Time spent waiting for the master lock.
+    long long lock_wait;
+    // Time spent waiting for a task.
+    long long idle;
+  };
+
+  // Add a task to a queue, or to the run queues if QUEUE is NULL.
   void
   add_to_queue(Task_list* queue, Task* t, bool front);
 
+  // Add a task to a run queue.
+  void
+  push_run_queue(int run_queue, Task* t, bool front);
+
+  // Take a task from a run queue, without the master lock.
+  Task*
+  take_task(int thread_number, bool* stolen);
+
+  // Return whether all the run queues are empty.
+  bool
+  run_queues_empty();
+
   // Find a runnable task, or wait for one.
   Task*
-  find_runnable_or_wait(int thread_number);
+  find_runnable_or_wait(int thread_number, Task* candidate, bool* pexit);
 
   // Find a runnable task.
   Task*
-  find_runnable();
+  find_runnable(int thread_number);
 
   // Find a runnable task in a list.
   Task*
@@ -260,11 +316,30 @@ class Workqueue
 
   // Release the locks for a Task.  Return the next Task to run.
   Task*
-  release_locks(Task*, Task_locker*);
+  release_locks(Task*, Task_locker*, int thread_number);
 
   // Store T into *PRET, or queue it as appropriate.
   bool
-  return_or_queue(Task* t, bool is_blocker, Task** pret);
+  return_or_queue(Task* t, bool is_blocker, Task** pret, int thread_number);
+
+  // Return the run queue used by a thread.
+  int
+  home_run_queue(int thread_number) const
+  { return thread_number % this->run_queue_count_; }
+
+  // Return the statistics for a thread.
+  Thread_stats*
+  thread_stats(int thread_number);
+
+  // Return the time to pass to add_lock_wait, or 0 if we are not
+  // collecting statistics.
+  long long
+  stats_time() const;
+
+  // Add the time since START, which was returned by stats_time, to
+  // the lock wait time of a thread.
+  void
+  add_lock_wait(int thread_number, long long start);
 
   // Return whether to cancel this thread.
   bool
@@ -275,8 +350,14 @@ class Workqueue
   Lock lock_;
   // List of tasks to execute soon.
   Task_list first_tasks_;
-  // List of tasks to execute after the ones in first_tasks_.
-  Task_list tasks_;
+  // Number of tasks on the run queues, plus the ones taken from a run
+  // queue by a thread which has not yet acquired the master lock.
+  // This counts the tasks to execute after the ones in first_tasks_.
+  int queued_;
+  // The run queue to which queue() adds the next task.
+  int next_run_queue_;
+  // Statistics for each thread, if we are collecting them.
+  std::vector<Thread_stats> thread_stats_;
   // Number of tasks currently running.
   int running_;
   // Number of tasks waiting for a lock to release.
@@ -288,6 +369,14 @@ class Workqueue
   // The threading implementation.  This is set at construction time
   // and not changed thereafter.
   Workqueue_threader* threader_;
+  // The run queues.  Each one has its own lock.
+  Run_queue run_queues_[max_run_queues];
+  // The number of run queues in use.  This is set at construction
+  // time and not changed thereafter.
+  int run_queue_count_;
+  // Whether to collect statistics.  This is set at construction time
+  // and not changed thereafter.
+  bool collect_stats_;
 };
 
 } // End namespace gold.
@@ -703,7 +703,8 @@ class Target_x86_64 : public Sized_target<size, false>
     : Sized_target<size, false>(info),
       got_(NULL), plt_(NULL), got_plt_(NULL), got_irelative_(NULL),
       got_tlsdesc_(NULL), global_offset_table_(NULL), rela_dyn_(NULL),
-      rela_irelative_(NULL), copy_relocs_(elfcpp::R_X86_64_COPY),
+      relr_dyn_(NULL), rela_irelative_(NULL),
+      copy_relocs_(elfcpp::R_X86_64_COPY),
       got_mod_index_offset_(-1U), tlsdesc_reloc_info_(),
       tls_base_symbol_defined_(false), isa_1_used_(0), isa_1_needed_(0),
       feature_1_(0), object_isa_1_used_(0), object_feature_1_(0),
@@ -1365,6 +1366,8 @@ class Target_x86_64 : public Sized_target<size, false>
   Symbol* global_offset_table_;
   // The dynamic reloc section.
   Reloc_section* rela_dyn_;
+  // The SHT_RELR section for -z pack-relative-relocs.
+  Output_data_relr<size, false>* relr_dyn_;
   // The section to use for IRELATIVE relocs.
   Reloc_section* rela_irelative_;
   // Relocs saved to avoid a COPY reloc.
@@ -1553,6 +1556,18 @@ Target_x86_64<size>::rela_dyn_section(Layout* layout)
       layout->add_output_section_data(".rela.dyn", elfcpp::SHT_RELA,
 				      elfcpp::SHF_ALLOC, this->rela_dyn_,
 				      ORDER_DYNAMIC_RELOCS, false);
+
+      // With -z pack-relative-relocs, the R_X86_64_RELATIVE relocs go
+      // in a compact SHT_RELR section where possible.  The section is
+      // only added to the layout by do_finalize_sections, if some
+      // relocs were packed.
+      if (parameters->options().pack_relative_relocs()
+	  && !parameters->doing_static_link())
+	{
+	  this->relr_dyn_ =
+	    new Output_data_relr<size, false>(elfcpp::R_X86_64_RELATIVE);
+	  this->rela_dyn_->set_relr_section(this->relr_dyn_);
+	}
     }
   return this->rela_dyn_;
 }
@@ -4528,6 +4543,17 @@ Target_x86_64<size>::do_finalize_sections(
 	  odyn->add_section_plus_offset(elfcpp::DT_TLSDESC_GOT,
 					this->got_, got_offset);
 	}
+
+      if (this->relr_dyn_ != NULL && this->relr_dyn_->any_relocs())
+	{
+	  layout->add_output_section_data(".relr.dyn", elfcpp::SHT_RELR,
+					  elfcpp::SHF_ALLOC, this->relr_dyn_,
+					  ORDER_DYNAMIC_RELOCS, false);
+	  Output_section* os = this->relr_dyn_->output_section();
+	  odyn->add_section_address(elfcpp::DT_RELR, os);
+	  odyn->add_section_size(elfcpp::DT_RELRSZ, os);
+	  odyn->add_constant(elfcpp::DT_RELRENT, size / 8);
+	}
     }
 
   // Emit any relocs we saved in an attempt to avoid generating COPY
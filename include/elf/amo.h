@@ -31,6 +31,13 @@ START_RELOC_NUMBERS (elf_amo_reloc_type)
     RELOC_NUMBER (R_AMO_PCREL, 2)
     RELOC_NUMBER (R_AMO_28, 3)
     RELOC_NUMBER (R_AMO_32, 4)
+    RELOC_NUMBER (R_AMO_21, 5)
 END_RELOC_NUMBERS (R_AMO_max)
 
+/* Processor specific flags for the ELF header e_flags field.  */
+
+/* Every pc-relative reference of the object carries a reloc, so the
+   linker may delete the literal words it relaxes away.  */
+#define EF_AMO_LINKRELAX_PREPARED 0x1
+
 #endif
\ No newline at end of file
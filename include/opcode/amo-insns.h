@@ -0,0 +1,141 @@
+/* amo-insns.h -- AMO instruction set description
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of GDB, GAS, and the GNU binutils.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* This is the only place where the encoding of the AMO instructions is
+   written down.  Define the macros below before including this file,
+   the ones left undefined expand to nothing:
+
+   AMO_FIELD (NAME, SHIFT, WIDTH)
+	a bit field of the 32-bit instruction word.
+
+   AMO_FORMAT (NAME, REG0, REG1, REG2, IMM_OPERAND, IMM, KIND)
+	how the operands are placed in the word: REGn is the field of the
+	register of the n-th operand (the base register of a dereference),
+	IMM the field of the immediate held by the operand IMM_OPERAND and
+	KIND how that immediate is checked and scaled.  NONE stands for no
+	field.
+
+   AMO_INSN (ID, MNEMONIC, OPCODE, OPERANDS, FORMAT)
+	one form of an instruction.  The forms of a mnemonic are adjacent
+	and the assembler picks the first one whose OPERANDS match.
+
+   AMO_PSEUDO (ID, MNEMONIC, OPCODE, OPERANDS, FORMAT)
+	a form the assembler expands, OPCODE never appears in the binary.  */
+
+#ifndef AMO_FIELD
+#define AMO_FIELD(name, shift, width)
+#endif
+#ifndef AMO_FORMAT
+#define AMO_FORMAT(name, reg0, reg1, reg2, imm_operand, imm, kind)
+#endif
+#ifndef AMO_INSN
+#define AMO_INSN(id, mnemonic, opcode, operands, format)
+#endif
+#ifndef AMO_PSEUDO
+#define AMO_PSEUDO(id, mnemonic, opcode, operands, format)
+#endif
+
+/* fields */
+AMO_FIELD (OPCODE, 26, 6)
+AMO_FIELD (RA, 21, 5)
+AMO_FIELD (RB, 16, 5)
+AMO_FIELD (RC, 11, 5)
+AMO_FIELD (IMM8, 0, 8)
+AMO_FIELD (IMM16, 0, 16)
+AMO_FIELD (IMM21, 0, 21)
+AMO_FIELD (IMM26, 0, 26)
+
+/* formats */
+AMO_FORMAT (NONE, NONE, NONE, NONE, 0, NONE, NONE)
+AMO_FORMAT (ARITH_IMM, RB, RA, NONE, 2, IMM16, SIGNED)
+AMO_FORMAT (LOGIC_IMM, RB, RA, NONE, 2, IMM16, UNSIGNED)
+AMO_FORMAT (REG3, RC, RA, RB, 0, NONE, NONE)
+AMO_FORMAT (NOT_IMM, RB, NONE, NONE, 1, IMM16, UNSIGNED)
+AMO_FORMAT (NOT_REG, RC, RB, NONE, 0, NONE, NONE)
+AMO_FORMAT (MOV_IMM, RA, NONE, NONE, 1, IMM21, SIGNED)
+AMO_FORMAT (MOV_REG, RA, RB, NONE, 0, NONE, NONE)
+AMO_FORMAT (MOV_LITERAL, RA, NONE, NONE, 1, IMM21, LITERAL)
+AMO_FORMAT (LOAD_REL, RA, NONE, NONE, 1, IMM21, SIGNED)
+AMO_FORMAT (LOAD, RB, RA, NONE, 1, IMM16, SIGNED)
+AMO_FORMAT (STORE_REL, NONE, RA, NONE, 0, IMM21, SIGNED)
+AMO_FORMAT (STORE, RA, RB, NONE, 0, IMM16, SIGNED)
+AMO_FORMAT (BRANCH, RA, RB, NONE, 2, IMM16, PCREL)
+AMO_FORMAT (JUMP, NONE, NONE, NONE, 0, IMM26, ABSOLUTE)
+AMO_FORMAT (JUMP_REG, RA, NONE, NONE, 0, NONE, NONE)
+AMO_FORMAT (SWI, NONE, NONE, NONE, 0, IMM8, UNSIGNED)
+AMO_FORMAT (SETVT, RA, NONE, NONE, 1, IMM16, UNCHECKED)
+
+/* instructions */
+AMO_PSEUDO (NOP, nop, PSEUDO_NOP, N, NONE)
+AMO_INSN (ADDI, add, 0x00, RRC, ARITH_IMM)
+AMO_INSN (ADD, add, 0x01, RRR, REG3)
+AMO_INSN (ADCI, adc, 0x02, RRC, ARITH_IMM)
+AMO_INSN (ADC, adc, 0x03, RRR, REG3)
+AMO_INSN (SUBI, sub, 0x04, RRC, ARITH_IMM)
+AMO_INSN (SUB, sub, 0x05, RRR, REG3)
+AMO_INSN (ANDI, and, 0x06, RRC, LOGIC_IMM)
+AMO_INSN (AND, and, 0x07, RRR, REG3)
+AMO_INSN (ORI, or, 0x08, RRC, LOGIC_IMM)
+AMO_INSN (OR, or, 0x09, RRR, REG3)
+AMO_INSN (XORI, xor, 0x0a, RRC, LOGIC_IMM)
+AMO_INSN (XOR, xor, 0x0b, RRR, REG3)
+AMO_INSN (NOTI, not, 0x0c, RC, NOT_IMM)
+AMO_INSN (NOT, not, 0x0d, RR, NOT_REG)
+AMO_INSN (LSLI, lsl, 0x0e, RRC, LOGIC_IMM)
+AMO_INSN (LSL, lsl, 0x0f, RRR, REG3)
+AMO_INSN (LSRI, lsr, 0x10, RRC, LOGIC_IMM)
+AMO_INSN (LSR, lsr, 0x11, RRR, REG3)
+AMO_INSN (ASRI, asr, 0x12, RRC, LOGIC_IMM)
+AMO_INSN (ASR, asr, 0x13, RRR, REG3)
+AMO_INSN (MOVI, mov, 0x14, RC, MOV_IMM)
+AMO_INSN (MOV, mov, 0x15, RR, MOV_REG)
+AMO_PSEUDO (MOV_SYM, mov, PSEUDO_MOV, RS, MOV_LITERAL)
+AMO_INSN (LDR_REL, ldr, 0x16, RD_R, LOAD_REL)
+AMO_INSN (LDR, ldr, 0x17, RD, LOAD)
+AMO_INSN (STR_REL, str, 0x18, D_RR, STORE_REL)
+AMO_INSN (STR, str, 0x19, DR, STORE)
+AMO_INSN (BEQ, beq, 0x1a, RRS, BRANCH)
+AMO_INSN (BNE, bne, 0x1b, RRS, BRANCH)
+AMO_INSN (BLT, blt, 0x1c, RRS, BRANCH)
+AMO_INSN (BLE, ble, 0x1d, RRS, BRANCH)
+AMO_INSN (JMPI, jmp, 0x1e, S, JUMP)
+AMO_INSN (JMP, jmp, 0x1f, R, JUMP_REG)
+AMO_INSN (JALI, jal, 0x20, S, JUMP)
+AMO_INSN (JAL, jal, 0x21, R, JUMP_REG)
+AMO_INSN (SWI, swi, 0x22, C, SWI)
+AMO_INSN (BLTU, bltu, 0x23, RRS, BRANCH)
+AMO_INSN (BLEU, bleu, 0x24, RRS, BRANCH)
+AMO_INSN (EXT, ext, 0x25, RRC, LOGIC_IMM)
+AMO_INSN (LDRB_REL, ldrb, 0x26, RD_R, LOAD_REL)
+AMO_INSN (LDRB, ldrb, 0x27, RD, LOAD)
+AMO_INSN (STRB_REL, strb, 0x28, D_RR, STORE_REL)
+AMO_INSN (STRB, strb, 0x29, DR, STORE)
+AMO_INSN (LDRH_REL, ldrh, 0x2a, RD_R, LOAD_REL)
+AMO_INSN (LDRH, ldrh, 0x2b, RD, LOAD)
+AMO_INSN (STRH_REL, strh, 0x2c, D_RR, STORE_REL)
+AMO_INSN (STRH, strh, 0x2d, DR, STORE)
+AMO_INSN (SETVT, setvt, 0x2e, RC, SETVT)
+AMO_INSN (RET, ret, 0x2f, R, JUMP_REG)
+AMO_INSN (LOCK, lock, 0x30, N, NONE)
+
+#undef AMO_FIELD
+#undef AMO_FORMAT
+#undef AMO_INSN
+#undef AMO_PSEUDO
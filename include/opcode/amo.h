@@ -7,11 +7,8 @@
 /* max number of operands used for one instruction */
 #define OPERAND_PER_INSTRUCTION_MAX 4
 
-/* max number of operations that one instruction can perform */
-#define OPERATION_PER_INSTRUCTION_MAX 4
-
-/* total number of instructions */
-#define INSTRUCTION_NUMBER_MAX 10
+/* number of opcodes that can be encoded in the 6-bit opcode field */
+#define OPCODE_NUMBER_MAX 64
 
 /* mnemonic */
 #define MNEMONIC_LENGTH_MAX 10
@@ -21,6 +18,10 @@
 #define LITERAL_POOL_SIZE_DEFAULT 16
 #define LITERAL_POOL_NAME_DEFAULT ".__litpol_chunk_%x_"
 #define LITERAL_POOL_NAME_LENGTH 42
+/* reach of the 21-bit pc-relative literal load */
+#define LITERAL_POOL_RANGE 1048576
+/* bytes of code after which a pending pool is dumped at the next unconditional jump */
+#define LITERAL_POOL_DISTANCE_DEFAULT 65536
 
 /* pseudo opcode */
 /* these opcodes must be eight-bits and have 1 in their MSB */
@@ -30,40 +31,17 @@
 /* system */
 #define IS_BIG_ENDIAN (!(union { uint16_t u16; unsigned char u8; }){ .u16 = 1 }.u8)
 
-#define OPCODESX(name) amo_opcode_t name##_opcodes[] = {
-#define ENDOPCODESX };
-#define OPX(mnemonic) { #mnemonic, {
-#define ENDOPX } },
-
-#define OPFUNCS(name) amo_opfunc_t name##_opfuncs[] = {
-#define ENDOPFUNCS };
-#define FUNC(mnemonic) { {
-#define ENDFUNC } },
-
-#define DECFUNCS(name) amo_decfunc_t name##_decfuncs[] = {
-#define ENDDECFUNCS };
-#define DECFUNC(mnemonic) { {
-#define ENDDECFUNC } },
-
-/* the instruction executor can receive the following macros as parameter */
-#define TYPE_NONE -1
-#define TYPE_IMM 0
-#define TYPE_SYM 1
-#define TYPE_REG 2
-#define TYPE_DEREF 3
-#define TYPE_DREL 4
-
-/* mask */
-#define MASK_REGISTER 0x1F
-#define MASK_IMM8 0xFF
-#define MASK_IMM16 0xFFFF
-#define MASK_IMM21 0x1FFFFF
-#define MASK_IMM26 0x3FFFFFF
-
 /* used to define the dereference */
 #define O_dereference O_md1
 #define O_dereference_rel O_md2
 
+/* operand types of the conditions, the operatorT gas gives each operand */
+#define OPERAND_CONST 2
+#define OPERAND_SYM 3
+#define OPERAND_REG 5
+#define OPERAND_DEREF 30
+#define OPERAND_DEREF_REL 31
+
 typedef struct
 {
 	/* total number of operation */
@@ -74,22 +52,133 @@ typedef struct
 	
 } operand_cond_t;
 
+/* fields of the instruction word */
+enum amo_field
+{
+#define AMO_FIELD(name, shift, width) AMO_FIELD_##name,
+#include "amo-insns.h"
+	AMO_FIELD_NONE
+};
+
+enum
+{
+#define AMO_FIELD(name, shift, width) AMO_SHIFT_##name = shift, AMO_WIDTH_##name = width,
+#include "amo-insns.h"
+	AMO_WIDTH_WORD = 32
+};
+
+/* extract, insert and check the fields known at compile time */
+#define AMO_MASK(field) ((1U << AMO_WIDTH_##field) - 1)
+#define AMO_GET(field, insn) (((insn) >> AMO_SHIFT_##field) & AMO_MASK (field))
+#define AMO_PUT(field, value) (((value) & AMO_MASK (field)) << AMO_SHIFT_##field)
+#define AMO_SIGN(field) (1L << (AMO_WIDTH_##field - 1))
+#define AMO_SEXT(field, insn) (((long) AMO_GET (field, insn) ^ AMO_SIGN (field)) - AMO_SIGN (field))
+#define AMO_SMIN(field) (-AMO_SIGN (field))
+#define AMO_SMAX(field) (AMO_SIGN (field) - 1)
+#define AMO_UMAX(field) ((long) AMO_MASK (field))
+
+/* how an immediate is checked and scaled */
+enum amo_imm_kind
+{
+	AMO_IMM_NONE,
+	AMO_IMM_SIGNED,
+	AMO_IMM_UNSIGNED,
+	/* written as is */
+	AMO_IMM_UNCHECKED,
+	/* signed word offset from the next instruction */
+	AMO_IMM_PCREL,
+	/* word address */
+	AMO_IMM_ABSOLUTE,
+	/* loaded from the literal pool when it does not fit */
+	AMO_IMM_LITERAL
+};
+
+enum amo_format
+{
+#define AMO_FORMAT(name, reg0, reg1, reg2, imm_operand, imm, kind) AMO_FORMAT_##name,
+#include "amo-insns.h"
+	AMO_FORMAT_MAX
+};
+
+/* index of each form in amo_opcodes */
+enum amo_insn_id
+{
+#define AMO_INSN(id, mnemonic, opcode, operands, format) AMO_INSN_##id,
+#define AMO_PSEUDO(id, mnemonic, opcode, operands, format) AMO_INSN_##id,
+#include "amo-insns.h"
+	AMO_INSN_MAX
+};
+
+/* opcode of each form */
+enum amo_opcode
+{
+#define AMO_INSN(id, mnemonic, opcode, operands, format) AMO_OP_##id = opcode,
+#define AMO_PSEUDO(id, mnemonic, opcode, operands, format) AMO_OP_##id = opcode,
+#include "amo-insns.h"
+	AMO_OP_NONE = -1
+};
+
+/* number of register operands a format can place */
+#define FORMAT_REGISTER_MAX 3
+
+typedef struct
+{
+	unsigned char shift;
+	unsigned char width;
+} amo_field_t;
+
+typedef struct
+{
+	/* field of the register of each operand (enum amo_field) */
+	unsigned char regs[FORMAT_REGISTER_MAX];
+
+	/* operand holding the immediate, its field and kind */
+	unsigned char imm_operand;
+	unsigned char imm;
+	unsigned char kind;
+} amo_format_t;
+
 typedef struct
 {
 	/* mnemonic */
 	const char *name;
 
-	/* different operations represented by the same mnemonic */
-	struct
-	{	
-		/* condition */
-		operand_cond_t condition;
-		/* opcode */
-		unsigned char opcode;
-	} operations[OPERATION_PER_INSTRUCTION_MAX];
+	/* condition */
+	operand_cond_t condition;
+
+	/* opcode and encoding */
+	unsigned char opcode;
+	unsigned char format;
 } amo_opcode_t;
 
-extern amo_opcode_t amo_opcodes[];
-extern unsigned int amo_opcodes_size;
+extern const amo_field_t amo_fields[];
+extern const amo_format_t amo_formats[];
+extern const amo_opcode_t amo_opcodes[];
+
+/* opcode dispatch table: the form of each 6-bit opcode, NULL for the
+   unused ones */
+extern const amo_opcode_t *const amo_dispatch_table[OPCODE_NUMBER_MAX];
+
+/* the same accessors for a field chosen at run time */
+static inline unsigned int
+amo_field_get (enum amo_field field, unsigned int insn)
+{
+	return (insn >> amo_fields[field].shift) & ((1U << amo_fields[field].width) - 1);
+}
+
+static inline unsigned int
+amo_field_put (enum amo_field field, unsigned int value)
+{
+	return (value & ((1U << amo_fields[field].width) - 1)) << amo_fields[field].shift;
+}
+
+static inline long
+amo_field_sext (enum amo_field field, unsigned int insn)
+{
+	long sign;
+
+	sign = 1L << (amo_fields[field].width - 1);
+	return ((long) amo_field_get (field, insn) ^ sign) - sign;
+}
 
 #endif
@@ -1,11 +1,11 @@
 ARCH=amo
 MACHINE=
-SCRIPT_NAME=elf32amo
+SCRIPT_NAME=elf
 OUTPUT_FORMAT="elf32-amo"
 MAXPAGESIZE=0x1000
 EMBEDDED=yes
 TEMPLATE_NAME=elf32
+EXTRA_EM_FILE=amoelf
 TEXT_START_ADDR=0x0000
 DYNAMIC_LINK=FALSE
 ALIGNMENT=4
-
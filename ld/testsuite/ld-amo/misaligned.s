@@ -0,0 +1,13 @@
+# a branch to a target that is not word aligned cannot be encoded
+
+	.text
+	.global _start
+_start:
+	beq	r1, r2, odd
+	ret	lr
+
+	.section .text.odd, "ax"
+	.byte	1
+	.global odd
+odd:
+	ret	lr
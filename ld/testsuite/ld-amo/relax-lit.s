@@ -0,0 +1,20 @@
+# literal loads of values that fit a mov are relaxed, and the pool words
+# nothing reads any more are deleted
+
+	.text
+	.global _start
+_start:
+	mov	r1, small
+	mov	r2, $0x12345678
+	mov	r3, big
+	mov	r4, small
+	beq	r1, r2, done
+	jmp	_start
+done:
+	ret	lr
+	.ltorg
+
+	.data
+	.global small
+small:
+	.word	0
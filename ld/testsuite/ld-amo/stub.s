@@ -0,0 +1,20 @@
+# conditional branches out of reach go through a stub placed before
+# their section
+
+	.text
+	.global _start
+_start:
+	beq	r1, r2, far
+	bne	r3, r4, far
+	blt	r1, r2, near
+	ret	lr
+near:
+	ret	lr
+
+	.section .text.pad, "ax"
+	.space	0x40000
+
+	.section .text.far, "ax"
+	.global far
+far:
+	ret	lr
@@ -21,13 +21,10 @@
    02110-1301, USA.  */
 
 #include "sysdep.h"
+#include <stdarg.h>
 #include "opcode/amo.h"
 #include "disassemble.h"
 #include "bfd.h"
-#include <stdio.h>
-
-#define ENTRY(func, p) { dec_##func, p },
-#define DECODE(name, ptype, pname) static void dec_##name (ptype pname)
 
 const char *REGS_STRING[33] = {
 	"r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
@@ -36,413 +33,138 @@ const char *REGS_STRING[33] = {
 	"r24", "r25", "r26", "r27", "r28", "fp", "sp", "lr",
 	NULL
 };
-#define REGS(n) ((0 <= n && n <= 31) ? REGS_STRING[n] : "INVALID_REG")
+#define REGS(n) ((unsigned int) (n) <= 31 ? REGS_STRING[n] : "INVALID_REG")
 
+/* decoding state of one instruction, private to each print_insn_amo call */
 struct amo_instruction_dec
 {
-	char name[MNEMONIC_LENGTH_MAX];
+	const amo_opcode_t *op;
+	const amo_format_t *format;
 	unsigned int binary;
-	unsigned char opcode;
-};
-
-typedef struct amo_decfunc
-{
-	struct
-	{
-		void (*f)(int param);
-		int parameter;
-	} operations[OPERATION_PER_INSTRUCTION_MAX];
-} amo_decfunc_t;
-
-static char buf[DISASSEMBLE_DECODE_LENGTH + 1];
-static struct amo_instruction_dec insn_dec;
-
-DECODE(nop, int, type ATTRIBUTE_UNUSED)
-{
-	sprintf (buf, "nop");
-}
-
-/* in decoding parts, decode the arithmetic and logical instruction together */
-DECODE(arithmetic, int, type)
-{
-	unsigned int src, dst, opn;
-	unsigned short imm;
-
-	src = (insn_dec.binary >> 21) & MASK_REGISTER;
-	if (type == TYPE_IMM)
-	{
-		dst = (insn_dec.binary >> 16) & MASK_REGISTER;
-		imm = insn_dec.binary & MASK_IMM16;
-
-		sprintf (buf, "%-5s%s, %s, $0x%hx (%hd)", insn_dec.name, REGS(dst), REGS(src), imm, imm);
-		return ;
-	}
-	else if (type == TYPE_REG)
-	{
-		opn = (insn_dec.binary >> 16) & MASK_REGISTER;
-		dst = (insn_dec.binary >> 11) & MASK_REGISTER;
-
-		sprintf (buf, "%-5s%s, %s, %s", insn_dec.name, REGS(dst), REGS(src), REGS(opn));
-		return ;
-	}
-
-	/* impossible */
-	abort ();
-}
-
-DECODE(not, int, type)
-{
-	unsigned int src, dst;
-	unsigned short imm;
-
-	if (type == TYPE_IMM)
-	{
-		dst = (insn_dec.binary >> 16) & MASK_REGISTER;
-		imm = insn_dec.binary & MASK_IMM16;
 
-		sprintf (buf, "%-5s%s, $0x%hx (%hd)", insn_dec.name, REGS(dst), imm, imm);
-		return ;
-	}
-	else if (type == TYPE_REG)
-	{
-		src = (insn_dec.binary >> 16) & MASK_REGISTER;
-		dst = (insn_dec.binary >> 11) & MASK_REGISTER;
-
-		sprintf (buf, "%-5s%s, %s", insn_dec.name, REGS(dst), REGS(src));
-		return ;
-	}
-
-	/* impossible */
-	abort ();
-}
-
-DECODE(mov, int, type)
-{
-	unsigned int src, dst;
-	unsigned int imm;
-
-	dst = (insn_dec.binary >> 21) & MASK_REGISTER;
-	if (type == TYPE_IMM)
-	{
-		imm = insn_dec.binary & MASK_IMM21;
-		if ((imm >> 20))
-			imm |= 0xFFE00000;
-
-		sprintf (buf, "%-5s%s, $0x%x (%d)", insn_dec.name, REGS(dst), imm, imm);
-		return ;
-	}
-	else if (type == TYPE_REG)
-	{
-		src = (insn_dec.binary >> 16) & MASK_REGISTER;
-
-		sprintf (buf, "%-5s%s, %s", insn_dec.name, REGS(dst), REGS(src));
-		return ;
-	}
-
-	/* impossible */
-	abort ();
-}
+	/* decoded text */
+	char buf[DISASSEMBLE_DECODE_LENGTH + 1];
+	int length;
+};
 
-DECODE(ldr, int, type)
+static void
+dec_append (struct amo_instruction_dec *dec, const char *fmt, ...)
 {
-	unsigned int base, dst;
-	unsigned int imm;
-
-	if (type == TYPE_DREL)
-	{
-		dst = (insn_dec.binary >> 21) & MASK_REGISTER;
-		imm = insn_dec.binary & MASK_IMM21;
-		if ((imm >> 20))
-			imm |= 0xFFE00000;
-
-		sprintf (buf, "%-5s%s, [$0x%x]", insn_dec.name, REGS(dst), imm);
-		return ;
-	}
-	else if (type == TYPE_DEREF)
-	{
-		base = (insn_dec.binary >> 21) & MASK_REGISTER;
-		dst = (insn_dec.binary >> 16) & MASK_REGISTER;
-		imm = insn_dec.binary & MASK_IMM16;
-		if ((imm >> 15))
-			imm |= 0xFFFF0000;
+	va_list ap;
+	int n;
 
-		if (imm)
-			sprintf (buf, "%-5s%s, [%s, $0x%x]", insn_dec.name, REGS(dst), REGS(base), imm);
-		else
-			sprintf (buf, "%-5s%s, [%s]", insn_dec.name, REGS(dst), REGS(base));
-		return ;
-	}
+	va_start (ap, fmt);
+	n = vsnprintf (dec->buf + dec->length, sizeof (dec->buf) - dec->length, fmt, ap);
+	va_end (ap);
 
-	/* impossible */
-	abort ();
+	if (n > 0)
+		dec->length += n;
+	if (dec->length >= (int) sizeof (dec->buf))
+		dec->length = sizeof (dec->buf) - 1;
 }
 
-DECODE(str, int, type)
+/* the immediate as the format scales it */
+static long
+dec_immediate (struct amo_instruction_dec *dec)
 {
-	unsigned int base, dst;
-	unsigned int imm;
-
-	if (type == TYPE_DREL)
-	{
-		dst = (insn_dec.binary >> 21) & MASK_REGISTER;
-		imm = insn_dec.binary & MASK_IMM21;
-		if ((imm >> 20))
-			imm |= 0xFFE00000;
+	enum amo_field field;
 
-		sprintf (buf, "%-5s[$0x%x], %s", insn_dec.name, imm, REGS(dst));
-		return ;
-	}
-	else if (type == TYPE_DEREF)
+	field = dec->format->imm;
+	switch (dec->format->kind)
 	{
-		base = (insn_dec.binary >> 21) & MASK_REGISTER;
-		dst = (insn_dec.binary >> 16) & MASK_REGISTER;
-		imm = insn_dec.binary & MASK_IMM16;
-		if ((imm >> 15))
-			imm |= 0xFFFF0000;
-
-		if (imm)
-			sprintf (buf, "%-5s[%s, $0x%x], %s", insn_dec.name, REGS(base), imm, REGS(dst));
-		else
-			sprintf (buf, "%-5s[%s], %s", insn_dec.name, REGS(base), REGS(dst));
-		return ;
+		case AMO_IMM_SIGNED:
+		case AMO_IMM_LITERAL:
+			return amo_field_sext (field, dec->binary);
+		case AMO_IMM_PCREL:
+			return amo_field_sext (field, dec->binary) * BYTES_PER_INSTRUCTION;
+		case AMO_IMM_ABSOLUTE:
+			return (long) amo_field_get (field, dec->binary) * BYTES_PER_INSTRUCTION;
+		default:
+			return amo_field_get (field, dec->binary);
 	}
-
-	/* impossible */
-	abort ();
-}
-
-DECODE(branch, int, type ATTRIBUTE_UNUSED)
-{
-	unsigned int src, opn;
-	unsigned int imm;
-
-	src = (insn_dec.binary >> 21) & MASK_REGISTER;
-	opn = (insn_dec.binary >> 16) & MASK_REGISTER;
-
-	imm = insn_dec.binary & MASK_IMM16;
-	if ((imm >> 15))
-		imm |= 0xFFFF0000;
-
-	sprintf (buf, "%-5s%s, %s, $0x%x (%d)", insn_dec.name, REGS(src), REGS(opn), imm << 2, imm << 2);
 }
 
-DECODE(jump, int, type)
+/* operands are printed in the order they are written */
+static void
+dec_operand (struct amo_instruction_dec *dec, int i)
 {
-	unsigned int src;
+	const char *reg;
 	unsigned int imm;
 
-	if (type == TYPE_IMM)
-	{
-		imm = insn_dec.binary & MASK_IMM21;
-		if ((imm >> 20))
-			imm |= 0xFFE00000;
+	reg = REGS (amo_field_get (dec->format->regs[i], dec->binary));
+	imm = (unsigned int) dec_immediate (dec);
 
-		sprintf (buf, "%-5s$0x%x", insn_dec.name, imm << 2);
-		return ;
-	}
-	else if (type == TYPE_REG)
+	switch (dec->op->condition.types[i])
 	{
-		src = (insn_dec.binary >> 21) & MASK_REGISTER;
-
-		sprintf (buf, "%-5s%s", insn_dec.name, REGS(src));
-		return ;
+		case OPERAND_REG:
+			dec_append (dec, "%s", reg);
+			break;
+
+		case OPERAND_CONST:
+			dec_append (dec, "$0x%x (%d)", imm, (int) imm);
+			break;
+
+		case OPERAND_SYM:
+			if (dec->format->kind == AMO_IMM_PCREL)
+				dec_append (dec, "$0x%x (%d)", imm, (int) imm);
+			else
+				dec_append (dec, "$0x%x", imm);
+			break;
+
+		case OPERAND_DEREF:
+			if (imm)
+				dec_append (dec, "[%s, $0x%x]", reg, imm);
+			else
+				dec_append (dec, "[%s]", reg);
+			break;
+
+		case OPERAND_DEREF_REL:
+			dec_append (dec, "[$0x%x]", imm);
+			break;
+
+		default:
+			/* impossible */
+			abort ();
 	}
-
-	/* impossible */
-	abort ();
 }
 
-DECODE(swi, int, type ATTRIBUTE_UNUSED)
-{
-	unsigned int imm;
-
-	imm = insn_dec.binary & MASK_IMM8;
-
-	sprintf (buf, "%-5s$0x%x (%d)", insn_dec.name, imm, imm);
-}
-
-DECODE(setvt, int, type ATTRIBUTE_UNUSED)
-{
-	unsigned int src, imm;
-
-	src = (insn_dec.binary >> 21) & MASK_REGISTER;
-	imm = insn_dec.binary & MASK_IMM16;
-
-	sprintf (buf, "%-7s%s, $0x%x (%d)", insn_dec.name, REGS(src), imm, imm);
-}
-
-DECODE(ret, int, type ATTRIBUTE_UNUSED)
-{
-	unsigned int src;
-
-	src = (insn_dec.binary >> 21) & MASK_REGISTER;
-
-	sprintf (buf, "%-5s%s", insn_dec.name, REGS(src));
-}
-
-DECODE(lock, int, type ATTRIBUTE_UNUSED)
-{
-	sprintf (buf, "%-5s", insn_dec.name);
-}
-
-DECFUNCS(amo)
-
-DECFUNC(nop)
-	ENTRY(nop, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(add)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(adc)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(sub)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(and)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(or)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(xor)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(not)
-	ENTRY(not, TYPE_IMM)
-	ENTRY(not, TYPE_REG)
-ENDDECFUNC
-DECFUNC(lsl)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(lsr)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(asr)
-	ENTRY(arithmetic, TYPE_IMM)
-	ENTRY(arithmetic, TYPE_REG)
-ENDDECFUNC
-DECFUNC(mov)
-	ENTRY(mov, TYPE_IMM)
-	ENTRY(mov, TYPE_REG)
-ENDDECFUNC
-DECFUNC(ldr)
-	ENTRY(ldr, TYPE_DREL)
-	ENTRY(ldr, TYPE_DEREF)
-ENDDECFUNC
-DECFUNC(str)
-	ENTRY(str, TYPE_DREL)
-	ENTRY(str, TYPE_DEREF)
-ENDDECFUNC
-DECFUNC(beq)
-	ENTRY(branch, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(bne)
-	ENTRY(branch, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(blt)
-	ENTRY(branch, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(ble)
-	ENTRY(branch, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(jmp)
-	ENTRY(jump, TYPE_IMM)
-	ENTRY(jump, TYPE_REG)
-ENDDECFUNC
-DECFUNC(jal)
-	ENTRY(jump, TYPE_IMM)
-	ENTRY(jump, TYPE_REG)
-ENDDECFUNC
-DECFUNC(swi)
-	ENTRY(swi, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(bltu)
-	ENTRY(branch, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(bleu)
-	ENTRY(branch, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(ext)
-	ENTRY(arithmetic, TYPE_IMM)
-ENDDECFUNC
-DECFUNC(ldrb)
-	ENTRY(ldr, TYPE_DREL)
-	ENTRY(ldr, TYPE_DEREF)
-ENDDECFUNC
-DECFUNC(strb)
-	ENTRY(str, TYPE_DREL)
-	ENTRY(str, TYPE_DEREF)
-ENDDECFUNC
-DECFUNC(ldrh)
-	ENTRY(ldr, TYPE_DREL)
-	ENTRY(ldr, TYPE_DEREF)
-ENDDECFUNC
-DECFUNC(strh)
-	ENTRY(str, TYPE_DREL)
-	ENTRY(str, TYPE_DEREF)
-ENDDECFUNC
-DECFUNC(setvt)
-	ENTRY(setvt, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(ret)
-	ENTRY(ret, TYPE_NONE)
-ENDDECFUNC
-DECFUNC(lock)
-	ENTRY(lock, TYPE_NONE)
-ENDDECFUNC
-
-ENDDECFUNCS
-
 int print_insn_amo(bfd_vma addr, disassemble_info *info)
 {
 	unsigned char b[BYTES_PER_INSTRUCTION];
-	unsigned int i, j;
+	struct amo_instruction_dec dec;
+	int status, i;
 
-	memset (buf, 0, sizeof (buf));
-	memset (&insn_dec, 0, sizeof (struct amo_instruction_dec));
-	if (info->read_memory_func (addr, (bfd_byte *) b, BYTES_PER_INSTRUCTION, info))
+	status = info->read_memory_func (addr, (bfd_byte *) b, BYTES_PER_INSTRUCTION, info);
+	if (status)
 	{
-		info->fprintf_func (info->stream, "Error: failed to read binary.\n");
+		info->memory_error_func (status, addr, info);
 		return -1;
 	}	
-	insn_dec.binary = (b[3] << 24) | (b[2] << 16) | (b[1] << 8) | b[0];
-	insn_dec.opcode = (insn_dec.binary >> 26);
-
-	for (i = 0; i < amo_opcodes_size; i++)
+	dec.binary = (b[3] << 24) | (b[2] << 16) | (b[1] << 8) | b[0];
+	dec.length = 0;
+	dec.buf[0] = '\0';
+
+	dec.op = amo_dispatch_table[AMO_GET (OPCODE, dec.binary)];
+	if (!dec.op)
+		dec_append (&dec, "unsupported opcode");
+	else
 	{
-		for (j = 0; j < OPERATION_PER_INSTRUCTION_MAX; j++)
+		dec.format = &amo_formats[dec.op->format];
+
+		/* operands start at a fixed column unless the mnemonic is longer */
+		dec_append (&dec, "%-5s", dec.op->name);
+		if (dec.op->condition.number && dec.length == (int) strlen (dec.op->name))
+			dec_append (&dec, " ");
+		for (i = 0; i < dec.op->condition.number; i++)
 		{
-			if (!amo_decfuncs[i].operations[j].f)
-				break;
-			if (amo_opcodes[i].operations[j].opcode == insn_dec.opcode)
-				goto matched;
+			if (i)
+				dec_append (&dec, ", ");
+			dec_operand (&dec, i);
 		}
 	}
 
-	sprintf (buf, "unsupported opcode");
-	goto end;
-
-matched:
-	strcpy (insn_dec.name, amo_opcodes[i].name);
-	amo_decfuncs[i].operations[j].f (amo_decfuncs[i].operations[j].parameter);
-
-end:
-	for (i = strlen (buf); i < DISASSEMBLE_DECODE_LENGTH; i++)
-		buf[i] = ' ';
-	printf ("%s", buf);
+	/* emit the whole instruction with one call, padded to a fixed column */
+	info->fprintf_func (info->stream, "%-*s", DISASSEMBLE_DECODE_LENGTH, dec.buf);
 
 	return BYTES_PER_INSTRUCTION;
 }
-
-/* clean up */
-#undef ENTRY
-#undef DECODE
@@ -22,13 +22,11 @@
 
 #include "opcode/amo.h"
 
-#define ARRAY_SIZE(a) (sizeof (a) / sizeof ((a)[0]))
-
-#define CONST 2
-#define SYM 3
-#define REG 5
-#define DEREF 30
-#define DEREF_REL 31
+#define CONST OPERAND_CONST
+#define SYM OPERAND_SYM
+#define REG OPERAND_REG
+#define DEREF OPERAND_DEREF
+#define DEREF_REL OPERAND_DEREF_REL
 
 #define N { 0, {  } }
 #define C { 1, { CONST } }
@@ -45,139 +43,51 @@
 #define RRS { 3, { REG, REG, SYM } }
 #define RRR { 3, { REG, REG, REG } }
 
-#define ENTRY(opcode, cond) { cond, opcode },
-
-OPCODESX(amo)
+const amo_field_t amo_fields[] =
+{
+#define AMO_FIELD(name, shift, width) { shift, width },
+#include "opcode/amo-insns.h"
+	{ 0, 0 }
+};
 
-OPX(nop)
-	ENTRY(PSEUDO_NOP, N)
-ENDOPX
-OPX(add)
-	ENTRY(0b000000, RRC)
-	ENTRY(0b000001, RRR)
-ENDOPX
-OPX(adc)
-	ENTRY(0b000010, RRC)
-	ENTRY(0b000011, RRR)
-ENDOPX
-OPX(sub)
-	ENTRY(0b000100, RRC)
-	ENTRY(0b000101, RRR)
-ENDOPX
-OPX(and)
-	ENTRY(0b000110, RRC)
-	ENTRY(0b000111, RRR)
-ENDOPX
-OPX(or)
-	ENTRY(0b001000, RRC)
-	ENTRY(0b001001, RRR)
-ENDOPX
-OPX(xor)
-	ENTRY(0b001010, RRC)
-	ENTRY(0b001011, RRR)
-ENDOPX
-OPX(not)
-	ENTRY(0b001100, RC)
-	ENTRY(0b001101, RR)
-ENDOPX
-OPX(lsl)
-	ENTRY(0b001110, RRC)
-	ENTRY(0b001111, RRR)
-ENDOPX
-OPX(lsr)
-	ENTRY(0b010000, RRC)
-	ENTRY(0b010001, RRR)
-ENDOPX
-OPX(asr)
-	ENTRY(0b010010, RRC)
-	ENTRY(0b010011, RRR)
-ENDOPX
-OPX(mov)
-	ENTRY(0b010100, RC)
-	ENTRY(0b010101, RR)
-	ENTRY(PSEUDO_MOV, RS)
-ENDOPX
-OPX(ldr)
-	ENTRY(0b010110, RD_R)
-	ENTRY(0b010111, RD)
-ENDOPX
-OPX(str)
-	ENTRY(0b011000, D_RR)
-	ENTRY(0b011001, DR)
-ENDOPX
-OPX(beq)
-	ENTRY(0b011010, RRS)
-ENDOPX
-OPX(bne)
-	ENTRY(0b011011, RRS)
-ENDOPX
-OPX(blt)
-	ENTRY(0b011100, RRS)
-ENDOPX
-OPX(ble)
-	ENTRY(0b011101, RRS)
-ENDOPX
-OPX(jmp)
-	ENTRY(0b011110, S)
-	ENTRY(0b011111, R)
-ENDOPX
-OPX(jal)
-	ENTRY(0b100000, S)
-	ENTRY(0b100001, R)
-ENDOPX
-OPX(swi)
-	ENTRY(0b100010, C)
-ENDOPX
-OPX(bltu)
-	ENTRY(0b100011, RRS)
-ENDOPX
-OPX(bleu)
-	ENTRY(0b100100, RRS)
-ENDOPX
-OPX(ext)
-	ENTRY(0b100101, RRC)
-ENDOPX
-OPX(ldrb)
-	ENTRY(0b100110, RD_R)
-	ENTRY(0b100111, RD)
-ENDOPX
-OPX(strb)
-	ENTRY(0b101000, D_RR)
-	ENTRY(0b101001, DR)
-ENDOPX
-OPX(ldrh)
-	ENTRY(0b101010, RD_R)
-	ENTRY(0b101011, RD)
-ENDOPX
-OPX(strh)
-	ENTRY(0b101100, D_RR)
-	ENTRY(0b101101, DR)
-ENDOPX
-OPX(setvt)
-	ENTRY(0b101110, RC)
-ENDOPX
-OPX(ret)
-	ENTRY(0b101111, R)
-ENDOPX
-OPX(lock)
-	ENTRY(0b110000, N)
-ENDOPX
+const amo_format_t amo_formats[] =
+{
+#define AMO_FORMAT(name, reg0, reg1, reg2, imm_operand, imm, kind) \
+	{ { AMO_FIELD_##reg0, AMO_FIELD_##reg1, AMO_FIELD_##reg2 }, imm_operand, AMO_FIELD_##imm, AMO_IMM_##kind },
+#include "opcode/amo-insns.h"
+};
 
-ENDOPCODESX
+/* the forms of one mnemonic are adjacent */
+const amo_opcode_t amo_opcodes[] =
+{
+#define AMO_INSN(id, mnemonic, opcode, operands, format) { #mnemonic, operands, opcode, AMO_FORMAT_##format },
+#define AMO_PSEUDO(id, mnemonic, opcode, operands, format) { #mnemonic, operands, opcode, AMO_FORMAT_##format },
+#include "opcode/amo-insns.h"
+};
 
-unsigned int amo_opcodes_size = ARRAY_SIZE (amo_opcodes);
+const amo_opcode_t *const amo_dispatch_table[OPCODE_NUMBER_MAX] =
+{
+#define AMO_INSN(id, mnemonic, opcode, operands, format) [opcode] = &amo_opcodes[AMO_INSN_##id],
+#include "opcode/amo-insns.h"
+};
 
 /* clean up */
 #undef CONST
 #undef SYM
 #undef REG
+#undef DEREF
+#undef DEREF_REL
 #undef N
 #undef C
 #undef S
 #undef R
 #undef RC
+#undef RS
 #undef RR
+#undef RD
+#undef RD_R
+#undef DR
+#undef D_RR
 #undef RRC
 #undef RRS
 #undef RRR
-#undef ENTRY